@@ -0,0 +1,331 @@
+///
+/// @file AsyncLogger.cpp
+/// @brief 异步二进制日志实现
+///
+
+#include "AsyncLogger.h"
+
+#include <chrono>
+#include <ctime>
+#include <time.h>
+
+namespace logdetail {
+
+ThreadBuffer::ThreadBuffer(size_t capacity)
+    : retired(false), m_capacity(capacity), m_mask(capacity - 1),
+      m_data(new char[capacity]), m_tail(0), m_pendingTail(0), m_cachedHead(0), m_head(0) {}
+
+ThreadBuffer::~ThreadBuffer() {
+    delete[] m_data;
+}
+
+char* ThreadBuffer::Reserve(size_t size) {
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t pos = static_cast<size_t>(tail & m_mask);
+    const size_t contiguous = m_capacity - pos;
+    // 尾部剩余空间不足时需要额外消耗尾部填充
+    const size_t needed = size <= contiguous ? size : size + contiguous;
+    if (size > m_capacity / 4) {
+        return nullptr;
+    }
+    if (tail + needed - m_cachedHead > m_capacity) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if (tail + needed - m_cachedHead > m_capacity) {
+            return nullptr;
+        }
+    }
+    if (size > contiguous) {
+        RecordHeader* padding = reinterpret_cast<RecordHeader*>(m_data + pos);
+        padding->size = static_cast<uint32_t>(contiguous);
+        padding->formatId = kPaddingFormatId;
+        tail += contiguous;
+    }
+    m_pendingTail = tail + size;
+    return m_data + (tail & m_mask);
+}
+
+void ThreadBuffer::Commit() {
+    m_tail.store(m_pendingTail, std::memory_order_release);
+}
+
+const RecordHeader* ThreadBuffer::Peek() {
+    while (true) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        const RecordHeader* record = reinterpret_cast<const RecordHeader*>(m_data + (head & m_mask));
+        if (record->formatId != kPaddingFormatId) {
+            return record;
+        }
+        m_head.store(head + record->size, std::memory_order_release);
+    }
+}
+
+void ThreadBuffer::Release(const RecordHeader* record) {
+    m_head.store(m_head.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+}
+
+} // namespace logdetail
+
+using logdetail::RecordHeader;
+using logdetail::ThreadBuffer;
+
+namespace {
+
+// 每个线程的日志缓冲区大小
+const size_t kThreadBufferSize = 1 << 20;
+
+// 后台线程空闲时的休眠间隔
+const std::chrono::milliseconds kFlushInterval(2);
+
+// 格式串注册表
+const uint32_t kMaxFormats = 4096;
+const char* g_formats[kMaxFormats];
+uint32_t g_formatCount = 0;
+std::mutex g_formatMutex;
+
+///
+/// @brief 线程退出时把缓冲区标记为退役, 由后台线程在读空后回收
+///
+struct ThreadBufferHolder {
+    ThreadBuffer* buffer;
+    ThreadBufferHolder() : buffer(nullptr) {}
+    ~ThreadBufferHolder() {
+        if (buffer) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadBufferHolder t_bufferHolder;
+
+template <typename V>
+V ReadScalar(const char*& p) {
+    V v;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return v;
+}
+
+} // namespace
+
+AsyncLogger& AsyncLogger::Instance() {
+    // 有意不析构: 其他线程的 thread_local 析构可能晚于静态对象析构
+    static AsyncLogger* instance = new AsyncLogger();
+    return *instance;
+}
+
+AsyncLogger::AsyncLogger()
+    : m_running(false), m_file(nullptr), m_echoConsole(true), m_reportedDropped(0), m_dropped(0) {}
+
+AsyncLogger::~AsyncLogger() {
+    Stop();
+}
+
+bool AsyncLogger::Start(const std::string& filePath, bool echoConsole) {
+    if (m_running.load()) {
+        return true;
+    }
+    // 文件打不开时仍启动后台线程, 只输出到标准输出, 否则各线程的记录积压在缓冲区中直至丢弃
+    m_file = fopen(filePath.c_str(), "a");
+    m_echoConsole = echoConsole || !m_file;
+    m_running.store(true);
+    m_thread = std::thread(&AsyncLogger::Run, this);
+    return m_file != nullptr;
+}
+
+void AsyncLogger::Stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running.store(false);
+    }
+    m_wakeCond.notify_one();
+    m_thread.join();
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+uint32_t AsyncLogger::RegisterFormat(const char* format) {
+    std::lock_guard<std::mutex> lock(g_formatMutex);
+    if (g_formatCount >= kMaxFormats) {
+        return kMaxFormats;
+    }
+    g_formats[g_formatCount] = format;
+    return g_formatCount++;
+}
+
+int64_t AsyncLogger::RealtimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+ThreadBuffer* AsyncLogger::LocalBuffer() {
+    ThreadBuffer* buffer = t_bufferHolder.buffer;
+    if (!buffer) {
+        buffer = new ThreadBuffer(kThreadBufferSize);
+        {
+            std::lock_guard<std::mutex> lock(m_registryMutex);
+            m_buffers.push_back(buffer);
+        }
+        t_bufferHolder.buffer = buffer;
+    }
+    return buffer;
+}
+
+void AsyncLogger::Run() {
+    while (true) {
+        const bool running = m_running.load(std::memory_order_acquire);
+        const size_t drained = Drain();
+        Flush();
+        if (!running) {
+            break;
+        }
+        if (drained == 0) {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (m_running.load(std::memory_order_relaxed)) {
+                m_wakeCond.wait_for(lock, kFlushInterval);
+            }
+        }
+    }
+}
+
+size_t AsyncLogger::Drain() {
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        buffers = m_buffers;
+    }
+
+    // 按时间戳归并, 保证不同线程的日志按发生顺序输出
+    size_t count = 0;
+    while (true) {
+        ThreadBuffer* earliestBuffer = nullptr;
+        const RecordHeader* earliest = nullptr;
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            const RecordHeader* record = buffers[i]->Peek();
+            if (record && (!earliest || record->timestampNs < earliest->timestampNs)) {
+                earliest = record;
+                earliestBuffer = buffers[i];
+            }
+        }
+        if (!earliest) {
+            break;
+        }
+        Format(earliest);
+        earliestBuffer->Release(earliest);
+        ++count;
+    }
+
+    // 回收已退出线程的缓冲区
+    {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        for (size_t i = 0; i < m_buffers.size();) {
+            ThreadBuffer* buffer = m_buffers[i];
+            if (buffer->retired.load(std::memory_order_acquire) && !buffer->Peek()) {
+                delete buffer;
+                m_buffers[i] = m_buffers.back();
+                m_buffers.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    const uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDropped) {
+        char line[96];
+        snprintf(line, sizeof(line), "[日志] 缓冲区满, 累计丢弃 %llu 条日志\n",
+                 static_cast<unsigned long long>(dropped));
+        m_batch += line;
+        if (m_echoConsole) {
+            m_consoleBatch += line;
+        }
+        m_reportedDropped = dropped;
+    }
+    return count;
+}
+
+void AsyncLogger::Format(const RecordHeader* record) {
+    const char* format = record->formatId < kMaxFormats ? g_formats[record->formatId] : "{}";
+    const char* arg = reinterpret_cast<const char*>(record) + sizeof(RecordHeader);
+    const char* end = reinterpret_cast<const char*>(record) + record->size;
+
+    // 时间戳前缀只写入文件
+    const time_t seconds = static_cast<time_t>(record->timestampNs / 1000000000LL);
+    struct tm tmTime;
+    localtime_r(&seconds, &tmTime);
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06d ",
+             tmTime.tm_hour, tmTime.tm_min, tmTime.tm_sec,
+             static_cast<int>((record->timestampNs % 1000000000LL) / 1000));
+
+    std::string line;
+    char number[64];
+    for (const char* f = format; *f; ++f) {
+        if (f[0] != '{' || f[1] != '}' || arg >= end || *arg == 0) {
+            line += *f;
+            continue;
+        }
+        ++f;
+        const uint8_t tag = static_cast<uint8_t>(*arg++);
+        switch (tag) {
+            case logdetail::kTagInt:
+                snprintf(number, sizeof(number), "%lld", static_cast<long long>(ReadScalar<int64_t>(arg)));
+                line += number;
+                break;
+            case logdetail::kTagUint:
+                snprintf(number, sizeof(number), "%llu",
+                         static_cast<unsigned long long>(ReadScalar<uint64_t>(arg)));
+                line += number;
+                break;
+            case logdetail::kTagDouble:
+                snprintf(number, sizeof(number), "%g", ReadScalar<double>(arg));
+                line += number;
+                break;
+            case logdetail::kTagChar:
+                line += ReadScalar<char>(arg);
+                break;
+            case logdetail::kTagBool:
+                line += ReadScalar<uint8_t>(arg) ? "true" : "false";
+                break;
+            case logdetail::kTagString: {
+                const uint16_t len = ReadScalar<uint16_t>(arg);
+                line.append(arg, len);
+                arg += len;
+                break;
+            }
+            default:
+                arg = end;
+                break;
+        }
+    }
+    line += '\n';
+
+    m_batch += prefix;
+    m_batch += line;
+    if (m_echoConsole) {
+        m_consoleBatch += line;
+    }
+}
+
+void AsyncLogger::Flush() {
+    if (!m_batch.empty()) {
+        if (m_file) {
+            fwrite(m_batch.data(), 1, m_batch.size(), m_file);
+            fflush(m_file);
+        }
+        m_batch.clear();
+    }
+    if (!m_consoleBatch.empty()) {
+        fwrite(m_consoleBatch.data(), 1, m_consoleBatch.size(), stdout);
+        fflush(stdout);
+        m_consoleBatch.clear();
+    }
+}
@@ -0,0 +1,272 @@
+///
+/// @file AsyncLogger.h
+/// @brief 异步二进制日志
+///
+/// 调用线程只把格式ID和原始参数编码进本线程独占的环形缓冲区,
+/// 由后台线程合并各线程记录、格式化并批量写入文件。
+///
+/// 用法:
+///   LOG("[请求] 发送登录请求, RequestID: {}", requestId);
+/// 格式串中的每个 {} 依次替换为一个参数。格式串必须是字符串字面量。
+///
+
+#ifndef CTP_TEST_ASYNC_LOGGER_H
+#define CTP_TEST_ASYNC_LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace logdetail {
+
+/// 参数类型标记
+enum ArgTag : uint8_t {
+    kTagInt = 1,
+    kTagUint,
+    kTagDouble,
+    kTagChar,
+    kTagBool,
+    kTagString,
+};
+
+/// 单个字符串参数的最大编码长度, 超出部分截断
+const size_t kMaxStringArg = 1024;
+
+inline char* EncodeString(char* p, const char* s, size_t len) {
+    if (len > kMaxStringArg) {
+        len = kMaxStringArg;
+    }
+    const uint16_t n = static_cast<uint16_t>(len);
+    *p++ = static_cast<char>(kTagString);
+    memcpy(p, &n, sizeof(n));
+    p += sizeof(n);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+inline size_t StringSize(size_t len) {
+    return 1 + sizeof(uint16_t) + (len > kMaxStringArg ? kMaxStringArg : len);
+}
+
+template <typename V>
+inline char* EncodeScalar(char* p, ArgTag tag, V v) {
+    *p++ = static_cast<char>(tag);
+    memcpy(p, &v, sizeof(v));
+    return p + sizeof(v);
+}
+
+/// 参数编码特性, 未支持的类型在编译期报错
+template <typename T, typename Enable = void>
+struct LogArg;
+
+template <typename T>
+struct LogArg<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value &&
+                                         !std::is_same<T, char>::value>::type> {
+    static size_t Size(T) { return 1 + sizeof(int64_t); }
+    static char* Encode(char* p, T v) { return EncodeScalar(p, kTagInt, static_cast<int64_t>(v)); }
+};
+
+template <typename T>
+struct LogArg<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                         !std::is_same<T, bool>::value &&
+                                         !std::is_same<T, char>::value>::type> {
+    static size_t Size(T) { return 1 + sizeof(uint64_t); }
+    static char* Encode(char* p, T v) { return EncodeScalar(p, kTagUint, static_cast<uint64_t>(v)); }
+};
+
+template <typename T>
+struct LogArg<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static size_t Size(T) { return 1 + sizeof(double); }
+    static char* Encode(char* p, T v) { return EncodeScalar(p, kTagDouble, static_cast<double>(v)); }
+};
+
+template <>
+struct LogArg<char> {
+    static size_t Size(char) { return 2; }
+    static char* Encode(char* p, char v) { return EncodeScalar(p, kTagChar, v); }
+};
+
+template <>
+struct LogArg<bool> {
+    static size_t Size(bool) { return 2; }
+    static char* Encode(char* p, bool v) { return EncodeScalar(p, kTagBool, static_cast<uint8_t>(v)); }
+};
+
+/// CTP结构体中的定长字符数组, 按数组长度截止
+template <size_t N>
+struct LogArg<char[N]> {
+    static size_t Size(const char (&s)[N]) { return StringSize(strnlen(s, N)); }
+    static char* Encode(char* p, const char (&s)[N]) { return EncodeString(p, s, strnlen(s, N)); }
+};
+
+template <>
+struct LogArg<const char*> {
+    static size_t Size(const char* s) { return StringSize(s ? strlen(s) : 0); }
+    static char* Encode(char* p, const char* s) { return EncodeString(p, s ? s : "", s ? strlen(s) : 0); }
+};
+
+template <>
+struct LogArg<char*> : LogArg<const char*> {};
+
+template <>
+struct LogArg<std::string> {
+    static size_t Size(const std::string& s) { return StringSize(s.size()); }
+    static char* Encode(char* p, const std::string& s) { return EncodeString(p, s.data(), s.size()); }
+};
+
+inline size_t ArgsSize() { return 0; }
+
+template <typename T, typename... Rest>
+inline size_t ArgsSize(const T& v, const Rest&... rest) {
+    return LogArg<T>::Size(v) + ArgsSize(rest...);
+}
+
+inline char* EncodeArgs(char* p) { return p; }
+
+template <typename T, typename... Rest>
+inline char* EncodeArgs(char* p, const T& v, const Rest&... rest) {
+    return EncodeArgs(LogArg<T>::Encode(p, v), rest...);
+}
+
+/// 日志记录头, 记录按8字节对齐
+struct RecordHeader {
+    uint32_t size;      ///< 记录总长度(含头部)
+    uint32_t formatId;  ///< 格式ID, kPaddingFormatId 表示缓冲区尾部填充
+    int64_t timestampNs;
+};
+
+const uint32_t kPaddingFormatId = 0xFFFFFFFFu;
+
+/// 单线程独占的字节环形缓冲区(单生产者单消费者)
+class ThreadBuffer {
+public:
+    explicit ThreadBuffer(size_t capacity);
+    ~ThreadBuffer();
+
+    /// 生产者: 预留size字节连续空间, 空间不足时返回nullptr
+    char* Reserve(size_t size);
+
+    /// 生产者: 提交 Reserve() 预留的空间
+    void Commit();
+
+    /// 消费者: 获取下一条记录, 无记录时返回nullptr
+    const RecordHeader* Peek();
+
+    /// 消费者: 释放 Peek() 返回的记录
+    void Release(const RecordHeader* record);
+
+    std::atomic<bool> retired;  ///< 所属线程已退出
+
+private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    char* m_data;
+
+    // 以填充隔开生产者和消费者索引(堆上分配, 不依赖 alignas)
+    char m_pad0[64];
+    std::atomic<uint64_t> m_tail;
+    uint64_t m_pendingTail;
+    uint64_t m_cachedHead;
+
+    char m_pad1[64];
+    std::atomic<uint64_t> m_head;
+};
+
+} // namespace logdetail
+
+///
+/// @brief 异步日志, 进程内单例
+///
+class AsyncLogger {
+public:
+    static AsyncLogger& Instance();
+
+    /// 打开日志文件并启动后台线程, echoConsole 为true时同时输出到标准输出。
+    /// 文件打不开时返回false, 后台线程照常启动, 日志只输出到标准输出
+    bool Start(const std::string& filePath, bool echoConsole = true);
+
+    /// 写出所有剩余记录后停止后台线程并关闭文件
+    void Stop();
+
+    /// 注册格式串, 返回格式ID。由 LOG 宏在每个调用点首次执行时调用一次
+    static uint32_t RegisterFormat(const char* format);
+
+    /// 编码一条日志记录到当前线程的缓冲区, 缓冲区满时丢弃并计数
+    template <typename... Args>
+    void Write(uint32_t formatId, const Args&... args) {
+        const size_t size = AlignedSize(sizeof(logdetail::RecordHeader) + logdetail::ArgsSize(args...));
+        logdetail::ThreadBuffer* buffer = LocalBuffer();
+        char* p = buffer->Reserve(size);
+        if (!p) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        logdetail::RecordHeader* header = reinterpret_cast<logdetail::RecordHeader*>(p);
+        header->size = static_cast<uint32_t>(size);
+        header->formatId = formatId;
+        header->timestampNs = RealtimeNs();
+        char* end = logdetail::EncodeArgs(p + sizeof(logdetail::RecordHeader), args...);
+        memset(end, 0, p + size - end);
+        buffer->Commit();
+    }
+
+    /// 因缓冲区满被丢弃的记录数
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    AsyncLogger();
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    static size_t AlignedSize(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+    static int64_t RealtimeNs();
+
+    /// 获取当前线程的缓冲区, 首次调用时创建并注册
+    logdetail::ThreadBuffer* LocalBuffer();
+
+    /// 后台线程主循环
+    void Run();
+
+    /// 按时间戳合并各线程缓冲区中的记录并格式化到 m_batch, 返回处理的记录数
+    size_t Drain();
+
+    /// 格式化一条记录并追加到 m_batch
+    void Format(const logdetail::RecordHeader* record);
+
+    /// 把 m_batch 写入文件(及标准输出)
+    void Flush();
+
+    std::mutex m_registryMutex;
+    std::vector<logdetail::ThreadBuffer*> m_buffers;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCond;
+
+    FILE* m_file;
+    bool m_echoConsole;
+    std::string m_batch;
+    std::string m_consoleBatch;
+    uint64_t m_reportedDropped;
+
+    std::atomic<uint64_t> m_dropped;
+};
+
+/// 异步写日志, 格式串中的 {} 依次替换为参数
+#define LOG(format, ...)                                                                    \
+    do {                                                                                    \
+        static const uint32_t ctpLogFormatId_ = AsyncLogger::RegisterFormat(format);        \
+        AsyncLogger::Instance().Write(ctpLogFormatId_, ##__VA_ARGS__);                      \
+    } while (0)
+
+#endif // CTP_TEST_ASYNC_LOGGER_H
@@ -0,0 +1,563 @@
+///
+/// @file Bench.cpp
+/// @brief 热路径微基准: 复现各组件提交说明中的耗时, 发现性能退化
+///
+/// 用法: ctp_bench [-n 次数] [用例...], 不指定用例时运行全部。应以 Release 编译运行,
+/// 单次调用远小于时钟开销的操作按批量平均计时, 其余每次调用前后各读一次时钟并给出百分位,
+/// 结果含 "时钟" 用例测得的读时钟开销。
+///
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "AsyncLogger.h"
+#include "BookStore.h"
+#include "Clock.h"
+#include "IdAllocator.h"
+#include "InstrumentCache.h"
+#include "LatencyHistogram.h"
+#include "OrderGateway.h"
+#include "RiskEngine.h"
+#include "StubTraderApi.h"
+#include "SymbolTable.h"
+#include "TickJournal.h"
+#include "ThostFtdcUserApiStruct.h"
+
+namespace {
+
+const int kDefaultIterations = 1000000;
+
+// 合约编号表用例的合约数, 与一个交易日的活跃合约数相当
+const int kSymbolCount = 1000;
+
+// 盘口用例的合约数, 与 SymbolTable 默认容量一致; 随机访问时盘口和源行情都不在缓存中
+const int kBookCount = 65536;
+
+// 行情落盘用例的写入速率和分段大小; 分段取小值使一次运行经过多次分段切换
+const int64_t kJournalTicksPerSecond = 200000;
+const size_t kJournalSegmentBytes = 64u << 20;
+
+// 风控竞争用例: 线程数、合约净持仓上限和每个线程每轮的尝试次数; 每个线程单独就能打满上限
+const int kRiskRaceThreads = 4;
+const int kRiskRaceLimit = 20;
+const int kRiskRaceAttempts = kRiskRaceLimit;
+
+struct BenchOptions {
+    int iterations;
+
+    BenchOptions() : iterations(kDefaultIterations) {}
+};
+
+/// 防止被测结果被优化掉
+volatile uint64_t g_sink = 0;
+
+/// xorshift 随机数, 各用例以固定种子开始, 结果可复现
+uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void LogHistogram(const char* name, const LatencyHistogram& histogram) {
+    const LatencyHistogram* histograms[1] = {&histogram};
+    const LatencySummary s = LatencyHistogram::Summarize(histograms, 1);
+    LOG("[基准] {} | 样本: {}, 平均: {}ns, p50: {}ns, p90: {}ns, p99: {}ns, p99.9: {}ns, 最大: {}ns", name, s.count,
+        s.mean, s.p50, s.p90, s.p99, s.p999, s.max);
+}
+
+/// 批量计时的结果, 以皮秒计以免整数除法丢掉个位纳秒以下的差异
+void LogAverage(const char* name, int64_t totalNs, int64_t count) {
+    const int64_t ps = count > 0 ? totalNs * 1000 / count : 0;
+    LOG("[基准] {} | 次数: {}, 平均: {}.{}ns", name, count, ps / 1000, (ps % 1000) / 100);
+}
+
+/// 合约代码, 形如 rb2701, 品种和月份各不相同
+void MakeInstrumentId(int index, TThostFtdcInstrumentIDType& id) {
+    static const char* const kProducts[] = {"rb", "hc", "au", "ag", "cu", "al", "zn", "ni", "sc", "IF",
+                                            "IC", "IH", "TA", "MA", "SR", "CF", "m", "y", "p", "i"};
+    const int productCount = static_cast<int>(sizeof(kProducts) / sizeof(kProducts[0]));
+    memset(id, 0, sizeof(id));
+    snprintf(id, sizeof(id), "%s%04d", kProducts[index % productCount], 2601 + index / productCount);
+}
+
+// ---------------------------------------------------------------------------
+// 用例
+// ---------------------------------------------------------------------------
+
+/// 连续两次读单调时钟之差, 即逐次计时的用例中每个样本包含的额外开销
+bool BenchClock(const BenchOptions& options) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < options.iterations; ++i) {
+        const int64_t start = MonotonicNs();
+        histogram.Record(MonotonicNs() - start);
+    }
+    LogHistogram("时钟 MonotonicNs", histogram);
+    return true;
+}
+
+/// 从 char[81] 合约字段查找编号, 对照 unordered_map<std::string>
+bool BenchSymbol(const BenchOptions& options) {
+    std::vector<CThostFtdcInstrumentField> fields(kSymbolCount);
+    SymbolTable symbols;
+    std::unordered_map<std::string, uint32_t> map;
+    for (int i = 0; i < kSymbolCount; ++i) {
+        MakeInstrumentId(i, fields[i].InstrumentID);
+        map[fields[i].InstrumentID] = symbols.Intern(fields[i].InstrumentID);
+    }
+    std::vector<uint16_t> order(options.iterations);
+    uint32_t random = 12345;
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint16_t>(NextRandom(random) % kSymbolCount);
+    }
+
+    uint64_t sum = 0;
+    int64_t start = MonotonicNs();
+    for (size_t i = 0; i < order.size(); ++i) {
+        sum += symbols.Find(fields[order[i]].InstrumentID);
+    }
+    LogAverage("合约编号 SymbolTable::Find", MonotonicNs() - start, options.iterations);
+
+    start = MonotonicNs();
+    for (size_t i = 0; i < order.size(); ++i) {
+        sum += map.find(fields[order[i]].InstrumentID)->second;
+    }
+    LogAverage("合约编号 unordered_map<string>::find", MonotonicNs() - start, options.iterations);
+    g_sink = sum;
+    return true;
+}
+
+/// 65536 个合约随机访问: 行情处理线程的 Update 和任意线程的 ReadTop
+bool BenchBook(const BenchOptions& options) {
+    std::vector<CThostFtdcDepthMarketDataField> ticks(kBookCount);
+    for (int i = 0; i < kBookCount; ++i) {
+        CThostFtdcDepthMarketDataField& tick = ticks[i];
+        memset(&tick, 0, sizeof(tick));
+        const double mid = 1000.0 + i % 4000;
+        tick.LastPrice = mid;
+        tick.Volume = i;
+        tick.BidPrice1 = mid - 1;
+        tick.AskPrice1 = mid + 1;
+        tick.BidVolume1 = 10;
+        tick.AskVolume1 = 12;
+        tick.BidPrice2 = mid - 2;
+        tick.AskPrice2 = mid + 2;
+        tick.BidVolume2 = 20;
+        tick.AskVolume2 = 22;
+        // 三至五档为空档
+        tick.BidPrice3 = tick.BidPrice4 = tick.BidPrice5 = 1.7976931348623157e308;
+        tick.AskPrice3 = tick.AskPrice4 = tick.AskPrice5 = 1.7976931348623157e308;
+        memcpy(tick.UpdateTime, "09:30:00", 8);
+        tick.UpdateMillisec = 500;
+    }
+    std::vector<uint32_t> order(options.iterations);
+    uint32_t random = 54321;
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = NextRandom(random) % kBookCount;
+    }
+
+    BookStore books(kBookCount);
+    int64_t start = MonotonicNs();
+    for (size_t i = 0; i < order.size(); ++i) {
+        books.Update(order[i], ticks[order[i]], static_cast<int64_t>(i));
+    }
+    LogAverage("盘口 BookStore::Update", MonotonicNs() - start, options.iterations);
+
+    uint64_t sum = 0;
+    TopOfBook top;
+    start = MonotonicNs();
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (books.ReadTop(order[i], top)) {
+            sum += top.bidVolume;
+        }
+    }
+    LogAverage("盘口 BookStore::ReadTop", MonotonicNs() - start, options.iterations);
+    g_sink = sum;
+    return true;
+}
+
+/// 删除目录及其中的文件, 目录中没有子目录
+void RemoveDirectory(const std::string& dir) {
+    DIR* handle = opendir(dir.c_str());
+    if (handle) {
+        while (struct dirent* entry = readdir(handle)) {
+            if (entry->d_name[0] != '.') {
+                unlink((dir + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(handle);
+    }
+    rmdir(dir.c_str());
+}
+
+/// 按行情回调线程的节奏(每秒20万笔)逐笔 Append, 统计单次耗时、丢弃数和分段切换
+bool BenchJournal(const BenchOptions& options) {
+    char dir[] = "/tmp/ctp_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        LOG("[错误] 无法创建临时目录");
+        return false;
+    }
+    CThostFtdcDepthMarketDataField tick;
+    memset(&tick, 0, sizeof(tick));
+    memcpy(tick.InstrumentID, "rb2701", 6);
+    tick.LastPrice = 3500;
+
+    LatencyHistogram histogram;
+    {
+        TickJournal journal(dir, kJournalSegmentBytes);
+        journal.Start();
+        if (!journal.Open("20260101")) {
+            LOG("[错误] 无法打开行情落盘日志 {}", dir);
+            journal.Stop();
+            RemoveDirectory(dir);
+            return false;
+        }
+        const int64_t intervalNs = 1000000000LL / kJournalTicksPerSecond;
+        int64_t next = MonotonicNs();
+        for (int i = 0; i < options.iterations; ++i) {
+            while (MonotonicNs() < next) {
+            }
+            next += intervalNs;
+            tick.Volume = i;
+            const int64_t start = MonotonicNs();
+            journal.Append(start, tick);
+            histogram.Record(MonotonicNs() - start);
+        }
+        journal.Stop();
+        LogHistogram("行情落盘 TickJournal::Append", histogram);
+        const size_t perSegment = (kJournalSegmentBytes - sizeof(TickJournalHeader)) / sizeof(TickRecord);
+        LOG("[基准] 行情落盘 | 写入: {}, 丢弃: {}, 分段切换约 {} 次", journal.Written(), journal.Dropped(),
+            journal.Written() / perSegment);
+    }
+    RemoveDirectory(dir);
+    return true;
+}
+
+/// 报单用例的合约和账户: 临时目录中的合约缓存、已驻留的合约编号和不限速的网关
+class GatewayFixture {
+public:
+    GatewayFixture()
+        : m_dir(MakeTempDir()), m_instruments(m_dir), m_gateway(&m_api, m_ids, UnlimitedRate()) {}
+
+    ~GatewayFixture() {
+        if (!m_dir.empty()) {
+            RemoveDirectory(m_dir);
+        }
+    }
+
+    /// 生成合约缓存和模板并模拟一次登录, 失败时返回false
+    bool Init(int instrumentCount) {
+        if (m_dir.empty()) {
+            LOG("[错误] 无法创建临时目录");
+            return false;
+        }
+        std::vector<CThostFtdcInstrumentField> rows(instrumentCount);
+        for (int i = 0; i < instrumentCount; ++i) {
+            CThostFtdcInstrumentField& row = rows[i];
+            memset(&row, 0, sizeof(row));
+            MakeInstrumentId(i, row.InstrumentID);
+            memcpy(row.ExchangeID, "SHFE", 4);
+            memcpy(row.ProductID, row.InstrumentID, 2);
+            row.ProductClass = THOST_FTDC_PC_Futures;
+            row.VolumeMultiple = 10;
+            row.PriceTick = 1.0;
+        }
+        if (!m_instruments.Build("20260101", rows)) {
+            LOG("[错误] 无法生成合约缓存 {}", m_dir);
+            return false;
+        }
+        for (size_t i = 0; i < m_instruments.Size(); ++i) {
+            m_symbols.Intern(m_instruments.At(i).InstrumentID);
+        }
+        m_gateway.SetAccount("9999", "bench", "bench");
+        return true;
+    }
+
+    /// 生成模板并登录, 风控等须在此之前设置
+    void Login() {
+        m_gateway.BuildTemplates(m_instruments, m_symbols);
+        CThostFtdcRspUserLoginField login;
+        memset(&login, 0, sizeof(login));
+        login.FrontID = 1;
+        login.SessionID = 1;
+        memcpy(login.MaxOrderRef, "0", 1);
+        m_ids.SeedOrderRef(login.MaxOrderRef);
+        m_gateway.OnLogin(login);
+    }
+
+    StubTraderApi& Api() { return m_api; }
+    IdAllocator& Ids() { return m_ids; }
+    InstrumentCache& Instruments() { return m_instruments; }
+    SymbolTable& Symbols() { return m_symbols; }
+    OrderGateway& Gateway() { return m_gateway; }
+
+private:
+    static std::string MakeTempDir() {
+        char dir[] = "/tmp/ctp_bench_XXXXXX";
+        return mkdtemp(dir) ? std::string(dir) + "/" : std::string();
+    }
+
+    static RateLimiterOptions UnlimitedRate() {
+        RateLimiterOptions options;
+        options.sessionPerSecond = 1e12;
+        options.sessionBurst = 1 << 30;
+        options.exchangePerSecond = 1e12;
+        options.exchangeBurst = 1 << 30;
+        return options;
+    }
+
+    const std::string m_dir;
+    StubTraderApi m_api;
+    IdAllocator m_ids;
+    InstrumentCache m_instruments;
+    SymbolTable m_symbols;
+    OrderGateway m_gateway;
+};
+
+/// 经 OrderGateway::InsertLimit 发送到空操作API, 对照逐字段填写报单结构的旧做法
+bool BenchGateway(const BenchOptions& options) {
+    GatewayFixture fixture;
+    if (!fixture.Init(kSymbolCount)) {
+        return false;
+    }
+    fixture.Login();
+    OrderGateway& gateway = fixture.Gateway();
+
+    LatencyHistogram histogram;
+    for (int i = 0; i < options.iterations; ++i) {
+        const uint32_t symbol = static_cast<uint32_t>(i % kSymbolCount);
+        const int64_t start = MonotonicNs();
+        gateway.InsertLimit(symbol, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 3500.0 + (i & 7), 1);
+        histogram.Record(MonotonicNs() - start);
+    }
+    LogHistogram("报单 OrderGateway::InsertLimit", histogram);
+
+    // 旧做法: 清零整个结构, 从 std::string 逐个字段 strncpy, snprintf 生成 OrderRef
+    std::vector<std::string> instrumentIds;
+    for (int i = 0; i < kSymbolCount; ++i) {
+        instrumentIds.push_back(fixture.Instruments().At(i).InstrumentID);
+    }
+    const std::string brokerId = "9999";
+    const std::string investorId = "bench";
+    const std::string exchangeId = "SHFE";
+    LatencyHistogram legacy;
+    StubTraderApi& api = fixture.Api();
+    IdAllocator& ids = fixture.Ids();
+    for (int i = 0; i < options.iterations; ++i) {
+        const std::string& instrumentId = instrumentIds[i % kSymbolCount];
+        const int64_t start = MonotonicNs();
+        CThostFtdcInputOrderField req;
+        memset(&req, 0, sizeof(req));
+        strncpy(req.BrokerID, brokerId.c_str(), sizeof(req.BrokerID) - 1);
+        strncpy(req.InvestorID, investorId.c_str(), sizeof(req.InvestorID) - 1);
+        strncpy(req.UserID, investorId.c_str(), sizeof(req.UserID) - 1);
+        strncpy(req.InstrumentID, instrumentId.c_str(), sizeof(req.InstrumentID) - 1);
+        strncpy(req.ExchangeID, exchangeId.c_str(), sizeof(req.ExchangeID) - 1);
+        snprintf(req.OrderRef, sizeof(req.OrderRef), "%d", ids.NextOrderRef());
+        req.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
+        req.Direction = THOST_FTDC_D_Buy;
+        req.CombOffsetFlag[0] = THOST_FTDC_OF_Open;
+        req.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
+        req.LimitPrice = 3500.0 + (i & 7);
+        req.VolumeTotalOriginal = 1;
+        req.TimeCondition = THOST_FTDC_TC_GFD;
+        req.VolumeCondition = THOST_FTDC_VC_AV;
+        req.MinVolume = 1;
+        req.ContingentCondition = THOST_FTDC_CC_Immediately;
+        req.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
+        req.RequestID = ids.NextRequestId();
+        api.ReqOrderInsert(&req, req.RequestID);
+        legacy.Record(MonotonicNs() - start);
+    }
+    LogHistogram("报单 逐字段填写后 ReqOrderInsert", legacy);
+    LOG("[基准] 报单 | 空操作API收到: {}", api.OrderInserts());
+    return true;
+}
+
+/// RiskEngine::Check 通过路径的单次耗时, 以及多线程同时报单时净持仓上限不被越过
+bool BenchRisk(const BenchOptions& options) {
+    GatewayFixture fixture;
+    if (!fixture.Init(kSymbolCount)) {
+        return false;
+    }
+    const SymbolTable& symbols = fixture.Symbols();
+    CThostFtdcDepthMarketDataField tick;
+    memset(&tick, 0, sizeof(tick));
+    tick.UpperLimitPrice = 4000.0;
+    tick.LowerLimitPrice = 3000.0;
+
+    // 通过路径: 每次检查后撤销在途量, 使每笔都通过
+    RiskLimits limits;
+    limits.maxOrderVolume = 100;
+    limits.maxInstrumentNet = 1000000;
+    limits.maxProductNet = 1000000;
+    RiskEngine risk(symbols, kSymbolCount, limits);
+    risk.BuildProducts(fixture.Instruments(), symbols);
+    for (int i = 0; i < kSymbolCount; ++i) {
+        risk.OnTick(static_cast<uint32_t>(i), tick);
+    }
+    LatencyHistogram histogram;
+    int passed = 0;
+    for (int i = 0; i < options.iterations; ++i) {
+        const uint32_t symbol = static_cast<uint32_t>(i % kSymbolCount);
+        const double price = 3500.0 + (i & 7);
+        const int64_t start = MonotonicNs();
+        const int result = risk.Check(symbol, THOST_FTDC_D_Buy, price, 1);
+        histogram.Record(MonotonicNs() - start);
+        if (result == kRiskOk) {
+            ++passed;
+            risk.Release(symbol, THOST_FTDC_D_Buy, 1);
+        }
+    }
+    LogHistogram("风控 RiskEngine::Check 通过", histogram);
+
+    // 竞争: 每轮各线程同时对同一合约发1手买单, 上限 kRiskRaceLimit 手, 通过的恰好应为上限
+    limits.maxInstrumentNet = kRiskRaceLimit;
+    RiskEngine raceRisk(symbols, kSymbolCount, limits);
+    raceRisk.BuildProducts(fixture.Instruments(), symbols);
+    raceRisk.OnTick(0, tick);
+    const int rounds = options.iterations / (kRiskRaceThreads * kRiskRaceAttempts) + 1;
+    std::atomic<int> round(0);
+    std::atomic<int> finished(0);
+    std::atomic<int> roundPassed(0);
+    LatencyHistogram raceHistograms[kRiskRaceThreads];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kRiskRaceThreads; ++t) {
+        LatencyHistogram& raceHistogram = raceHistograms[t];
+        threads.emplace_back([&raceRisk, &round, &finished, &roundPassed, &raceHistogram, rounds]() {
+            for (int r = 1; r <= rounds; ++r) {
+                while (round.load(std::memory_order_acquire) < r) {
+                    std::this_thread::yield();
+                }
+                for (int k = 0; k < kRiskRaceAttempts; ++k) {
+                    const int64_t start = MonotonicNs();
+                    const int result = raceRisk.Check(0, THOST_FTDC_D_Buy, 3500.0, 1);
+                    raceHistogram.Record(MonotonicNs() - start);
+                    if (result == kRiskOk) {
+                        roundPassed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            }
+        });
+    }
+    int mismatched = 0;
+    for (int r = 1; r <= rounds; ++r) {
+        raceRisk.ResetInflight();
+        roundPassed.store(0, std::memory_order_relaxed);
+        round.store(r, std::memory_order_release);
+        while (finished.load(std::memory_order_acquire) < r * kRiskRaceThreads) {
+            std::this_thread::yield();
+        }
+        const int roundResult = roundPassed.load(std::memory_order_relaxed);
+        if (roundResult != kRiskRaceLimit) {
+            if (mismatched == 0) {
+                LOG("[错误] 风控 竞争 | 第 {} 轮通过 {} 手, 上限 {} 手", r, roundResult, kRiskRaceLimit);
+            }
+            ++mismatched;
+        }
+    }
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    for (int t = 0; t < kRiskRaceThreads; ++t) {
+        const std::string name = "风控 RiskEngine::Check 竞争 线程" + std::to_string(t);
+        LogHistogram(name.c_str(), raceHistograms[t]);
+    }
+    LOG("[基准] 风控 | 通过路径通过: {}/{}, 竞争轮数: {}, 线程: {}, 通过手数不等于上限的轮数: {}", passed,
+        options.iterations, rounds, kRiskRaceThreads, mismatched);
+    return passed == options.iterations && mismatched == 0;
+}
+
+struct BenchCase {
+    const char* name;
+    const char* description;
+    bool (*run)(const BenchOptions&);  ///< 结果不符合预期时返回false
+};
+
+const BenchCase kCases[] = {
+    {"clock", "读单调时钟的开销", BenchClock},
+    {"symbol", "SymbolTable 按 char[81] 字段查找, 对照 unordered_map", BenchSymbol},
+    {"book", "BookStore 在 65536 个合约上随机 Update 和 ReadTop", BenchBook},
+    {"journal", "TickJournal 按每秒20万笔逐笔 Append", BenchJournal},
+    {"gateway", "OrderGateway::InsertLimit 发送到空操作API, 对照逐字段填写", BenchGateway},
+    {"risk", "RiskEngine::Check 通过路径, 及4线程竞争20手净持仓上限", BenchRisk},
+};
+
+const size_t kCaseCount = sizeof(kCases) / sizeof(kCases[0]);
+
+void PrintUsage(const char* programName) {
+    std::cout << "使用方法: " << programName << " [选项] [用例...]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -n <次数>  每个用例的调用次数 (默认: " << kDefaultIterations << ")" << std::endl;
+    std::cout << "  -h          显示帮助信息" << std::endl;
+    std::cout << "用例 (不指定时运行全部):" << std::endl;
+    for (size_t i = 0; i < kCaseCount; ++i) {
+        std::cout << "  " << kCases[i].name << "  " << kCases[i].description << std::endl;
+    }
+}
+
+} // namespace
+
+///
+/// @brief 主函数
+///
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                options.iterations = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                PrintUsage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.iterations <= 0) {
+        std::cout << "[错误] 无效的调用次数" << std::endl;
+        return 1;
+    }
+
+    std::vector<const BenchCase*> selected;
+    for (int i = optind; i < argc; ++i) {
+        const BenchCase* found = nullptr;
+        for (size_t j = 0; j < kCaseCount; ++j) {
+            if (strcmp(argv[i], kCases[j].name) == 0) {
+                found = &kCases[j];
+            }
+        }
+        if (!found) {
+            std::cout << "[错误] 未知的用例: " << argv[i] << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        selected.push_back(found);
+    }
+    if (selected.empty()) {
+        for (size_t i = 0; i < kCaseCount; ++i) {
+            selected.push_back(&kCases[i]);
+        }
+    }
+
+    if (!AsyncLogger::Instance().Start("ctp_bench.log")) {
+        std::cout << "[警告] 无法打开日志文件 ctp_bench.log, 日志仅输出到控制台" << std::endl;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < selected.size(); ++i) {
+        ok = selected[i]->run(options) && ok;
+    }
+    AsyncLogger::Instance().Stop();
+    return ok ? 0 : 1;
+}
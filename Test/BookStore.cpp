@@ -0,0 +1,152 @@
+///
+/// @file BookStore.cpp
+/// @brief 盘口存储实现
+///
+
+#include "BookStore.h"
+
+#include <cfloat>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const size_t kCacheLine = 64;
+
+// CTP用DBL_MAX表示无效价格
+inline double NormalizePrice(double price, int volume) {
+    return (volume <= 0 || price >= DBL_MAX) ? 0.0 : price;
+}
+
+// "HH:MM:SS" + 毫秒 -> 当日毫秒数
+inline int ParseTimeMs(const char* time, int millisec) {
+    return (((time[0] - '0') * 10 + (time[1] - '0')) * 3600 +
+            ((time[3] - '0') * 10 + (time[4] - '0')) * 60 +
+            ((time[6] - '0') * 10 + (time[7] - '0'))) * 1000 + millisec;
+}
+
+} // namespace
+
+template <typename T>
+T* BookStore::AllocateLines(size_t count) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kCacheLine, count * sizeof(T)) != 0) {
+        throw std::bad_alloc();
+    }
+    T* lines = static_cast<T*>(memory);
+    for (size_t i = 0; i < count; ++i) {
+        new (&lines[i]) T();
+        lines[i].seq.store(0, std::memory_order_relaxed);
+    }
+    return lines;
+}
+
+BookStore::BookStore(size_t capacity)
+    : m_capacity(capacity),
+      m_bids(AllocateLines<SideLine>(capacity)),
+      m_asks(AllocateLines<SideLine>(capacity)),
+      m_trades(AllocateLines<TradeLine>(capacity)) {}
+
+BookStore::~BookStore() {
+    free(m_bids);
+    free(m_asks);
+    free(m_trades);
+}
+
+void BookStore::Update(uint32_t symbolId, const CThostFtdcDepthMarketDataField& data, int64_t recvNs) {
+    if (symbolId >= m_capacity) {
+        return;
+    }
+    SideLine& bid = m_bids[symbolId];
+    SideLine& ask = m_asks[symbolId];
+    TradeLine& trade = m_trades[symbolId];
+
+    // 三条缓存行使用同一序号, 读方可以据此判断跨行读取是否来自同一次更新
+    const uint32_t seq = trade.seq.load(std::memory_order_relaxed) + 1;
+    bid.seq.store(seq, std::memory_order_relaxed);
+    ask.seq.store(seq, std::memory_order_relaxed);
+    trade.seq.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const double* bidPrices[kBookDepth] = {&data.BidPrice1, &data.BidPrice2, &data.BidPrice3,
+                                           &data.BidPrice4, &data.BidPrice5};
+    const int* bidVolumes[kBookDepth] = {&data.BidVolume1, &data.BidVolume2, &data.BidVolume3,
+                                         &data.BidVolume4, &data.BidVolume5};
+    const double* askPrices[kBookDepth] = {&data.AskPrice1, &data.AskPrice2, &data.AskPrice3,
+                                           &data.AskPrice4, &data.AskPrice5};
+    const int* askVolumes[kBookDepth] = {&data.AskVolume1, &data.AskVolume2, &data.AskVolume3,
+                                         &data.AskVolume4, &data.AskVolume5};
+    for (int i = 0; i < kBookDepth; ++i) {
+        bid.volume[i] = *bidVolumes[i];
+        bid.price[i] = NormalizePrice(*bidPrices[i], *bidVolumes[i]);
+        ask.volume[i] = *askVolumes[i];
+        ask.price[i] = NormalizePrice(*askPrices[i], *askVolumes[i]);
+    }
+    trade.lastPrice = data.LastPrice >= DBL_MAX ? 0.0 : data.LastPrice;
+    trade.volume = data.Volume;
+    trade.updateTimeMs = ParseTimeMs(data.UpdateTime, data.UpdateMillisec);
+    trade.recvNs = recvNs;
+
+    bid.seq.store(seq + 1, std::memory_order_release);
+    ask.seq.store(seq + 1, std::memory_order_release);
+    trade.seq.store(seq + 1, std::memory_order_release);
+}
+
+bool BookStore::ReadTop(uint32_t symbolId, TopOfBook& top) const {
+    if (symbolId >= m_capacity) {
+        return false;
+    }
+    const SideLine& bid = m_bids[symbolId];
+    const SideLine& ask = m_asks[symbolId];
+    while (true) {
+        const uint32_t seq = bid.seq.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return false;
+        }
+        if ((seq & 1) != 0 || ask.seq.load(std::memory_order_acquire) != seq) {
+            continue;
+        }
+        top.bidPrice = bid.price[0];
+        top.bidVolume = bid.volume[0];
+        top.askPrice = ask.price[0];
+        top.askVolume = ask.volume[0];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (bid.seq.load(std::memory_order_relaxed) == seq && ask.seq.load(std::memory_order_relaxed) == seq) {
+            return true;
+        }
+    }
+}
+
+bool BookStore::Read(uint32_t symbolId, BookSnapshot& snapshot) const {
+    if (symbolId >= m_capacity) {
+        return false;
+    }
+    const SideLine& bid = m_bids[symbolId];
+    const SideLine& ask = m_asks[symbolId];
+    const TradeLine& trade = m_trades[symbolId];
+    while (true) {
+        const uint32_t seq = trade.seq.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return false;
+        }
+        if ((seq & 1) != 0 || bid.seq.load(std::memory_order_acquire) != seq ||
+            ask.seq.load(std::memory_order_acquire) != seq) {
+            continue;
+        }
+        for (int i = 0; i < kBookDepth; ++i) {
+            snapshot.bidPrice[i] = bid.price[i];
+            snapshot.bidVolume[i] = bid.volume[i];
+            snapshot.askPrice[i] = ask.price[i];
+            snapshot.askVolume[i] = ask.volume[i];
+        }
+        snapshot.lastPrice = trade.lastPrice;
+        snapshot.volume = trade.volume;
+        snapshot.updateTimeMs = trade.updateTimeMs;
+        snapshot.recvNs = trade.recvNs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (trade.seq.load(std::memory_order_relaxed) == seq && bid.seq.load(std::memory_order_relaxed) == seq &&
+            ask.seq.load(std::memory_order_relaxed) == seq) {
+            return true;
+        }
+    }
+}
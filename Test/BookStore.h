@@ -0,0 +1,104 @@
+///
+/// @file BookStore.h
+/// @brief 按合约编号索引的五档盘口存储, 结构数组布局, 每组字段独占缓存行
+///
+
+#ifndef CTP_TEST_BOOK_STORE_H
+#define CTP_TEST_BOOK_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ThostFtdcUserApiStruct.h"
+
+/// 盘口档数
+const int kBookDepth = 5;
+
+///
+/// @brief 最优买卖价
+///
+struct TopOfBook {
+    double bidPrice;
+    double askPrice;
+    int bidVolume;
+    int askVolume;
+};
+
+///
+/// @brief 一个合约的盘口快照
+///
+struct BookSnapshot {
+    double bidPrice[kBookDepth];
+    double askPrice[kBookDepth];
+    int bidVolume[kBookDepth];
+    int askVolume[kBookDepth];
+    double lastPrice;
+    int volume;                 ///< 当日累计成交量
+    int updateTimeMs;           ///< 交易所时间, 当日毫秒数
+    int64_t recvNs;             ///< 本地接收时刻(单调时钟)
+};
+
+///
+/// @brief 盘口存储
+///
+/// 只保留深度行情中的五档价量、最新价、成交量和时间, 按字段组分成三个数组:
+/// 买盘、卖盘、成交, 每个合约在每个数组中占一条64字节缓存行。读最优价只访问
+/// 买盘和卖盘两条缓存行, 而不是约500字节的 CThostFtdcDepthMarketDataField。
+///
+/// 单写多读: Update() 只能由一个线程(行情处理线程)调用, Read*() 可在任意线程调用。
+/// 每条缓存行带一个序号构成顺序锁, 写方开始时把三条缓存行的序号置为奇数, 写完置为
+/// 下一个偶数; 读方在序号为偶数且读前读后一致(跨行读取时各行序号也一致)时才接受结果,
+/// 否则重试。空档的价格和数量均为0。
+///
+class BookStore {
+public:
+    /// @param capacity 合约数上限, 与 SymbolTable 容量一致
+    explicit BookStore(size_t capacity);
+    ~BookStore();
+
+    BookStore(const BookStore&) = delete;
+    BookStore& operator=(const BookStore&) = delete;
+
+    /// 用深度行情原地更新, 仅由一个线程调用
+    void Update(uint32_t symbolId, const CThostFtdcDepthMarketDataField& data, int64_t recvNs);
+
+    /// 读取最优买卖价, 尚无行情时返回false
+    bool ReadTop(uint32_t symbolId, TopOfBook& top) const;
+
+    /// 读取完整快照, 尚无行情时返回false
+    bool Read(uint32_t symbolId, BookSnapshot& snapshot) const;
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    /// 一侧五档, 恰好一条缓存行
+    struct SideLine {
+        std::atomic<uint32_t> seq;
+        int32_t volume[kBookDepth];
+        double price[kBookDepth];
+    };
+
+    /// 成交相关字段, 一条缓存行
+    struct TradeLine {
+        std::atomic<uint32_t> seq;
+        int32_t volume;
+        double lastPrice;
+        int64_t recvNs;
+        int32_t updateTimeMs;
+        char pad[36];
+    };
+
+    static_assert(sizeof(SideLine) == 64, "SideLine must be one cache line");
+    static_assert(sizeof(TradeLine) == 64, "TradeLine must be one cache line");
+
+    template <typename T>
+    static T* AllocateLines(size_t count);
+
+    const size_t m_capacity;
+    SideLine* m_bids;
+    SideLine* m_asks;
+    TradeLine* m_trades;
+};
+
+#endif // CTP_TEST_BOOK_STORE_H
@@ -0,0 +1,21 @@
+///
+/// @file Clock.h
+/// @brief 时间戳工具
+///
+
+#ifndef CTP_TEST_CLOCK_H
+#define CTP_TEST_CLOCK_H
+
+#include <cstdint>
+#include <time.h>
+
+///
+/// @brief 单调时钟纳秒时间戳, 用于测量耗时
+///
+inline int64_t MonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+#endif // CTP_TEST_CLOCK_H
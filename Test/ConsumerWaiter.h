@@ -0,0 +1,92 @@
+///
+/// @file ConsumerWaiter.h
+/// @brief 队列消费线程的先空转后休眠等待, 与 SpscQueue 配合使用
+///
+
+#ifndef CTP_TEST_CONSUMER_WAITER_H
+#define CTP_TEST_CONSUMER_WAITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+///
+/// @brief 消费线程的空闲等待和生产者唤醒
+///
+/// 消费线程取不到数据时调用 Idle(): 先 yield 空转 spinCount 次, 仍无数据则置休眠标志并
+/// 在条件变量上等待, 最长 maxSleep 作为漏唤醒的兜底。生产者发布数据后调用 Notify(),
+/// 只有消费线程已置休眠标志时才加锁唤醒, 热路径上只多一次 seq_cst 屏障和一次读。
+///
+/// 两侧的 seq_cst 屏障配对: 消费线程置标志后再检查队列, 生产者发布后再检查标志,
+/// 两者至少有一方看到对方的写入, 不会出现数据已入队而消费线程仍在休眠的情况。
+/// 停止标志等不经过队列的状态须通过 Signal() 在锁内修改, 否则可能在检查与等待之间丢失。
+///
+/// 空转计数只由消费线程访问; Notify()/Signal() 可由任意线程调用。
+///
+class ConsumerWaiter {
+public:
+    explicit ConsumerWaiter(int spinCount = 200,
+                            std::chrono::nanoseconds maxSleep = std::chrono::milliseconds(100))
+        : m_spinCount(spinCount), m_maxSleep(maxSleep), m_idleSpins(0), m_sleeping(false) {}
+
+    ConsumerWaiter(const ConsumerWaiter&) = delete;
+    ConsumerWaiter& operator=(const ConsumerWaiter&) = delete;
+
+    /// 生产者: 发布数据之后调用, 消费线程休眠时唤醒它
+    void Notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cond.notify_one();
+        }
+    }
+
+    /// 任意线程: 在锁内执行 update 修改状态后唤醒消费线程
+    template <typename Update>
+    void Signal(Update update) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            update();
+        }
+        m_cond.notify_one();
+    }
+
+    /// 消费者: 本轮取到了数据, 重新开始计数空转
+    void Busy() { m_idleSpins = 0; }
+
+    /// 消费者: 本轮没有取到数据; 空转次数用完后在 ready() 为假时休眠
+    /// @param ready 在锁内、休眠标志置位之后调用, 返回true表示有数据或须退出, 不再休眠
+    template <typename Ready>
+    void Idle(Ready ready) {
+        Idle(ready, m_maxSleep);
+    }
+
+    /// 同上, 本次休眠最长 maxSleep, 用于还有定时任务的消费线程
+    template <typename Ready>
+    void Idle(Ready ready, std::chrono::nanoseconds maxSleep) {
+        if (++m_idleSpins < m_spinCount) {
+            std::this_thread::yield();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            m_cond.wait_for(lock, maxSleep < m_maxSleep ? maxSleep : m_maxSleep);
+        }
+        m_sleeping.store(false, std::memory_order_relaxed);
+        m_idleSpins = 0;
+    }
+
+private:
+    const int m_spinCount;
+    const std::chrono::nanoseconds m_maxSleep;
+    int m_idleSpins;
+    std::atomic<bool> m_sleeping;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+#endif // CTP_TEST_CONSUMER_WAITER_H
@@ -0,0 +1,69 @@
+///
+/// @file ControlEvents.cpp
+/// @brief 主线程控制事件实现
+///
+
+#include "ControlEvents.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Clock.h"
+
+ControlEvents::ControlEvents()
+    : m_eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_pending(0) {}
+
+ControlEvents::~ControlEvents() {
+    if (m_eventFd >= 0) {
+        close(m_eventFd);
+    }
+}
+
+void ControlEvents::Post(uint32_t bits) {
+    m_pending.fetch_or(bits, std::memory_order_acq_rel);
+    if (m_eventFd >= 0) {
+        const uint64_t one = 1;
+        ssize_t ret = write(m_eventFd, &one, sizeof(one));
+        (void)ret;  // 计数器溢出(EAGAIN)时等待方必然已可读, 忽略即可
+    }
+}
+
+uint32_t ControlEvents::Wait(uint32_t mask, int timeoutMs) {
+    const int64_t deadlineNs = timeoutMs < 0 ? 0 : MonotonicNs() + timeoutMs * 1000000LL;
+    while (true) {
+        const uint32_t fired = m_pending.load(std::memory_order_acquire) & mask;
+        if (fired) {
+            return fired;
+        }
+
+        int waitMs = -1;
+        if (timeoutMs >= 0) {
+            const int64_t remainingNs = deadlineNs - MonotonicNs();
+            if (remainingNs <= 0) {
+                return 0;
+            }
+            waitMs = static_cast<int>((remainingNs + 999999) / 1000000);
+        }
+
+        if (m_eventFd < 0) {
+            // eventfd创建失败时退化为短间隔轮询
+            usleep(1000);
+            continue;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = m_eventFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int ret = poll(&pfd, 1, waitMs);
+        if (ret > 0) {
+            uint64_t count;
+            ssize_t n = read(m_eventFd, &count, sizeof(count));
+            (void)n;
+        } else if (ret < 0 && errno != EINTR) {
+            usleep(1000);
+        }
+    }
+}
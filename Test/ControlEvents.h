@@ -0,0 +1,57 @@
+///
+/// @file ControlEvents.h
+/// @brief 主线程控制事件, 基于eventfd唤醒
+///
+
+#ifndef CTP_TEST_CONTROL_EVENTS_H
+#define CTP_TEST_CONTROL_EVENTS_H
+
+#include <atomic>
+#include <cstdint>
+
+///
+/// @brief 控制事件位
+///
+enum ControlEventBits : uint32_t {
+    kControlShutdown     = 1u << 0,   ///< 收到退出信号
+    kControlDisconnected = 1u << 1,   ///< 与交易前置断开连接
+    kControlLoginFailed  = 1u << 2,   ///< 登录失败
+    kControlLogoutDone   = 1u << 3,   ///< 登出完成(成功或失败)
+    kControlReconnected  = 1u << 4,   ///< 断线后重新登录成功且启动查询完成
+    kControlRelogin      = 1u << 5,   ///< 断线后重新登录成功, 启动查询尚未完成
+};
+
+///
+/// @brief 控制事件集合
+///
+/// 事件以位标志保存, 投递后保持置位直到 Clear()。
+/// Post() 只使用无锁原子操作和 write(2), 可以在信号处理函数中调用;
+/// Wait() 阻塞在eventfd上, 事件到达时立即唤醒, 不需要轮询。
+///
+class ControlEvents {
+public:
+    ControlEvents();
+    ~ControlEvents();
+
+    ControlEvents(const ControlEvents&) = delete;
+    ControlEvents& operator=(const ControlEvents&) = delete;
+
+    /// 投递事件并唤醒等待线程
+    void Post(uint32_t bits);
+
+    /// 等待 mask 中任一事件发生, timeoutMs < 0 表示无限等待
+    /// @return 已发生的 mask 中的事件, 超时返回0
+    uint32_t Wait(uint32_t mask, int timeoutMs);
+
+    /// 当前已置位的事件
+    uint32_t Pending() const { return m_pending.load(std::memory_order_acquire); }
+
+    /// 清除事件
+    void Clear(uint32_t bits) { m_pending.fetch_and(~bits, std::memory_order_acq_rel); }
+
+private:
+    int m_eventFd;
+    std::atomic<uint32_t> m_pending;
+};
+
+#endif // CTP_TEST_CONTROL_EVENTS_H
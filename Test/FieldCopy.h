@@ -0,0 +1,29 @@
+///
+/// @file FieldCopy.h
+/// @brief CTP定长字符数组字段的拷贝
+///
+
+#ifndef CTP_TEST_FIELD_COPY_H
+#define CTP_TEST_FIELD_COPY_H
+
+#include <cstddef>
+#include <cstring>
+
+///
+/// @brief 拷贝字符串到定长字段, 超长截断, 始终以 '\0' 结尾
+///
+/// 最多读取源串的前 N - 1 个字节, 即 strnlen(src, N - 1), 再 memcpy 并补 '\0'。
+/// 不用 strncpy: 它把剩余部分补零, 且截断时触发 -Wstringop-truncation;
+/// 也不直接调用 strnlen: 源是较短的定长字段时会触发 -Wstringop-overread。
+///
+template <size_t N>
+inline void CopyField(char (&dst)[N], const char* src) {
+    size_t length = 0;
+    while (length < N - 1 && src[length] != '\0') {
+        ++length;
+    }
+    memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+#endif // CTP_TEST_FIELD_COPY_H
@@ -0,0 +1,340 @@
+///
+/// @file FundsEstimator.cpp
+/// @brief 本地资金估算实现
+///
+
+#include "FundsEstimator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+const size_t kCacheLine = 64;
+
+} // namespace
+
+FundsEstimator::FundsEstimator(size_t capacity, size_t orderCapacity)
+    : m_capacity(capacity), m_instruments(capacity), m_ledger(orderCapacity), m_line(nullptr),
+      m_accountLoaded(false), m_staticBalance(0.0), m_otherAvailable(0.0), m_margin(0.0), m_commission(0.0),
+      m_closeProfit(0.0),
+      m_frozenMargin(0.0), m_frozenCommission(0.0), m_frozenMarginAtLoad(0.0), m_frozenCommissionAtLoad(0.0),
+      m_unpriced(0) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kCacheLine, sizeof(FundsLine)) != 0) {
+        throw std::bad_alloc();
+    }
+    m_line = new (memory) FundsLine();
+    m_line->seq.store(0, std::memory_order_relaxed);
+    m_line->loaded = false;
+    m_line->funds = FundsSnapshot();
+    memset(&m_account, 0, sizeof(m_account));
+    memset(&m_instruments[0], 0, m_instruments.size() * sizeof(InstrumentFunds));
+    memset(&m_ledger[0], 0, m_ledger.size() * sizeof(FrozenLedger));
+}
+
+FundsEstimator::~FundsEstimator() {
+    free(m_line);
+}
+
+void FundsEstimator::BuildInstruments(const InstrumentCache& instruments, const SymbolTable& symbols) {
+    for (size_t i = 0; i < instruments.Size(); ++i) {
+        const CThostFtdcInstrumentField& instrument = instruments.At(i);
+        const uint32_t symbolId = symbols.Find(instrument.InstrumentID);
+        if (symbolId < m_capacity && m_instruments[symbolId].multiple != instrument.VolumeMultiple) {
+            m_instruments[symbolId].multiple = instrument.VolumeMultiple;
+            Reprice(m_instruments[symbolId]);
+        }
+    }
+    Publish();
+}
+
+void FundsEstimator::OnMarginRate(const CThostFtdcInstrumentMarginRateField& rate, SymbolTable& symbols) {
+    if (rate.HedgeFlag != THOST_FTDC_HF_Speculation) {
+        return;
+    }
+    const uint32_t symbolId = symbols.Intern(rate.InstrumentID);
+    if (symbolId >= m_capacity) {
+        return;
+    }
+    InstrumentFunds& instrument = m_instruments[symbolId];
+    instrument.longMarginByMoney = rate.LongMarginRatioByMoney;
+    instrument.longMarginByVolume = rate.LongMarginRatioByVolume;
+    instrument.shortMarginByMoney = rate.ShortMarginRatioByMoney;
+    instrument.shortMarginByVolume = rate.ShortMarginRatioByVolume;
+    instrument.hasMargin = true;
+    Reprice(instrument);
+    Publish();
+}
+
+void FundsEstimator::OnCommissionRate(const CThostFtdcInstrumentCommissionRateField& rate,
+                                      const InstrumentCache& instruments, SymbolTable& symbols) {
+    // 合约级结果只写该合约; 品种级结果写该品种下尚无合约级结果的全部合约
+    std::vector<uint32_t> targets;
+    if (instruments.Find(rate.InstrumentID)) {
+        targets.push_back(symbols.Intern(rate.InstrumentID));
+    } else {
+        for (size_t i = 0; i < instruments.Size(); ++i) {
+            const CThostFtdcInstrumentField& instrument = instruments.At(i);
+            if (strcmp(instrument.ProductID, rate.InstrumentID) == 0) {
+                targets.push_back(symbols.Find(instrument.InstrumentID));
+            }
+        }
+    }
+    const bool exact = targets.size() == 1 && instruments.Find(rate.InstrumentID);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (targets[i] >= m_capacity) {
+            continue;
+        }
+        InstrumentFunds& instrument = m_instruments[targets[i]];
+        if (instrument.exactCommission && !exact) {
+            continue;
+        }
+        instrument.openFeeByMoney = rate.OpenRatioByMoney;
+        instrument.openFeeByVolume = rate.OpenRatioByVolume;
+        instrument.closeFeeByMoney = rate.CloseRatioByMoney;
+        instrument.closeFeeByVolume = rate.CloseRatioByVolume;
+        instrument.closeTodayFeeByMoney = rate.CloseTodayRatioByMoney;
+        instrument.closeTodayFeeByVolume = rate.CloseTodayRatioByVolume;
+        instrument.hasCommission = true;
+        instrument.exactCommission = exact;
+        Reprice(instrument);
+    }
+    Publish();
+}
+
+bool FundsEstimator::NeedRates(uint32_t symbolId) {
+    if (symbolId >= m_capacity) {
+        return false;
+    }
+    InstrumentFunds& instrument = m_instruments[symbolId];
+    if ((instrument.hasMargin && instrument.hasCommission) || instrument.rateRequested) {
+        return false;
+    }
+    instrument.rateRequested = true;
+    return true;
+}
+
+void FundsEstimator::ResetRateRequests() {
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        m_instruments[i].rateRequested = false;
+    }
+}
+
+void FundsEstimator::LoadAccount(const CThostFtdcTradingAccountField& account) {
+    m_account = account;
+    m_accountLoaded = true;
+    m_staticBalance = account.PreBalance - account.PreCredit - account.PreMortgage + account.Mortgage -
+                      account.Withdraw + account.Deposit;
+    m_otherAvailable = account.Available -
+                       (account.Balance - account.CurrMargin - account.FrozenMargin - account.FrozenCommission);
+    m_frozenMarginAtLoad = m_frozenMargin;
+    m_frozenCommissionAtLoad = m_frozenCommission;
+    Publish();
+}
+
+void FundsEstimator::LoadPositions(const std::vector<CThostFtdcInvestorPositionField>& positions,
+                                   SymbolTable& symbols) {
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        InstrumentFunds& instrument = m_instruments[i];
+        instrument.ydLongVolume = 0;
+        instrument.ydShortVolume = 0;
+        instrument.ydLongCostPx = 0.0;
+        instrument.ydShortCostPx = 0.0;
+    }
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const CThostFtdcInvestorPositionField& row = positions[i];
+        const uint32_t symbolId = symbols.Intern(row.InstrumentID);
+        if (symbolId >= m_capacity || row.YdPosition <= 0) {
+            continue;
+        }
+        InstrumentFunds& instrument = m_instruments[symbolId];
+        if (row.PosiDirection == THOST_FTDC_PD_Short) {
+            instrument.ydShortVolume += row.YdPosition;
+            instrument.ydShortCostPx += row.PreSettlementPrice * row.YdPosition;
+        } else {
+            instrument.ydLongVolume += row.YdPosition;
+            instrument.ydLongCostPx += row.PreSettlementPrice * row.YdPosition;
+        }
+    }
+    ResetPositions();
+}
+
+void FundsEstimator::ResetPositions() {
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        InstrumentFunds& instrument = m_instruments[i];
+        instrument.longVolume = instrument.ydLongVolume;
+        instrument.shortVolume = instrument.ydShortVolume;
+        instrument.longCostPx = instrument.ydLongCostPx;
+        instrument.shortCostPx = instrument.ydShortCostPx;
+        instrument.openPx = 0.0;
+        instrument.openVolume = 0;
+        instrument.closePx = 0.0;
+        instrument.closeVolume = 0;
+        instrument.closeTodayPx = 0.0;
+        instrument.closeTodayVolume = 0;
+        instrument.closeProfitPx = 0.0;
+        instrument.margin = 0.0;
+        instrument.commission = 0.0;
+        instrument.closeProfit = 0.0;
+        Reprice(instrument);
+    }
+    // 逐个合约增减会累积舍入误差, 全部重算后直接求和
+    m_margin = 0.0;
+    m_commission = 0.0;
+    m_closeProfit = 0.0;
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        m_margin += m_instruments[i].margin;
+        m_commission += m_instruments[i].commission;
+        m_closeProfit += m_instruments[i].closeProfit;
+    }
+    Publish();
+}
+
+void FundsEstimator::OnOrderUpdate(uint32_t index, const OrderInfo& info) {
+    if (index >= m_ledger.size() || info.symbolId >= m_capacity) {
+        return;
+    }
+    const InstrumentFunds& instrument = m_instruments[info.symbolId];
+    const int remaining = IsTerminalState(info.state) ? 0 : std::max(info.volumeTotalOriginal - info.volumeTraded, 0);
+    double margin = 0.0;
+    double commission = 0.0;
+    if (remaining > 0) {
+        if (instrument.multiple == 0 || !instrument.hasMargin || !instrument.hasCommission) {
+            m_unpriced.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (info.offset == THOST_FTDC_OF_Open) {
+            margin = remaining * MarginPerLot(instrument, info.direction, info.limitPrice);
+        }
+        commission = Fee(instrument, info.offset, info.limitPrice, remaining);
+    }
+
+    FrozenLedger& frozen = m_ledger[index];
+    if (margin == frozen.margin && commission == frozen.commission) {
+        return;
+    }
+    m_frozenMargin += margin - frozen.margin;
+    m_frozenCommission += commission - frozen.commission;
+    frozen.margin = margin;
+    frozen.commission = commission;
+    Publish();
+}
+
+void FundsEstimator::OnTrade(uint32_t symbolId, const CThostFtdcTradeField& trade) {
+    if (symbolId >= m_capacity || trade.Volume <= 0) {
+        return;
+    }
+    InstrumentFunds& instrument = m_instruments[symbolId];
+    if (instrument.multiple == 0 || !instrument.hasMargin || !instrument.hasCommission) {
+        m_unpriced.fetch_add(1, std::memory_order_relaxed);
+    }
+    const bool buy = trade.Direction == THOST_FTDC_D_Buy;
+    const double amountPx = trade.Price * trade.Volume;
+
+    if (trade.OffsetFlag == THOST_FTDC_OF_Open) {
+        (buy ? instrument.longVolume : instrument.shortVolume) += trade.Volume;
+        (buy ? instrument.longCostPx : instrument.shortCostPx) += amountPx;
+        instrument.openPx += amountPx;
+        instrument.openVolume += trade.Volume;
+    } else {
+        // 买平减空头, 卖平减多头, 按平均成本释放
+        int& volume = buy ? instrument.shortVolume : instrument.longVolume;
+        double& costPx = buy ? instrument.shortCostPx : instrument.longCostPx;
+        const int closed = std::min(trade.Volume, std::max(volume, 0));
+        if (closed > 0) {
+            const double releasedPx = costPx * closed / volume;
+            const double closedPx = trade.Price * closed;
+            volume -= closed;
+            costPx = volume == 0 ? 0.0 : costPx - releasedPx;
+            instrument.closeProfitPx += buy ? releasedPx - closedPx : closedPx - releasedPx;
+        }
+        if (trade.OffsetFlag == THOST_FTDC_OF_CloseToday) {
+            instrument.closeTodayPx += amountPx;
+            instrument.closeTodayVolume += trade.Volume;
+        } else {
+            instrument.closePx += amountPx;
+            instrument.closeVolume += trade.Volume;
+        }
+    }
+    Reprice(instrument);
+    Publish();
+}
+
+bool FundsEstimator::Read(FundsSnapshot& funds) const {
+    while (true) {
+        const uint32_t seq = m_line->seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            continue;
+        }
+        const bool loaded = m_line->loaded;
+        funds = m_line->funds;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_line->seq.load(std::memory_order_relaxed) == seq) {
+            return loaded;
+        }
+    }
+}
+
+double FundsEstimator::MarginPerLot(const InstrumentFunds& instrument, char direction, double price) const {
+    if (direction == THOST_FTDC_D_Buy) {
+        return price * instrument.multiple * instrument.longMarginByMoney + instrument.longMarginByVolume;
+    }
+    return price * instrument.multiple * instrument.shortMarginByMoney + instrument.shortMarginByVolume;
+}
+
+double FundsEstimator::Fee(const InstrumentFunds& instrument, char offset, double price, int volume) const {
+    const double notional = price * instrument.multiple * volume;
+    if (offset == THOST_FTDC_OF_Open) {
+        return notional * instrument.openFeeByMoney + volume * instrument.openFeeByVolume;
+    }
+    if (offset == THOST_FTDC_OF_CloseToday) {
+        return notional * instrument.closeTodayFeeByMoney + volume * instrument.closeTodayFeeByVolume;
+    }
+    return notional * instrument.closeFeeByMoney + volume * instrument.closeFeeByVolume;
+}
+
+void FundsEstimator::Reprice(InstrumentFunds& instrument) {
+    const double multiple = instrument.multiple;
+    const double margin =
+        (instrument.longCostPx * instrument.longMarginByMoney + instrument.shortCostPx * instrument.shortMarginByMoney) *
+            multiple +
+        instrument.longVolume * instrument.longMarginByVolume + instrument.shortVolume * instrument.shortMarginByVolume;
+    const double commission =
+        (instrument.openPx * instrument.openFeeByMoney + instrument.closePx * instrument.closeFeeByMoney +
+         instrument.closeTodayPx * instrument.closeTodayFeeByMoney) * multiple +
+        instrument.openVolume * instrument.openFeeByVolume + instrument.closeVolume * instrument.closeFeeByVolume +
+        instrument.closeTodayVolume * instrument.closeTodayFeeByVolume;
+    const double closeProfit = instrument.closeProfitPx * multiple;
+    m_margin += margin - instrument.margin;
+    m_commission += commission - instrument.commission;
+    m_closeProfit += closeProfit - instrument.closeProfit;
+    instrument.margin = margin;
+    instrument.commission = commission;
+    instrument.closeProfit = closeProfit;
+}
+
+void FundsEstimator::Publish() {
+    if (!m_accountLoaded) {
+        return;     // 尚无资金基准, 只累计冻结量
+    }
+    const double frozenMargin = m_account.FrozenMargin + (m_frozenMargin - m_frozenMarginAtLoad);
+    const double frozenCommission = m_account.FrozenCommission + (m_frozenCommission - m_frozenCommissionAtLoad);
+
+    FundsSnapshot funds;
+    funds.balance = m_staticBalance + m_closeProfit - m_commission;
+    funds.currMargin = m_margin;
+    funds.frozenMargin = frozenMargin;
+    funds.frozenCommission = frozenCommission;
+    funds.commission = m_commission;
+    funds.closeProfit = m_closeProfit;
+    funds.available = funds.balance - funds.currMargin - frozenMargin - frozenCommission + m_otherAvailable;
+
+    FundsLine& line = *m_line;
+    line.seq.store(line.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    line.loaded = true;
+    line.funds = funds;
+    line.seq.store(line.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
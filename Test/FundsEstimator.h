@@ -0,0 +1,190 @@
+///
+/// @file FundsEstimator.h
+/// @brief 本地资金估算: 以静态权益和昨仓为基线, 按当日成交、报单和缓存的费率计算可用资金、保证金和手续费
+///
+
+#ifndef CTP_TEST_FUNDS_ESTIMATOR_H
+#define CTP_TEST_FUNDS_ESTIMATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "InstrumentCache.h"
+#include "OrderTable.h"
+#include "SymbolTable.h"
+
+///
+/// @brief 资金估算结果, 字段含义与 CThostFtdcTradingAccountField 同名字段一致
+///
+struct FundsSnapshot {
+    double balance;             ///< 权益, 不含持仓盈亏
+    double available;
+    double currMargin;
+    double frozenMargin;
+    double frozenCommission;
+    double commission;
+    double closeProfit;
+};
+
+///
+/// @brief 本地资金估算
+///
+/// 与实时持仓相同, 估算只依赖当日不变的基线和当日全部成交, 与资金、持仓查询结果到达的早晚无关:
+/// - 资金查询结果只取静态权益 = 上次结算准备金 - 上次信用额度 - 上次质押 + 质押 - 出金 + 入金,
+///   以及 可用资金 - (权益 - 保证金 - 冻结保证金 - 冻结手续费) 这一与成交无关的差额;
+/// - 持仓查询结果只取昨仓 YdPosition, 按昨结算价计为持仓成本;
+/// - 当日每笔成交(由调用方按成交编号去重后按顺序调用 OnTrade())累计到每个合约的聚合量: 开仓增加
+///   手数和成本, 平仓按该方向的平均成本释放, 差额计入平仓盈亏; 开仓、平今、平仓分别累计金额和手数;
+/// - 保证金 = 持仓成本 x 合约乘数 x 按金额比率 + 手数 x 按手数金额, 手续费同理, 平仓盈亏为聚合的
+///   价差 x 合约乘数; 聚合量不含费率和乘数, 费率或乘数到达时重算该合约的金额;
+/// - 权益 = 静态权益 + 平仓盈亏 - 手续费, 可用资金 = 权益 - 保证金 - 冻结保证金 - 冻结手续费 + 差额;
+/// - 开仓挂单冻结 剩余数量 x 每手保证金, 所有挂单冻结 剩余数量 x 每手手续费, 报单进入终态时释放;
+///   每笔报单已冻结的金额记在按 OrderTable 下标索引的台账中, 资金查询时挂单已冻结的金额视为已包含在
+///   查询结果的冻结金额中。
+/// 不估算持仓盈亏, 权益和可用资金不随行情变化。成交缺失(如成交查询失败)时手续费和平仓盈亏偏小。
+///
+/// 费率查询每秒1笔, 不能逐个合约预先查询: 登录后查询一次持仓合约的费率, 之后报单或成交涉及
+/// 尚无费率的合约时由 NeedRates() 通知调用方补查; 费率到达前该合约按0估算并计入 Unpriced(),
+/// 到达后按聚合量补算。手续费率可能按品种返回, 此时应用到该品种下没有合约级费率的全部合约。
+///
+/// 除 Read()/Unpriced() 外只能由交易回调处理线程调用。结果保存在一条带序号的缓存行中,
+/// Read() 为一次顺序锁读, 可在任意线程调用。
+///
+class FundsEstimator {
+public:
+    /// @param capacity      合约数上限, 与 SymbolTable 容量一致
+    /// @param orderCapacity 与 OrderTable 容量一致
+    FundsEstimator(size_t capacity, size_t orderCapacity);
+    ~FundsEstimator();
+
+    FundsEstimator(const FundsEstimator&) = delete;
+    FundsEstimator& operator=(const FundsEstimator&) = delete;
+
+    /// 按合约缓存记录合约乘数, 合约编号分配后调用
+    void BuildInstruments(const InstrumentCache& instruments, const SymbolTable& symbols);
+
+    /// 保证金率查询结果, 只使用投机套保标志的费率
+    void OnMarginRate(const CThostFtdcInstrumentMarginRateField& rate, SymbolTable& symbols);
+
+    /// 手续费率查询结果, InstrumentID 可能为合约或品种
+    void OnCommissionRate(const CThostFtdcInstrumentCommissionRateField& rate, const InstrumentCache& instruments,
+                          SymbolTable& symbols);
+
+    /// 合约缺少费率且尚未补查时返回true并记为已补查, 调用方随后提交费率查询
+    bool NeedRates(uint32_t symbolId);
+
+    /// 断线时调用: 排队中的费率查询已被丢弃, 仍缺少费率的合约允许重新补查
+    void ResetRateRequests();
+
+    /// 资金查询结果, 取静态权益和与成交无关的可用资金差额
+    void LoadAccount(const CThostFtdcTradingAccountField& account);
+
+    /// 持仓查询结果中的昨仓作为基线, 清空当日成交的聚合量; 之后须重放当日全部成交
+    void LoadPositions(const std::vector<CThostFtdcInvestorPositionField>& positions, SymbolTable& symbols);
+
+    /// 尚无昨仓基线: 清空全部合约的持仓和当日成交的聚合量
+    void ResetPositions();
+
+    /// 报单状态变化
+    /// @param index OrderTable 记录下标
+    void OnOrderUpdate(uint32_t index, const OrderInfo& info);
+
+    /// 成交回报, 每笔成交只能调用一次
+    void OnTrade(uint32_t symbolId, const CThostFtdcTradeField& trade);
+
+    /// 读取估算结果, 尚未收到资金查询结果时返回false
+    bool Read(FundsSnapshot& funds) const;
+
+    /// 因缺少费率或合约乘数而按0估算的报单和成交次数
+    uint64_t Unpriced() const { return m_unpriced.load(std::memory_order_relaxed); }
+
+private:
+    /// 每个合约的费率和持仓, 仅处理线程访问
+    struct InstrumentFunds {
+        double longMarginByMoney;
+        double longMarginByVolume;
+        double shortMarginByMoney;
+        double shortMarginByVolume;
+        double openFeeByMoney;
+        double openFeeByVolume;
+        double closeFeeByMoney;
+        double closeFeeByVolume;
+        double closeTodayFeeByMoney;
+        double closeTodayFeeByVolume;
+        int multiple;                       ///< 合约乘数, 0表示未知
+        bool hasMargin;
+        bool hasCommission;
+        bool exactCommission;               ///< 手续费率来自合约级结果, 品种级结果不再覆盖
+        bool rateRequested;
+        // 昨仓基线
+        int ydLongVolume;
+        int ydShortVolume;
+        double ydLongCostPx;                ///< 昨结算价 x 手数
+        double ydShortCostPx;
+        // 持仓和当日成交的聚合量, 金额均为 价格 x 手数, 不含合约乘数
+        int longVolume;
+        int shortVolume;
+        double longCostPx;                  ///< 多头持仓成本
+        double shortCostPx;
+        double openPx;                      ///< 开仓成交金额和手数, 用于手续费
+        int openVolume;
+        double closePx;
+        int closeVolume;
+        double closeTodayPx;
+        int closeTodayVolume;
+        double closeProfitPx;               ///< 平仓盈亏
+        // 计入合计的金额, 由聚合量、费率和乘数算出
+        double margin;
+        double commission;
+        double closeProfit;
+    };
+
+    /// 每笔报单已冻结的金额, 仅处理线程访问
+    struct FrozenLedger {
+        double margin;
+        double commission;
+    };
+
+    /// 估算结果, 一条缓存行
+    struct FundsLine {
+        std::atomic<uint32_t> seq;
+        bool loaded;
+        FundsSnapshot funds;
+    };
+
+    static_assert(sizeof(FundsLine) == 64, "FundsLine must be one cache line");
+
+    double MarginPerLot(const InstrumentFunds& instrument, char direction, double price) const;
+    double Fee(const InstrumentFunds& instrument, char offset, double price, int volume) const;
+
+    /// 按聚合量、费率和乘数重算一个合约的金额并计入合计
+    void Reprice(InstrumentFunds& instrument);
+
+    /// 按基线和合计重新计算并发布
+    void Publish();
+
+    const size_t m_capacity;
+    std::vector<InstrumentFunds> m_instruments;
+    std::vector<FrozenLedger> m_ledger;
+    FundsLine* m_line;
+
+    // 以下仅处理线程访问
+    CThostFtdcTradingAccountField m_account;    ///< 最近一次资金查询结果
+    bool m_accountLoaded;
+    double m_staticBalance;                     ///< 静态权益
+    double m_otherAvailable;                    ///< 可用资金中与成交无关的差额
+    double m_margin;                            ///< 各合约金额的合计
+    double m_commission;
+    double m_closeProfit;
+    double m_frozenMargin;                      ///< 当前全部挂单冻结的保证金
+    double m_frozenCommission;
+    double m_frozenMarginAtLoad;                ///< 资金查询时全部挂单冻结的保证金
+    double m_frozenCommissionAtLoad;
+
+    std::atomic<uint64_t> m_unpriced;
+};
+
+#endif // CTP_TEST_FUNDS_ESTIMATOR_H
@@ -0,0 +1,316 @@
+///
+/// @file GatewayOrderTest.cpp
+/// @brief 报单网关的并发报单检验: 多个线程同时调用 InsertLimit, 前置收到的 OrderRef 严格递增
+///
+/// 用法: ctp_gateway_test [-t 线程数] [-n 每线程报单数]。登录模拟前置并确认结算后查询合约生成合约缓存和
+/// 报单模板, 各线程在同一时刻开始对不同合约连续报买单(不会互相成交)。前置按收到的顺序处理报单,
+/// 每笔报单的第一个回调(OnRtnOrder 或报单出错)按同一顺序到达, 据此检查 OrderRef 严格递增、
+/// 发出的报单全部到达且没有重复。单核机器上线程只在时间片用完时交错, 报单数须足够多才能覆盖
+/// 取号与发送之间被切换的情形。前置请求队列满时 ReqOrderInsert 返回-2, 这类报单不计入检查。
+/// 任一项不符时打印原因并返回1。
+///
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "AsyncLogger.h"
+#include "FieldCopy.h"
+#include "IdAllocator.h"
+#include "InstrumentCache.h"
+#include "OrderGateway.h"
+#include "SimFront.h"
+#include "SymbolTable.h"
+
+namespace {
+
+const char* const kBrokerId = "9999";
+const char* const kUserId = "gateway";
+
+const int kDefaultThreads = 4;
+const int kDefaultOrders = 50000;
+
+// 前置请求队列容量, 报单线程连续发送时尽量不因队列满而失败
+const size_t kRequestQueueCapacity = 1 << 16;
+
+// 等待登录、合约查询和全部回报的最长时间
+const std::chrono::seconds kReadyTimeout(5);
+const std::chrono::seconds kDrainTimeout(10);
+
+///
+/// @brief 前置会话: 登录、结算确认、合约查询, 按到达顺序记录本会话报单的 OrderRef
+///
+class OrderRecorder : public CThostFtdcTraderSpi {
+public:
+    OrderRecorder() : m_api(nullptr), m_ready(false), m_failed(false), m_nextRequestId(0) {}
+
+    ~OrderRecorder() {
+        if (m_api) {
+            m_api->Release();
+        }
+    }
+
+    bool Connect() {
+        m_api = CThostFtdcTraderApi::CreateFtdcTraderApi("./flow/");
+        m_api->RegisterSpi(this);
+        m_api->SubscribePrivateTopic(THOST_TERT_QUICK);
+        m_api->SubscribePublicTopic(THOST_TERT_QUICK);
+        m_api->RegisterFront(const_cast<char*>("tcp://127.0.0.1:0"));
+        m_api->Init();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, kReadyTimeout, [this] { return m_ready || m_failed; }) && m_ready;
+    }
+
+    /// 等待收到 count 笔报单的第一个回调
+    bool WaitArrivals(size_t count) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, kDrainTimeout, [this, count] { return m_arrivals.size() >= count; });
+    }
+
+    CThostFtdcTraderApi* Api() { return m_api; }
+    const CThostFtdcRspUserLoginField& Login() const { return m_login; }
+    const std::vector<CThostFtdcInstrumentField>& Instruments() const { return m_instruments; }
+
+    std::vector<int> Arrivals() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_arrivals;
+    }
+
+    virtual void OnFrontConnected() override {
+        CThostFtdcReqUserLoginField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.UserID, kUserId);
+        CopyField(req.Password, kUserId);
+        m_api->ReqUserLogin(&req, ++m_nextRequestId);
+    }
+
+    virtual void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                                int, bool) override {
+        if ((pRspInfo && pRspInfo->ErrorID != 0) || !pRspUserLogin) {
+            Finish(false);
+            return;
+        }
+        m_login = *pRspUserLogin;
+        CThostFtdcSettlementInfoConfirmField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.InvestorID, kUserId);
+        m_api->ReqSettlementInfoConfirm(&req, ++m_nextRequestId);
+    }
+
+    virtual void OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *, CThostFtdcRspInfoField *pRspInfo,
+                                            int, bool) override {
+        if (pRspInfo && pRspInfo->ErrorID != 0) {
+            Finish(false);
+            return;
+        }
+        CThostFtdcQryInstrumentField req;
+        memset(&req, 0, sizeof(req));
+        if (m_api->ReqQryInstrument(&req, ++m_nextRequestId) != 0) {
+            Finish(false);
+        }
+    }
+
+    virtual void OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument, CThostFtdcRspInfoField *pRspInfo,
+                                    int, bool bIsLast) override {
+        if (pInstrument) {
+            m_instruments.push_back(*pInstrument);
+        }
+        if (bIsLast) {
+            Finish(!(pRspInfo && pRspInfo->ErrorID != 0) && !m_instruments.empty());
+        }
+    }
+
+    virtual void OnRtnOrder(CThostFtdcOrderField *pOrder) override {
+        if (pOrder->FrontID == m_login.FrontID && pOrder->SessionID == m_login.SessionID) {
+            Record(pOrder->OrderRef);
+        }
+    }
+
+    virtual void OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *, int,
+                                  bool) override {
+        if (pInputOrder) {
+            Record(pInputOrder->OrderRef);
+        }
+    }
+
+    virtual void OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *) override {
+        if (pInputOrder) {
+            Record(pInputOrder->OrderRef);
+        }
+    }
+
+private:
+    void Finish(bool ok) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ready = ok;
+        m_failed = !ok;
+        m_cond.notify_all();
+    }
+
+    /// 每笔报单只记录第一个回调
+    void Record(const char* orderRef) {
+        const int ref = atoi(orderRef);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_seen.insert(ref).second) {
+            m_arrivals.push_back(ref);
+            m_cond.notify_all();
+        }
+    }
+
+    CThostFtdcTraderApi* m_api;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_ready;
+    bool m_failed;
+    std::atomic<int> m_nextRequestId;
+    CThostFtdcRspUserLoginField m_login;
+    std::vector<CThostFtdcInstrumentField> m_instruments;     ///< 仅在就绪前由回调线程写入
+    std::set<int> m_seen;
+    std::vector<int> m_arrivals;
+};
+
+/// 不限速的流控参数, 报单之间不排队, 线程竞争最激烈
+RateLimiterOptions UnlimitedRate() {
+    RateLimiterOptions options;
+    options.sessionPerSecond = 1e12;
+    options.sessionBurst = 1 << 30;
+    options.exchangePerSecond = 1e12;
+    options.exchangeBurst = 1 << 30;
+    return options;
+}
+
+bool Fail(const std::string& message) {
+    std::cout << "[失败] " << message << std::endl;
+    return false;
+}
+
+bool Run(int threads, int orders) {
+    OrderRecorder recorder;
+    if (!recorder.Connect()) {
+        return Fail("登录、结算确认或合约查询失败");
+    }
+
+    // 与 TraderSpi 相同的顺序: 合约缓存 -> 合约编号 -> 报单模板 -> 登录
+    InstrumentCache instruments("./flow_gateway/");
+    if (!instruments.Build(recorder.Login().TradingDay, recorder.Instruments())) {
+        return Fail("无法生成合约缓存");
+    }
+    SymbolTable symbols(256);
+    for (size_t i = 0; i < instruments.Size(); ++i) {
+        symbols.Intern(instruments.At(i).InstrumentID);
+    }
+    // 每个线程一个策略槽位, OrderRef 由序号和槽位合成, 仍按序号递增
+    IdAllocator ids(threads);
+    OrderGateway gateway(recorder.Api(), ids, UnlimitedRate());
+    gateway.SetAccount(kBrokerId, kUserId, kUserId);
+    gateway.BuildTemplates(instruments, symbols);
+    ids.SeedOrderRef(recorder.Login().MaxOrderRef);
+    gateway.OnLogin(recorder.Login());
+    if (!gateway.Ready()) {
+        return Fail("报单网关未就绪");
+    }
+
+    std::atomic<bool> start(false);
+    std::atomic<int> sent(0);
+    std::atomic<int> failed(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            const CThostFtdcInstrumentField& instrument = instruments.At(static_cast<size_t>(t) % instruments.Size());
+            const uint32_t symbolId = symbols.Find(instrument.InstrumentID);
+            const double price = instrument.PriceTick * 1000;
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < orders; ++i) {
+                if (gateway.InsertLimit(symbolId, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, price, 1, t) == 0) {
+                    sent.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    start.store(true, std::memory_order_release);
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    const size_t expected = static_cast<size_t>(sent.load());
+    if (!recorder.WaitArrivals(expected)) {
+        return Fail("发出 " + std::to_string(expected) + " 笔, 前置只收到 " +
+                    std::to_string(recorder.Arrivals().size()) + " 笔");
+    }
+    const std::vector<int> arrivals = recorder.Arrivals();
+    if (arrivals.size() != expected) {
+        return Fail("发出 " + std::to_string(expected) + " 笔, 前置收到 " + std::to_string(arrivals.size()) + " 笔");
+    }
+    for (size_t i = 1; i < arrivals.size(); ++i) {
+        if (arrivals[i] <= arrivals[i - 1]) {
+            return Fail("第 " + std::to_string(i) + " 笔 OrderRef " + std::to_string(arrivals[i]) + " 不大于前一笔 " +
+                        std::to_string(arrivals[i - 1]));
+        }
+    }
+    std::cout << threads << " 个线程并发报单: 发出 " << expected << " 笔, 失败 " << failed.load()
+              << " 笔, 前置收到的 OrderRef 严格递增" << std::endl;
+    return expected > 0 ? true : Fail("没有报单发出");
+}
+
+void PrintUsage(const char* programName) {
+    std::cout << "使用方法: " << programName << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -t <线程数>  并发报单的线程数 (默认: " << kDefaultThreads << ")" << std::endl;
+    std::cout << "  -n <报单数>  每个线程的报单数 (默认: " << kDefaultOrders << ")" << std::endl;
+    std::cout << "  -h          显示帮助信息" << std::endl;
+}
+
+} // namespace
+
+///
+/// @brief 主函数
+///
+int main(int argc, char* argv[]) {
+    int threads = kDefaultThreads;
+    int orders = kDefaultOrders;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:h")) != -1) {
+        switch (opt) {
+            case 't':
+                threads = atoi(optarg);
+                break;
+            case 'n':
+                orders = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                PrintUsage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (threads <= 0 || orders <= 0) {
+        std::cout << "[错误] 无效的线程数或报单数" << std::endl;
+        return 1;
+    }
+
+    if (!AsyncLogger::Instance().Start("ctp_gateway_test.log", false)) {
+        std::cout << "[警告] 无法打开日志文件 ctp_gateway_test.log" << std::endl;
+    }
+    SimFrontOptions options;
+    options.requestQueueCapacity = kRequestQueueCapacity;
+    SimFront::Instance().Configure(options);
+    const bool ok = Run(threads, orders);
+    SimFront::Instance().Stop();
+    AsyncLogger::Instance().Stop();
+    return ok ? 0 : 1;
+}
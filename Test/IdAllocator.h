@@ -0,0 +1,68 @@
+///
+/// @file IdAllocator.h
+/// @brief RequestID 和 OrderRef 分配器, 原子自增, 可在任意线程调用
+///
+
+#ifndef CTP_TEST_ID_ALLOCATOR_H
+#define CTP_TEST_ID_ALLOCATOR_H
+
+#include <atomic>
+#include <cstdlib>
+
+///
+/// @brief RequestID 和 OrderRef 分配器
+///
+/// 两类编号各用一个原子计数器, 分配只有一次 fetch_add, 无锁、无等待。
+///
+/// OrderRef 由报单序号和策略槽位组成: OrderRef = 序号 * strategySlots + 策略槽位。
+/// 序号全局递增, 因此无论哪个策略报单, 同一会话内的 OrderRef 都严格递增且互不重复;
+/// 按 OrderRef 取模即可还原策略槽位。strategySlots 为1时 OrderRef 就是序号本身。
+///
+/// 登录成功后用 CThostFtdcRspUserLoginField::MaxOrderRef 调用 SeedOrderRef(),
+/// 之后分配的 OrderRef 都大于 MaxOrderRef; 重新登录时须再次调用。
+///
+class IdAllocator {
+public:
+    /// @param strategySlots 策略槽位数, 策略编号取值 [0, strategySlots)
+    explicit IdAllocator(int strategySlots = 1)
+        : m_strategySlots(strategySlots > 0 ? strategySlots : 1), m_requestId(0), m_orderSeq(1) {}
+
+    IdAllocator(const IdAllocator&) = delete;
+    IdAllocator& operator=(const IdAllocator&) = delete;
+
+    /// 分配 RequestID, 从1开始
+    int NextRequestId() { return m_requestId.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    /// 以登录返回的 MaxOrderRef 为起点; 只前进不后退, 断线前已分配的序号不会在新会话中重复
+    void SeedOrderRef(const char* maxOrderRef) {
+        const int seed = atoi(maxOrderRef) / m_strategySlots + 1;
+        int current = m_orderSeq.load(std::memory_order_relaxed);
+        while (current < seed && !m_orderSeq.compare_exchange_weak(current, seed, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// 分配报单序号, 用 OrderRefOf() 换算为 OrderRef
+    int NextOrderSeq() { return m_orderSeq.fetch_add(1, std::memory_order_relaxed); }
+
+    /// 下一个将被分配的报单序号
+    int PeekOrderSeq() const { return m_orderSeq.load(std::memory_order_relaxed); }
+
+    /// 报单序号和策略槽位 -> OrderRef
+    int OrderRefOf(int seq, int strategy) const { return seq * m_strategySlots + strategy; }
+
+    /// 分配 OrderRef
+    int NextOrderRef(int strategy = 0) { return OrderRefOf(NextOrderSeq(), strategy); }
+
+    /// OrderRef -> 策略槽位
+    int StrategyOf(int orderRef) const { return orderRef % m_strategySlots; }
+
+    /// 策略槽位数
+    int StrategySlots() const { return m_strategySlots; }
+
+private:
+    const int m_strategySlots;
+    std::atomic<int> m_requestId;
+    std::atomic<int> m_orderSeq;
+};
+
+#endif // CTP_TEST_ID_ALLOCATOR_H
@@ -0,0 +1,226 @@
+///
+/// @file InstrumentCache.cpp
+/// @brief 合约信息缓存实现
+///
+
+#include "InstrumentCache.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+const char kMagic[8] = {'C', 'T', 'P', 'I', 'N', 'S', 'T', '1'};
+const uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;    ///< sizeof(CThostFtdcInstrumentField), API版本变化时缓存作废
+    uint32_t count;
+    uint32_t indexSize;     ///< 索引槽位数, 2的幂
+    uint64_t recordsOffset;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+    char tradingDay[16];
+};
+
+static_assert(sizeof(FileHeader) <= 64, "FileHeader must fit in the reserved 64 bytes");
+const size_t kHeaderSize = 64;
+
+uint32_t HashInstrumentId(const char* id, size_t maxLen) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < maxLen && id[i] != '\0'; ++i) {
+        hash ^= static_cast<unsigned char>(id[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+InstrumentCache::InstrumentCache(const std::string& dir)
+    : m_dir(dir), m_ready(false), m_base(nullptr), m_mappedSize(0), m_records(nullptr),
+      m_index(nullptr), m_count(0), m_indexMask(0) {
+    if (!m_dir.empty() && m_dir[m_dir.size() - 1] != '/') {
+        m_dir += '/';
+    }
+}
+
+InstrumentCache::~InstrumentCache() {
+    Unmap();
+}
+
+std::string InstrumentCache::PathFor(const std::string& tradingDay) const {
+    return m_dir + "instruments_" + tradingDay + ".dat";
+}
+
+bool InstrumentCache::Open(const std::string& tradingDay) {
+    if (Ready() && tradingDay == m_tradingDay) {
+        return true;
+    }
+    Unmap();
+    return Map(PathFor(tradingDay), tradingDay);
+}
+
+bool InstrumentCache::Build(const std::string& tradingDay,
+                            const std::vector<CThostFtdcInstrumentField>& instruments) {
+    const size_t idSize = sizeof(instruments[0].InstrumentID);
+
+    // 槽位数取不小于合约数两倍的2的幂, 装载因子不超过0.5
+    uint32_t indexSize = 16;
+    while (indexSize < instruments.size() * 2) {
+        indexSize <<= 1;
+    }
+    std::vector<uint32_t> index(indexSize, 0);
+    std::vector<uint32_t> order;
+    order.reserve(instruments.size());
+
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        const char* id = instruments[i].InstrumentID;
+        uint32_t slot = HashInstrumentId(id, idSize) & (indexSize - 1);
+        bool duplicate = false;
+        while (index[slot] != 0) {
+            if (strncmp(instruments[order[index[slot] - 1]].InstrumentID, id, idSize) == 0) {
+                duplicate = true;   // 超时重发等原因导致的重复行
+                break;
+            }
+            slot = (slot + 1) & (indexSize - 1);
+        }
+        if (!duplicate) {
+            order.push_back(static_cast<uint32_t>(i));
+            index[slot] = static_cast<uint32_t>(order.size());
+        }
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.recordSize = sizeof(CThostFtdcInstrumentField);
+    header.count = static_cast<uint32_t>(order.size());
+    header.indexSize = indexSize;
+    header.recordsOffset = kHeaderSize;
+    header.indexOffset = (kHeaderSize + order.size() * sizeof(CThostFtdcInstrumentField) + 63) & ~uint64_t(63);
+    header.fileSize = header.indexOffset + indexSize * sizeof(uint32_t);
+    strncpy(header.tradingDay, tradingDay.c_str(), sizeof(header.tradingDay) - 1);
+
+    std::vector<char> buffer(header.fileSize, 0);
+    memcpy(&buffer[0], &header, sizeof(header));
+    for (size_t i = 0; i < order.size(); ++i) {
+        memcpy(&buffer[header.recordsOffset + i * sizeof(CThostFtdcInstrumentField)],
+               &instruments[order[i]], sizeof(CThostFtdcInstrumentField));
+    }
+    memcpy(&buffer[header.indexOffset], &index[0], indexSize * sizeof(uint32_t));
+
+    // 写临时文件后改名, 其他进程只会看到完整的文件
+    mkdir(m_dir.c_str(), 0755);
+    const std::string path = PathFor(tradingDay);
+    const std::string tmpPath = path + ".tmp";
+    const int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG("[错误] 无法创建合约缓存文件 {}", tmpPath);
+        return false;
+    }
+    const bool ok = WriteAll(fd, &buffer[0], buffer.size()) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOG("[错误] 写入合约缓存文件 {} 失败", path);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    Unmap();
+    return Map(path, tradingDay);
+}
+
+bool InstrumentCache::Map(const std::string& path, const std::string& tradingDay) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+        close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, base, sizeof(header));
+    header.tradingDay[sizeof(header.tradingDay) - 1] = '\0';
+    const bool valid = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                       header.recordSize == sizeof(CThostFtdcInstrumentField) && header.fileSize == size &&
+                       header.indexSize != 0 && (header.indexSize & (header.indexSize - 1)) == 0 &&
+                       header.recordsOffset + uint64_t(header.count) * header.recordSize <= header.indexOffset &&
+                       header.indexOffset + uint64_t(header.indexSize) * sizeof(uint32_t) <= size &&
+                       tradingDay == header.tradingDay;
+    if (!valid) {
+        LOG("[警告] 合约缓存文件 {} 格式不匹配, 忽略", path);
+        munmap(base, size);
+        return false;
+    }
+
+    m_base = base;
+    m_mappedSize = size;
+    m_records = reinterpret_cast<const CThostFtdcInstrumentField*>(static_cast<const char*>(base) +
+                                                                   header.recordsOffset);
+    m_index = reinterpret_cast<const uint32_t*>(static_cast<const char*>(base) + header.indexOffset);
+    m_count = header.count;
+    m_indexMask = header.indexSize - 1;
+    m_tradingDay = tradingDay;
+    m_ready.store(true, std::memory_order_release);
+    return true;
+}
+
+void InstrumentCache::Unmap() {
+    m_ready.store(false, std::memory_order_release);
+    if (m_base) {
+        munmap(m_base, m_mappedSize);
+    }
+    m_base = nullptr;
+    m_mappedSize = 0;
+    m_records = nullptr;
+    m_index = nullptr;
+    m_count = 0;
+    m_indexMask = 0;
+}
+
+const CThostFtdcInstrumentField* InstrumentCache::Find(const char* instrumentId) const {
+    if (!Ready()) {
+        return nullptr;
+    }
+    const size_t idSize = sizeof(m_records[0].InstrumentID);
+    uint32_t slot = HashInstrumentId(instrumentId, idSize) & m_indexMask;
+    while (m_index[slot] != 0) {
+        const CThostFtdcInstrumentField& record = m_records[m_index[slot] - 1];
+        if (strncmp(record.InstrumentID, instrumentId, idSize) == 0) {
+            return &record;
+        }
+        slot = (slot + 1) & m_indexMask;
+    }
+    return nullptr;
+}
@@ -0,0 +1,78 @@
+///
+/// @file InstrumentCache.h
+/// @brief 合约信息缓存, 按交易日持久化到内存映射文件
+///
+
+#ifndef CTP_TEST_INSTRUMENT_CACHE_H
+#define CTP_TEST_INSTRUMENT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+
+///
+/// @brief 合约信息缓存
+///
+/// 每个交易日对应一个只读文件 <dir>/instruments_<交易日>.dat, 内容为文件头、
+/// 按查询顺序排列的 CThostFtdcInstrumentField 记录和开放寻址哈希索引。
+/// 文件以 MAP_SHARED 只读映射, 同一交易日内的重启和其他进程直接映射已有文件,
+/// 不再发送 ReqQryInstrument; 查找只需一次哈希和少量探测, 不做任何内存分配。
+///
+/// Open()/Build() 由交易回调处理线程在登录后调用; Find() 可在任意线程调用,
+/// Ready() 返回true之后映射在本交易日内不再变化。
+///
+class InstrumentCache {
+public:
+    /// @param dir 缓存目录, 与交易API的流文件目录相同即可
+    explicit InstrumentCache(const std::string& dir);
+    ~InstrumentCache();
+
+    InstrumentCache(const InstrumentCache&) = delete;
+    InstrumentCache& operator=(const InstrumentCache&) = delete;
+
+    /// 映射指定交易日的缓存文件, 文件不存在或不完整时返回false, 需要查询后调用 Build()
+    bool Open(const std::string& tradingDay);
+
+    /// 用查询结果生成缓存文件并映射, 重复的合约只保留第一条
+    bool Build(const std::string& tradingDay, const std::vector<CThostFtdcInstrumentField>& instruments);
+
+    /// 是否已映射可用
+    bool Ready() const { return m_ready.load(std::memory_order_acquire); }
+
+    /// 按合约代码查找, 未找到或缓存不可用时返回nullptr
+    const CThostFtdcInstrumentField* Find(const char* instrumentId) const;
+
+    /// 合约数量
+    size_t Size() const { return m_count; }
+
+    /// 按下标访问, index < Size()
+    const CThostFtdcInstrumentField& At(size_t index) const { return m_records[index]; }
+
+    /// 已映射的交易日
+    const std::string& TradingDay() const { return m_tradingDay; }
+
+private:
+    std::string PathFor(const std::string& tradingDay) const;
+
+    /// 映射文件并校验, 成功后置 Ready
+    bool Map(const std::string& path, const std::string& tradingDay);
+
+    void Unmap();
+
+    std::string m_dir;
+    std::string m_tradingDay;
+    std::atomic<bool> m_ready;
+
+    void* m_base;
+    size_t m_mappedSize;
+    const CThostFtdcInstrumentField* m_records;
+    const uint32_t* m_index;        ///< 槽位存放记录下标+1, 0表示空
+    size_t m_count;
+    uint32_t m_indexMask;
+};
+
+#endif // CTP_TEST_INSTRUMENT_CACHE_H
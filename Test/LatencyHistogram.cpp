@@ -0,0 +1,82 @@
+///
+/// @file LatencyHistogram.cpp
+/// @brief 延迟直方图实现
+///
+
+#include "LatencyHistogram.h"
+
+#include <vector>
+
+LatencyHistogram::LatencyHistogram() : m_count(0), m_sum(0), m_max(0) {
+    for (int i = 0; i < kLatencyBuckets; ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::Record(int64_t ns) {
+    if (ns < 0) {
+        ns = 0;
+    }
+    m_buckets[BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+    int64_t max = m_max.load(std::memory_order_relaxed);
+    while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+int LatencyHistogram::BucketOf(int64_t ns) {
+    const uint64_t value = static_cast<uint64_t>(ns);
+    if (value < static_cast<uint64_t>(kLatencySubBuckets)) {
+        return static_cast<int>(value);
+    }
+    // 最高位在第 msb 位: 右移 shift 位后落在 [kLatencyHalfSubBuckets, kLatencySubBuckets)
+    const int msb = 63 - __builtin_clzll(value);
+    const int shift = msb - kLatencySubBucketBits + 1;
+    const int bucket = shift * kLatencyHalfSubBuckets + static_cast<int>(value >> shift);
+    return bucket < kLatencyBuckets ? bucket : kLatencyBuckets - 1;
+}
+
+int64_t LatencyHistogram::BucketUpperBound(int bucket) {
+    if (bucket < kLatencySubBuckets) {
+        return bucket;
+    }
+    const int shift = bucket / kLatencyHalfSubBuckets - 1;
+    const int64_t sub = bucket - shift * kLatencyHalfSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+LatencySummary LatencyHistogram::Summarize(const LatencyHistogram* const* histograms, size_t count) {
+    LatencySummary summary = {0, 0, 0, 0, 0, 0, 0};
+    std::vector<uint64_t> buckets(kLatencyBuckets, 0);
+    int64_t sum = 0;
+    for (size_t h = 0; h < count; ++h) {
+        const LatencyHistogram& histogram = *histograms[h];
+        for (int i = 0; i < kLatencyBuckets; ++i) {
+            const uint64_t n = histogram.m_buckets[i].load(std::memory_order_relaxed);
+            buckets[i] += n;
+            summary.count += n;
+        }
+        sum += histogram.m_sum.load(std::memory_order_relaxed);
+        const int64_t max = histogram.m_max.load(std::memory_order_relaxed);
+        summary.max = max > summary.max ? max : summary.max;
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean = sum / static_cast<int64_t>(summary.count);
+
+    // 按桶累计, 依次找到各百分位所在的桶
+    const double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+    int64_t* outputs[] = {&summary.p50, &summary.p90, &summary.p99, &summary.p999};
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (int i = 0; i < kLatencyBuckets && next < 4; ++i) {
+        seen += buckets[i];
+        while (next < 4 && seen >= static_cast<uint64_t>(quantiles[next] * summary.count + 0.5) && seen > 0) {
+            const int64_t upper = BucketUpperBound(i);
+            *outputs[next++] = upper < summary.max ? upper : summary.max;
+        }
+    }
+    return summary;
+}
@@ -0,0 +1,73 @@
+///
+/// @file LatencyHistogram.h
+/// @brief HDR风格的对数-线性延迟直方图, 无锁记录, 运行时可读
+///
+
+#ifndef CTP_TEST_LATENCY_HISTOGRAM_H
+#define CTP_TEST_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// 每个2的幂区间分成 2^(kLatencySubBucketBits-1) 个等宽桶, 相对误差不超过 1/32
+const int kLatencySubBucketBits = 6;
+const int kLatencySubBuckets = 1 << kLatencySubBucketBits;
+const int kLatencyHalfSubBuckets = kLatencySubBuckets / 2;
+
+/// 可记录的最大值约 2^40 纳秒(约18分钟), 更大的值计入最后一个桶
+const int kLatencyMaxBits = 40;
+const int kLatencyBuckets = (kLatencyMaxBits - kLatencySubBucketBits + 2) * kLatencyHalfSubBuckets;
+
+///
+/// @brief 延迟统计摘要, 单位纳秒
+///
+struct LatencySummary {
+    uint64_t count;
+    int64_t mean;
+    int64_t p50;
+    int64_t p90;
+    int64_t p99;
+    int64_t p999;
+    int64_t max;
+};
+
+///
+/// @brief 延迟直方图
+///
+/// 与 HdrHistogram 相同的桶布局: 小于 kLatencySubBuckets 的值每个数一个桶, 之后每个2的幂
+/// 区间等分为 kLatencyHalfSubBuckets 个桶, 定位只需一次前导零计数和移位。
+/// Record() 是几次 relaxed 原子加, 可在任意线程并发调用; Summarize() 可在任意线程随时调用,
+/// 读到的是近似同一时刻的计数, 不阻塞记录方。
+/// 百分位返回所在桶的上界, 与 HdrHistogram 的 highestEquivalentValue 一致。
+///
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /// 记录一个样本, 负值按0记录
+    void Record(int64_t ns);
+
+    /// 样本数
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+
+    /// 汇总一组直方图, 用于合并各交易所
+    static LatencySummary Summarize(const LatencyHistogram* const* histograms, size_t count);
+
+    /// 值 -> 桶下标
+    static int BucketOf(int64_t ns);
+
+    /// 桶下标 -> 该桶可表示的最大值
+    static int64_t BucketUpperBound(int bucket);
+
+private:
+    std::atomic<uint64_t> m_buckets[kLatencyBuckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<int64_t> m_sum;
+    std::atomic<int64_t> m_max;
+};
+
+#endif // CTP_TEST_LATENCY_HISTOGRAM_H
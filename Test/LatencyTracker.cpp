@@ -0,0 +1,157 @@
+///
+/// @file LatencyTracker.cpp
+/// @brief 分段延迟统计实现
+///
+
+#include "LatencyTracker.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+// 每个阶段的交易所列数, 最后一列为超出上限的交易所
+const int kLatencyColumns = kLatencyMaxExchanges + 1;
+
+const size_t kCacheLine = 64;
+
+} // namespace
+
+const char* LatencyStageName(int stage) {
+    switch (stage) {
+        case kLatencyMdToDecision:
+            return "行情->决策";
+        case kLatencyDecisionToSend:
+            return "决策->发送";
+        case kLatencySendCall:
+            return "ReqOrderInsert";
+        case kLatencyTickToSend:
+            return "行情->发出";
+        case kLatencySendToAck:
+            return "发送->CTP确认";
+        case kLatencySendToAccept:
+            return "发送->交易所确认";
+        case kLatencySendToFill:
+            return "发送->成交";
+        default:
+            return "未知";
+    }
+}
+
+LatencyTracker::LatencyTracker(size_t capacity)
+    : m_capacity(capacity), m_slots(nullptr),
+      m_histograms(new LatencyHistogram[kLatencyStages * kLatencyColumns]), m_exchangeCount(0) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kCacheLine, capacity * sizeof(Slot)) != 0) {
+        throw std::bad_alloc();
+    }
+    m_slots = static_cast<Slot*>(memory);
+    for (size_t i = 0; i < capacity; ++i) {
+        new (&m_slots[i]) Slot();
+        m_slots[i].orderRef.store(0, std::memory_order_relaxed);
+        m_slots[i].exchange = 0;
+        m_slots[i].sendNs = 0;
+        m_slots[i].acked = false;
+        m_slots[i].accepted = false;
+        m_slots[i].filled = false;
+    }
+    memset(m_exchangeNames, 0, sizeof(m_exchangeNames));
+}
+
+LatencyTracker::~LatencyTracker() {
+    free(m_slots);
+}
+
+int LatencyTracker::RegisterExchange(const char* exchangeId) {
+    for (int i = 0; i < m_exchangeCount; ++i) {
+        if (strcmp(m_exchangeNames[i], exchangeId) == 0) {
+            return i;
+        }
+    }
+    if (m_exchangeCount >= kLatencyMaxExchanges) {
+        return kLatencyMaxExchanges;
+    }
+    strncpy(m_exchangeNames[m_exchangeCount], exchangeId, sizeof(m_exchangeNames[0]) - 1);
+    return m_exchangeCount++;
+}
+
+void LatencyTracker::OnSending(int orderRef, int exchange, int64_t sendNs) {
+    if (m_capacity == 0 || orderRef <= 0) {
+        return;
+    }
+    if (exchange < 0 || exchange > kLatencyMaxExchanges) {
+        exchange = kLatencyMaxExchanges;
+    }
+    Slot& slot = m_slots[static_cast<size_t>(orderRef) % m_capacity];
+    slot.orderRef.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.exchange = exchange;
+    slot.sendNs = sendNs;
+    slot.acked = false;
+    slot.accepted = false;
+    slot.filled = false;
+    slot.orderRef.store(orderRef, std::memory_order_release);
+}
+
+void LatencyTracker::OnSent(int exchange, int64_t mdRecvNs, int64_t decisionNs, int64_t sendNs, int64_t returnNs) {
+    if (exchange < 0 || exchange > kLatencyMaxExchanges) {
+        exchange = kLatencyMaxExchanges;
+    }
+    LatencyHistogram* column = &m_histograms[exchange];
+    if (mdRecvNs > 0) {
+        column[kLatencyMdToDecision * kLatencyColumns].Record(decisionNs - mdRecvNs);
+        column[kLatencyTickToSend * kLatencyColumns].Record(returnNs - mdRecvNs);
+    }
+    column[kLatencyDecisionToSend * kLatencyColumns].Record(sendNs - decisionNs);
+    column[kLatencySendCall * kLatencyColumns].Record(returnNs - sendNs);
+}
+
+void LatencyTracker::OnOrderReturn(int orderRef, bool accepted, int64_t recvNs) {
+    Slot* slot = Find(orderRef);
+    if (!slot) {
+        return;
+    }
+    LatencyHistogram* column = &m_histograms[slot->exchange];
+    if (!slot->acked) {
+        slot->acked = true;
+        column[kLatencySendToAck * kLatencyColumns].Record(recvNs - slot->sendNs);
+    }
+    if (accepted && !slot->accepted) {
+        slot->accepted = true;
+        column[kLatencySendToAccept * kLatencyColumns].Record(recvNs - slot->sendNs);
+    }
+}
+
+void LatencyTracker::OnTrade(int orderRef, int64_t recvNs) {
+    Slot* slot = Find(orderRef);
+    if (!slot || slot->filled) {
+        return;
+    }
+    slot->filled = true;
+    m_histograms[kLatencySendToFill * kLatencyColumns + slot->exchange].Record(recvNs - slot->sendNs);
+}
+
+LatencySummary LatencyTracker::Summary(int stage, int exchange) const {
+    const LatencyHistogram* histograms[kLatencyColumns];
+    size_t count = 0;
+    if (stage >= 0 && stage < kLatencyStages) {
+        const LatencyHistogram* row = &m_histograms[stage * kLatencyColumns];
+        if (exchange < 0) {
+            for (int i = 0; i < kLatencyColumns; ++i) {
+                histograms[count++] = &row[i];
+            }
+        } else if (exchange <= kLatencyMaxExchanges) {
+            histograms[count++] = &row[exchange];
+        }
+    }
+    return LatencyHistogram::Summarize(histograms, count);
+}
+
+LatencyTracker::Slot* LatencyTracker::Find(int orderRef) {
+    if (m_capacity == 0 || orderRef <= 0) {
+        return nullptr;
+    }
+    Slot& slot = m_slots[static_cast<size_t>(orderRef) % m_capacity];
+    return slot.orderRef.load(std::memory_order_acquire) == orderRef ? &slot : nullptr;
+}
@@ -0,0 +1,105 @@
+///
+/// @file LatencyTracker.h
+/// @brief 行情到成交的分段延迟: 按 OrderRef 关联各采样点, 按阶段和交易所记入延迟直方图
+///
+
+#ifndef CTP_TEST_LATENCY_TRACKER_H
+#define CTP_TEST_LATENCY_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "LatencyHistogram.h"
+
+///
+/// @brief 延迟阶段
+///
+/// 采样点: 行情回调入口(md) -> 策略决策即调用 InsertLimit(decision) -> 调用 ReqOrderInsert(send)
+/// -> ReqOrderInsert 返回(return) -> 第一次 OnRtnOrder(ack) -> 带交易所报单编号的 OnRtnOrder(accept)
+/// -> 第一次 OnRtnTrade(fill)。回报的时刻取CTP回调入口, 不含处理线程的排队时间。
+///
+enum LatencyStage {
+    kLatencyMdToDecision = 0,       ///< md -> decision, 策略计算
+    kLatencyDecisionToSend,         ///< decision -> send, 风控、流控和填单
+    kLatencySendCall,               ///< send -> return, ReqOrderInsert 本身
+    kLatencyTickToSend,             ///< md -> return, 行情到报单发出
+    kLatencySendToAck,              ///< send -> ack, CTP前置确认
+    kLatencySendToAccept,           ///< send -> accept, 交易所确认
+    kLatencySendToFill,             ///< send -> fill, 首笔成交
+    kLatencyStages,
+};
+
+/// 阶段名称
+const char* LatencyStageName(int stage);
+
+/// 分交易所统计的交易所数上限, 超出的交易所只计入合计
+const int kLatencyMaxExchanges = 8;
+
+///
+/// @brief 分段延迟统计
+///
+/// 报单线程调用 ReqOrderInsert 之前以 OnSending() 把 OrderRef 和发送时刻写入按 OrderRef 取模定位的
+/// 槽位, 回报即使早于 ReqOrderInsert 返回也能找到槽位; 返回后以 OnSent() 记录本地阶段。
+/// 处理线程收到本会话的回报时按 OrderRef 找到槽位, 记录确认和成交阶段。槽位中保存完整的
+/// OrderRef, 被后来的报单覆盖或尚未写入时不记录。全程无锁、不分配内存。
+///
+/// 每个阶段每个交易所一个 LatencyHistogram, Summary() 可在运行中任意线程读取,
+/// 交易所传 -1 时合并全部交易所。
+///
+class LatencyTracker {
+public:
+    /// @param capacity 槽位数, 应不少于同时在途的报单数
+    explicit LatencyTracker(size_t capacity = 65536);
+    ~LatencyTracker();
+
+    LatencyTracker(const LatencyTracker&) = delete;
+    LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+    /// 登记交易所, 返回交易所下标; 超出上限时返回 kLatencyMaxExchanges (只计入合计)。
+    /// 由处理线程在报单开始前调用
+    int RegisterExchange(const char* exchangeId);
+
+    /// 已登记的交易所数和名称
+    int ExchangeCount() const { return m_exchangeCount; }
+    const char* ExchangeName(int exchange) const { return m_exchangeNames[exchange]; }
+
+    /// 即将调用 ReqOrderInsert: 发布槽位
+    void OnSending(int orderRef, int exchange, int64_t sendNs);
+
+    /// ReqOrderInsert 已成功返回: 记录决策到发出的本地阶段
+    /// @param mdRecvNs 触发本笔报单的行情回调时刻, 0表示不是由行情触发
+    void OnSent(int exchange, int64_t mdRecvNs, int64_t decisionNs, int64_t sendNs, int64_t returnNs);
+
+    /// 本会话报单的回报
+    /// @param accepted 是否已有交易所报单编号
+    void OnOrderReturn(int orderRef, bool accepted, int64_t recvNs);
+
+    /// 本会话报单的成交
+    void OnTrade(int orderRef, int64_t recvNs);
+
+    /// 统计摘要, exchange 为 -1 时合并全部交易所
+    LatencySummary Summary(int stage, int exchange) const;
+
+private:
+    /// 一笔报单的时刻, 独占一条缓存行
+    struct alignas(64) Slot {
+        std::atomic<int> orderRef;          ///< 最后写入, 读方据此确认槽位属于该报单
+        int exchange;
+        int64_t sendNs;
+        bool acked;                         ///< 以下发布前由报单线程清零, 之后仅处理线程访问
+        bool accepted;
+        bool filled;
+    };
+
+    Slot* Find(int orderRef);
+
+    const size_t m_capacity;
+    Slot* m_slots;
+    std::unique_ptr<LatencyHistogram[]> m_histograms;   ///< [阶段][交易所], 最后一列为超出上限的交易所
+    char m_exchangeNames[kLatencyMaxExchanges][9];
+    int m_exchangeCount;
+};
+
+#endif // CTP_TEST_LATENCY_TRACKER_H
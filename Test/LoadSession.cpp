@@ -0,0 +1,511 @@
+///
+/// @file LoadSession.cpp
+/// @brief 压测会话实现
+///
+
+#include "LoadSession.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+#include "FieldCopy.h"
+
+namespace {
+
+// 距下一次发送超过该值时休眠, 否则让出CPU等待
+const int64_t kPaceSleepNs = 200000;
+
+/// 逐级创建目录
+void MakeDirs(const std::string& path) {
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+bool IsError(const CThostFtdcRspInfoField* info) {
+    return info && info->ErrorID != 0;
+}
+
+} // namespace
+
+const size_t LoadSession::kOrderSlots;
+const size_t LoadSession::kQuerySlots;
+const size_t LoadSession::kCancelSlots;
+const int LoadSession::kMaxWindow;
+
+LoadSession::LoadSession(int index, const LoadOptions& options)
+    : m_index(index), m_options(options), m_api(nullptr), m_ready(false), m_failed(false), m_frontId(0),
+      m_sessionId(0), m_maxOrderRef(0), m_callbackClockValid(false), m_inFlight(0), m_nextRef(1),
+      m_nextRequestId(0), m_random(2463534242u + static_cast<uint32_t>(index) * 2654435761u),
+      m_cancelRing(kCancelSlots), m_cancelHead(0), m_cancelCount(0), m_startNs(0), m_stopNs(0),
+      m_driverCpuNs(0), m_callbackCpuStartNs(0), m_callbackCpuNs(0), m_orderSlots(new OrderSlot[kOrderSlots]),
+      m_querySendNs(new std::atomic<int64_t>[kQuerySlots]), m_orders(0), m_cancels(0), m_queries(0),
+      m_throttled(0), m_orderRejects(0), m_cancelRejects(0), m_rtnOrders(0), m_rtnTrades(0), m_callbacks(0) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "%03d", index);
+    m_userId = m_options.userPrefix + suffix;
+    m_flowPath = m_options.flowRoot + suffix + "/";
+    for (size_t i = 0; i < kOrderSlots; ++i) {
+        m_orderSlots[i].ref.store(0, std::memory_order_relaxed);
+        m_orderSlots[i].sendNs.store(0, std::memory_order_relaxed);
+        m_orderSlots[i].cancelNs.store(0, std::memory_order_relaxed);
+        m_orderSlots[i].acked.store(true, std::memory_order_relaxed);
+        m_orderSlots[i].finished.store(true, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kQuerySlots; ++i) {
+        m_querySendNs[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+LoadSession::~LoadSession() {
+    if (m_driver.joinable()) {
+        m_driver.join();
+    }
+    Close();
+}
+
+bool LoadSession::Connect() {
+    MakeDirs(m_flowPath);
+    m_api = CThostFtdcTraderApi::CreateFtdcTraderApi(m_flowPath.c_str());
+    if (!m_api) {
+        return false;
+    }
+    m_api->RegisterSpi(this);
+    m_api->SubscribePrivateTopic(THOST_TERT_QUICK);
+    m_api->SubscribePublicTopic(THOST_TERT_QUICK);
+    m_api->RegisterFront(const_cast<char*>(m_options.frontAddr.c_str()));
+    m_api->Init();
+    return true;
+}
+
+bool LoadSession::WaitReady(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(m_readyMutex);
+    m_readyCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return m_ready || m_failed; });
+    return m_ready;
+}
+
+void LoadSession::Run(int64_t endNs) {
+    m_driver = std::thread(&LoadSession::DriveLoop, this, endNs);
+}
+
+void LoadSession::Join(int drainTimeoutMs) {
+    if (m_driver.joinable()) {
+        m_driver.join();
+    }
+    const int64_t deadline = MonotonicNs() + static_cast<int64_t>(drainTimeoutMs) * 1000000;
+    while (m_inFlight.load(std::memory_order_acquire) > 0 && MonotonicNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    m_callbackCpuNs = CallbackCpuNs() - m_callbackCpuStartNs;
+}
+
+LoadSessionReport LoadSession::Report() const {
+    LoadSessionReport report;
+    report.orders = m_orders.load(std::memory_order_relaxed);
+    report.cancels = m_cancels.load(std::memory_order_relaxed);
+    report.queries = m_queries.load(std::memory_order_relaxed);
+    report.throttled = m_throttled.load(std::memory_order_relaxed);
+    report.orderRejects = m_orderRejects.load(std::memory_order_relaxed);
+    report.cancelRejects = m_cancelRejects.load(std::memory_order_relaxed);
+    report.rtnOrders = m_rtnOrders.load(std::memory_order_relaxed);
+    report.rtnTrades = m_rtnTrades.load(std::memory_order_relaxed);
+    report.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    const LatencyHistogram* order = &m_orderLatency;
+    const LatencyHistogram* cancel = &m_cancelLatency;
+    const LatencyHistogram* query = &m_queryLatency;
+    report.orderLatency = LatencyHistogram::Summarize(&order, 1);
+    report.cancelLatency = LatencyHistogram::Summarize(&cancel, 1);
+    report.queryLatency = LatencyHistogram::Summarize(&query, 1);
+    report.wallNs = m_stopNs - m_startNs;
+    report.driverCpuNs = m_driverCpuNs;
+    report.callbackCpuNs = m_callbackCpuNs;
+    return report;
+}
+
+void LoadSession::Close() {
+    if (m_api) {
+        m_api->Release();
+        m_api = nullptr;
+    }
+}
+
+int64_t LoadSession::ThreadCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t LoadSession::CallbackCpuNs() const {
+    if (!m_callbackClockValid.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    struct timespec ts;
+    if (clock_gettime(m_callbackClock, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+uint32_t LoadSession::NextRandom() {
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random;
+}
+
+// ---------------------------------------------------------------------------
+// 发送线程
+// ---------------------------------------------------------------------------
+
+void LoadSession::DriveLoop(int64_t endNs) {
+    const int totalWeight = m_options.orderWeight + m_options.cancelWeight + m_options.queryWeight;
+    const int64_t intervalNs =
+        m_options.ratePerSession > 0.0 ? static_cast<int64_t>(1e9 / m_options.ratePerSession) : 0;
+
+    m_callbackCpuStartNs = CallbackCpuNs();
+    const int64_t cpuStartNs = ThreadCpuNs();
+    m_startNs = MonotonicNs();
+    int64_t nextNs = m_startNs;
+
+    while (true) {
+        const int64_t now = MonotonicNs();
+        if (now >= endNs) {
+            break;
+        }
+        if (m_inFlight.load(std::memory_order_acquire) >= m_options.window) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (intervalNs > 0) {
+            if (now < nextNs) {
+                if (nextNs - now > kPaceSleepNs) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(nextNs - now - kPaceSleepNs / 2));
+                } else {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            nextNs += intervalNs;
+        }
+
+        const int pick = totalWeight > 0 ? static_cast<int>(NextRandom() % static_cast<uint32_t>(totalWeight)) : 0;
+        if (pick < m_options.orderWeight) {
+            SendOrder();
+        } else if (pick < m_options.orderWeight + m_options.cancelWeight) {
+            // 跳过回调线程已标记终结的报单, 没有可撤的报单时改为报单
+            int ref = 0;
+            while (m_cancelCount > 0 && ref == 0) {
+                const int candidate = m_cancelRing[m_cancelHead];
+                m_cancelHead = (m_cancelHead + 1) % kCancelSlots;
+                --m_cancelCount;
+                const OrderSlot& slot = m_orderSlots[static_cast<size_t>(candidate) & (kOrderSlots - 1)];
+                if (slot.ref.load(std::memory_order_relaxed) == candidate &&
+                    !slot.finished.load(std::memory_order_relaxed)) {
+                    ref = candidate;
+                }
+            }
+            if (ref == 0) {
+                SendOrder();
+            } else {
+                SendCancel(ref);
+            }
+        } else {
+            SendQuery();
+        }
+    }
+
+    m_stopNs = MonotonicNs();
+    m_driverCpuNs = ThreadCpuNs() - cpuStartNs;
+}
+
+int LoadSession::SendOrder() {
+    CThostFtdcInputOrderField req;
+    memset(&req, 0, sizeof(req));
+    CopyField(req.BrokerID, m_options.brokerId.c_str());
+    CopyField(req.InvestorID, m_userId.c_str());
+    CopyField(req.UserID, m_userId.c_str());
+    CopyField(req.InstrumentID, m_options.instrumentId.c_str());
+    CopyField(req.ExchangeID, m_options.exchangeId.c_str());
+    const int ref = m_nextRef++;
+    snprintf(req.OrderRef, sizeof(req.OrderRef), "%d", ref);
+    req.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
+    const uint32_t random = NextRandom();
+    req.Direction = (random & 1) ? THOST_FTDC_D_Buy : THOST_FTDC_D_Sell;
+    const int offset = static_cast<int>((random >> 1) % static_cast<uint32_t>(2 * m_options.priceSpread + 1)) -
+                       m_options.priceSpread;
+    req.LimitPrice = m_options.midPrice + offset * m_options.priceTick;
+    req.CombOffsetFlag[0] = THOST_FTDC_OF_Open;
+    req.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
+    req.VolumeTotalOriginal = 1;
+    req.TimeCondition = THOST_FTDC_TC_GFD;
+    req.VolumeCondition = THOST_FTDC_VC_AV;
+    req.MinVolume = 1;
+    req.ContingentCondition = THOST_FTDC_CC_Immediately;
+    req.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
+    req.RequestID = ++m_nextRequestId;
+
+    OrderSlot& slot = m_orderSlots[static_cast<size_t>(ref) & (kOrderSlots - 1)];
+    slot.ref.store(ref, std::memory_order_relaxed);
+    slot.acked.store(false, std::memory_order_relaxed);
+    slot.finished.store(false, std::memory_order_relaxed);
+    slot.cancelNs.store(0, std::memory_order_relaxed);
+    m_inFlight.fetch_add(1, std::memory_order_relaxed);
+    slot.sendNs.store(MonotonicNs(), std::memory_order_relaxed);
+    const int result = m_api->ReqOrderInsert(&req, req.RequestID);
+    if (result != 0) {
+        slot.acked.store(true, std::memory_order_relaxed);
+        slot.finished.store(true, std::memory_order_relaxed);
+        Complete();
+        m_throttled.store(m_throttled.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return result;
+    }
+    m_orders.store(m_orders.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // 撤单环满时丢掉最早的报单, 它不会再被撤
+    if (m_cancelCount == kCancelSlots) {
+        m_cancelHead = (m_cancelHead + 1) % kCancelSlots;
+        --m_cancelCount;
+    }
+    m_cancelRing[(m_cancelHead + m_cancelCount) % kCancelSlots] = ref;
+    ++m_cancelCount;
+    return 0;
+}
+
+int LoadSession::SendCancel(int ref) {
+    CThostFtdcInputOrderActionField req;
+    memset(&req, 0, sizeof(req));
+    CopyField(req.BrokerID, m_options.brokerId.c_str());
+    CopyField(req.InvestorID, m_userId.c_str());
+    CopyField(req.UserID, m_userId.c_str());
+    snprintf(req.OrderRef, sizeof(req.OrderRef), "%d", ref);
+    req.FrontID = m_frontId;
+    req.SessionID = m_sessionId;
+    req.ActionFlag = THOST_FTDC_AF_Delete;
+    CopyField(req.InstrumentID, m_options.instrumentId.c_str());
+    CopyField(req.ExchangeID, m_options.exchangeId.c_str());
+
+    OrderSlot& slot = m_orderSlots[static_cast<size_t>(ref) & (kOrderSlots - 1)];
+    m_inFlight.fetch_add(1, std::memory_order_relaxed);
+    slot.cancelNs.store(MonotonicNs(), std::memory_order_relaxed);
+    const int result = m_api->ReqOrderAction(&req, ++m_nextRequestId);
+    if (result != 0) {
+        if (slot.cancelNs.exchange(0, std::memory_order_relaxed) != 0) {
+            Complete();
+        }
+        m_throttled.store(m_throttled.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return result;
+    }
+    m_cancels.store(m_cancels.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return 0;
+}
+
+int LoadSession::SendQuery() {
+    const int requestId = ++m_nextRequestId;
+    std::atomic<int64_t>& sendNs = m_querySendNs[static_cast<size_t>(requestId) & (kQuerySlots - 1)];
+    m_inFlight.fetch_add(1, std::memory_order_relaxed);
+    sendNs.store(MonotonicNs(), std::memory_order_relaxed);
+
+    // 资金和持仓查询交替
+    int result;
+    if (requestId & 1) {
+        CThostFtdcQryTradingAccountField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, m_options.brokerId.c_str());
+        CopyField(req.InvestorID, m_userId.c_str());
+        result = m_api->ReqQryTradingAccount(&req, requestId);
+    } else {
+        CThostFtdcQryInvestorPositionField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, m_options.brokerId.c_str());
+        CopyField(req.InvestorID, m_userId.c_str());
+        result = m_api->ReqQryInvestorPosition(&req, requestId);
+    }
+    if (result != 0) {
+        if (sendNs.exchange(0, std::memory_order_relaxed) != 0) {
+            Complete();
+        }
+        m_throttled.store(m_throttled.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return result;
+    }
+    m_queries.store(m_queries.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// API回调线程
+// ---------------------------------------------------------------------------
+
+void LoadSession::OnFrontConnected() {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!m_callbackClockValid.load(std::memory_order_relaxed) &&
+        pthread_getcpuclockid(pthread_self(), &m_callbackClock) == 0) {
+        m_callbackClockValid.store(true, std::memory_order_release);
+    }
+
+    CThostFtdcReqUserLoginField req;
+    memset(&req, 0, sizeof(req));
+    CopyField(req.BrokerID, m_options.brokerId.c_str());
+    CopyField(req.UserID, m_userId.c_str());
+    CopyField(req.Password, m_userId.c_str());
+    if (m_api->ReqUserLogin(&req, ++m_nextRequestId) != 0) {
+        LOG("[压测] 会话 {} 发送登录请求失败", m_index);
+    }
+}
+
+void LoadSession::OnFrontDisconnected(int nReason) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    LOG("[压测] 会话 {} 连接断开, 原因码: {}", m_index, nReason);
+}
+
+void LoadSession::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                                 int, bool) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (IsError(pRspInfo) || !pRspUserLogin) {
+        LOG("[压测] 会话 {} 登录失败, ErrorID: {}", m_index, (pRspInfo ? pRspInfo->ErrorID : -1));
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        m_failed = true;
+        m_readyCond.notify_all();
+        return;
+    }
+    m_frontId = pRspUserLogin->FrontID;
+    m_sessionId = pRspUserLogin->SessionID;
+    m_maxOrderRef = atoi(pRspUserLogin->MaxOrderRef);
+    // 发送线程尚未启动, 报单引用从最大引用之后开始
+    m_nextRef = m_maxOrderRef + 1;
+
+    CThostFtdcSettlementInfoConfirmField req;
+    memset(&req, 0, sizeof(req));
+    CopyField(req.BrokerID, m_options.brokerId.c_str());
+    CopyField(req.InvestorID, m_userId.c_str());
+    m_api->ReqSettlementInfoConfirm(&req, ++m_nextRequestId);
+}
+
+void LoadSession::OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *, CThostFtdcRspInfoField *pRspInfo,
+                                             int, bool) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_readyMutex);
+    if (IsError(pRspInfo)) {
+        LOG("[压测] 会话 {} 结算确认失败, ErrorID: {}", m_index, pRspInfo->ErrorID);
+        m_failed = true;
+    } else {
+        m_ready = true;
+    }
+    m_readyCond.notify_all();
+}
+
+void LoadSession::OnRspQryTradingAccount(CThostFtdcTradingAccountField *, CThostFtdcRspInfoField *,
+                                         int nRequestID, bool bIsLast) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!bIsLast) {
+        return;
+    }
+    const int64_t sendNs =
+        m_querySendNs[static_cast<size_t>(nRequestID) & (kQuerySlots - 1)].exchange(0, std::memory_order_relaxed);
+    if (sendNs != 0) {
+        m_queryLatency.Record(MonotonicNs() - sendNs);
+        Complete();
+    }
+}
+
+void LoadSession::OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *, CThostFtdcRspInfoField *,
+                                           int nRequestID, bool bIsLast) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!bIsLast) {
+        return;
+    }
+    const int64_t sendNs =
+        m_querySendNs[static_cast<size_t>(nRequestID) & (kQuerySlots - 1)].exchange(0, std::memory_order_relaxed);
+    if (sendNs != 0) {
+        m_queryLatency.Record(MonotonicNs() - sendNs);
+        Complete();
+    }
+}
+
+void LoadSession::OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *, int, bool) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!pInputOrder) {
+        return;
+    }
+    const int ref = atoi(pInputOrder->OrderRef);
+    OrderSlot& slot = m_orderSlots[static_cast<size_t>(ref) & (kOrderSlots - 1)];
+    if (slot.ref.load(std::memory_order_relaxed) != ref) {
+        return;
+    }
+    slot.finished.store(true, std::memory_order_relaxed);
+    if (!slot.acked.exchange(true, std::memory_order_relaxed)) {
+        m_orderRejects.store(m_orderRejects.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        Complete();
+    }
+}
+
+void LoadSession::OnRspOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction, CThostFtdcRspInfoField *,
+                                   int, bool) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!pInputOrderAction) {
+        return;
+    }
+    const int ref = atoi(pInputOrderAction->OrderRef);
+    OrderSlot& slot = m_orderSlots[static_cast<size_t>(ref) & (kOrderSlots - 1)];
+    if (slot.ref.load(std::memory_order_relaxed) == ref &&
+        slot.cancelNs.exchange(0, std::memory_order_relaxed) != 0) {
+        m_cancelRejects.store(m_cancelRejects.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        Complete();
+    }
+}
+
+void LoadSession::OnRspError(CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    LOG("[压测] 会话 {} 错误应答, RequestID: {}, ErrorID: {}", m_index, nRequestID,
+        (pRspInfo ? pRspInfo->ErrorID : 0));
+}
+
+void LoadSession::OnRtnOrder(CThostFtdcOrderField *pOrder) {
+    const int64_t now = MonotonicNs();
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_rtnOrders.store(m_rtnOrders.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!pOrder || pOrder->FrontID != m_frontId || pOrder->SessionID != m_sessionId) {
+        return;
+    }
+    const int ref = atoi(pOrder->OrderRef);
+    OrderSlot& slot = m_orderSlots[static_cast<size_t>(ref) & (kOrderSlots - 1)];
+    if (slot.ref.load(std::memory_order_relaxed) != ref) {
+        return;
+    }
+    if (!slot.acked.exchange(true, std::memory_order_relaxed)) {
+        m_orderLatency.Record(now - slot.sendNs.load(std::memory_order_relaxed));
+        Complete();
+    }
+    // 终结状态的报单从撤单环中剔除, 发送线程出环时跳过
+    const char status = pOrder->OrderStatus;
+    if (status == THOST_FTDC_OST_AllTraded || status == THOST_FTDC_OST_Canceled ||
+        status == THOST_FTDC_OST_PartTradedNotQueueing || status == THOST_FTDC_OST_NoTradeNotQueueing) {
+        slot.finished.store(true, std::memory_order_relaxed);
+    }
+    if (status == THOST_FTDC_OST_Canceled) {
+        const int64_t cancelNs = slot.cancelNs.exchange(0, std::memory_order_relaxed);
+        if (cancelNs != 0) {
+            m_cancelLatency.Record(now - cancelNs);
+            Complete();
+        }
+    }
+}
+
+void LoadSession::OnRtnTrade(CThostFtdcTradeField *) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_rtnTrades.store(m_rtnTrades.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LoadSession::OnErrRtnOrderInsert(CThostFtdcInputOrderField *, CThostFtdcRspInfoField *) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LoadSession::OnErrRtnOrderAction(CThostFtdcOrderActionField *, CThostFtdcRspInfoField *) {
+    m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
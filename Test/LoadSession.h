@@ -0,0 +1,226 @@
+///
+/// @file LoadSession.h
+/// @brief 压测会话: 一个交易API实例按配置的报单/撤单/查询比例持续发送请求并统计延迟
+///
+
+#ifndef CTP_TEST_LOAD_SESSION_H
+#define CTP_TEST_LOAD_SESSION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "ThostFtdcTraderApi.h"
+#include "LatencyHistogram.h"
+
+///
+/// @brief 压测参数, 所有会话共用
+///
+struct LoadOptions {
+    std::string frontAddr;
+    std::string brokerId;
+    std::string userPrefix;     ///< 第 i 个会话的用户名为 <userPrefix><i>, 各会话各自一个资金账户
+    std::string flowRoot;       ///< 第 i 个会话的流文件目录为 <flowRoot><i>/
+    std::string instrumentId;
+    std::string exchangeId;
+    double midPrice;            ///< 报单价格在 midPrice 上下 priceSpread 个最小变动价位内随机
+    double priceTick;
+    int priceSpread;
+    double ratePerSession;      ///< 每个会话每秒发送的请求数, 0为不限
+    int window;                 ///< 每个会话未完成的请求数上限, 不超过 LoadSession::kMaxWindow
+    int orderWeight;            ///< 报单、撤单、查询的比例
+    int cancelWeight;
+    int queryWeight;
+
+    LoadOptions()
+        : frontAddr("tcp://127.0.0.1:0"), brokerId("9999"), userPrefix("load"), flowRoot("./flow/load/"),
+          instrumentId("rb2701"), exchangeId("SHFE"), midPrice(3500.0), priceTick(1.0), priceSpread(5),
+          ratePerSession(0.0), window(64), orderWeight(70), cancelWeight(25), queryWeight(5) {}
+};
+
+///
+/// @brief 一个会话的压测结果
+///
+struct LoadSessionReport {
+    uint64_t orders;            ///< 发出的报单
+    uint64_t cancels;           ///< 发出的撤单
+    uint64_t queries;           ///< 发出的查询
+    uint64_t throttled;         ///< Req* 返回-2/-3被流控的请求
+    uint64_t orderRejects;      ///< 被拒的报单
+    uint64_t cancelRejects;     ///< 被拒的撤单(报单已成交或已撤)
+    uint64_t rtnOrders;
+    uint64_t rtnTrades;
+    uint64_t callbacks;         ///< 全部回调数
+    LatencySummary orderLatency;    ///< ReqOrderInsert 到第一个 OnRtnOrder
+    LatencySummary cancelLatency;   ///< ReqOrderAction 到已撤单的 OnRtnOrder
+    LatencySummary queryLatency;    ///< ReqQry* 到 bIsLast 的应答
+    int64_t wallNs;             ///< 压测时长
+    int64_t driverCpuNs;        ///< 发送线程CPU时间
+    int64_t callbackCpuNs;      ///< API回调线程CPU时间
+};
+
+///
+/// @brief 压测会话
+///
+/// 每个会话创建自己的 CThostFtdcTraderApi, 流文件放在独立目录中, 连接后登录并确认结算单。
+/// Run() 启动发送线程, 按权重随机选择报单、撤单或查询, 未完成的请求达到 window 时等待应答,
+/// 配置了速率时按固定间隔发送。报单为 GFD 限价开仓单, 价格在中间价附近随机, 与其他会话的
+/// 报单互相成交; 撤单按发出顺序撤最早的报单, 已成交的报单撤单被拒也计入完成。
+///
+/// 请求的发出时刻由发送线程写入, 回调线程在应答到达时读取并记入直方图; 两者之间经API
+/// 内部队列同步。CPU时间按线程分别统计: 发送线程用 CLOCK_THREAD_CPUTIME_ID,
+/// 回调线程在第一次回调时取得它的CPU时钟。
+///
+class LoadSession : public CThostFtdcTraderSpi {
+public:
+    LoadSession(int index, const LoadOptions& options);
+    ~LoadSession();
+
+    LoadSession(const LoadSession&) = delete;
+    LoadSession& operator=(const LoadSession&) = delete;
+
+    /// 创建流文件目录和API并连接
+    bool Connect();
+
+    /// 等待登录和结算确认完成, 失败或超时返回false
+    bool WaitReady(int timeoutMs);
+
+    /// 启动发送线程, 到 endNs(单调时钟)时停止发送
+    void Run(int64_t endNs);
+
+    /// 等待发送线程结束, 再等待未完成的请求应答, 最多 drainTimeoutMs
+    void Join(int drainTimeoutMs);
+
+    /// 压测结果, Join() 之后调用
+    LoadSessionReport Report() const;
+
+    /// 释放API
+    void Close();
+
+    int Index() const { return m_index; }
+
+    /// 未完成请求数上限的最大值, 保证报单在未完成期间其状态槽位不被新报单复用
+    static const int kMaxWindow = 1 << 14;
+
+    virtual void OnFrontConnected() override;
+    virtual void OnFrontDisconnected(int nReason) override;
+    virtual void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                                int nRequestID, bool bIsLast) override;
+    virtual void OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                            CThostFtdcRspInfoField *pRspInfo, int nRequestID,
+                                            bool bIsLast) override;
+    virtual void OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTradingAccount,
+                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
+    virtual void OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *pInvestorPosition,
+                                          CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
+    virtual void OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo,
+                                  int nRequestID, bool bIsLast) override;
+    virtual void OnRspOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction,
+                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
+    virtual void OnRspError(CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
+    virtual void OnRtnOrder(CThostFtdcOrderField *pOrder) override;
+    virtual void OnRtnTrade(CThostFtdcTradeField *pTrade) override;
+    virtual void OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder,
+                                     CThostFtdcRspInfoField *pRspInfo) override;
+    virtual void OnErrRtnOrderAction(CThostFtdcOrderActionField *pOrderAction,
+                                     CThostFtdcRspInfoField *pRspInfo) override;
+
+private:
+    /// 报单状态槽位数, 以 OrderRef 低位索引
+    static const size_t kOrderSlots = 1 << 16;
+
+    /// 查询发出时刻的槽位数, 以 RequestID 低位索引
+    static const size_t kQuerySlots = 1 << 10;
+
+    /// 待撤报单环的容量; 取槽位数的一半, 被撤的报单之后至少还要发出这么多笔报单才会复用它的槽位
+    static const size_t kCancelSlots = kOrderSlots / 2;
+
+    /// 一笔报单的发出和撤单时刻; 槽位被新报单复用时 ref 随之改变, 旧报单的回调被忽略
+    struct OrderSlot {
+        std::atomic<int> ref;
+        std::atomic<int64_t> sendNs;
+        std::atomic<int64_t> cancelNs;  ///< 0 表示没有未完成的撤单
+        std::atomic<bool> acked;
+        std::atomic<bool> finished;     ///< 已全部成交、已撤或被拒, 不再撤单
+    };
+
+    /// 发送线程主循环
+    void DriveLoop(int64_t endNs);
+
+    /// 以下由发送线程调用, 返回 Req* 的返回值
+    int SendOrder();
+    int SendCancel(int ref);
+    int SendQuery();
+
+    /// 一个请求完成, 释放窗口
+    void Complete() { m_inFlight.fetch_sub(1, std::memory_order_release); }
+
+    /// 当前线程CPU时间
+    static int64_t ThreadCpuNs();
+
+    /// 回调线程CPU时间, 尚未回调时为0
+    int64_t CallbackCpuNs() const;
+
+    /// xorshift 随机数, 仅发送线程使用
+    uint32_t NextRandom();
+
+    const int m_index;
+    const LoadOptions m_options;
+    std::string m_userId;
+    std::string m_flowPath;
+    CThostFtdcTraderApi* m_api;
+
+    // 登录结果, 由回调线程写入
+    std::mutex m_readyMutex;
+    std::condition_variable m_readyCond;
+    bool m_ready;
+    bool m_failed;
+    int m_frontId;
+    int m_sessionId;
+    int m_maxOrderRef;
+
+    // 回调线程的CPU时钟
+    std::atomic<bool> m_callbackClockValid;
+    clockid_t m_callbackClock;
+
+    // 发送线程
+    std::thread m_driver;
+    std::atomic<int> m_inFlight;
+    int m_nextRef;
+    int m_nextRequestId;
+    uint32_t m_random;
+    std::vector<int> m_cancelRing;  ///< 已发出、尚未撤单的报单, 按发出顺序; 已终结的在出环时跳过
+    size_t m_cancelHead;
+    size_t m_cancelCount;
+    int64_t m_startNs;
+    int64_t m_stopNs;
+    int64_t m_driverCpuNs;
+    int64_t m_callbackCpuStartNs;
+    int64_t m_callbackCpuNs;
+
+    std::unique_ptr<OrderSlot[]> m_orderSlots;
+    std::unique_ptr<std::atomic<int64_t>[]> m_querySendNs;
+
+    // 计数, 发送线程写的和回调线程写的分开
+    std::atomic<uint64_t> m_orders;
+    std::atomic<uint64_t> m_cancels;
+    std::atomic<uint64_t> m_queries;
+    std::atomic<uint64_t> m_throttled;
+    std::atomic<uint64_t> m_orderRejects;
+    std::atomic<uint64_t> m_cancelRejects;
+    std::atomic<uint64_t> m_rtnOrders;
+    std::atomic<uint64_t> m_rtnTrades;
+    std::atomic<uint64_t> m_callbacks;
+
+    LatencyHistogram m_orderLatency;
+    LatencyHistogram m_cancelLatency;
+    LatencyHistogram m_queryLatency;
+};
+
+#endif // CTP_TEST_LOAD_SESSION_H
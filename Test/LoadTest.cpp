@@ -0,0 +1,284 @@
+///
+/// @file LoadTest.cpp
+/// @brief 多会话压测程序: 多个交易API实例同时向本地模拟前置发送报单、撤单和查询
+///
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+#include "LoadSession.h"
+#include "SimFront.h"
+
+namespace {
+
+// 登录和结算确认的最长等待时间
+const int kReadyTimeoutMs = 10000;
+
+// 停止发送后等待未完成请求应答的最长时间
+const int kDrainTimeoutMs = 2000;
+
+// 会话数上限, 与模拟前置的会话数上限一致
+const int kMaxLoadSessions = 1024;
+
+int64_t TimevalNs(const struct timeval& tv) {
+    return static_cast<int64_t>(tv.tv_sec) * 1000000000LL + static_cast<int64_t>(tv.tv_usec) * 1000;
+}
+
+/// 进程累计CPU时间(用户态+内核态)
+int64_t ProcessCpuNs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return TimevalNs(usage.ru_utime) + TimevalNs(usage.ru_stime);
+}
+
+/// 每秒次数
+double PerSecond(uint64_t count, int64_t ns) {
+    return ns > 0 ? static_cast<double>(count) * 1e9 / static_cast<double>(ns) : 0.0;
+}
+
+/// CPU占用百分比
+double CpuPercent(int64_t cpuNs, int64_t wallNs) {
+    return wallNs > 0 ? static_cast<double>(cpuNs) * 100.0 / static_cast<double>(wallNs) : 0.0;
+}
+
+/// 解析 "报单:撤单:查询" 比例
+bool ParseMix(const std::string& text, LoadOptions& options) {
+    int order = 0;
+    int cancel = 0;
+    int query = 0;
+    char tail = 0;
+    if (sscanf(text.c_str(), "%d:%d:%d%c", &order, &cancel, &query, &tail) != 3) {
+        return false;
+    }
+    if (order < 0 || cancel < 0 || query < 0 || order + cancel + query == 0) {
+        return false;
+    }
+    options.orderWeight = order;
+    options.cancelWeight = cancel;
+    options.queryWeight = query;
+    return true;
+}
+
+void LogSummary(int index, const char* name, const LatencySummary& s) {
+    if (s.count == 0) {
+        return;
+    }
+    LOG("[压测] 会话 {} 延迟 {} | 样本: {}, 平均: {}ns, p50: {}ns, p90: {}ns, p99: {}ns, p99.9: {}ns, 最大: {}ns",
+        index, name, s.count, s.mean, s.p50, s.p90, s.p99, s.p999, s.max);
+}
+
+void PrintUsage(const char* programName) {
+    std::cout << "使用方法: " << programName << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -n <数量>  会话数 (默认: 4)" << std::endl;
+    std::cout << "  -d <秒>    压测时长 (默认: 10)" << std::endl;
+    std::cout << "  -r <次数>  每个会话每秒请求数, 0为不限 (默认: 0)" << std::endl;
+    std::cout << "  -w <数量>  每个会话未完成的请求数上限, 最大 16384 (默认: 64)" << std::endl;
+    std::cout << "  -x <比例>  报单:撤单:查询 (默认: 70:25:5)" << std::endl;
+    std::cout << "  -q <次数>  模拟前置每个会话每秒允许的查询数, 0为不限 (默认: 0)" << std::endl;
+    std::cout << "  -i <合约>  报单合约 (默认: rb2701)" << std::endl;
+    std::cout << "  -e <交易所> 交易所 (默认: SHFE)" << std::endl;
+    std::cout << "  -P <价格>  报单中间价 (默认: 3500)" << std::endl;
+    std::cout << "  -T <价位>  最小变动价位 (默认: 1)" << std::endl;
+    std::cout << "  -S <价位数> 报单价在中间价上下的价位数 (默认: 5)" << std::endl;
+    std::cout << "  -F <目录>  流文件根目录, 每个会话一个子目录 (默认: ./flow/load/)" << std::endl;
+    std::cout << "  -f <地址>  前置地址 (默认: tcp://127.0.0.1:0)" << std::endl;
+    std::cout << "  -b <经纪商> 经纪公司代码 (默认: 9999)" << std::endl;
+    std::cout << "  -u <前缀>  用户名前缀, 第 i 个会话为 <前缀>i (默认: load)" << std::endl;
+    std::cout << "  -h          显示帮助信息" << std::endl;
+    std::cout << "\n示例:" << std::endl;
+    std::cout << "  " << programName << " -n 8 -d 30 -x 60:35:5 -w 32" << std::endl;
+}
+
+} // namespace
+
+///
+/// @brief 主函数
+///
+int main(int argc, char* argv[]) {
+    if (!AsyncLogger::Instance().Start("ctp_load_test.log")) {
+        std::cout << "[警告] 无法打开日志文件 ctp_load_test.log, 日志仅输出到控制台" << std::endl;
+    }
+
+    LoadOptions options;
+    SimFrontOptions frontOptions;
+    frontOptions.queriesPerSecond = 0.0;
+    int sessionCount = 4;
+    int durationSec = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:r:w:x:q:i:e:P:T:S:F:f:b:u:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                sessionCount = atoi(optarg);
+                break;
+            case 'd':
+                durationSec = atoi(optarg);
+                break;
+            case 'r':
+                options.ratePerSession = atof(optarg);
+                break;
+            case 'w':
+                options.window = atoi(optarg);
+                break;
+            case 'x':
+                if (!ParseMix(optarg, options)) {
+                    LOG("[错误] 无效的请求比例: {}", optarg);
+                    AsyncLogger::Instance().Stop();
+                    PrintUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'q':
+                frontOptions.queriesPerSecond = atof(optarg);
+                break;
+            case 'i':
+                options.instrumentId = optarg;
+                break;
+            case 'e':
+                options.exchangeId = optarg;
+                break;
+            case 'P':
+                options.midPrice = atof(optarg);
+                break;
+            case 'T':
+                options.priceTick = atof(optarg);
+                break;
+            case 'S':
+                options.priceSpread = atoi(optarg);
+                break;
+            case 'F':
+                options.flowRoot = optarg;
+                if (!options.flowRoot.empty() && options.flowRoot.back() != '/') {
+                    options.flowRoot += '/';
+                }
+                break;
+            case 'f':
+                options.frontAddr = optarg;
+                break;
+            case 'b':
+                options.brokerId = optarg;
+                break;
+            case 'u':
+                options.userPrefix = optarg;
+                break;
+            case 'h':
+                AsyncLogger::Instance().Stop();
+                PrintUsage(argv[0]);
+                return 0;
+            default:
+                AsyncLogger::Instance().Stop();
+                PrintUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (sessionCount < 1 || sessionCount > kMaxLoadSessions || durationSec < 1 || options.window < 1 ||
+        options.window > LoadSession::kMaxWindow || options.priceSpread < 0 || options.priceTick <= 0.0) {
+        LOG("[错误] 参数无效: 会话数 1-{}, 时长至少为1, 窗口 1-{}, 价位须为正", kMaxLoadSessions,
+            LoadSession::kMaxWindow);
+        AsyncLogger::Instance().Stop();
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    LOG("[配置] 会话: {}, 时长: {}s, 每会话速率: {}/s, 窗口: {}, 比例 {}:{}:{}, 合约: {}.{}", sessionCount,
+        durationSec, options.ratePerSession, options.window, options.orderWeight, options.cancelWeight,
+        options.queryWeight, options.instrumentId, options.exchangeId);
+
+    SimFront::Instance().Configure(frontOptions);
+
+    // 连接并等待全部会话就绪
+    std::vector<std::unique_ptr<LoadSession>> sessions;
+    sessions.reserve(static_cast<size_t>(sessionCount));
+    for (int i = 0; i < sessionCount; ++i) {
+        sessions.emplace_back(new LoadSession(i, options));
+        if (!sessions.back()->Connect()) {
+            LOG("[错误] 会话 {} 创建API失败", i);
+            AsyncLogger::Instance().Stop();
+            return 1;
+        }
+    }
+    for (auto& session : sessions) {
+        if (!session->WaitReady(kReadyTimeoutMs)) {
+            LOG("[错误] 会话 {} 登录失败或超时", session->Index());
+            for (auto& s : sessions) {
+                s->Close();
+            }
+            SimFront::Instance().Stop();
+            AsyncLogger::Instance().Stop();
+            return 1;
+        }
+    }
+    LOG("[压测] {} 个会话已就绪, 开始发送", sessionCount);
+
+    const SimFrontStats frontBefore = SimFront::Instance().GetStats();
+    const int64_t cpuBeforeNs = ProcessCpuNs();
+    const int64_t startNs = MonotonicNs();
+    const int64_t endNs = startNs + static_cast<int64_t>(durationSec) * 1000000000LL;
+    for (auto& session : sessions) {
+        session->Run(endNs);
+    }
+    for (auto& session : sessions) {
+        session->Join(kDrainTimeoutMs);
+    }
+    const int64_t wallNs = MonotonicNs() - startNs;
+    const int64_t processCpuNs = ProcessCpuNs() - cpuBeforeNs;
+    const SimFrontStats frontAfter = SimFront::Instance().GetStats();
+
+    // 各会话结果
+    uint64_t totalRequests = 0;
+    uint64_t totalCallbacks = 0;
+    uint64_t totalThrottled = 0;
+    int64_t sessionCpuNs = 0;
+    for (auto& session : sessions) {
+        const LoadSessionReport r = session->Report();
+        const uint64_t requests = r.orders + r.cancels + r.queries;
+        totalRequests += requests;
+        totalCallbacks += r.callbacks;
+        totalThrottled += r.throttled;
+        sessionCpuNs += r.driverCpuNs + r.callbackCpuNs;
+        LOG("[压测] 会话 {} | 报单: {}, 撤单: {}, 查询: {}, 流控: {}, 报单被拒: {}, 撤单被拒: {}, 报单回报: {}, "
+            "成交回报: {}",
+            session->Index(), r.orders, r.cancels, r.queries, r.throttled, r.orderRejects, r.cancelRejects,
+            r.rtnOrders, r.rtnTrades);
+        LOG("[压测] 会话 {} | 请求: {}/s, 回调: {}/s, 发送线程CPU: {}%, 回调线程CPU: {}%", session->Index(),
+            static_cast<uint64_t>(PerSecond(requests, r.wallNs)), static_cast<uint64_t>(PerSecond(r.callbacks, r.wallNs)),
+            CpuPercent(r.driverCpuNs, r.wallNs), CpuPercent(r.callbackCpuNs, r.wallNs));
+        LogSummary(session->Index(), "报单", r.orderLatency);
+        LogSummary(session->Index(), "撤单", r.cancelLatency);
+        LogSummary(session->Index(), "查询", r.queryLatency);
+    }
+
+    // 合计
+    LOG("[压测] 合计 | 会话: {}, 用时: {}ms, 请求: {} ({}/s), 回调: {} ({}/s), 流控: {}", sessionCount,
+        wallNs / 1000000, totalRequests, static_cast<uint64_t>(PerSecond(totalRequests, wallNs)), totalCallbacks,
+        static_cast<uint64_t>(PerSecond(totalCallbacks, wallNs)), totalThrottled);
+    LOG("[压测] 合计 | 进程CPU: {}%, 其中会话线程: {}%, 前置及其他线程: {}%", CpuPercent(processCpuNs, wallNs),
+        CpuPercent(sessionCpuNs, wallNs), CpuPercent(processCpuNs - sessionCpuNs, wallNs));
+    LOG("[压测] 前置 | 请求: {}, 报单: {}, 报单被拒: {}, 撤单: {}, 成交: {}, 回调: {}, 回调队列满等待: {}",
+        frontAfter.requests - frontBefore.requests, frontAfter.orders - frontBefore.orders,
+        frontAfter.orderRejects - frontBefore.orderRejects, frontAfter.cancels - frontBefore.cancels,
+        frontAfter.trades - frontBefore.trades, frontAfter.responses - frontBefore.responses,
+        frontAfter.responseQueueFullSpins - frontBefore.responseQueueFullSpins);
+    if (frontAfter.faults != frontBefore.faults) {
+        LOG("[压测] 前置 | 注入故障: {}, 推迟或重排的回调: {}", frontAfter.faults - frontBefore.faults,
+            frontAfter.heldResponses - frontBefore.heldResponses);
+    }
+
+    for (auto& session : sessions) {
+        session->Close();
+    }
+    SimFront::Instance().Stop();
+    LOG("[完成] 压测结束");
+    AsyncLogger::Instance().Stop();
+    return 0;
+}
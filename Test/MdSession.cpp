@@ -0,0 +1,245 @@
+///
+/// @file MdSession.cpp
+/// @brief CTP行情会话实现
+///
+
+#include "MdSession.h"
+
+#include <cstring>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+
+namespace {
+
+// 每次 SubscribeMarketData 调用订阅的合约数
+const int kSubscribeBatchSize = 200;
+
+} // namespace
+
+MdSession::MdSession(CThostFtdcMdApi* api, SymbolTable& symbols, size_t queueCapacity)
+    : m_api(api), m_symbols(symbols), m_loggedIn(false), m_requestId(0), m_journal(nullptr),
+      m_queue(queueCapacity), m_stopping(false),
+      m_ticks(0), m_dropped(0), m_queueFullSpins(0), m_maxQueueDelayNs(0) {}
+
+MdSession::~MdSession() {
+    Stop();
+}
+
+void MdSession::SetLoginInfo(const std::string& frontAddr,
+                             const std::string& brokerId,
+                             const std::string& userId,
+                             const std::string& password) {
+    m_frontAddr = frontAddr;
+    m_brokerId = brokerId;
+    m_userId = userId;
+    m_password = password;
+}
+
+void MdSession::SetInstruments(const std::vector<std::string>& instruments) {
+    m_instruments = instruments;
+}
+
+void MdSession::SetTickHandler(const TickHandler& handler) {
+    m_handler = handler;
+}
+
+void MdSession::SetTickJournal(TickJournal* journal) {
+    m_journal = journal;
+}
+
+std::vector<std::string> MdSession::ParseInstrumentList(const std::string& list) {
+    std::vector<std::string> result;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string item = list.substr(begin, end - begin);
+        const size_t first = item.find_first_not_of(" \t");
+        if (first != std::string::npos) {
+            result.push_back(item.substr(first, item.find_last_not_of(" \t") - first + 1));
+        }
+        begin = end + 1;
+    }
+    return result;
+}
+
+void MdSession::Start() {
+    if (m_dispatchThread.joinable()) {
+        return;
+    }
+    m_stopping.store(false);
+    m_dispatchThread = std::thread(&MdSession::DispatchLoop, this);
+
+    m_api->RegisterSpi(this);
+    m_api->RegisterFront(const_cast<char*>(m_frontAddr.c_str()));
+    m_api->Init();
+}
+
+void MdSession::Stop() {
+    if (!m_dispatchThread.joinable()) {
+        return;
+    }
+    m_waiter.Signal([this] { m_stopping.store(true); });
+    m_dispatchThread.join();
+}
+
+MdSessionStats MdSession::GetStats() const {
+    MdSessionStats stats;
+    stats.ticks = m_ticks.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.queueFullSpins = m_queueFullSpins.load(std::memory_order_relaxed);
+    stats.maxQueueDelayNs = m_maxQueueDelayNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ---------------------------------------------------------------------------
+// CTP回调线程
+// ---------------------------------------------------------------------------
+
+void MdSession::OnFrontConnected() {
+    LOG("[行情] 成功连接到行情服务器");
+    ReqUserLogin();
+}
+
+void MdSession::OnFrontDisconnected(int nReason) {
+    LOG("[行情] 与行情服务器断开连接, 原因码: {}", nReason);
+    m_loggedIn.store(false);
+}
+
+void MdSession::OnHeartBeatWarning(int nTimeLapse) {
+    LOG("[警告] 行情心跳超时, 距离上次接收时间: {}秒", nTimeLapse);
+}
+
+void MdSession::OnRspUserLogin(CThostFtdcRspUserLoginField* pRspUserLogin,
+                               CThostFtdcRspInfoField* pRspInfo,
+                               int /*nRequestID*/, bool /*bIsLast*/) {
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 行情登录失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+        return;
+    }
+    LOG("[行情] 登录成功, 交易日: {}", (pRspUserLogin ? pRspUserLogin->TradingDay : ""));
+    if (m_journal && pRspUserLogin && !m_journal->Open(pRspUserLogin->TradingDay)) {
+        LOG("[错误] 打开行情日志失败, 本交易日行情不落盘");
+    }
+    m_loggedIn.store(true);
+    SubscribeAll();
+}
+
+void MdSession::OnRspSubMarketData(CThostFtdcSpecificInstrumentField* pSpecificInstrument,
+                                   CThostFtdcRspInfoField* pRspInfo,
+                                   int /*nRequestID*/, bool /*bIsLast*/) {
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 订阅行情失败, 合约: {}, ErrorID: {}, ErrorMsg: {}",
+            (pSpecificInstrument ? pSpecificInstrument->InstrumentID : ""), pRspInfo->ErrorID,
+            pRspInfo->ErrorMsg);
+    }
+}
+
+void MdSession::OnRspError(CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool /*bIsLast*/) {
+    LOG("[错误] 行情错误响应, RequestID: {}, ErrorID: {}, ErrorMsg: {}", nRequestID,
+        (pRspInfo ? pRspInfo->ErrorID : 0), (pRspInfo ? pRspInfo->ErrorMsg : ""));
+}
+
+void MdSession::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* pDepthMarketData) {
+    const int64_t recvNs = MonotonicNs();
+    if (!pDepthMarketData || m_stopping.load(std::memory_order_acquire)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (m_journal) {
+        m_journal->Append(recvNs, *pDepthMarketData);
+    }
+    const uint32_t symbolId = m_symbols.Intern(pDepthMarketData->InstrumentID);
+    if (symbolId == kInvalidSymbol) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    MdTick* tick;
+    while ((tick = m_queue.Claim()) == nullptr) {
+        if (m_stopping.load(std::memory_order_acquire)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_queueFullSpins.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+    tick->symbolId = symbolId;
+    tick->recvNs = recvNs;
+    tick->data = *pDepthMarketData;
+    m_queue.Publish();
+    m_ticks.store(m_ticks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    m_waiter.Notify();
+}
+
+void MdSession::ReqUserLogin() {
+    CThostFtdcReqUserLoginField req;
+    memset(&req, 0, sizeof(req));
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
+    strncpy(req.Password, m_password.c_str(), sizeof(req.Password) - 1);
+
+    const int requestId = m_requestId.fetch_add(1) + 1;
+    int result = m_api->ReqUserLogin(&req, requestId);
+    if (result == 0) {
+        LOG("[请求] 发送行情登录请求, RequestID: {}", requestId);
+    } else {
+        LOG("[错误] 发送行情登录请求失败, 返回码: {}", result);
+    }
+}
+
+void MdSession::SubscribeAll() {
+    std::vector<char*> ids;
+    ids.reserve(kSubscribeBatchSize);
+    int subscribed = 0;
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        ids.push_back(const_cast<char*>(m_instruments[i].c_str()));
+        if (ids.size() == static_cast<size_t>(kSubscribeBatchSize) || i + 1 == m_instruments.size()) {
+            const int count = static_cast<int>(ids.size());
+            int result = m_api->SubscribeMarketData(&ids[0], count);
+            if (result == 0) {
+                subscribed += count;
+            } else {
+                LOG("[错误] 订阅行情失败, 返回码: {}, 本批 {} 个合约", result, count);
+            }
+            ids.clear();
+        }
+    }
+    LOG("[行情] 已发送订阅请求, 合约 {} 个", subscribed);
+}
+
+// ---------------------------------------------------------------------------
+// 处理线程
+// ---------------------------------------------------------------------------
+
+void MdSession::DispatchLoop() {
+    while (true) {
+        MdTick* tick = m_queue.Front();
+        if (tick) {
+            const int64_t delayNs = MonotonicNs() - tick->recvNs;
+            if (delayNs > m_maxQueueDelayNs.load(std::memory_order_relaxed)) {
+                m_maxQueueDelayNs.store(delayNs, std::memory_order_relaxed);
+            }
+            if (m_handler) {
+                m_handler(*tick);
+            }
+            m_queue.Pop();
+            m_waiter.Busy();
+            continue;
+        }
+
+        if (m_stopping.load(std::memory_order_acquire)) {
+            if (m_queue.Empty()) {
+                break;
+            }
+            continue;
+        }
+
+        m_waiter.Idle([this] { return !m_queue.Empty() || m_stopping.load(std::memory_order_relaxed); });
+    }
+}
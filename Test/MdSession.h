@@ -0,0 +1,142 @@
+///
+/// @file MdSession.h
+/// @brief CTP行情会话: 登录、批量订阅和深度行情接收
+///
+
+#ifndef CTP_TEST_MD_SESSION_H
+#define CTP_TEST_MD_SESSION_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThostFtdcMdApi.h"
+#include "ConsumerWaiter.h"
+#include "SpscQueue.h"
+#include "SymbolTable.h"
+#include "TickJournal.h"
+
+///
+/// @brief 一条深度行情
+///
+struct MdTick {
+    uint32_t symbolId;          ///< SymbolTable 编号
+    int64_t recvNs;             ///< 回调到达时刻(单调时钟)
+    CThostFtdcDepthMarketDataField data;
+};
+
+///
+/// @brief 行情会话统计
+///
+struct MdSessionStats {
+    uint64_t ticks;             ///< 收到的行情数
+    uint64_t dropped;           ///< 停止后或合约编号表已满时丢弃的行情数
+    uint64_t queueFullSpins;    ///< 队列满时回调线程的等待次数
+    int64_t maxQueueDelayNs;    ///< 行情从到达到被处理的最大延迟
+};
+
+///
+/// @brief CTP行情会话
+///
+/// 连接建立后自动登录, 登录成功后按批次订阅配置的合约; 断线重连后重新登录并订阅。
+/// 行情回调线程只查出合约编号并把行情拷贝进环形队列, 由处理线程调用 TickHandler。
+/// 连接、登录和订阅应答很少, 直接在回调线程中处理。
+///
+/// CThostFtdcMdApi 由调用方创建并注入, 可以替换为本地桩实现进行测试;
+/// MdSession 不负责 Release()。
+///
+class MdSession : public CThostFtdcMdSpi {
+public:
+    /// 行情处理函数, 在处理线程中调用
+    typedef std::function<void(const MdTick& tick)> TickHandler;
+
+    /// @param api     行情API, 由调用方创建和释放
+    /// @param symbols 合约编号表, 未见过的合约在收到行情时分配编号
+    MdSession(CThostFtdcMdApi* api, SymbolTable& symbols, size_t queueCapacity = 16384);
+    ~MdSession();
+
+    MdSession(const MdSession&) = delete;
+    MdSession& operator=(const MdSession&) = delete;
+
+    /// 设置登录参数
+    void SetLoginInfo(const std::string& frontAddr,
+                      const std::string& brokerId,
+                      const std::string& userId,
+                      const std::string& password);
+
+    /// 设置订阅的合约
+    void SetInstruments(const std::vector<std::string>& instruments);
+
+    /// 设置行情处理函数, 须在 Start() 之前调用
+    void SetTickHandler(const TickHandler& handler);
+
+    /// 设置行情落盘日志, 须在 Start() 之前调用; 登录后按交易日打开, 在回调线程中写入
+    void SetTickJournal(TickJournal* journal);
+
+    /// 启动处理线程, 注册回调和前置地址并初始化API
+    void Start();
+
+    /// 处理完队列中剩余行情后停止处理线程, 之后到达的行情将被丢弃
+    void Stop();
+
+    /// 是否处于已登录状态
+    bool IsLoggedIn() const { return m_loggedIn.load(); }
+
+    /// 获取统计
+    MdSessionStats GetStats() const;
+
+    /// 把逗号分隔的合约列表拆分为数组, 忽略空项和空白
+    static std::vector<std::string> ParseInstrumentList(const std::string& list);
+
+    virtual void OnFrontConnected() override;
+    virtual void OnFrontDisconnected(int nReason) override;
+    virtual void OnHeartBeatWarning(int nTimeLapse) override;
+    virtual void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin,
+                                CThostFtdcRspInfoField *pRspInfo,
+                                int nRequestID, bool bIsLast) override;
+    virtual void OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                    CThostFtdcRspInfoField *pRspInfo,
+                                    int nRequestID, bool bIsLast) override;
+    virtual void OnRspError(CThostFtdcRspInfoField *pRspInfo,
+                            int nRequestID, bool bIsLast) override;
+    virtual void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData) override;
+
+private:
+    /// 登录请求
+    void ReqUserLogin();
+
+    /// 按批次订阅全部合约
+    void SubscribeAll();
+
+    /// 处理线程主循环
+    void DispatchLoop();
+
+    CThostFtdcMdApi* m_api;
+    SymbolTable& m_symbols;
+    std::atomic<bool> m_loggedIn;
+    std::atomic<int> m_requestId;
+    std::string m_frontAddr;
+    std::string m_brokerId;
+    std::string m_userId;
+    std::string m_password;
+    std::vector<std::string> m_instruments;
+    TickHandler m_handler;
+    TickJournal* m_journal;
+
+    // 回调线程 -> 处理线程
+    SpscQueue<MdTick> m_queue;
+    std::thread m_dispatchThread;
+    std::atomic<bool> m_stopping;
+    ConsumerWaiter m_waiter;
+
+    // 统计
+    std::atomic<uint64_t> m_ticks;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_queueFullSpins;
+    std::atomic<int64_t> m_maxQueueDelayNs;
+};
+
+#endif // CTP_TEST_MD_SESSION_H
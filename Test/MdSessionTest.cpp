@@ -0,0 +1,285 @@
+///
+/// @file MdSessionTest.cpp
+/// @brief MdSession 对行情API桩的检验: 登录、分批订阅、断线重订阅、行情顺序和处理线程唤醒
+///
+/// 用法: ctp_md_session_test [-n 行情数]。测试线程充当CTP行情回调线程, 经 StubMdApi 记录的调用检查
+/// 登录和订阅请求; 行情以很小的队列容量连续推送, 检查处理线程按到达顺序逐笔处理、合约编号正确,
+/// 再逐笔间隔推送, 检查处理线程休眠后能被及时唤醒而不是等到休眠兜底超时。任一项不符时打印原因并返回1。
+///
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+#include "MdSession.h"
+#include "StubMdApi.h"
+#include "SymbolTable.h"
+
+namespace {
+
+const int kDefaultTicks = 200000;
+
+// 订阅合约数, 按 MdSession 每批200个应分3批
+const int kInstrumentCount = 450;
+const int kExpectedBatches[] = {200, 200, 50};
+
+// 推送行情的合约数和队列容量; 容量小到连续推送时回调线程会等待队列
+const int kTickSymbols = 8;
+const size_t kQueueCapacity = 64;
+
+// 唤醒检查: 每轮先等处理线程进入休眠再推送一笔
+const int kWakeRounds = 20;
+const std::chrono::milliseconds kWakeIdle(30);
+// 唤醒延迟中位数上限, 远小于处理线程100毫秒的休眠兜底
+const int64_t kMaxMedianWakeNs = 20000000LL;
+
+// 等待处理线程处理完的最长时间
+const std::chrono::seconds kDrainTimeout(10);
+
+void PrintUsage(const char* programName) {
+    std::cout << "使用方法: " << programName << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -n <行情数>  连续推送的行情数 (默认: " << kDefaultTicks << ")" << std::endl;
+    std::cout << "  -h          显示帮助信息" << std::endl;
+}
+
+///
+/// @brief 检验过程, 测试线程即行情回调线程
+///
+class SessionCheck {
+public:
+    SessionCheck()
+        : m_symbols(256), m_session(&m_api, m_symbols, kQueueCapacity),
+          m_handled(0), m_lastSeq(0), m_outOfOrder(0), m_badSymbol(0), m_lastHandledNs(0) {}
+
+    bool Run(int ticks) {
+        for (int i = 0; i < kInstrumentCount; ++i) {
+            char id[16];
+            snprintf(id, sizeof(id), "rb%04d", 1000 + i);
+            m_instruments.push_back(id);
+        }
+        m_session.SetLoginInfo("tcp://127.0.0.1:0", "9999", "u1", "pw");
+        m_session.SetInstruments(m_instruments);
+        m_session.SetTickHandler([this](const MdTick& tick) { OnTick(tick); });
+        m_session.Start();
+
+        const bool ok = CheckLogin() && CheckBurst(ticks) && CheckWakeup(ticks) && CheckReconnect() &&
+                        CheckStop(ticks);
+        m_session.Stop();
+        return ok;
+    }
+
+private:
+    bool Fail(const std::string& message) {
+        std::cout << "[失败] " << message << std::endl;
+        return false;
+    }
+
+    /// 处理线程
+    void OnTick(const MdTick& tick) {
+        const uint64_t seq = static_cast<uint64_t>(tick.data.Volume);
+        if (seq != m_lastSeq.load(std::memory_order_relaxed) + 1) {
+            m_outOfOrder.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (tick.symbolId != m_symbols.Find(tick.data.InstrumentID)) {
+            m_badSymbol.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_lastSeq.store(seq, std::memory_order_relaxed);
+        m_lastHandledNs.store(MonotonicNs(), std::memory_order_relaxed);
+        m_handled.fetch_add(1, std::memory_order_release);
+    }
+
+    void PushTick(uint64_t seq) {
+        CThostFtdcDepthMarketDataField data;
+        memset(&data, 0, sizeof(data));
+        snprintf(data.InstrumentID, sizeof(data.InstrumentID), "%s",
+                 m_instruments[seq % kTickSymbols].c_str());
+        data.LastPrice = 3000.0 + static_cast<double>(seq % 100);
+        data.Volume = static_cast<int>(seq);
+        m_api.Spi()->OnRtnDepthMarketData(&data);
+    }
+
+    bool WaitHandled(uint64_t count) {
+        const auto deadline = std::chrono::steady_clock::now() + kDrainTimeout;
+        while (m_handled.load(std::memory_order_acquire) < count) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void Login(int errorId) {
+        CThostFtdcRspUserLoginField login;
+        memset(&login, 0, sizeof(login));
+        snprintf(login.TradingDay, sizeof(login.TradingDay), "%s", "20260101");
+        CThostFtdcRspInfoField info;
+        memset(&info, 0, sizeof(info));
+        info.ErrorID = errorId;
+        m_api.Spi()->OnRspUserLogin(&login, &info, 1, true);
+    }
+
+    bool CheckSubscribed() {
+        const std::vector<int>& batches = m_api.SubscribeBatches();
+        if (batches.size() != sizeof(kExpectedBatches) / sizeof(kExpectedBatches[0]) ||
+            !std::equal(batches.begin(), batches.end(), kExpectedBatches)) {
+            return Fail("订阅应分为 200/200/50 三批, 实际 " + std::to_string(batches.size()) + " 批");
+        }
+        if (m_api.Subscribed() != m_instruments) {
+            return Fail("订阅的合约与配置不一致");
+        }
+        return true;
+    }
+
+    bool CheckLogin() {
+        if (m_api.Inits() != 1 || m_api.Spi() != &m_session || m_api.FrontAddress() != "tcp://127.0.0.1:0") {
+            return Fail("Start() 应注册回调和前置地址并调用一次 Init()");
+        }
+        m_api.Spi()->OnFrontConnected();
+        if (m_api.Logins() != 1 || strcmp(m_api.LastLogin().BrokerID, "9999") != 0 ||
+            strcmp(m_api.LastLogin().UserID, "u1") != 0 || strcmp(m_api.LastLogin().Password, "pw") != 0) {
+            return Fail("连接后应以配置的账号发送一次登录请求");
+        }
+        Login(3);
+        if (m_session.IsLoggedIn() || !m_api.Subscribed().empty()) {
+            return Fail("登录失败时不应进入已登录状态或订阅");
+        }
+        Login(0);
+        if (!m_session.IsLoggedIn()) {
+            return Fail("登录成功后应进入已登录状态");
+        }
+        std::cout << "登录和订阅: 通过" << std::endl;
+        return CheckSubscribed();
+    }
+
+    bool CheckBurst(int ticks) {
+        const int64_t start = MonotonicNs();
+        for (int i = 1; i <= ticks; ++i) {
+            PushTick(static_cast<uint64_t>(i));
+        }
+        if (!WaitHandled(static_cast<uint64_t>(ticks))) {
+            return Fail("处理线程未在时限内处理完 " + std::to_string(ticks) + " 笔行情, 已处理 " +
+                        std::to_string(m_handled.load()));
+        }
+        const MdSessionStats stats = m_session.GetStats();
+        std::cout << "连续推送 " << ticks << " 笔: " << (MonotonicNs() - start) / 1000000 << " 毫秒, 队列满等待 "
+                  << stats.queueFullSpins << " 次" << std::endl;
+        if (m_outOfOrder.load() != 0 || m_badSymbol.load() != 0) {
+            return Fail("乱序 " + std::to_string(m_outOfOrder.load()) + " 笔, 合约编号错误 " +
+                        std::to_string(m_badSymbol.load()) + " 笔");
+        }
+        if (stats.ticks != static_cast<uint64_t>(ticks) || stats.dropped != 0) {
+            return Fail("统计的行情数 " + std::to_string(stats.ticks) + ", 丢弃 " + std::to_string(stats.dropped));
+        }
+        return true;
+    }
+
+    bool CheckWakeup(int ticks) {
+        std::vector<int64_t> delays;
+        for (int round = 0; round < kWakeRounds; ++round) {
+            std::this_thread::sleep_for(kWakeIdle);
+            const uint64_t seq = static_cast<uint64_t>(ticks + round + 1);
+            const int64_t pushNs = MonotonicNs();
+            PushTick(seq);
+            if (!WaitHandled(seq)) {
+                return Fail("休眠后推送的行情未被处理");
+            }
+            delays.push_back(m_lastHandledNs.load(std::memory_order_relaxed) - pushNs);
+        }
+        std::sort(delays.begin(), delays.end());
+        const int64_t median = delays[delays.size() / 2];
+        std::cout << "休眠后唤醒延迟: 中位数 " << median / 1000 << " 微秒, 最大 " << delays.back() / 1000
+                  << " 微秒" << std::endl;
+        if (median > kMaxMedianWakeNs) {
+            return Fail("处理线程休眠后未被及时唤醒");
+        }
+        return m_outOfOrder.load() == 0 ? true : Fail("唤醒检查中行情乱序");
+    }
+
+    bool CheckReconnect() {
+        m_api.Spi()->OnFrontDisconnected(0x1001);
+        if (m_session.IsLoggedIn()) {
+            return Fail("断线后应退出已登录状态");
+        }
+        m_api.ClearSubscribed();
+        m_api.Spi()->OnFrontConnected();
+        Login(0);
+        if (m_api.Logins() != 2 || !m_session.IsLoggedIn()) {
+            return Fail("重连后应重新登录");
+        }
+        std::cout << "断线重新登录和订阅: 通过" << std::endl;
+        return CheckSubscribed();
+    }
+
+    bool CheckStop(int ticks) {
+        const uint64_t handled = m_handled.load();
+        m_session.Stop();
+        PushTick(handled + 1);
+        const MdSessionStats stats = m_session.GetStats();
+        if (m_handled.load() != handled || stats.dropped != 1 ||
+            stats.ticks != static_cast<uint64_t>(ticks + kWakeRounds)) {
+            return Fail("停止后到达的行情应被丢弃");
+        }
+        std::cout << "停止: 通过" << std::endl;
+        return true;
+    }
+
+    StubMdApi m_api;
+    SymbolTable m_symbols;
+    MdSession m_session;
+    std::vector<std::string> m_instruments;
+
+    // 由处理线程写入
+    std::atomic<uint64_t> m_handled;
+    std::atomic<uint64_t> m_lastSeq;
+    std::atomic<uint64_t> m_outOfOrder;
+    std::atomic<uint64_t> m_badSymbol;
+    std::atomic<int64_t> m_lastHandledNs;
+};
+
+} // namespace
+
+///
+/// @brief 主函数
+///
+int main(int argc, char* argv[]) {
+    int ticks = kDefaultTicks;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                ticks = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                PrintUsage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (ticks <= 0) {
+        std::cout << "[错误] 无效的行情数" << std::endl;
+        return 1;
+    }
+
+    if (!AsyncLogger::Instance().Start("ctp_md_session_test.log", false)) {
+        std::cout << "[警告] 无法打开日志文件 ctp_md_session_test.log" << std::endl;
+    }
+    bool ok = false;
+    {
+        SessionCheck check;
+        ok = check.Run(ticks);
+    }
+    AsyncLogger::Instance().Stop();
+    return ok ? 0 : 1;
+}
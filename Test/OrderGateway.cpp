@@ -0,0 +1,405 @@
+///
+/// @file OrderGateway.cpp
+/// @brief 报单网关实现
+///
+
+#include "OrderGateway.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+
+namespace {
+
+// m_slots 中没有模板的合约
+const uint32_t kNoTemplate = 0xFFFFFFFFu;
+
+// 批量撤单被CTP流控时的最多发送次数
+const int kCancelMaxAttempts = 5;
+
+// 一次批量撤单最多合并的 交易所+前置+会话 组数, 超出的挂单逐笔撤
+const size_t kMaxBatchGroups = 16;
+
+// 十进制写入 OrderRef, 与 snprintf("%d") 结果相同
+inline void FormatOrderRef(int value, TThostFtdcOrderRefType& out) {
+    char digits[sizeof(TThostFtdcOrderRefType)];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+    unsigned int v = static_cast<unsigned int>(value);
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0 && p != digits);
+    const size_t length = static_cast<size_t>(end - p);
+    memcpy(out, p, length);
+    out[length < sizeof(out) ? length : sizeof(out) - 1] = '\0';
+}
+
+} // namespace
+
+OrderGateway::OrderGateway(CThostFtdcTraderApi* api, IdAllocator& ids, const RateLimiterOptions& rateOptions)
+    : m_api(api), m_ids(ids), m_risk(nullptr), m_latency(nullptr), m_batchExchanges(1, "CFFEX"), m_templatesBuilt(false),
+      m_loggedIn(false), m_frontId(0), m_sessionId(0), m_ready(false), m_sendTurn(0), m_loginGeneration(0), m_actionRef(0),
+      m_limiter(rateOptions), m_sent(0), m_failed(0), m_cancelsSent(0), m_cancelsFailed(0) {
+    memset(&m_actionTemplate, 0, sizeof(m_actionTemplate));
+    memset(&m_batchTemplate, 0, sizeof(m_batchTemplate));
+}
+
+void OrderGateway::SetAccount(const std::string& brokerId, const std::string& investorId,
+                              const std::string& userId) {
+    m_brokerId = brokerId;
+    m_investorId = investorId;
+    m_userId = userId;
+}
+
+void OrderGateway::SetRiskEngine(RiskEngine* risk) {
+    m_risk = risk;
+}
+
+void OrderGateway::SetLatencyTracker(LatencyTracker* latency) {
+    m_latency = latency;
+}
+
+void OrderGateway::SetBatchCancelExchanges(const std::vector<std::string>& exchangeIds) {
+    m_batchExchanges = exchangeIds;
+}
+
+void OrderGateway::OnLogin(const CThostFtdcRspUserLoginField& login) {
+    m_frontId = login.FrontID;
+    m_sessionId = login.SessionID;
+    m_sendTurn.store(m_ids.PeekOrderSeq(), std::memory_order_relaxed);
+    // 先推进 m_sendTurn 再发布新代数: 看到新代数的报单取到的序号不小于新起点
+    m_loginGeneration.fetch_add(1, std::memory_order_release);
+    m_loggedIn = true;
+    m_ready.store(m_templatesBuilt, std::memory_order_release);
+}
+
+void OrderGateway::OnDisconnected() {
+    m_loggedIn = false;
+    m_ready.store(false, std::memory_order_release);
+}
+
+void OrderGateway::BuildTemplates(const InstrumentCache& instruments, const SymbolTable& symbols) {
+    if (m_templatesBuilt || !instruments.Ready()) {
+        return;
+    }
+
+    // 账户级字段, 所有合约共用
+    CThostFtdcInputOrderField base;
+    memset(&base, 0, sizeof(base));
+    strncpy(base.BrokerID, m_brokerId.c_str(), sizeof(base.BrokerID) - 1);
+    strncpy(base.InvestorID, m_investorId.c_str(), sizeof(base.InvestorID) - 1);
+    strncpy(base.UserID, m_userId.c_str(), sizeof(base.UserID) - 1);
+    base.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
+    base.Direction = THOST_FTDC_D_Buy;
+    base.CombOffsetFlag[0] = THOST_FTDC_OF_Open;
+    base.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
+    base.VolumeTotalOriginal = 1;
+    base.TimeCondition = THOST_FTDC_TC_GFD;
+    base.VolumeCondition = THOST_FTDC_VC_AV;
+    base.MinVolume = 1;
+    base.ContingentCondition = THOST_FTDC_CC_Immediately;
+    base.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
+    base.IsAutoSuspend = 0;
+    base.UserForceClose = 0;
+
+    memcpy(m_actionTemplate.BrokerID, base.BrokerID, sizeof(base.BrokerID));
+    memcpy(m_actionTemplate.InvestorID, base.InvestorID, sizeof(base.InvestorID));
+    memcpy(m_actionTemplate.UserID, base.UserID, sizeof(base.UserID));
+    m_actionTemplate.ActionFlag = THOST_FTDC_AF_Delete;
+    memcpy(m_batchTemplate.BrokerID, base.BrokerID, sizeof(base.BrokerID));
+    memcpy(m_batchTemplate.InvestorID, base.InvestorID, sizeof(base.InvestorID));
+    memcpy(m_batchTemplate.UserID, base.UserID, sizeof(base.UserID));
+
+    m_slots.assign(symbols.Capacity(), kNoTemplate);
+    m_templates.clear();
+    m_templates.reserve(instruments.Size());
+    m_exchanges.clear();
+    m_exchanges.reserve(instruments.Size());
+    m_latencyExchanges.clear();
+    m_latencyExchanges.reserve(instruments.Size());
+    m_batchCancel.clear();
+    m_batchCancel.reserve(instruments.Size());
+    for (size_t i = 0; i < instruments.Size(); ++i) {
+        const CThostFtdcInstrumentField& instrument = instruments.At(i);
+        const uint32_t symbolId = symbols.Find(instrument.InstrumentID);
+        if (symbolId == kInvalidSymbol || m_slots[symbolId] != kNoTemplate) {
+            continue;
+        }
+        m_templates.push_back(base);
+        CThostFtdcInputOrderField& field = m_templates.back();
+        memcpy(field.InstrumentID, instrument.InstrumentID, sizeof(field.InstrumentID));
+        memcpy(field.ExchangeID, instrument.ExchangeID, sizeof(field.ExchangeID));
+        m_exchanges.push_back(m_limiter.RegisterExchange(field.ExchangeID));
+        m_latencyExchanges.push_back(m_latency ? m_latency->RegisterExchange(field.ExchangeID) : 0);
+        bool batch = false;
+        for (size_t j = 0; j < m_batchExchanges.size(); ++j) {
+            batch = batch || m_batchExchanges[j] == field.ExchangeID;
+        }
+        m_batchCancel.push_back(batch ? 1 : 0);
+        m_slots[symbolId] = static_cast<uint32_t>(m_templates.size() - 1);
+    }
+    m_templatesBuilt = true;
+    m_ready.store(m_loggedIn, std::memory_order_release);
+    LOG("[报单] 已生成报单模板 {} 个", m_templates.size());
+}
+
+int OrderGateway::InsertLimit(uint32_t symbolId, TThostFtdcDirectionType direction,
+                              TThostFtdcOffsetFlagType offset, double price, int volume, int strategy,
+                              int* orderRef, int64_t mdRecvNs) {
+    // 本次报单只在入口读一次时钟, 既是延迟统计的决策时刻, 也是流控取令牌的当前时刻
+    const int64_t decisionNs = MonotonicNs();
+    const uint32_t generation = m_loginGeneration.load(std::memory_order_acquire);
+    if (!m_ready.load(std::memory_order_acquire)) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return kOrderGatewayNotReady;
+    }
+    if (symbolId >= m_slots.size() || m_slots[symbolId] == kNoTemplate) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return kOrderUnknownInstrument;
+    }
+    if (strategy < 0 || strategy >= m_ids.StrategySlots()) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return kOrderBadStrategy;
+    }
+    if (m_risk) {
+        const int risk = m_risk->Check(symbolId, direction, price, volume);
+        if (risk != kRiskOk) {
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+            return risk;
+        }
+    }
+
+    const uint32_t slot = m_slots[symbolId];
+    int64_t sendNs = 0;
+    const int token = WaitForToken(slot, decisionNs, m_limiter.MaxQueueNs(), sendNs);
+    if (token != 0) {
+        if (m_risk) {
+            m_risk->Release(symbolId, direction, volume);
+        }
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return token;
+    }
+
+    CThostFtdcInputOrderField req = m_templates[slot];
+    const int seq = m_ids.NextOrderSeq();
+    const int ref = m_ids.OrderRefOf(seq, strategy);
+    const int requestId = m_ids.NextRequestId();
+    FormatOrderRef(ref, req.OrderRef);
+    req.Direction = direction;
+    req.CombOffsetFlag[0] = offset;
+    req.LimitPrice = price;
+    req.VolumeTotalOriginal = volume;
+    req.RequestID = requestId;
+    if (orderRef) {
+        *orderRef = ref;
+    }
+
+    // 等前一个序号发出后再发送, 保证 OrderRef 按递增顺序到达CTP;
+    // 重新登录会把 m_sendTurn 推到新的起点, 此时旧序号不再等待, 也不再发送
+    while (m_sendTurn.load(std::memory_order_acquire) < seq) {
+        std::this_thread::yield();
+    }
+    if (m_loginGeneration.load(std::memory_order_acquire) != generation) {
+        // 取号晚于重新登录时序号落在新会话中, 须把发送权交给下一个序号
+        int expected = seq;
+        m_sendTurn.compare_exchange_strong(expected, seq + 1, std::memory_order_release,
+                                           std::memory_order_relaxed);
+        m_limiter.Release(m_exchanges[slot]);
+        if (m_risk) {
+            m_risk->Release(symbolId, direction, volume);
+        }
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return kOrderGatewayNotReady;
+    }
+    int64_t callNs = 0;
+    if (m_latency) {
+        // 先发布槽位再发送, 早于 ReqOrderInsert 返回到达的回报也能关联到本笔报单
+        callNs = MonotonicNs();
+        m_latency->OnSending(ref, m_latencyExchanges[slot], callNs);
+    }
+    const int result = m_api->ReqOrderInsert(&req, requestId);
+    const int64_t returnNs = m_latency ? MonotonicNs() : 0;
+    int expected = seq;
+    m_sendTurn.compare_exchange_strong(expected, seq + 1, std::memory_order_release, std::memory_order_relaxed);
+    if (result == 0) {
+        m_limiter.OnSent(sendNs);
+        m_sent.fetch_add(1, std::memory_order_relaxed);
+        if (m_latency) {
+            m_latency->OnSent(m_latencyExchanges[slot], mdRecvNs, decisionNs, callNs, returnNs);
+        }
+    } else {
+        m_limiter.OnRejected(result, MonotonicNs());
+        if (m_risk) {
+            m_risk->Release(symbolId, direction, volume);
+        }
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    return result;
+}
+
+int OrderGateway::CancelOrder(const OrderInfo& order) {
+    return SendCancel(order, m_limiter.MaxQueueNs(), 1);
+}
+
+MassCancelResult OrderGateway::MassCancel(const OrderTable& orders, CancelScope scope, uint32_t symbolId,
+                                          int strategy, int64_t budgetNs) {
+    struct BatchGroup {
+        uint32_t slot;          ///< 该交易所任一合约的模板, 用于取交易所代码
+        int frontId;
+        int sessionId;
+        int orders;
+    };
+
+    const int64_t startNs = MonotonicNs();
+    const int64_t deadlineNs = startNs + budgetNs;
+    MassCancelResult result = {0, 0, 0, 0, 0, 0};
+    BatchGroup groups[kMaxBatchGroups];
+    size_t groupCount = 0;
+    // 模板在就绪前可能正在生成, 未就绪时不访问模板, 只统计
+    const bool ready = Ready();
+
+    // 逐笔撤单在扫描中立即发出, 批量撤单在扫描结束后发出
+    OrderInfo info;
+    const size_t size = orders.Size();
+    for (size_t i = 0; i < size; ++i) {
+        if (!orders.Read(i, info) || IsTerminalState(info.state)) {
+            continue;
+        }
+        if ((scope == CancelScope::Instrument && info.symbolId != symbolId) ||
+            (scope == CancelScope::Strategy && m_ids.StrategyOf(atoi(info.key.orderRef)) != strategy)) {
+            continue;
+        }
+        ++result.orders;
+        if (!ready || info.symbolId >= m_slots.size() || m_slots[info.symbolId] == kNoTemplate) {
+            ++result.failed;
+            continue;
+        }
+
+        const uint32_t slot = m_slots[info.symbolId];
+        if (scope == CancelScope::Account && m_batchCancel[slot]) {
+            size_t g = 0;
+            while (g < groupCount && !(groups[g].frontId == info.key.frontId &&
+                                       groups[g].sessionId == info.key.sessionId &&
+                                       strcmp(m_templates[groups[g].slot].ExchangeID,
+                                              m_templates[slot].ExchangeID) == 0)) {
+                ++g;
+            }
+            if (g == groupCount && groupCount < kMaxBatchGroups) {
+                BatchGroup& group = groups[groupCount++];
+                group.slot = slot;
+                group.frontId = info.key.frontId;
+                group.sessionId = info.key.sessionId;
+                group.orders = 0;
+            }
+            if (g < groupCount) {
+                ++groups[g].orders;
+                continue;
+            }
+        }
+        const int sent = SendCancel(info, deadlineNs - MonotonicNs(), kCancelMaxAttempts);
+        if (sent == 0) {
+            ++result.actionRequests;
+        } else if (sent == kRateSessionLimited || sent == kRateExchangeLimited) {
+            ++result.deferred;
+        } else {
+            ++result.failed;
+        }
+    }
+
+    for (size_t g = 0; g < groupCount; ++g) {
+        CThostFtdcInputBatchOrderActionField req = m_batchTemplate;
+        req.FrontID = groups[g].frontId;
+        req.SessionID = groups[g].sessionId;
+        memcpy(req.ExchangeID, m_templates[groups[g].slot].ExchangeID, sizeof(req.ExchangeID));
+        const int sent = SendAction(groups[g].slot, req, &CThostFtdcTraderApi::ReqBatchOrderAction,
+                                    deadlineNs - MonotonicNs(), kCancelMaxAttempts);
+        if (sent == 0) {
+            ++result.batchRequests;
+        } else if (sent == kRateSessionLimited || sent == kRateExchangeLimited) {
+            result.deferred += groups[g].orders;
+        } else {
+            result.failed += groups[g].orders;
+        }
+    }
+
+    result.elapsedNs = MonotonicNs() - startNs;
+    return result;
+}
+
+int OrderGateway::SendCancel(const OrderInfo& order, int64_t maxQueueNs, int maxAttempts) {
+    if (!Ready()) {
+        m_cancelsFailed.fetch_add(1, std::memory_order_relaxed);
+        return kOrderGatewayNotReady;
+    }
+    if (order.symbolId >= m_slots.size() || m_slots[order.symbolId] == kNoTemplate) {
+        m_cancelsFailed.fetch_add(1, std::memory_order_relaxed);
+        return kOrderUnknownInstrument;
+    }
+
+    // 前置+会话+报单引用 和 交易所+报单编号 都填上, 交易所尚未确认的报单只能用前者
+    const uint32_t slot = m_slots[order.symbolId];
+    const CThostFtdcInputOrderField& tmpl = m_templates[slot];
+    CThostFtdcInputOrderActionField req = m_actionTemplate;
+    req.FrontID = order.key.frontId;
+    req.SessionID = order.key.sessionId;
+    memcpy(req.OrderRef, order.key.orderRef, sizeof(req.OrderRef));
+    req.OrderRef[sizeof(req.OrderRef) - 1] = '\0';
+    memcpy(req.OrderSysID, order.orderSysId, sizeof(req.OrderSysID));
+    memcpy(req.ExchangeID, tmpl.ExchangeID, sizeof(req.ExchangeID));
+    memcpy(req.InstrumentID, tmpl.InstrumentID, sizeof(req.InstrumentID));
+    return SendAction(slot, req, &CThostFtdcTraderApi::ReqOrderAction, maxQueueNs, maxAttempts);
+}
+
+template <typename Field>
+int OrderGateway::SendAction(uint32_t slot, Field& req, int (CThostFtdcTraderApi::*send)(Field*, int),
+                             int64_t maxQueueNs, int maxAttempts) {
+    req.OrderActionRef = m_actionRef.fetch_add(1, std::memory_order_relaxed) + 1;
+    int result = 0;
+    for (int attempt = 1; ; ++attempt) {
+        int64_t sendNs = 0;
+        result = WaitForToken(slot, MonotonicNs(), maxQueueNs, sendNs);
+        if (result != 0) {
+            break;
+        }
+        req.RequestID = m_ids.NextRequestId();
+        result = (m_api->*send)(&req, req.RequestID);
+        if (result == 0) {
+            m_limiter.OnSent(sendNs);
+            m_cancelsSent.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        // 被流控时下调速率, 再取令牌重发
+        m_limiter.OnRejected(result, MonotonicNs());
+        if ((result != kCtpTooManyPending && result != kCtpTooManyPerSecond) || attempt >= maxAttempts) {
+            break;
+        }
+    }
+    m_cancelsFailed.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+int OrderGateway::WaitForToken(uint32_t slot, int64_t nowNs, int64_t maxQueueNs, int64_t& sendNs) {
+    const int64_t wait = m_limiter.Acquire(m_exchanges[slot], nowNs, maxQueueNs);
+    if (wait < 0) {
+        return static_cast<int>(wait);
+    }
+    // 令牌已预留, 等到可发送的时刻
+    sendNs = nowNs + wait;
+    while (wait > 0 && MonotonicNs() < sendNs) {
+        std::this_thread::yield();
+    }
+    return 0;
+}
+
+OrderGatewayStats OrderGateway::GetStats() const {
+    OrderGatewayStats stats;
+    stats.sent = m_sent.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    stats.cancelsSent = m_cancelsSent.load(std::memory_order_relaxed);
+    stats.cancelsFailed = m_cancelsFailed.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,206 @@
+///
+/// @file OrderGateway.h
+/// @brief 报单网关: 按合约预填 CThostFtdcInputOrderField 模板, 发送时只改写少量字段
+///
+
+#ifndef CTP_TEST_ORDER_GATEWAY_H
+#define CTP_TEST_ORDER_GATEWAY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ThostFtdcTraderApi.h"
+#include "IdAllocator.h"
+#include "InstrumentCache.h"
+#include "LatencyTracker.h"
+#include "OrderTable.h"
+#include "RateLimiter.h"
+#include "RiskEngine.h"
+#include "SymbolTable.h"
+
+/// 报单网关返回码, 与CTP Req* 函数的返回码(0, -1, -2, -3)不重叠
+const int kOrderGatewayNotReady = -100;     ///< 未登录或模板尚未生成
+const int kOrderUnknownInstrument = -101;   ///< 合约编号没有对应的模板
+const int kOrderBadStrategy = -102;         ///< 策略槽位超出 IdAllocator 的范围
+// -103 / -104 为流控拒绝, 见 RateLimiter.h
+
+/// MassCancel() 默认的耗时上限: 按流控节奏排队, 实际上不会因流控而放弃
+const int64_t kMassCancelBudgetNs = 60LL * 1000000000LL;
+
+///
+/// @brief 报单网关统计
+///
+struct OrderGatewayStats {
+    uint64_t sent;              ///< ReqOrderInsert 返回0的笔数
+    uint64_t failed;            ///< 未发出或 ReqOrderInsert 返回非0的笔数
+    uint64_t cancelsSent;       ///< ReqOrderAction / ReqBatchOrderAction 返回0的笔数
+    uint64_t cancelsFailed;     ///< 未能发出的撤单数
+};
+
+///
+/// @brief 批量撤单范围
+///
+enum class CancelScope : uint8_t {
+    Account,        ///< 账户的全部挂单
+    Instrument,     ///< 指定合约的挂单
+    Strategy,       ///< 指定策略槽位的挂单, 按 OrderRef 还原策略
+};
+
+///
+/// @brief 一次批量撤单的结果
+///
+struct MassCancelResult {
+    int orders;                 ///< 需要撤销的挂单数
+    int batchRequests;          ///< 发出的 ReqBatchOrderAction 笔数
+    int actionRequests;         ///< 发出的 ReqOrderAction 笔数
+    int failed;                 ///< 未能发出的撤单数
+    int deferred;               ///< 流控排队超出耗时上限而未发出的撤单数, 稍后可再撤
+    int64_t elapsedNs;          ///< 从开始扫描到最后一笔请求发出的耗时
+};
+
+///
+/// @brief 报单网关
+///
+/// 一个网关对应一个资金账户。合约缓存就绪后为每个合约生成一份限价单模板, 经纪公司、
+/// 投资者、合约、交易所以及投机套保、有效期、成交量条件等固定字段都已填好。
+/// 报单时把模板拷贝到栈上, 只改写价格、数量、买卖方向、开平标志和 OrderRef,
+/// 然后直接调用 ReqOrderInsert: 不清零整个结构、不做字符串拷贝、不加锁、不分配内存。
+///
+/// 模板每个交易日只生成一次, 生成后只读, 因此 InsertLimit() 可在任意线程并发调用。
+/// OrderRef 和 RequestID 由 IdAllocator 无锁分配。CTP要求同一会话内 OrderRef 递增,
+/// 并发报单时按报单序号依次调用 ReqOrderInsert: 序号较大的线程等待前一笔调用返回,
+/// CTP内部本就串行处理 ReqOrderInsert, 这一排队不增加额外的串行化。
+/// 报单开始时记下登录代数, 排到发送时若已重新登录, 旧会话的序号作废:
+/// 退还风控和流控预留, 返回 kOrderGatewayNotReady, 不以新会话发送旧的 OrderRef。
+/// OnLogin()/OnDisconnected()/BuildTemplates() 由交易回调处理线程调用。
+///
+/// 设置了风控时, 报单在分配 OrderRef 之前先经 RiskEngine::Check(), 被拒的报单不占用 OrderRef。
+/// 风控通过后按会话和合约所在交易所取流控令牌, 令牌不足时在 maxQueueNs 内排队等待, 否则拒绝;
+/// ReqOrderInsert 返回的 -2/-3 反馈给 RateLimiter 以下调会话速率。
+///
+/// 撤单同样按模板发送。MassCancel() 扫描 OrderTable 中的挂单, 撤账户全部挂单时对支持
+/// ReqBatchOrderAction 的交易所按 前置+会话 各发一笔批量撤单, 其余挂单逐笔 ReqOrderAction,
+/// 不等待应答连续发出; 撤单按流控节奏排队, 被CTP流控时退避后重发, 整次撤单的排队不超过调用方
+/// 给出的耗时上限, 超出的挂单计入 deferred 留给下一次撤单。
+///
+class OrderGateway {
+public:
+    /// @param api 交易API, 由调用方创建和释放
+    /// @param ids 编号分配器, 与发送查询请求的 TraderSpi 共用
+    /// @param rateOptions 报单流控参数
+    OrderGateway(CThostFtdcTraderApi* api, IdAllocator& ids,
+                 const RateLimiterOptions& rateOptions = RateLimiterOptions());
+
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+    /// 设置账户信息, 须在 BuildTemplates() 之前调用
+    void SetAccount(const std::string& brokerId, const std::string& investorId, const std::string& userId);
+
+    /// 设置报单前风控, 须在 BuildTemplates() 之前调用
+    void SetRiskEngine(RiskEngine* risk);
+
+    /// 设置延迟统计, 设置后每笔报单多读两次时钟; 须在 BuildTemplates() 之前调用
+    void SetLatencyTracker(LatencyTracker* latency);
+
+    /// 设置支持 ReqBatchOrderAction 的交易所, 默认只有中金所; 须在 BuildTemplates() 之前调用
+    void SetBatchCancelExchanges(const std::vector<std::string>& exchangeIds);
+
+    /// 登录成功: 记录前置编号和会话编号; IdAllocator 须已用本次登录的 MaxOrderRef 重置
+    void OnLogin(const CThostFtdcRspUserLoginField& login);
+
+    /// 断线: 停止接受报单, 直到重新登录
+    void OnDisconnected();
+
+    /// 为合约缓存中已分配编号的合约生成模板, 每个交易日只生成一次
+    void BuildTemplates(const InstrumentCache& instruments, const SymbolTable& symbols);
+
+    /// 是否可以报单
+    bool Ready() const { return m_ready.load(std::memory_order_acquire); }
+
+    /// 发送限价单
+    /// @param symbolId  SymbolTable 编号
+    /// @param direction THOST_FTDC_D_Buy / THOST_FTDC_D_Sell
+    /// @param offset    THOST_FTDC_OF_Open / THOST_FTDC_OF_Close / THOST_FTDC_OF_CloseToday ...
+    /// @param strategy  策略槽位, 编入 OrderRef
+    /// @param orderRef  非空时返回本笔报单使用的 OrderRef
+    /// @param mdRecvNs  触发本笔报单的行情回调时刻(MdTick::recvNs), 用于延迟统计; 0表示不是由行情触发
+    /// @return 0 表示已发出; 其余为 ReqOrderInsert 的返回码、kOrder*、kRate* 或 kRisk* 错误码
+    int InsertLimit(uint32_t symbolId, TThostFtdcDirectionType direction, TThostFtdcOffsetFlagType offset,
+                    double price, int volume, int strategy = 0, int* orderRef = nullptr, int64_t mdRecvNs = 0);
+
+    /// 撤销一笔报单, 按流控参数排队或拒绝
+    /// @return 0 表示已发出; 其余为 ReqOrderAction 的返回码、kOrder* 或 kRate* 错误码
+    int CancelOrder(const OrderInfo& order);
+
+    /// 批量撤单, 可在任意线程调用
+    /// @param orders   报单状态表, 从中选出未终结的报单
+    /// @param scope    撤单范围
+    /// @param symbolId scope 为 Instrument 时的合约编号
+    /// @param strategy scope 为 Strategy 时的策略槽位
+    /// @param budgetNs 从开始扫描起的耗时上限, 流控排队超出时不再等待
+    MassCancelResult MassCancel(const OrderTable& orders, CancelScope scope, uint32_t symbolId = 0,
+                                int strategy = 0, int64_t budgetNs = kMassCancelBudgetNs);
+
+    /// 登录返回的前置编号
+    int FrontId() const { return m_frontId; }
+
+    /// 登录返回的会话编号
+    int SessionId() const { return m_sessionId; }
+
+    /// 获取统计
+    OrderGatewayStats GetStats() const;
+
+    /// 获取流控统计
+    RateLimiterStats GetRateStats() const { return m_limiter.GetStats(); }
+
+private:
+    /// 填写并发送一笔撤单, maxQueueNs 为流控排队上限; 被CTP流控时最多发送 maxAttempts 次
+    int SendCancel(const OrderInfo& order, int64_t maxQueueNs, int maxAttempts);
+
+    /// 等待流控令牌, 返回0或 kRate* 错误码; nowNs 为调用方已读取的当前时刻, 成功时 sendNs 为可以发送的时刻
+    int WaitForToken(uint32_t slot, int64_t nowNs, int64_t maxQueueNs, int64_t& sendNs);
+
+    /// 取令牌并调用 ReqOrderAction / ReqBatchOrderAction, 被CTP流控时重发
+    template <typename Field>
+    int SendAction(uint32_t slot, Field& req, int (CThostFtdcTraderApi::*send)(Field*, int),
+                   int64_t maxQueueNs, int maxAttempts);
+
+    CThostFtdcTraderApi* m_api;
+    IdAllocator& m_ids;
+    RiskEngine* m_risk;
+    LatencyTracker* m_latency;
+    std::string m_brokerId;
+    std::string m_investorId;
+    std::string m_userId;
+
+    // 以下由处理线程写入, 通过 m_ready 发布给报单线程
+    std::vector<CThostFtdcInputOrderField> m_templates;
+    std::vector<uint32_t> m_slots;          ///< 合约编号 -> m_templates 下标
+    std::vector<int> m_exchanges;           ///< m_templates 下标 -> 交易所令牌桶下标
+    std::vector<int> m_latencyExchanges;    ///< m_templates 下标 -> 延迟统计的交易所下标
+    std::vector<char> m_batchCancel;        ///< m_templates 下标 -> 交易所是否支持批量撤单
+    std::vector<std::string> m_batchExchanges;
+    CThostFtdcInputOrderActionField m_actionTemplate;
+    CThostFtdcInputBatchOrderActionField m_batchTemplate;
+    bool m_templatesBuilt;
+    bool m_loggedIn;
+    int m_frontId;
+    int m_sessionId;
+
+    std::atomic<bool> m_ready;
+    std::atomic<int> m_sendTurn;        ///< 下一个允许调用 ReqOrderInsert 的报单序号
+    std::atomic<uint32_t> m_loginGeneration;    ///< 每次登录加1, 报单序号属于取号时的登录
+    std::atomic<int> m_actionRef;       ///< OrderActionRef
+    RateLimiter m_limiter;
+
+    // 统计
+    std::atomic<uint64_t> m_sent;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<uint64_t> m_cancelsSent;
+    std::atomic<uint64_t> m_cancelsFailed;
+};
+
+#endif // CTP_TEST_ORDER_GATEWAY_H
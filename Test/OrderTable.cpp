@@ -0,0 +1,312 @@
+///
+/// @file OrderTable.cpp
+/// @brief 报单状态表实现
+///
+
+#include "OrderTable.h"
+
+#include <cstdlib>
+#include <new>
+
+#include "Clock.h"
+#include "FieldCopy.h"
+
+namespace {
+
+const size_t kCacheLine = 64;
+
+// CTP报单回报 -> 生命周期状态
+OrderState StateOf(const CThostFtdcOrderField& order) {
+    if (order.OrderSubmitStatus == THOST_FTDC_OSS_InsertRejected) {
+        return OrderState::Rejected;
+    }
+    switch (order.OrderStatus) {
+        case THOST_FTDC_OST_AllTraded:
+            return OrderState::Filled;
+        case THOST_FTDC_OST_PartTradedQueueing:
+            return OrderState::PartiallyFilled;
+        case THOST_FTDC_OST_PartTradedNotQueueing:
+        case THOST_FTDC_OST_NoTradeNotQueueing:
+        case THOST_FTDC_OST_Canceled:
+            return OrderState::Cancelled;
+        case THOST_FTDC_OST_NoTradeQueueing:
+        case THOST_FTDC_OST_NotTouched:
+        case THOST_FTDC_OST_Touched:
+            return OrderState::Accepted;
+        default:
+            return OrderState::Submitted;
+    }
+}
+
+inline size_t HashSysId(const char* exchangeId, const char* orderSysId) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const char* p = exchangeId; *p; ++p) {
+        h = (h ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+    }
+    h = (h ^ ':') * 1099511628211ULL;
+    for (const char* p = orderSysId; *p; ++p) {
+        h = (h ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+size_t SlotCount(size_t capacity) {
+    size_t slots = 16;
+    while (slots < capacity * 2) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+} // namespace
+
+OrderTable::OrderTable(SymbolTable& symbols, size_t capacity)
+    : m_symbols(symbols), m_capacity(capacity), m_mask(SlotCount(capacity) - 1), m_entries(nullptr),
+      m_refSlots(SlotCount(capacity)), m_sysSlots(SlotCount(capacity)),
+      m_count(0), m_overflow(0), m_orphanTrades(0) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kCacheLine, capacity * sizeof(Entry)) != 0) {
+        throw std::bad_alloc();
+    }
+    m_entries = static_cast<Entry*>(memory);
+    for (size_t i = 0; i < capacity; ++i) {
+        new (&m_entries[i]) Entry();
+        m_entries[i].seq.store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i <= m_mask; ++i) {
+        m_refSlots[i].store(0, std::memory_order_relaxed);
+        m_sysSlots[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+OrderTable::~OrderTable() {
+    free(m_entries);
+}
+
+// ---------------------------------------------------------------------------
+// 写方
+// ---------------------------------------------------------------------------
+
+bool OrderTable::OnRtnOrder(const CThostFtdcOrderField& order) {
+    const OrderKey key = MakeOrderKey(order.FrontID, order.SessionID, order.OrderRef);
+    int64_t index = IndexOf(key);
+    if (index < 0) {
+        index = Insert(key, order.InstrumentID, order.ExchangeID, order.Direction, order.CombOffsetFlag[0],
+                       order.LimitPrice, order.VolumeTotalOriginal);
+        if (index < 0) {
+            return false;
+        }
+    }
+
+    Entry& entry = m_entries[index];
+    const OrderInfo& current = entry.info;
+    const OrderState state = StateOf(order);
+    // 报单编号只在交易所确认时写入一次, 写入后加入第二索引且不再修改
+    const bool firstSysId = order.OrderSysID[0] != '\0' && current.orderSysId[0] == '\0';
+    if (state == current.state && order.OrderStatus == current.orderStatus &&
+        order.VolumeTraded <= current.volumeTraded && !firstSysId) {
+        return false;
+    }
+    // 续传时重复到达的旧回报, 或晚于成交回报到达的回报: 成交量回退或从终态回到非终态
+    if (order.VolumeTraded < current.volumeTraded ||
+        (IsTerminalState(current.state) && !IsTerminalState(state))) {
+        return false;
+    }
+
+    BeginWrite(entry);
+    OrderInfo& info = entry.info;
+    info.state = state;
+    info.orderStatus = order.OrderStatus;
+    info.volumeTraded = order.VolumeTraded;
+    if (firstSysId) {
+        CopyField(info.orderSysId, order.OrderSysID);
+    }
+    info.updateNs = MonotonicNs();
+    EndWrite(entry);
+
+    if (firstSysId) {
+        IndexSysId(static_cast<uint32_t>(index));
+    }
+    return true;
+}
+
+bool OrderTable::OnRtnTrade(const CThostFtdcTradeField& trade) {
+    const int64_t index = IndexOfSysId(trade.ExchangeID, trade.OrderSysID);
+    if (index < 0) {
+        m_orphanTrades.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Entry& entry = m_entries[index];
+    entry.tradeVolume += trade.Volume;
+    if (entry.tradeVolume <= entry.info.volumeTraded) {
+        return false;   // 报单回报已先到
+    }
+
+    BeginWrite(entry);
+    OrderInfo& info = entry.info;
+    info.volumeTraded = entry.tradeVolume;
+    if (info.volumeTraded >= info.volumeTotalOriginal) {
+        info.state = OrderState::Filled;
+    } else if (info.state == OrderState::Submitted || info.state == OrderState::Accepted) {
+        info.state = OrderState::PartiallyFilled;
+    }
+    info.updateNs = MonotonicNs();
+    EndWrite(entry);
+    return true;
+}
+
+bool OrderTable::OnInsertRejected(int frontId, int sessionId, const CThostFtdcInputOrderField& input,
+                                  int errorId) {
+    const OrderKey key = MakeOrderKey(frontId, sessionId, input.OrderRef);
+    int64_t index = IndexOf(key);
+    if (index < 0) {
+        index = Insert(key, input.InstrumentID, input.ExchangeID, input.Direction, input.CombOffsetFlag[0],
+                       input.LimitPrice, input.VolumeTotalOriginal);
+        if (index < 0) {
+            return false;
+        }
+    }
+    Entry& entry = m_entries[index];
+    if (IsTerminalState(entry.info.state)) {
+        return false;
+    }
+    BeginWrite(entry);
+    entry.info.state = OrderState::Rejected;
+    entry.info.errorId = errorId;
+    entry.info.updateNs = MonotonicNs();
+    EndWrite(entry);
+    return true;
+}
+
+bool OrderTable::OnActionRejected(const OrderKey& key, const char* exchangeId, const char* orderSysId,
+                                  int errorId) {
+    int64_t index = IndexOf(key);
+    if (index < 0 && orderSysId[0] != '\0') {
+        index = IndexOfSysId(exchangeId, orderSysId);
+    }
+    if (index < 0) {
+        return false;
+    }
+    Entry& entry = m_entries[index];
+    BeginWrite(entry);
+    entry.info.errorId = errorId;
+    entry.info.updateNs = MonotonicNs();
+    EndWrite(entry);
+    return true;
+}
+
+int64_t OrderTable::Insert(const OrderKey& key, const TThostFtdcInstrumentIDType& instrumentId,
+                           const char* exchangeId, char direction, char offset, double limitPrice,
+                           int volumeTotalOriginal) {
+    const size_t index = m_count.load(std::memory_order_relaxed);
+    if (index >= m_capacity) {
+        m_overflow.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    Entry& entry = m_entries[index];
+    entry.tradeVolume = 0;
+    OrderInfo& info = entry.info;
+    memset(&info, 0, sizeof(info));
+    info.key = key;
+    CopyField(info.exchangeId, exchangeId);
+    info.symbolId = m_symbols.Intern(instrumentId);
+    info.state = OrderState::Submitted;
+    info.direction = direction;
+    info.offset = offset;
+    info.limitPrice = limitPrice;
+    info.volumeTotalOriginal = volumeTotalOriginal;
+    info.updateNs = MonotonicNs();
+    entry.seq.store(2, std::memory_order_relaxed);
+
+    // 先发布记录数, 再发布索引槽位: 读方通过索引找到的记录一定已经写完
+    m_count.store(index + 1, std::memory_order_release);
+    size_t slot = OrderKeyHash()(key) & m_mask;
+    while (m_refSlots[slot].load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) & m_mask;
+    }
+    m_refSlots[slot].store(static_cast<uint32_t>(index + 1), std::memory_order_release);
+    return static_cast<int64_t>(index);
+}
+
+void OrderTable::IndexSysId(uint32_t index) {
+    const OrderInfo& info = m_entries[index].info;
+    size_t slot = HashSysId(info.exchangeId, info.orderSysId) & m_mask;
+    while (m_sysSlots[slot].load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) & m_mask;
+    }
+    m_sysSlots[slot].store(index + 1, std::memory_order_release);
+}
+
+void OrderTable::BeginWrite(Entry& entry) {
+    entry.seq.store(entry.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void OrderTable::EndWrite(Entry& entry) {
+    entry.seq.store(entry.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// 读方
+// ---------------------------------------------------------------------------
+
+int64_t OrderTable::IndexOf(const OrderKey& key) const {
+    size_t slot = OrderKeyHash()(key) & m_mask;
+    while (true) {
+        const uint32_t value = m_refSlots[slot].load(std::memory_order_acquire);
+        if (value == 0) {
+            return -1;
+        }
+        // 主键在记录发布后不再修改, 可以直接比较
+        if (m_entries[value - 1].info.key == key) {
+            return static_cast<int64_t>(value - 1);
+        }
+        slot = (slot + 1) & m_mask;
+    }
+}
+
+int64_t OrderTable::IndexOfSysId(const char* exchangeId, const char* orderSysId) const {
+    size_t slot = HashSysId(exchangeId, orderSysId) & m_mask;
+    while (true) {
+        const uint32_t value = m_sysSlots[slot].load(std::memory_order_acquire);
+        if (value == 0) {
+            return -1;
+        }
+        // 报单编号写入后才加入索引, 之后不再修改
+        const OrderInfo& info = m_entries[value - 1].info;
+        if (strcmp(info.orderSysId, orderSysId) == 0 && strcmp(info.exchangeId, exchangeId) == 0) {
+            return static_cast<int64_t>(value - 1);
+        }
+        slot = (slot + 1) & m_mask;
+    }
+}
+
+bool OrderTable::ReadEntry(uint32_t index, OrderInfo& info) const {
+    const Entry& entry = m_entries[index];
+    while (true) {
+        const uint32_t seq = entry.seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            continue;
+        }
+        info = entry.info;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.seq.load(std::memory_order_relaxed) == seq) {
+            return true;
+        }
+    }
+}
+
+bool OrderTable::Find(const OrderKey& key, OrderInfo& info) const {
+    const int64_t index = IndexOf(key);
+    return index >= 0 && ReadEntry(static_cast<uint32_t>(index), info);
+}
+
+bool OrderTable::FindBySysId(const char* exchangeId, const char* orderSysId, OrderInfo& info) const {
+    const int64_t index = IndexOfSysId(exchangeId, orderSysId);
+    return index >= 0 && ReadEntry(static_cast<uint32_t>(index), info);
+}
+
+bool OrderTable::Read(size_t index, OrderInfo& info) const {
+    return index < Size() && ReadEntry(static_cast<uint32_t>(index), info);
+}
@@ -0,0 +1,185 @@
+///
+/// @file OrderTable.h
+/// @brief 报单状态表: 预分配开放寻址哈希表, 按 前置+会话+报单引用 和 交易所+报单编号 索引
+///
+
+#ifndef CTP_TEST_ORDER_TABLE_H
+#define CTP_TEST_ORDER_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "SymbolTable.h"
+
+///
+/// @brief 报单主键: FrontID + SessionID + OrderRef, 定长, 可直接按字节比较
+///
+struct OrderKey {
+    int32_t frontId;
+    int32_t sessionId;
+    char orderRef[16];          ///< TThostFtdcOrderRefType, 末尾补0
+
+    bool operator==(const OrderKey& other) const { return memcmp(this, &other, sizeof(OrderKey)) == 0; }
+};
+
+static_assert(sizeof(OrderKey) == 24, "OrderKey must be 24 bytes");
+
+inline OrderKey MakeOrderKey(int frontId, int sessionId, const TThostFtdcOrderRefType& orderRef) {
+    OrderKey key;
+    memset(&key, 0, sizeof(key));
+    key.frontId = frontId;
+    key.sessionId = sessionId;
+    // 只拷贝到 '\0' 为止, 源字段 '\0' 之后的内容不影响主键
+    memcpy(key.orderRef, orderRef, strnlen(orderRef, sizeof(TThostFtdcOrderRefType) - 1));
+    return key;
+}
+
+///
+/// @brief OrderKey 哈希, 也可用于标准容器
+///
+struct OrderKeyHash {
+    size_t operator()(const OrderKey& key) const {
+        uint64_t words[3];
+        memcpy(words, &key, sizeof(words));
+        uint64_t h = words[0] * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ words[1] ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ words[2] ^ (h >> 32)) * 0x94D049BB133111EBULL;
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+};
+
+///
+/// @brief 报单生命周期状态
+///
+enum class OrderState : uint8_t {
+    Submitted,          ///< 已报入CTP, 交易所尚未确认
+    Accepted,           ///< 交易所已接受, 未成交
+    PartiallyFilled,    ///< 部分成交, 剩余仍在队列中
+    Filled,             ///< 全部成交
+    Cancelled,          ///< 已撤单(可能部分成交)
+    Rejected,           ///< 被CTP或交易所拒绝
+};
+
+/// 是否为终态
+inline bool IsTerminalState(OrderState state) {
+    return state == OrderState::Filled || state == OrderState::Cancelled || state == OrderState::Rejected;
+}
+
+///
+/// @brief 一笔报单的当前状态
+///
+struct OrderInfo {
+    OrderKey key;
+    char exchangeId[9];
+    char orderSysId[21];            ///< 交易所确认前为空
+    uint32_t symbolId;              ///< SymbolTable 编号, 编号表已满时为 kInvalidSymbol
+    OrderState state;
+    char direction;                 ///< THOST_FTDC_D_*
+    char offset;                    ///< CombOffsetFlag[0]
+    char orderStatus;               ///< 最近一次回报的 OrderStatus
+    double limitPrice;
+    int volumeTotalOriginal;
+    int volumeTraded;
+    int errorId;                    ///< 最近一次报单或撤单被拒的错误码
+    int64_t updateNs;               ///< 最近一次变化的时刻(单调时钟)
+};
+
+///
+/// @brief 报单状态表
+///
+/// 报单记录在构造时按容量一次分配, 每条记录占两条缓存行, 交易日内只增不删;
+/// 主键索引和报单编号索引都是线性探测的开放寻址表, 槽位数为容量的两倍以上。
+/// 回报到达时的查找和更新不分配内存, 成交回报不带前置和会话, 按交易所+报单编号
+/// 通过第二个索引找到报单。
+///
+/// 单写多读: On*() 只能由交易回调处理线程调用; Find*()/Read() 可在任意线程调用,
+/// 每条记录带一个序号构成顺序锁, 读方拿到的总是某次更新完成后的一致状态。
+///
+class OrderTable {
+public:
+    /// @param symbols  合约编号表, 报单首次出现时为其合约分配编号
+    /// @param capacity 报单数上限, 超出后新报单不再记录
+    explicit OrderTable(SymbolTable& symbols, size_t capacity = 65536);
+    ~OrderTable();
+
+    OrderTable(const OrderTable&) = delete;
+    OrderTable& operator=(const OrderTable&) = delete;
+
+    /// 报单回报, 状态有变化时返回true; 重复或比已有状态更旧的回报返回false
+    bool OnRtnOrder(const CThostFtdcOrderField& order);
+
+    /// 成交回报, 须已去重; 找不到对应报单时返回false
+    bool OnRtnTrade(const CThostFtdcTradeField& trade);
+
+    /// 报单被拒(OnRspOrderInsert / OnErrRtnOrderInsert), 拒单可能早于任何报单回报
+    bool OnInsertRejected(int frontId, int sessionId, const CThostFtdcInputOrderField& input, int errorId);
+
+    /// 撤单被拒, 只记录错误码, 报单状态不变
+    bool OnActionRejected(const OrderKey& key, const char* exchangeId, const char* orderSysId, int errorId);
+
+    /// 按主键查找
+    bool Find(const OrderKey& key, OrderInfo& info) const;
+
+    /// 按交易所+报单编号查找
+    bool FindBySysId(const char* exchangeId, const char* orderSysId, OrderInfo& info) const;
+
+    /// 查找主键, 返回记录下标或 -1
+    int64_t IndexOf(const OrderKey& key) const;
+
+    /// 查找报单编号, 返回记录下标或 -1
+    int64_t IndexOfSysId(const char* exchangeId, const char* orderSysId) const;
+
+    /// 按记录下标读取, index < Size(), 用于遍历全部报单
+    bool Read(size_t index, OrderInfo& info) const;
+
+    /// 已记录的报单数
+    size_t Size() const { return m_count.load(std::memory_order_acquire); }
+
+    /// 因容量不足未记录的报单数
+    uint64_t Overflow() const { return m_overflow.load(std::memory_order_relaxed); }
+
+    /// 找不到报单的成交数
+    uint64_t OrphanTrades() const { return m_orphanTrades.load(std::memory_order_relaxed); }
+
+private:
+    /// 一条报单记录, 两条缓存行
+    struct Entry {
+        std::atomic<uint32_t> seq;
+        int32_t tradeVolume;        ///< 成交回报累计的成交量, 仅写方访问
+        OrderInfo info;
+        char pad[128 - 8 - sizeof(OrderInfo)];
+    };
+
+    static_assert(sizeof(Entry) == 128, "Entry must be two cache lines");
+
+    /// 新建记录并加入主键索引, 容量不足时返回 -1
+    int64_t Insert(const OrderKey& key, const TThostFtdcInstrumentIDType& instrumentId,
+                   const char* exchangeId, char direction, char offset, double limitPrice,
+                   int volumeTotalOriginal);
+
+    /// 报单编号首次出现时加入第二索引
+    void IndexSysId(uint32_t index);
+
+    /// 顺序锁: 写方开始和结束修改
+    void BeginWrite(Entry& entry);
+    void EndWrite(Entry& entry);
+
+    /// 顺序锁: 读方拷贝
+    bool ReadEntry(uint32_t index, OrderInfo& info) const;
+
+    SymbolTable& m_symbols;
+    const size_t m_capacity;
+    const size_t m_mask;            ///< 索引槽位数 - 1
+    Entry* m_entries;
+    std::vector<std::atomic<uint32_t>> m_refSlots;   ///< 主键索引, 存 记录下标+1, 0为空
+    std::vector<std::atomic<uint32_t>> m_sysSlots;   ///< 报单编号索引
+    std::atomic<size_t> m_count;
+    std::atomic<uint64_t> m_overflow;
+    std::atomic<uint64_t> m_orphanTrades;
+};
+
+#endif // CTP_TEST_ORDER_TABLE_H
@@ -0,0 +1,200 @@
+///
+/// @file PositionKeeper.cpp
+/// @brief 实时持仓实现
+///
+
+#include "PositionKeeper.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const size_t kCacheLine = 64;
+
+// 从 from 中扣除最多 volume, 返回未能扣除的数量
+inline int Take(int& from, int volume) {
+    const int taken = std::min(std::max(from, 0), volume);
+    from -= taken;
+    return volume - taken;
+}
+
+} // namespace
+
+PositionKeeper::PositionKeeper(size_t capacity, size_t orderCapacity)
+    : m_capacity(capacity), m_lines(nullptr), m_ledger(orderCapacity), m_loaded(false), m_shortfall(0) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kCacheLine, capacity * sizeof(PositionLine)) != 0) {
+        throw std::bad_alloc();
+    }
+    m_lines = static_cast<PositionLine*>(memory);
+    for (size_t i = 0; i < capacity; ++i) {
+        new (&m_lines[i]) PositionLine();
+        m_lines[i].seq.store(0, std::memory_order_relaxed);
+        m_lines[i].position = Position();
+    }
+    for (size_t i = 0; i < m_ledger.size(); ++i) {
+        m_ledger[i].today = 0;
+        m_ledger[i].yesterday = 0;
+    }
+}
+
+PositionKeeper::~PositionKeeper() {
+    free(m_lines);
+}
+
+void PositionKeeper::Load(const std::vector<CThostFtdcInvestorPositionField>& positions, SymbolTable& symbols) {
+    std::vector<Position> loaded;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const CThostFtdcInvestorPositionField& row = positions[i];
+        const uint32_t symbolId = symbols.Intern(row.InstrumentID);
+        if (symbolId == kInvalidSymbol || symbolId >= m_capacity) {
+            continue;
+        }
+        if (symbolId >= loaded.size()) {
+            loaded.resize(symbolId + 1, Position());
+        }
+        Position& position = loaded[symbolId];
+        if (row.PosiDirection == THOST_FTDC_PD_Short) {
+            position.shortYesterday += row.YdPosition;
+        } else {
+            position.longYesterday += row.YdPosition;
+        }
+    }
+
+    m_loaded = true;
+    Overwrite(loaded, std::min<uint32_t>(symbols.Size(), static_cast<uint32_t>(m_capacity)));
+}
+
+void PositionKeeper::Reset(const SymbolTable& symbols) {
+    m_loaded = false;
+    Overwrite(std::vector<Position>(), std::min<uint32_t>(symbols.Size(), static_cast<uint32_t>(m_capacity)));
+}
+
+void PositionKeeper::Overwrite(const std::vector<Position>& values, uint32_t size) {
+    // 只改写持仓量, 冻结量由报单状态维护
+    for (uint32_t i = 0; i < size; ++i) {
+        const Position value = i < values.size() ? values[i] : Position();
+        PositionLine& line = m_lines[i];
+        Position& position = line.position;
+        if (position.longToday == value.longToday && position.longYesterday == value.longYesterday &&
+            position.shortToday == value.shortToday && position.shortYesterday == value.shortYesterday) {
+            continue;
+        }
+        BeginWrite(line);
+        position.longToday = value.longToday;
+        position.longYesterday = value.longYesterday;
+        position.shortToday = value.shortToday;
+        position.shortYesterday = value.shortYesterday;
+        EndWrite(line);
+    }
+}
+
+void PositionKeeper::OnTrade(uint32_t symbolId, const CThostFtdcTradeField& trade) {
+    if (symbolId >= m_capacity || trade.Volume <= 0) {
+        return;
+    }
+    PositionLine& line = m_lines[symbolId];
+    Position& position = line.position;
+    const bool buy = trade.Direction == THOST_FTDC_D_Buy;
+
+    BeginWrite(line);
+    int left = 0;
+    if (trade.OffsetFlag == THOST_FTDC_OF_Open) {
+        (buy ? position.longToday : position.shortToday) += trade.Volume;
+    } else {
+        // 买平减空头, 卖平减多头
+        int& today = buy ? position.shortToday : position.longToday;
+        int& yesterday = buy ? position.shortYesterday : position.longYesterday;
+        if (trade.OffsetFlag == THOST_FTDC_OF_CloseToday) {
+            left = Take(yesterday, Take(today, trade.Volume));
+        } else {
+            left = Take(today, Take(yesterday, trade.Volume));
+        }
+    }
+    EndWrite(line);
+
+    if (left > 0 && m_loaded) {
+        m_shortfall.fetch_add(static_cast<uint64_t>(left), std::memory_order_relaxed);
+    }
+}
+
+void PositionKeeper::OnOrderUpdate(uint32_t index, const OrderInfo& info) {
+    if (index >= m_ledger.size() || info.offset == THOST_FTDC_OF_Open || info.symbolId >= m_capacity) {
+        return;
+    }
+    FrozenLedger& frozen = m_ledger[index];
+    const int target = IsTerminalState(info.state) ? 0 : std::max(info.volumeTotalOriginal - info.volumeTraded, 0);
+    const int current = frozen.today + frozen.yesterday;
+    if (target == current) {
+        return;
+    }
+
+    PositionLine& line = m_lines[info.symbolId];
+    Position& position = line.position;
+    const bool buy = info.direction == THOST_FTDC_D_Buy;
+    int& frozenToday = buy ? position.shortFrozenToday : position.longFrozenToday;
+    int& frozenYesterday = buy ? position.shortFrozenYesterday : position.longFrozenYesterday;
+    const bool todayFirst = info.offset == THOST_FTDC_OF_CloseToday;
+
+    int today = 0;
+    int yesterday = 0;
+    if (target > current) {
+        // 平今只冻结今仓, 平昨只冻结昨仓, 其余平仓先冻结可用的昨仓
+        const int add = target - current;
+        if (todayFirst) {
+            today = add;
+        } else if (info.offset == THOST_FTDC_OF_CloseYesterday) {
+            yesterday = add;
+        } else {
+            const int available = (buy ? position.shortYesterday : position.longYesterday) - frozenYesterday;
+            yesterday = std::min(add, std::max(available, 0));
+            today = add - yesterday;
+        }
+    } else {
+        // 成交按平仓顺序先消耗的一项先释放
+        const int release = current - target;
+        if (todayFirst) {
+            today = -std::min(frozen.today, release);
+            yesterday = -(release + today);
+        } else {
+            yesterday = -std::min(frozen.yesterday, release);
+            today = -(release + yesterday);
+        }
+    }
+    frozen.today += today;
+    frozen.yesterday += yesterday;
+
+    BeginWrite(line);
+    frozenToday += today;
+    frozenYesterday += yesterday;
+    EndWrite(line);
+}
+
+bool PositionKeeper::Read(uint32_t symbolId, Position& position) const {
+    if (symbolId >= m_capacity) {
+        return false;
+    }
+    const PositionLine& line = m_lines[symbolId];
+    while (true) {
+        const uint32_t seq = line.seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            continue;
+        }
+        position = line.position;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (line.seq.load(std::memory_order_relaxed) == seq) {
+            return true;
+        }
+    }
+}
+
+void PositionKeeper::BeginWrite(PositionLine& line) {
+    line.seq.store(line.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PositionKeeper::EndWrite(PositionLine& line) {
+    line.seq.store(line.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,114 @@
+///
+/// @file PositionKeeper.h
+/// @brief 实时持仓: 以持仓查询结果中的昨仓为基线, 按当日成交和报单状态增量维护
+///
+
+#ifndef CTP_TEST_POSITION_KEEPER_H
+#define CTP_TEST_POSITION_KEEPER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "OrderTable.h"
+#include "SymbolTable.h"
+
+///
+/// @brief 一个合约的持仓
+///
+/// 冻结量为挂着的平仓单占用的持仓: 卖平冻结多头, 买平冻结空头。
+/// 可平今 = 今仓 - 今仓冻结, 可平昨 = 昨仓 - 昨仓冻结; 平仓成交到达而报单回报尚未到达的
+/// 瞬间冻结量可能大于持仓, 使用时按0截断。
+///
+struct Position {
+    int longToday;
+    int longYesterday;
+    int shortToday;
+    int shortYesterday;
+    int longFrozenToday;
+    int longFrozenYesterday;
+    int shortFrozenToday;
+    int shortFrozenYesterday;
+};
+
+///
+/// @brief 实时持仓
+///
+/// 每个合约一条64字节缓存行, 区分多空和今昨仓, 读取是一次顺序锁读, O(1), 不需要查询。
+///
+/// 写入方都是交易回调处理线程:
+/// - Load() 用持仓查询结果中的昨仓覆盖全部合约的持仓量, 今仓清零, 冻结量不变。上期所/能源中心
+///   的今仓和昨仓分两行返回, 其他交易所合并为一行, 两种情况都按 昨仓 = 各行 YdPosition 之和 计算;
+/// - OnTrade() 按成交的开平标志增减持仓: 开仓计入今仓; 平今先减今仓, 其余平仓先减昨仓,
+///   不足部分再减另一项, 与CTP的平仓顺序一致;
+/// - OnOrderUpdate() 按报单剩余数量维护平仓冻结, 每笔报单的冻结量记在按 OrderTable 下标
+///   索引的台账中, 报单进入终态时全部释放。
+///
+/// YdPosition 是交易日开始时的昨仓, 不随当日成交变化, 查询结果到达的早晚不影响基线;
+/// 当日成交由调用方按成交编号去重后在 Load() 之后逐笔重放, 每笔只计入一次。
+///
+class PositionKeeper {
+public:
+    /// @param capacity      合约数上限, 与 SymbolTable 容量一致
+    /// @param orderCapacity 与 OrderTable 容量一致
+    PositionKeeper(size_t capacity, size_t orderCapacity);
+    ~PositionKeeper();
+
+    PositionKeeper(const PositionKeeper&) = delete;
+    PositionKeeper& operator=(const PositionKeeper&) = delete;
+
+    /// 用持仓查询结果中的昨仓覆盖全部合约的持仓量, 今仓清零; 之后须重放当日全部成交
+    void Load(const std::vector<CThostFtdcInvestorPositionField>& positions, SymbolTable& symbols);
+
+    /// 尚无昨仓基线: 全部合约的持仓量清零, 恢复到首次 Load() 之前的状态
+    void Reset(const SymbolTable& symbols);
+
+    /// 成交回报, 每笔成交只能调用一次
+    void OnTrade(uint32_t symbolId, const CThostFtdcTradeField& trade);
+
+    /// 报单状态变化
+    /// @param index OrderTable 记录下标
+    void OnOrderUpdate(uint32_t index, const OrderInfo& info);
+
+    /// 读取持仓, 可在任意线程调用; 合约编号越界时返回false
+    bool Read(uint32_t symbolId, Position& position) const;
+
+    /// Load() 之后成交时对应方向的持仓不足、按0截断的数量, 非0说明持仓初始化有误;
+    /// Load() 之前或 Reset() 之后的成交随后会在 Load() 之后重放, 不计入
+    uint64_t Shortfall() const { return m_shortfall.load(std::memory_order_relaxed); }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    /// 每个合约一条缓存行
+    struct PositionLine {
+        std::atomic<uint32_t> seq;
+        Position position;
+        char pad[28];
+    };
+
+    static_assert(sizeof(PositionLine) == 64, "PositionLine must be one cache line");
+
+    /// 每笔报单已冻结的数量, 仅处理线程访问
+    struct FrozenLedger {
+        int32_t today;
+        int32_t yesterday;
+    };
+
+    /// 用 values 覆盖前 size 个合约的持仓量, 冻结量不变
+    void Overwrite(const std::vector<Position>& values, uint32_t size);
+
+    /// 写方开始和结束一次更新
+    void BeginWrite(PositionLine& line);
+    void EndWrite(PositionLine& line);
+
+    const size_t m_capacity;
+    PositionLine* m_lines;
+    std::vector<FrozenLedger> m_ledger;
+    bool m_loaded;                          ///< 是否已 Load() 过, 仅处理线程访问
+    std::atomic<uint64_t> m_shortfall;
+};
+
+#endif // CTP_TEST_POSITION_KEEPER_H
@@ -0,0 +1,525 @@
+///
+/// @file PositionRecoveryTest.cpp
+/// @brief 实时持仓和资金估算的断线恢复检验: 登录和重连前后持续有成交时, 每笔成交恰好计入一次
+///
+/// 用法: ctp_position_test。每个场景一个资金账户, 同一账户的另一个会话(成交方)在 TraderSpi 登录前、
+/// 启动查询期间和重连前后持续以自成交的开平仓对产生成交。TraderSpi 以 QUICK 订阅私有流, 登录前的成交
+/// 只能经成交查询得到, 重连后续传的成交与查询结果重复。成交方停止后以它的持仓和资金查询结果为准, 检查
+/// PositionKeeper 各合约的多空持仓一致且没有持仓不足, FundsEstimator 的权益、可用资金、保证金和手续费
+/// 一致(费率按需逐个查询, 等待时间较长)。两个场景在各自的线程中同时运行,
+/// 任一项不符时打印原因并返回1。
+///
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "AsyncLogger.h"
+#include "ControlEvents.h"
+#include "FieldCopy.h"
+#include "FundsEstimator.h"
+#include "InstrumentCache.h"
+#include "PositionKeeper.h"
+#include "RecoveryTracker.h"
+#include "SimFront.h"
+#include "SymbolTable.h"
+#include "TraderSpi.h"
+
+namespace {
+
+const char* const kBrokerId = "9999";
+
+// 成交方先于 TraderSpi 成交的时间, 以及 TraderSpi 重连完成后继续成交的时间
+const std::chrono::milliseconds kLeadTime(500);
+const std::chrono::milliseconds kTailTime(300);
+// 两对报单之间的间隔; 每对报单等待两笔成交的最长时间
+const std::chrono::milliseconds kPairInterval(20);
+const std::chrono::seconds kFillTimeout(2);
+
+// 等待登录、重连完成和持仓一致的最长时间
+const std::chrono::seconds kReadyTimeout(5);
+const std::chrono::seconds kResyncTimeout(30);
+const std::chrono::seconds kSettleTimeout(15);
+
+// 查询流控下重发查询的间隔
+const std::chrono::milliseconds kQueryRetry(200);
+// 资金比较的容差, 元
+const double kFundsTolerance = 0.01;
+
+const size_t kOrderCapacity = 1 << 12;
+
+/// 一个场景: 资金账户、TraderSpi 的故障注入和成交的两个合约
+struct Scenario {
+    const char* name;
+    const char* user;
+    const char* faults;
+    struct Leg {
+        const char* instrumentId;
+        const char* exchangeId;
+        double price;
+        char closeFlag;     ///< 上期所/能源中心平今, 其他交易所平仓
+    } legs[2];
+};
+
+const Scenario kScenarios[] = {
+    // 持仓查询已发出、成交查询尚未发出时断线
+    {"启动查询中途断线", "pos1", "2500:disconnect:0x1001:300",
+     {{"rb2701", "SHFE", 3500.0, THOST_FTDC_OF_CloseToday}, {"m2701", "DCE", 3000.0, THOST_FTDC_OF_Close}}},
+    // 首次登录的启动查询全部出错, 之后断线重新登录
+    {"启动查询出错后断线", "pos2", "0:reject:3500:90,5000:disconnect:0x1001:300",
+     {{"cu2612", "SHFE", 80000.0, THOST_FTDC_OF_CloseToday}, {"SR701", "CZCE", 6000.0, THOST_FTDC_OF_Close}}},
+};
+
+/// 多空持仓量
+struct Volume {
+    int longVolume;
+    int shortVolume;
+};
+
+///
+/// @brief 成交方: 与 TraderSpi 同一账户的另一个会话, 持续发送自成交的报单对
+///
+/// 开仓对为同价的买开和卖开, 平仓对为同价的卖平和买平, 每对成交两笔; 等两笔成交都到达后再发下一对。
+/// 回调在API回调线程, 发送在 Run() 的调用线程。
+///
+class TradingPeer : public CThostFtdcTraderSpi {
+public:
+    explicit TradingPeer(const Scenario& scenario)
+        : m_scenario(scenario), m_api(nullptr), m_ready(false), m_failed(false), m_trades(0),
+          m_positionsDone(false), m_accountDone(false), m_nextRef(1), m_nextRequestId(0) {}
+
+    ~TradingPeer() {
+        if (m_api) {
+            m_api->Release();
+        }
+    }
+
+    bool Connect() {
+        m_api = CThostFtdcTraderApi::CreateFtdcTraderApi("./flow/");
+        m_api->RegisterSpi(this);
+        m_api->SubscribePrivateTopic(THOST_TERT_QUICK);
+        m_api->SubscribePublicTopic(THOST_TERT_QUICK);
+        m_api->RegisterFront(const_cast<char*>("tcp://127.0.0.1:0"));
+        m_api->Init();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, kReadyTimeout, [this] { return m_ready || m_failed; }) && m_ready;
+    }
+
+    /// 持续成交直到 stop 置位, 某对报单未按时成交时返回false
+    bool Run(const std::atomic<bool>& stop) {
+        int openPairs[2] = {0, 0};
+        for (int round = 0; !stop.load(); ++round) {
+            const int leg = round & 1;
+            const bool close = openPairs[leg] > 0 && round % 3 == 2;
+            if (!SendPair(m_scenario.legs[leg], close)) {
+                return false;
+            }
+            openPairs[leg] += close ? -1 : 1;
+            std::this_thread::sleep_for(kPairInterval);
+        }
+        return true;
+    }
+
+    /// 查询账户持仓, 按合约汇总多空持仓量
+    bool QueryPositions(std::map<std::string, Volume>& volumes) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_positions.clear();
+            m_positionsDone = false;
+        }
+        CThostFtdcQryInvestorPositionField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.InvestorID, m_scenario.user);
+        if (!SendQuery([this, &req] { return m_api->ReqQryInvestorPosition(&req, ++m_nextRequestId); })) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_cond.wait_for(lock, kReadyTimeout, [this] { return m_positionsDone; })) {
+            return false;
+        }
+        volumes = m_positions;
+        return true;
+    }
+
+    /// 查询资金账户
+    bool QueryAccount(CThostFtdcTradingAccountField& account) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_accountDone = false;
+        }
+        CThostFtdcQryTradingAccountField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.InvestorID, m_scenario.user);
+        if (!SendQuery([this, &req] { return m_api->ReqQryTradingAccount(&req, ++m_nextRequestId); })) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_cond.wait_for(lock, kReadyTimeout, [this] { return m_accountDone; })) {
+            return false;
+        }
+        account = m_account;
+        return true;
+    }
+
+    uint64_t Trades() const { return m_trades.load(); }
+
+    virtual void OnFrontConnected() override {
+        CThostFtdcReqUserLoginField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.UserID, m_scenario.user);
+        CopyField(req.Password, m_scenario.user);
+        m_api->ReqUserLogin(&req, ++m_nextRequestId);
+    }
+
+    virtual void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                                int, bool) override {
+        if ((pRspInfo && pRspInfo->ErrorID != 0) || !pRspUserLogin) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_failed = true;
+            m_cond.notify_all();
+            return;
+        }
+        m_nextRef = atoi(pRspUserLogin->MaxOrderRef) + 1;
+        CThostFtdcSettlementInfoConfirmField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.InvestorID, m_scenario.user);
+        m_api->ReqSettlementInfoConfirm(&req, ++m_nextRequestId);
+    }
+
+    virtual void OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *, CThostFtdcRspInfoField *pRspInfo,
+                                            int, bool) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ready = !(pRspInfo && pRspInfo->ErrorID != 0);
+        m_failed = !m_ready;
+        m_cond.notify_all();
+    }
+
+    virtual void OnRtnTrade(CThostFtdcTradeField *) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_trades.fetch_add(1);
+        m_cond.notify_all();
+    }
+
+    virtual void OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *pInvestorPosition,
+                                          CThostFtdcRspInfoField *, int, bool bIsLast) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pInvestorPosition) {
+            Volume& volume = m_positions[pInvestorPosition->InstrumentID];
+            if (pInvestorPosition->PosiDirection == THOST_FTDC_PD_Short) {
+                volume.shortVolume += pInvestorPosition->Position;
+            } else {
+                volume.longVolume += pInvestorPosition->Position;
+            }
+        }
+        if (bIsLast) {
+            m_positionsDone = true;
+            m_cond.notify_all();
+        }
+    }
+
+    virtual void OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTradingAccount, CThostFtdcRspInfoField *,
+                                        int, bool bIsLast) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pTradingAccount) {
+            m_account = *pTradingAccount;
+        }
+        if (bIsLast) {
+            m_accountDone = true;
+            m_cond.notify_all();
+        }
+    }
+
+private:
+    /// 查询每秒1笔, 被流控时稍后重发
+    template <typename Send>
+    bool SendQuery(Send send) {
+        const auto deadline = std::chrono::steady_clock::now() + kReadyTimeout;
+        while (send() != 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(kQueryRetry);
+        }
+        return true;
+    }
+
+    bool SendPair(const Scenario::Leg& leg, bool close) {
+        const uint64_t target = m_trades.load() + 2;
+        // 平仓对先卖平多头再买平空头, 开仓对先买后卖
+        const char first = close ? THOST_FTDC_D_Sell : THOST_FTDC_D_Buy;
+        const char second = close ? THOST_FTDC_D_Buy : THOST_FTDC_D_Sell;
+        const char offset = close ? leg.closeFlag : THOST_FTDC_OF_Open;
+        if (!SendOrder(leg, first, offset) || !SendOrder(leg, second, offset)) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, kFillTimeout, [this, target] { return m_trades.load() >= target; });
+    }
+
+    bool SendOrder(const Scenario::Leg& leg, char direction, char offset) {
+        CThostFtdcInputOrderField req;
+        memset(&req, 0, sizeof(req));
+        CopyField(req.BrokerID, kBrokerId);
+        CopyField(req.InvestorID, m_scenario.user);
+        CopyField(req.UserID, m_scenario.user);
+        CopyField(req.InstrumentID, leg.instrumentId);
+        CopyField(req.ExchangeID, leg.exchangeId);
+        snprintf(req.OrderRef, sizeof(req.OrderRef), "%d", m_nextRef++);
+        req.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
+        req.Direction = direction;
+        req.LimitPrice = leg.price;
+        req.CombOffsetFlag[0] = offset;
+        req.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
+        req.VolumeTotalOriginal = 1;
+        req.TimeCondition = THOST_FTDC_TC_GFD;
+        req.VolumeCondition = THOST_FTDC_VC_AV;
+        req.MinVolume = 1;
+        req.ContingentCondition = THOST_FTDC_CC_Immediately;
+        req.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
+        return m_api->ReqOrderInsert(&req, ++m_nextRequestId) == 0;
+    }
+
+    const Scenario& m_scenario;
+    CThostFtdcTraderApi* m_api;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_ready;
+    bool m_failed;
+    std::atomic<uint64_t> m_trades;
+    std::map<std::string, Volume> m_positions;
+    bool m_positionsDone;
+    CThostFtdcTradingAccountField m_account;
+    bool m_accountDone;
+    int m_nextRef;
+    std::atomic<int> m_nextRequestId;
+};
+
+///
+/// @brief 一个场景的检验过程
+///
+class ScenarioCheck {
+public:
+    explicit ScenarioCheck(const Scenario& scenario)
+        : m_scenario(scenario), m_peer(scenario), m_symbols(256),
+          m_instruments(std::string("./flow_") + scenario.user + "/"), m_positions(m_symbols.Capacity(), kOrderCapacity), m_funds(m_symbols.Capacity(), kOrderCapacity),
+          m_ok(false) {}
+
+    void Run() { m_ok = RunChecked(); }
+
+    bool Ok() const { return m_ok; }
+    const std::string& Message() const { return m_message; }
+
+private:
+    bool Fail(const std::string& message) {
+        m_message = message;
+        return false;
+    }
+
+    bool RunChecked() {
+        if (!m_peer.Connect()) {
+            return Fail("成交方登录失败");
+        }
+        std::atomic<bool> stop(false);
+        bool peerOk = true;
+        std::thread peer([this, &stop, &peerOk] { peerOk = m_peer.Run(stop); });
+        std::this_thread::sleep_for(kLeadTime);
+
+        // 断线重连一次并完成启动查询后, 再让成交方继续成交一段时间
+        const uint64_t tradesBeforeLogin = m_peer.Trades();
+        const std::string front = std::string("tcp://127.0.0.1:0?faults=") + m_scenario.faults;
+        CThostFtdcTraderApi* api = CThostFtdcTraderApi::CreateFtdcTraderApi("./flow/");
+        ControlEvents control;
+        RecoveryTracker recovery;
+        bool resynced = false;
+        {
+            TraderSpi spi(api, control, kOrderCapacity);
+            spi.SetLoginInfo(front, kBrokerId, m_scenario.user, m_scenario.user);
+            spi.SetInvestorId(m_scenario.user);
+            spi.SetSymbolTable(&m_symbols);
+            spi.SetInstrumentCache(&m_instruments);
+            spi.SetPositionKeeper(&m_positions);
+            spi.SetFundsEstimator(&m_funds);
+            spi.SetRecoveryTracker(&recovery);
+            spi.Start();
+            api->RegisterSpi(&spi);
+            api->SubscribePrivateTopic(THOST_TERT_QUICK);
+            api->SubscribePublicTopic(THOST_TERT_QUICK);
+            api->RegisterFront(const_cast<char*>(front.c_str()));
+            api->Init();
+
+            const auto deadline = std::chrono::steady_clock::now() + kResyncTimeout;
+            while (!(resynced = recovery.Summary(kRecoveryResync).count >= 1) &&
+                   std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            if (resynced) {
+                std::this_thread::sleep_for(kTailTime);
+            }
+            stop.store(true);
+            peer.join();
+            if (resynced && peerOk) {
+                resynced = Settle();
+            }
+            spi.Stop();
+            api->Release();
+        }
+        if (!peerOk) {
+            return Fail("成交方的报单未按时成交");
+        }
+        if (!resynced && m_message.empty()) {
+            return Fail("TraderSpi 未在时限内完成断线重连和启动查询");
+        }
+        if (!m_message.empty()) {
+            return false;
+        }
+        std::cout << m_scenario.name << ": 成交 " << m_peer.Trades() << " 笔, 其中 TraderSpi 登录前 "
+                  << tradesBeforeLogin << " 笔, 持仓和资金一致" << std::endl;
+        return true;
+    }
+
+    /// 等待 TraderSpi 的持仓和资金与成交方查询到的一致
+    bool Settle() {
+        std::map<std::string, Volume> expected;
+        if (!m_peer.QueryPositions(expected)) {
+            return Fail("成交方查询持仓失败");
+        }
+        CThostFtdcTradingAccountField account;
+        if (!m_peer.QueryAccount(account)) {
+            return Fail("成交方查询资金失败");
+        }
+        const auto deadline = std::chrono::steady_clock::now() + kSettleTimeout;
+        std::string mismatch;
+        do {
+            mismatch = Compare(expected);
+            if (mismatch.empty()) {
+                mismatch = CompareFunds(account);
+            }
+            if (mismatch.empty()) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        } while (std::chrono::steady_clock::now() < deadline);
+        if (!mismatch.empty()) {
+            return Fail(mismatch);
+        }
+        if (m_positions.Shortfall() != 0) {
+            return Fail("成交时持仓不足 " + std::to_string(m_positions.Shortfall()) + " 手");
+        }
+        return true;
+    }
+
+    std::string Compare(const std::map<std::string, Volume>& expected) const {
+        for (int i = 0; i < 2; ++i) {
+            const std::string instrumentId = m_scenario.legs[i].instrumentId;
+            const auto it = expected.find(instrumentId);
+            const Volume want = it != expected.end() ? it->second : Volume();
+            Position position = Position();
+            const uint32_t symbolId = m_symbols.Find(instrumentId);
+            if (symbolId != kInvalidSymbol) {
+                m_positions.Read(symbolId, position);
+            }
+            const int longVolume = position.longToday + position.longYesterday;
+            const int shortVolume = position.shortToday + position.shortYesterday;
+            if (longVolume != want.longVolume || shortVolume != want.shortVolume) {
+                return instrumentId + " 持仓 多 " + std::to_string(longVolume) + " 空 " +
+                       std::to_string(shortVolume) + ", 前置为 多 " + std::to_string(want.longVolume) + " 空 " +
+                       std::to_string(want.shortVolume);
+            }
+        }
+        return std::string();
+    }
+
+    std::string CompareFunds(const CThostFtdcTradingAccountField& account) const {
+        FundsSnapshot funds;
+        if (!m_funds.Read(funds)) {
+            return "尚未估算资金";
+        }
+        const struct {
+            const char* name;
+            double estimated;
+            double expected;
+        } fields[] = {
+            {"权益", funds.balance, account.Balance},
+            {"可用资金", funds.available, account.Available},
+            {"保证金", funds.currMargin, account.CurrMargin},
+            {"手续费", funds.commission, account.Commission},
+            {"平仓盈亏", funds.closeProfit, account.CloseProfit},
+        };
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+            if (std::fabs(fields[i].estimated - fields[i].expected) > kFundsTolerance) {
+                return std::string(fields[i].name) + " 估算为 " + std::to_string(fields[i].estimated) +
+                       ", 前置为 " + std::to_string(fields[i].expected);
+            }
+        }
+        return std::string();
+    }
+
+    const Scenario& m_scenario;
+    TradingPeer m_peer;
+    SymbolTable m_symbols;
+    InstrumentCache m_instruments;
+    PositionKeeper m_positions;
+    FundsEstimator m_funds;
+    bool m_ok;
+    std::string m_message;
+};
+
+void PrintUsage(const char* programName) {
+    std::cout << "使用方法: " << programName << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -h          显示帮助信息" << std::endl;
+}
+
+} // namespace
+
+///
+/// @brief 主函数
+///
+int main(int argc, char* argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "h")) != -1) {
+        PrintUsage(argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+
+    if (!AsyncLogger::Instance().Start("ctp_position_test.log", false)) {
+        std::cout << "[警告] 无法打开日志文件 ctp_position_test.log" << std::endl;
+    }
+    SimFront::Instance().Configure(SimFrontOptions());
+
+    const size_t count = sizeof(kScenarios) / sizeof(kScenarios[0]);
+    std::vector<std::unique_ptr<ScenarioCheck>> checks;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; ++i) {
+        checks.emplace_back(new ScenarioCheck(kScenarios[i]));
+        threads.emplace_back(&ScenarioCheck::Run, checks.back().get());
+    }
+    bool ok = true;
+    for (size_t i = 0; i < count; ++i) {
+        threads[i].join();
+        if (!checks[i]->Ok()) {
+            std::cout << "[失败] " << kScenarios[i].name << ": " << checks[i]->Message() << std::endl;
+            ok = false;
+        }
+    }
+    checks.clear();
+
+    SimFront::Instance().Stop();
+    AsyncLogger::Instance().Stop();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+///
+/// @file QueryScheduler.cpp
+/// @brief 查询请求调度器实现
+///
+
+#include "QueryScheduler.h"
+
+#include <algorithm>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+// 空闲时的最长休眠时间
+const std::chrono::seconds kIdleWait(1);
+
+// CTP请求返回码: 未处理请求超过许可数 / 每秒发送请求数超过许可数
+const int kCtpTooManyPending = -2;
+const int kCtpTooManyPerSecond = -3;
+
+} // namespace
+
+QueryScheduler::QueryScheduler(std::function<int()> nextRequestId, const QuerySchedulerOptions& options)
+    : m_nextRequestId(nextRequestId), m_options(options), m_running(false),
+      m_throttledInFlight(0), m_nextSeq(0), m_generation(0),
+      m_tokens(std::max(1.0, options.queriesPerSecond)), m_lastRefill(Clock::now()) {}
+
+QueryScheduler::~QueryScheduler() {
+    Stop();
+}
+
+void QueryScheduler::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_lastRefill = Clock::now();
+    m_thread = std::thread(&QueryScheduler::Run, this);
+}
+
+void QueryScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+}
+
+void QueryScheduler::Submit(const std::string& name, int priority, const Sender& sender, bool throttled,
+                            const Abandoned& abandoned) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Task task;
+        task.seq = m_nextSeq++;
+        task.priority = priority;
+        task.throttled = throttled;
+        task.attempts = 0;
+        task.backoffMs = m_options.retryBackoffMs;
+        task.notBefore = Clock::now();
+        task.name = name;
+        task.sender = sender;
+        task.abandoned = abandoned;
+        m_pending.insert(task);
+    }
+    m_cond.notify_one();
+}
+
+void QueryScheduler::OnResponse(int requestId) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<int, InFlight>::iterator it = m_inFlight.find(requestId);
+        if (it == m_inFlight.end()) {
+            return;
+        }
+        if (it->second.task.throttled) {
+            --m_throttledInFlight;
+        }
+        m_inFlight.erase(it);
+    }
+    m_cond.notify_one();
+}
+
+bool QueryScheduler::OnError(int requestId) {
+    Abandoned abandoned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<int, InFlight>::iterator it = m_inFlight.find(requestId);
+        if (it == m_inFlight.end()) {
+            return false;
+        }
+        const Task& task = it->second.task;
+        if (task.throttled) {
+            --m_throttledInFlight;
+        }
+        LOG("[错误] {}请求收到错误应答, RequestID: {}, 放弃", task.name, requestId);
+        abandoned = task.abandoned;
+        m_inFlight.erase(it);
+    }
+    m_cond.notify_one();
+    if (abandoned) {
+        abandoned(requestId);
+    }
+    return true;
+}
+
+bool QueryScheduler::IsCurrent(int requestId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inFlight.find(requestId) != m_inFlight.end();
+}
+
+void QueryScheduler::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.clear();
+        m_inFlight.clear();
+        m_abandoned.clear();
+        m_throttledInFlight = 0;
+        ++m_generation;
+    }
+    m_cond.notify_one();
+}
+
+size_t QueryScheduler::Outstanding() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size() + m_inFlight.size();
+}
+
+void QueryScheduler::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        const Clock::time_point now = Clock::now();
+        Clock::time_point wakeAt = now + kIdleWait;
+
+        Refill(now);
+        ExpireInFlight(now, wakeAt);
+        if (!m_abandoned.empty()) {
+            NotifyAbandoned(lock);
+            continue;
+        }
+
+        Task task;
+        if (!PopReady(now, task, wakeAt)) {
+            m_cond.wait_until(lock, wakeAt);
+            continue;
+        }
+
+        // 发送前先登记在途并预占额度, 发送时不持有锁, 以免阻塞回调处理线程的 OnResponse();
+        // 响应可能在 sender 返回之前到达, 因此必须在发送前登记
+        if (task.throttled) {
+            m_tokens -= 1.0;
+            ++m_throttledInFlight;
+        }
+        ++task.attempts;
+        const int requestId = m_nextRequestId();
+        InFlight& inFlight = m_inFlight[requestId];
+        inFlight.task = task;
+        inFlight.sentAt = now;
+
+        const uint64_t generation = m_generation;
+        lock.unlock();
+        const int result = task.sender(requestId);
+        lock.lock();
+
+        if (generation != m_generation) {
+            // 发送期间发生了断线重置, 结果作废
+            continue;
+        }
+        HandleSendResult(task, requestId, result);
+    }
+}
+
+void QueryScheduler::Refill(Clock::time_point now) {
+    const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_lastRefill = now;
+    const double burst = std::max(1.0, m_options.queriesPerSecond);
+    m_tokens = std::min(burst, m_tokens + elapsed * m_options.queriesPerSecond);
+}
+
+void QueryScheduler::ExpireInFlight(Clock::time_point now, Clock::time_point& wakeAt) {
+    const Clock::duration timeout = std::chrono::milliseconds(m_options.responseTimeoutMs);
+    for (std::map<int, InFlight>::iterator it = m_inFlight.begin(); it != m_inFlight.end();) {
+        const Clock::time_point deadline = it->second.sentAt + timeout;
+        if (deadline > now) {
+            wakeAt = std::min(wakeAt, deadline);
+            ++it;
+            continue;
+        }
+
+        Task task = it->second.task;
+        if (task.throttled) {
+            --m_throttledInFlight;
+        }
+        if (task.attempts < m_options.maxAttempts) {
+            LOG("[警告] {}请求等待响应超时, RequestID: {}, 重新发送", task.name, it->first);
+            task.notBefore = now;
+            m_pending.insert(task);
+        } else {
+            LOG("[错误] {}请求等待响应超时, RequestID: {}, 已达最大重试次数, 放弃", task.name, it->first);
+            Abandon(task, it->first);
+        }
+        m_inFlight.erase(it++);
+    }
+}
+
+bool QueryScheduler::PopReady(Clock::time_point now, Task& task, Clock::time_point& wakeAt) {
+    for (std::set<Task>::iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (it->notBefore > now) {
+            wakeAt = std::min(wakeAt, it->notBefore);
+            continue;
+        }
+        if (it->throttled) {
+            if (m_throttledInFlight >= m_options.maxInFlight) {
+                // 等待 OnResponse() 唤醒
+                continue;
+            }
+            if (m_tokens < 1.0) {
+                const double waitSeconds = (1.0 - m_tokens) / m_options.queriesPerSecond;
+                wakeAt = std::min(wakeAt, now + std::chrono::duration_cast<Clock::duration>(
+                                                    std::chrono::duration<double>(waitSeconds)));
+                continue;
+            }
+        }
+        task = *it;
+        m_pending.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void QueryScheduler::HandleSendResult(Task& task, int requestId, int result) {
+    if (result == 0) {
+        LOG("[请求] 发送{}请求, RequestID: {}", task.name, requestId);
+        return;
+    }
+
+    // 发送失败, 撤销在途登记
+    if (m_inFlight.erase(requestId) > 0 && task.throttled) {
+        --m_throttledInFlight;
+    }
+
+    if (result == kCtpTooManyPending || result == kCtpTooManyPerSecond) {
+        // 被前置流控: 不计入重试次数, 退避后重新排队
+        --task.attempts;
+        if (result == kCtpTooManyPerSecond) {
+            m_tokens = std::min(m_tokens, 0.0);
+        }
+        LOG("[流控] {}请求被拒绝, 返回码: {}, {}ms后重试", task.name, result, task.backoffMs);
+    } else if (task.attempts < m_options.maxAttempts) {
+        LOG("[错误] 发送{}请求失败, 返回码: {}, {}ms后重试", task.name, result, task.backoffMs);
+    } else {
+        LOG("[错误] 发送{}请求失败, 返回码: {}, 已达最大重试次数, 放弃", task.name, result);
+        Abandon(task, 0);
+        return;
+    }
+
+    task.notBefore = Clock::now() + std::chrono::milliseconds(task.backoffMs);
+    task.backoffMs = std::min(task.backoffMs * 2, m_options.maxRetryBackoffMs);
+    m_pending.insert(task);
+}
+
+void QueryScheduler::Abandon(const Task& task, int requestId) {
+    if (task.abandoned) {
+        m_abandoned.push_back(std::make_pair(task.abandoned, requestId));
+    }
+}
+
+void QueryScheduler::NotifyAbandoned(std::unique_lock<std::mutex>& lock) {
+    std::vector<std::pair<Abandoned, int> > abandoned;
+    abandoned.swap(m_abandoned);
+    lock.unlock();
+    for (size_t i = 0; i < abandoned.size(); ++i) {
+        abandoned[i].first(abandoned[i].second);
+    }
+    lock.lock();
+}
@@ -0,0 +1,167 @@
+///
+/// @file QueryScheduler.h
+/// @brief 查询请求调度器, 按CTP查询流控节奏发送并在被流控时重试
+///
+
+#ifndef CTP_TEST_QUERY_SCHEDULER_H
+#define CTP_TEST_QUERY_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///
+/// @brief 查询优先级, 数值越小越先发送
+///
+enum QueryPriority {
+    kQueryPriorityHigh = 0,
+    kQueryPriorityNormal = 1,
+    kQueryPriorityLow = 2,
+};
+
+///
+/// @brief 调度参数
+///
+struct QuerySchedulerOptions {
+    double queriesPerSecond;    ///< 每秒允许发送的查询数 (CTP默认1笔/秒)
+    int maxInFlight;            ///< 同时等待响应的查询数上限
+    int retryBackoffMs;         ///< 被流控后的首次重试间隔, 之后按倍数退避
+    int maxRetryBackoffMs;      ///< 重试间隔上限
+    int responseTimeoutMs;      ///< 等待响应超时, 超时后释放名额并重发
+    int maxAttempts;            ///< 单个查询的最大发送次数(含超时重发)
+
+    QuerySchedulerOptions()
+        : queriesPerSecond(1.0), maxInFlight(1), retryBackoffMs(200), maxRetryBackoffMs(2000),
+          responseTimeoutMs(10000), maxAttempts(5) {}
+};
+
+///
+/// @brief 查询请求调度器
+///
+/// 所有 ReqQry* 请求经 Submit() 提交, 由调度线程按优先级取出,
+/// 在令牌桶和在途数量允许时立即发送。Req* 返回 -2(未处理请求超限) 或
+/// -3(每秒请求超限) 时按指数退避重新排队, 不再因一次被拒而中断后续查询。
+/// 收到 bIsLast 响应后须调用 OnResponse() 释放在途名额。响应超时的请求以新的 RequestID
+/// 重发, 调用方须先以 IsCurrent() 检查 RequestID, 丢弃原请求迟到的响应, 以免多行结果被累加两次。
+///
+/// 每个请求最终只有一个结局: 调用方处理响应后 OnResponse(), 或被放弃 —— 超时或发送失败达到
+/// 最大次数、收到 OnRspError 后调用方调用 OnError()。被放弃时调用提交时给出的放弃回调,
+/// 回调在放弃它的线程(调度线程或调用 OnError() 的线程)上执行, 执行时不持有调度器的锁。
+/// Reset() 丢弃的请求不调用放弃回调。
+///
+class QueryScheduler {
+public:
+    /// 发送函数: 参数为RequestID, 返回CTP Req*函数的返回码
+    typedef std::function<int(int)> Sender;
+
+    /// 放弃回调: 参数为最后一次发送使用的RequestID, 一次都未发出时为0
+    typedef std::function<void(int)> Abandoned;
+
+    /// @param nextRequestId 分配RequestID的函数, 可能被多个线程调用
+    explicit QueryScheduler(std::function<int()> nextRequestId,
+                            const QuerySchedulerOptions& options = QuerySchedulerOptions());
+    ~QueryScheduler();
+
+    QueryScheduler(const QueryScheduler&) = delete;
+    QueryScheduler& operator=(const QueryScheduler&) = delete;
+
+    void Start();
+    void Stop();
+
+    /// 提交请求
+    /// @param name      请求名称, 用于日志
+    /// @param priority  优先级
+    /// @param sender    发送函数
+    /// @param throttled 是否占用查询流控额度; 结算确认等非查询请求传false
+    /// @param abandoned 放弃该请求时的回调, 可为空
+    void Submit(const std::string& name, int priority, const Sender& sender, bool throttled = true,
+                const Abandoned& abandoned = Abandoned());
+
+    /// 收到请求的最后一条响应时调用
+    void OnResponse(int requestId);
+
+    /// 收到请求的错误应答(OnRspError)时调用: 释放在途名额并放弃该请求, 调用其放弃回调
+    /// @return requestId 是否属于在途的请求
+    bool OnError(int requestId);
+
+    /// requestId 是否仍在等待响应; 超时重发后原请求的 RequestID 不再在途, 其迟到的响应应丢弃
+    bool IsCurrent(int requestId) const;
+
+    /// 断线时调用, 丢弃所有排队和在途请求
+    void Reset();
+
+    /// 排队和在途的请求数
+    size_t Outstanding() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Task {
+        uint64_t seq;
+        int priority;
+        bool throttled;
+        int attempts;
+        int backoffMs;
+        Clock::time_point notBefore;
+        std::string name;
+        Sender sender;
+        Abandoned abandoned;
+
+        bool operator<(const Task& other) const {
+            return priority != other.priority ? priority < other.priority : seq < other.seq;
+        }
+    };
+
+    struct InFlight {
+        Task task;
+        Clock::time_point sentAt;
+    };
+
+    void Run();
+
+    /// 补充令牌
+    void Refill(Clock::time_point now);
+
+    /// 处理响应超时的在途请求, 同时用最近的超时时刻更新 wakeAt
+    void ExpireInFlight(Clock::time_point now, Clock::time_point& wakeAt);
+
+    /// 取出下一个可发送的请求, 同时计算下一次需要醒来的时间
+    bool PopReady(Clock::time_point now, Task& task, Clock::time_point& wakeAt);
+
+    /// 发送结果处理: 失败时撤销在途登记, 被流控则退避后重新排队
+    void HandleSendResult(Task& task, int requestId, int result);
+
+    /// 登记放弃的请求, 由 Run() 释放锁后统一调用放弃回调
+    void Abandon(const Task& task, int requestId);
+
+    /// 调用已登记的放弃回调; 期间释放锁
+    void NotifyAbandoned(std::unique_lock<std::mutex>& lock);
+
+    std::function<int()> m_nextRequestId;
+    const QuerySchedulerOptions m_options;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    bool m_running;
+
+    std::set<Task> m_pending;
+    std::map<int, InFlight> m_inFlight;
+    std::vector<std::pair<Abandoned, int> > m_abandoned;    ///< 待调用的放弃回调和RequestID
+    int m_throttledInFlight;
+    uint64_t m_nextSeq;
+    uint64_t m_generation;      ///< Reset() 时递增, 丢弃旧代次请求的发送结果
+
+    double m_tokens;
+    Clock::time_point m_lastRefill;
+};
+
+#endif // CTP_TEST_QUERY_SCHEDULER_H
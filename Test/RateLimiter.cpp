@@ -0,0 +1,161 @@
+///
+/// @file RateLimiter.cpp
+/// @brief 报单/撤单流控实现
+///
+
+#include "RateLimiter.h"
+
+#include <cstring>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+const double kNsPerSecond = 1e9;
+
+inline int64_t IntervalOf(double perSecond) {
+    return perSecond > 0.0 ? static_cast<int64_t>(kNsPerSecond / perSecond) : 0;
+}
+
+} // namespace
+
+RateLimiter::RateLimiter(const RateLimiterOptions& options)
+    : m_options(options), m_baseIntervalNs(IntervalOf(options.sessionPerSecond)),
+      m_maxIntervalNs(IntervalOf(options.minPerSecond)), m_exchangeCount(0), m_lastDecreaseNs(0), m_lastIncreaseNs(0),
+      m_allowed(0), m_delayed(0), m_sessionLimited(0), m_exchangeLimited(0),
+      m_tooManyPending(0), m_tooManyPerSecond(0), m_decreases(0), m_increases(0) {
+    m_session.tatNs.store(0, std::memory_order_relaxed);
+    m_session.intervalNs.store(m_baseIntervalNs, std::memory_order_relaxed);
+    m_session.burst = options.sessionBurst > 0 ? options.sessionBurst : 1;
+    memset(m_session.exchangeId, 0, sizeof(m_session.exchangeId));
+    for (int i = 0; i < kRateMaxExchanges; ++i) {
+        Bucket& bucket = m_exchanges[i];
+        bucket.tatNs.store(0, std::memory_order_relaxed);
+        bucket.intervalNs.store(IntervalOf(options.exchangePerSecond), std::memory_order_relaxed);
+        bucket.burst = options.exchangeBurst > 0 ? options.exchangeBurst : 1;
+        memset(bucket.exchangeId, 0, sizeof(bucket.exchangeId));
+    }
+}
+
+int RateLimiter::RegisterExchange(const char* exchangeId) {
+    for (int i = 0; i < m_exchangeCount; ++i) {
+        if (strncmp(m_exchanges[i].exchangeId, exchangeId, sizeof(m_exchanges[i].exchangeId) - 1) == 0) {
+            return i;
+        }
+    }
+    if (m_exchangeCount >= kRateMaxExchanges) {
+        LOG("[警告] 交易所 {} 超出流控令牌桶数 {}, 只受会话流控限制", exchangeId, kRateMaxExchanges);
+        return -1;
+    }
+    Bucket& bucket = m_exchanges[m_exchangeCount];
+    strncpy(bucket.exchangeId, exchangeId, sizeof(bucket.exchangeId) - 1);
+    return m_exchangeCount++;
+}
+
+int64_t RateLimiter::Reserve(Bucket& bucket, int64_t nowNs, int64_t maxQueueNs) {
+    const int64_t interval = bucket.intervalNs.load(std::memory_order_relaxed);
+    const int64_t tolerance = (bucket.burst - 1) * interval;
+    int64_t tat = bucket.tatNs.load(std::memory_order_relaxed);
+    while (true) {
+        int64_t wait = tat - tolerance - nowNs;
+        wait = wait > 0 ? wait : 0;
+        if (wait > maxQueueNs) {
+            return -1;
+        }
+        const int64_t next = (tat > nowNs ? tat : nowNs) + interval;
+        if (bucket.tatNs.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+            return wait;
+        }
+    }
+}
+
+int64_t RateLimiter::Acquire(int exchange, int64_t nowNs, int64_t maxQueueNs) {
+    const int64_t sessionWait = Reserve(m_session, nowNs, maxQueueNs);
+    if (sessionWait < 0) {
+        m_sessionLimited.fetch_add(1, std::memory_order_relaxed);
+        return kRateSessionLimited;
+    }
+    int64_t wait = sessionWait;
+    if (exchange >= 0) {
+        const int64_t exchangeWait = Reserve(m_exchanges[exchange], nowNs, maxQueueNs);
+        if (exchangeWait < 0) {
+            // 退还会话令牌
+            m_session.tatNs.fetch_sub(m_session.intervalNs.load(std::memory_order_relaxed),
+                                      std::memory_order_relaxed);
+            m_exchangeLimited.fetch_add(1, std::memory_order_relaxed);
+            return kRateExchangeLimited;
+        }
+        wait = exchangeWait > wait ? exchangeWait : wait;
+    }
+    (wait == 0 ? m_allowed : m_delayed).fetch_add(1, std::memory_order_relaxed);
+    return wait;
+}
+
+void RateLimiter::Release(int exchange) {
+    m_session.tatNs.fetch_sub(m_session.intervalNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (exchange >= 0) {
+        Bucket& bucket = m_exchanges[exchange];
+        bucket.tatNs.fetch_sub(bucket.intervalNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void RateLimiter::OnSent(int64_t nowNs) {
+    // 未被下调时只有一次读
+    const int64_t interval = m_session.intervalNs.load(std::memory_order_relaxed);
+    if (interval <= m_baseIntervalNs) {
+        return;
+    }
+    int64_t last = m_lastIncreaseNs.load(std::memory_order_relaxed);
+    if (nowNs - last < m_options.recoveryNs ||
+        nowNs - m_lastDecreaseNs.load(std::memory_order_relaxed) < m_options.recoveryNs ||
+        !m_lastIncreaseNs.compare_exchange_strong(last, nowNs, std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t next = IntervalOf(kNsPerSecond / interval + m_options.recoveryPerSecond);
+    next = next > m_baseIntervalNs ? next : m_baseIntervalNs;
+    m_session.intervalNs.store(next, std::memory_order_relaxed);
+    m_increases.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RateLimiter::OnRejected(int result, int64_t nowNs) {
+    if (result == kCtpTooManyPending) {
+        m_tooManyPending.fetch_add(1, std::memory_order_relaxed);
+    } else if (result == kCtpTooManyPerSecond) {
+        m_tooManyPerSecond.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        return;
+    }
+
+    // CTP按秒统计, 同一秒内的超限通常让多笔报单先后被拒, 一个恢复周期内只下调一次
+    int64_t interval = m_session.intervalNs.load(std::memory_order_relaxed);
+    int64_t last = m_lastDecreaseNs.load(std::memory_order_relaxed);
+    if (nowNs - last >= m_options.recoveryNs && interval < m_maxIntervalNs &&
+        m_lastDecreaseNs.compare_exchange_strong(last, nowNs, std::memory_order_relaxed)) {
+        const int64_t slower = static_cast<int64_t>(interval / m_options.decreaseFactor);
+        interval = slower < m_maxIntervalNs ? slower : m_maxIntervalNs;
+        m_session.intervalNs.store(interval, std::memory_order_relaxed);
+        m_decreases.fetch_add(1, std::memory_order_relaxed);
+        LOG("[警告] 报单被CTP流控 (返回码 {}), 会话速率下调至 {} 笔/秒", result, kNsPerSecond / interval);
+    }
+
+    // 推后理论到达时刻, 已在排队的报单按新间隔发送
+    const int64_t pause = nowNs + interval;
+    int64_t tat = m_session.tatNs.load(std::memory_order_relaxed);
+    while (tat < pause && !m_session.tatNs.compare_exchange_weak(tat, pause, std::memory_order_relaxed)) {
+    }
+}
+
+RateLimiterStats RateLimiter::GetStats() const {
+    RateLimiterStats stats;
+    stats.allowed = m_allowed.load(std::memory_order_relaxed);
+    stats.delayed = m_delayed.load(std::memory_order_relaxed);
+    stats.sessionLimited = m_sessionLimited.load(std::memory_order_relaxed);
+    stats.exchangeLimited = m_exchangeLimited.load(std::memory_order_relaxed);
+    stats.tooManyPending = m_tooManyPending.load(std::memory_order_relaxed);
+    stats.tooManyPerSecond = m_tooManyPerSecond.load(std::memory_order_relaxed);
+    stats.decreases = m_decreases.load(std::memory_order_relaxed);
+    stats.increases = m_increases.load(std::memory_order_relaxed);
+    const int64_t interval = m_session.intervalNs.load(std::memory_order_relaxed);
+    stats.sessionPerSecond = interval > 0 ? kNsPerSecond / interval : 0.0;
+    return stats;
+}
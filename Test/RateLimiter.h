@@ -0,0 +1,142 @@
+///
+/// @file RateLimiter.h
+/// @brief 报单/撤单流控: 按会话和交易所的令牌桶, 根据CTP返回的 -2/-3 自适应调整会话速率
+///
+
+#ifndef CTP_TEST_RATE_LIMITER_H
+#define CTP_TEST_RATE_LIMITER_H
+
+#include <atomic>
+#include <cstdint>
+
+/// 流控结果
+const int kRateAllowed = 0;
+const int kRateSessionLimited = -103;       ///< 会话令牌桶在允许的排队时间内没有令牌
+const int kRateExchangeLimited = -104;      ///< 交易所令牌桶在允许的排队时间内没有令牌
+
+/// CTP Req* 函数返回码: 未处理请求超过许可数 / 每秒发送请求数超过许可数
+const int kCtpTooManyPending = -2;
+const int kCtpTooManyPerSecond = -3;
+
+/// 交易所令牌桶数上限, 超出的交易所只受会话令牌桶限制
+const int kRateMaxExchanges = 8;
+
+///
+/// @brief 流控参数
+///
+struct RateLimiterOptions {
+    double sessionPerSecond;        ///< 会话每秒报单+撤单数, 通常等于期货公司设置的报单流控
+    int sessionBurst;               ///< 会话允许的突发笔数
+    double exchangePerSecond;       ///< 每个交易所每秒报单+撤单数
+    int exchangeBurst;              ///< 每个交易所允许的突发笔数
+    int64_t maxQueueNs;             ///< 没有令牌时最多排队等待的时间, 0表示立即拒绝
+    double minPerSecond;            ///< 自适应下调的会话速率下限
+    double decreaseFactor;          ///< 被流控时会话速率乘以该系数
+    double recoveryPerSecond;       ///< 每个恢复周期会话速率回升的笔数
+    int64_t recoveryNs;             ///< 恢复周期, 上次下调后至少间隔这么久才回升
+
+    RateLimiterOptions()
+        : sessionPerSecond(20.0), sessionBurst(5), exchangePerSecond(20.0), exchangeBurst(5),
+          maxQueueNs(0), minPerSecond(1.0), decreaseFactor(0.75), recoveryPerSecond(1.0),
+          recoveryNs(1000000000LL) {}
+};
+
+///
+/// @brief 流控统计
+///
+struct RateLimiterStats {
+    uint64_t allowed;               ///< 立即放行的笔数
+    uint64_t delayed;               ///< 排队后放行的笔数
+    uint64_t sessionLimited;        ///< 因会话流控拒绝的笔数
+    uint64_t exchangeLimited;       ///< 因交易所流控拒绝的笔数
+    uint64_t tooManyPending;        ///< CTP返回 -2 的笔数
+    uint64_t tooManyPerSecond;      ///< CTP返回 -3 的笔数
+    uint64_t decreases;             ///< 会话速率下调次数
+    uint64_t increases;             ///< 会话速率回升次数
+    double sessionPerSecond;        ///< 当前会话速率
+};
+
+///
+/// @brief 报单/撤单流控
+///
+/// 令牌桶按 GCRA 实现: 每个桶只保存一个"理论到达时刻"和发送间隔, 取令牌是对理论到达时刻的
+/// 一次 CAS, 不加锁、无系统调用, 可在任意报单线程并发调用。一笔报单须同时取得会话令牌和
+/// 其交易所的令牌, 后者失败时退还前者。
+///
+/// Acquire() 返回需要等待的纳秒数: 令牌已预留, 调用方等到该时刻再发送; 等待时间超过
+/// maxQueueNs 时不预留并返回 kRate* 拒绝原因。
+///
+/// CTP返回 -2(未处理请求超限) 或 -3(每秒请求超限) 时调用 OnRejected(): 会话速率乘以
+/// decreaseFactor (不低于 minPerSecond, 每个 recoveryNs 最多一次), 并把理论到达时刻推后一个新间隔,
+/// 让正在排队的报单也随之放慢; 最近 recoveryNs 内没有下调时, 每隔 recoveryNs 的成功发送
+/// 让速率增加 recoveryPerSecond, 直到回到 sessionPerSecond。
+/// 即乘性减、加性增, 在期货公司的流控上限附近收敛。
+///
+class RateLimiter {
+public:
+    explicit RateLimiter(const RateLimiterOptions& options = RateLimiterOptions());
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /// 登记交易所, 返回交易所令牌桶下标; 超过 kRateMaxExchanges 时返回 -1。
+    /// 由交易回调处理线程在报单开始前调用
+    int RegisterExchange(const char* exchangeId);
+
+    /// 为一笔报单或撤单取令牌
+    /// @param exchange RegisterExchange() 的返回值, -1 表示只检查会话
+    /// @param nowNs    MonotonicNs()
+    /// @return >= 0 为需要等待的纳秒数; 否则为 kRate* 拒绝原因
+    int64_t Acquire(int exchange, int64_t nowNs) { return Acquire(exchange, nowNs, m_options.maxQueueNs); }
+
+    /// 同上, 指定最长排队时间; 批量撤单用它排队发出全部撤单而不被拒绝
+    int64_t Acquire(int exchange, int64_t nowNs, int64_t maxQueueNs);
+
+    /// 退还 Acquire() 预留但最终没有发送的令牌
+    void Release(int exchange);
+
+    /// Req* 返回0
+    void OnSent(int64_t nowNs);
+
+    /// Req* 返回 -2 / -3
+    void OnRejected(int result, int64_t nowNs);
+
+    /// 默认的最长排队时间
+    int64_t MaxQueueNs() const { return m_options.maxQueueNs; }
+
+    /// 获取统计
+    RateLimiterStats GetStats() const;
+
+private:
+    /// 一个令牌桶, 独占一条缓存行
+    struct alignas(64) Bucket {
+        std::atomic<int64_t> tatNs;         ///< 理论到达时刻
+        std::atomic<int64_t> intervalNs;    ///< 当前发送间隔
+        int burst;                          ///< 突发笔数, 可提前 (burst - 1) 个间隔发送
+        char exchangeId[9];
+    };
+
+    /// 从桶中预留一个令牌, 返回需要等待的纳秒数, 超过 maxQueueNs 时返回 -1 且不预留
+    int64_t Reserve(Bucket& bucket, int64_t nowNs, int64_t maxQueueNs);
+
+    const RateLimiterOptions m_options;
+    const int64_t m_baseIntervalNs;         ///< 会话基准间隔
+    const int64_t m_maxIntervalNs;          ///< 会话最大间隔(速率下限)
+
+    Bucket m_session;
+    Bucket m_exchanges[kRateMaxExchanges];
+    int m_exchangeCount;                    ///< 仅处理线程访问
+    std::atomic<int64_t> m_lastDecreaseNs;  ///< 最近一次下调会话速率的时刻
+    std::atomic<int64_t> m_lastIncreaseNs;  ///< 最近一次回升会话速率的时刻
+
+    std::atomic<uint64_t> m_allowed;
+    std::atomic<uint64_t> m_delayed;
+    std::atomic<uint64_t> m_sessionLimited;
+    std::atomic<uint64_t> m_exchangeLimited;
+    std::atomic<uint64_t> m_tooManyPending;
+    std::atomic<uint64_t> m_tooManyPerSecond;
+    std::atomic<uint64_t> m_decreases;
+    std::atomic<uint64_t> m_increases;
+};
+
+#endif // CTP_TEST_RATE_LIMITER_H
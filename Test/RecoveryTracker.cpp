@@ -0,0 +1,81 @@
+///
+/// @file RecoveryTracker.cpp
+/// @brief 断线恢复耗时统计实现
+///
+
+#include "RecoveryTracker.h"
+
+#include "AsyncLogger.h"
+
+namespace {
+
+int64_t NsToMs(int64_t ns) {
+    return ns / 1000000;
+}
+
+} // namespace
+
+const char* RecoveryStageName(int stage) {
+    switch (stage) {
+        case kRecoveryReconnect:
+            return "断线->重连";
+        case kRecoveryLogin:
+            return "断线->登录";
+        case kRecoveryResync:
+            return "断线->同步完成";
+        default:
+            return "未知";
+    }
+}
+
+RecoveryTracker::RecoveryTracker()
+    : m_state(kIdle), m_reason(0), m_disconnectNs(0), m_disconnects(0), m_interrupted(0) {
+    for (int i = 0; i < kRecoveryStages; ++i) {
+        m_stageNs[i] = 0;
+    }
+}
+
+void RecoveryTracker::OnDisconnected(int reason, int64_t ns) {
+    if (m_state != kIdle) {
+        ++m_interrupted;
+    }
+    ++m_disconnects;
+    m_state = kWaitConnect;
+    m_reason = reason;
+    m_disconnectNs = ns;
+}
+
+void RecoveryTracker::OnConnected(int64_t ns) {
+    if (m_state != kWaitConnect) {
+        return;
+    }
+    m_stageNs[kRecoveryReconnect] = ns - m_disconnectNs;
+    m_histograms[kRecoveryReconnect].Record(m_stageNs[kRecoveryReconnect]);
+    m_state = kWaitLogin;
+}
+
+void RecoveryTracker::OnLogin(int64_t ns) {
+    if (m_state != kWaitLogin) {
+        return;
+    }
+    m_stageNs[kRecoveryLogin] = ns - m_disconnectNs;
+    m_histograms[kRecoveryLogin].Record(m_stageNs[kRecoveryLogin]);
+    m_state = kWaitResync;
+}
+
+void RecoveryTracker::OnResynced(int64_t ns) {
+    if (m_state != kWaitResync) {
+        return;
+    }
+    m_stageNs[kRecoveryResync] = ns - m_disconnectNs;
+    m_histograms[kRecoveryResync].Record(m_stageNs[kRecoveryResync]);
+    m_state = kIdle;
+    LOG("[恢复] 原因码: {} | 重连: {}ms | 登录: {}ms | 同步完成: {}ms", m_reason,
+        NsToMs(m_stageNs[kRecoveryReconnect]), NsToMs(m_stageNs[kRecoveryLogin]),
+        NsToMs(m_stageNs[kRecoveryResync]));
+}
+
+LatencySummary RecoveryTracker::Summary(int stage) const {
+    const LatencyHistogram* histogram = &m_histograms[stage];
+    return LatencyHistogram::Summarize(&histogram, 1);
+}
@@ -0,0 +1,65 @@
+///
+/// @file RecoveryTracker.h
+/// @brief 断线恢复耗时: 从 OnFrontDisconnected 到重连、重新登录和启动查询完成
+///
+
+#ifndef CTP_TEST_RECOVERY_TRACKER_H
+#define CTP_TEST_RECOVERY_TRACKER_H
+
+#include <cstdint>
+
+#include "LatencyHistogram.h"
+
+///
+/// @brief 恢复阶段, 均从断线时刻起算
+///
+enum RecoveryStage {
+    kRecoveryReconnect = 0,     ///< 断线 -> OnFrontConnected
+    kRecoveryLogin,             ///< 断线 -> 登录成功
+    kRecoveryResync,            ///< 断线 -> 启动查询全部完成, 私有流已续传
+    kRecoveryStages,
+};
+
+/// 阶段名称
+const char* RecoveryStageName(int stage);
+
+///
+/// @brief 断线恢复耗时统计
+///
+/// 由 TraderSpi 的处理线程在断线、连接、登录和启动查询完成时调用, 时刻取处理线程处理该事件时,
+/// 即客户端实际感知到的时刻。恢复未完成又断线时从新的断线重新计时, 旧的一次计为中断。
+/// 首次连接和登录不计入。每次恢复完成时记一行日志; Summary() 可在任意线程读取,
+/// 次数在处理线程停止后读取。
+///
+class RecoveryTracker {
+public:
+    RecoveryTracker();
+
+    RecoveryTracker(const RecoveryTracker&) = delete;
+    RecoveryTracker& operator=(const RecoveryTracker&) = delete;
+
+    void OnDisconnected(int reason, int64_t ns);
+    void OnConnected(int64_t ns);
+    void OnLogin(int64_t ns);
+    void OnResynced(int64_t ns);
+
+    /// 断线次数和恢复未完成又断线的次数
+    uint64_t Disconnects() const { return m_disconnects; }
+    uint64_t Interrupted() const { return m_interrupted; }
+
+    LatencySummary Summary(int stage) const;
+
+private:
+    /// 当前阶段: 未断线、等待连接、等待登录、等待同步
+    enum State { kIdle, kWaitConnect, kWaitLogin, kWaitResync };
+
+    State m_state;
+    int m_reason;
+    int64_t m_disconnectNs;
+    int64_t m_stageNs[kRecoveryStages];
+    uint64_t m_disconnects;
+    uint64_t m_interrupted;
+    LatencyHistogram m_histograms[kRecoveryStages];
+};
+
+#endif // CTP_TEST_RECOVERY_TRACKER_H
@@ -0,0 +1,545 @@
+///
+/// @file ReplayMdApi.cpp
+/// @brief 行情回放API实现
+///
+
+#include "ReplayMdApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+#include "FieldCopy.h"
+
+namespace {
+
+const char kScheme[] = "replay://";
+const size_t kSchemeLength = sizeof(kScheme) - 1;
+
+// 距回放时刻超过该值时在条件变量上休眠, 否则空转等待
+const int64_t kPaceSleepNs = 200000;
+
+// 休眠提前醒来的余量, 剩余时间空转, 抵消唤醒延迟
+const int64_t kPaceSpinNs = 100000;
+
+// 合约代码超长、无法驻留时的错误
+const int kErrInstrumentNotFound = 16;
+
+/// 解析 ticks_<交易日>_<分段>.dat, 不匹配时返回false
+bool ParseSegmentName(const char* name, std::string& tradingDay, uint32_t& segment) {
+    static const char kPrefix[] = "ticks_";
+    if (strncmp(name, kPrefix, sizeof(kPrefix) - 1) != 0) {
+        return false;
+    }
+    const char* day = name + sizeof(kPrefix) - 1;
+    const char* sep = strchr(day, '_');
+    if (!sep || sep == day) {
+        return false;
+    }
+    char* end;
+    const unsigned long index = strtoul(sep + 1, &end, 10);
+    if (end == sep + 1 || strcmp(end, ".dat") != 0) {
+        return false;
+    }
+    tradingDay.assign(day, sep);
+    segment = static_cast<uint32_t>(index);
+    return true;
+}
+
+} // namespace
+
+CThostFtdcMdApi* CThostFtdcMdApi::CreateFtdcMdApi(const char *pszFlowPath, const bool, const bool) {
+    return new ReplayMdApi(pszFlowPath);
+}
+
+const char* CThostFtdcMdApi::GetApiVersion() {
+    return "v6.7.7 TickReplay";
+}
+
+ReplayMdOptions ReplayMdOptions::Parse(const std::string& frontAddress, const std::string& defaultDir) {
+    ReplayMdOptions options;
+    options.dir = defaultDir;
+    if (frontAddress.compare(0, kSchemeLength, kScheme) == 0) {
+        const size_t query = frontAddress.find('?', kSchemeLength);
+        const std::string dir = frontAddress.substr(kSchemeLength, query - kSchemeLength);
+        if (!dir.empty()) {
+            options.dir = dir;
+        }
+        size_t begin = query == std::string::npos ? frontAddress.size() : query + 1;
+        while (begin < frontAddress.size()) {
+            size_t end = frontAddress.find('&', begin);
+            if (end == std::string::npos) {
+                end = frontAddress.size();
+            }
+            const std::string item = frontAddress.substr(begin, end - begin);
+            const size_t eq = item.find('=');
+            const std::string key = item.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+            if (key == "day") {
+                options.tradingDay = value;
+            } else if (key == "speed") {
+                options.speed = value == "max" ? 0.0 : atof(value.c_str());
+                if (value != "max" && options.speed <= 0.0) {
+                    LOG("[警告] 回放倍速 {} 无效, 按1倍速回放", value);
+                    options.speed = 1.0;
+                }
+            } else if (key == "gap") {
+                options.maxGapNs = atoll(value.c_str()) * 1000000LL;
+            } else if (!key.empty()) {
+                LOG("[警告] 忽略未知的回放参数 {}", item);
+            }
+            begin = end + 1;
+        }
+    }
+    if (options.dir.empty()) {
+        options.dir = "./";
+    } else if (options.dir[options.dir.size() - 1] != '/') {
+        options.dir += '/';
+    }
+    return options;
+}
+
+ReplayMdApi::ReplayMdApi(const char* flowPath)
+    : m_flowPath(flowPath ? flowPath : ""), m_spi(nullptr), m_nextPath(0), m_loggedIn(false), m_finished(false),
+      m_startNs(0), m_paceStartNs(0), m_firstTickNs(0), m_lastTickNs(0), m_read(0), m_delivered(0),
+      m_subscribed(m_symbols.Capacity(), 0), m_running(false), m_hasRequests(false), m_released(false),
+      m_joiners(0) {
+    memset(m_tradingDay, 0, sizeof(m_tradingDay));
+    memset(&m_segment, 0, sizeof(m_segment));
+}
+
+ReplayMdApi::~ReplayMdApi() {}
+
+void ReplayMdApi::Init() {
+    if (m_thread.joinable()) {
+        return;
+    }
+    // 流文件路径形如 ./flow/md_, 默认从其所在目录回放
+    const size_t slash = m_flowPath.rfind('/');
+    m_options = ReplayMdOptions::Parse(m_frontAddress,
+                                       slash == std::string::npos ? "./" : m_flowPath.substr(0, slash + 1));
+    if (ScanSegments()) {
+        LOG("[回放] 交易日 {} 共 {} 个分段, 目录 {}, 倍速 {}", m_tradingDay, m_paths.size(), m_options.dir,
+            m_options.speed > 0.0 ? std::to_string(m_options.speed) : std::string("max"));
+    }
+
+    m_running.store(true);
+    m_thread = std::thread(&ReplayMdApi::ReplayLoop, this);
+}
+
+void ReplayMdApi::Release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running.store(false);
+    }
+    m_cond.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    CloseSegment();
+
+    std::unique_lock<std::mutex> lock(m_joinMutex);
+    m_released = true;
+    m_joinCond.notify_all();
+    m_joinCond.wait(lock, [this] { return m_joiners == 0; });
+    lock.unlock();
+    delete this;
+}
+
+int ReplayMdApi::Join() {
+    std::unique_lock<std::mutex> lock(m_joinMutex);
+    ++m_joiners;
+    m_joinCond.wait(lock, [this] { return m_released; });
+    --m_joiners;
+    m_joinCond.notify_all();
+    return 0;
+}
+
+const char* ReplayMdApi::GetTradingDay() {
+    return m_tradingDay;
+}
+
+void ReplayMdApi::RegisterFront(char *pszFrontAddress) {
+    m_frontAddress = pszFrontAddress ? pszFrontAddress : "";
+}
+
+void ReplayMdApi::RegisterNameServer(char *pszNsAddress) {
+    m_frontAddress = pszNsAddress ? pszNsAddress : "";
+}
+
+void ReplayMdApi::RegisterFensUserInfo(CThostFtdcFensUserInfoField *) {}
+
+void ReplayMdApi::RegisterSpi(CThostFtdcMdSpi *pSpi) {
+    m_spi = pSpi;
+}
+
+int ReplayMdApi::SubscribeMarketData(char *ppInstrumentID[], int nCount) {
+    return PostInstruments(RequestType::Subscribe, ppInstrumentID, nCount);
+}
+
+int ReplayMdApi::UnSubscribeMarketData(char *ppInstrumentID[], int nCount) {
+    return PostInstruments(RequestType::UnSubscribe, ppInstrumentID, nCount);
+}
+
+int ReplayMdApi::SubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) {
+    return PostInstruments(RequestType::SubscribeForQuote, ppInstrumentID, nCount);
+}
+
+int ReplayMdApi::UnSubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) {
+    return PostInstruments(RequestType::UnSubscribeForQuote, ppInstrumentID, nCount);
+}
+
+int ReplayMdApi::ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) {
+    Request request;
+    request.type = RequestType::Login;
+    request.requestId = nRequestID;
+    request.isLast = true;
+    if (pReqUserLoginField) {
+        request.brokerId = pReqUserLoginField->BrokerID;
+        request.userId = pReqUserLoginField->UserID;
+    }
+    return Post(request);
+}
+
+int ReplayMdApi::ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) {
+    Request request;
+    request.type = RequestType::Logout;
+    request.requestId = nRequestID;
+    request.isLast = true;
+    if (pUserLogout) {
+        request.brokerId = pUserLogout->BrokerID;
+        request.userId = pUserLogout->UserID;
+    }
+    return Post(request);
+}
+
+int ReplayMdApi::ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField *, int nRequestID) {
+    Request request;
+    request.type = RequestType::QryMulticastInstrument;
+    request.requestId = nRequestID;
+    request.isLast = true;
+    return Post(request);
+}
+
+int ReplayMdApi::Post(const Request& request) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back(request);
+        m_hasRequests.store(true, std::memory_order_release);
+    }
+    m_cond.notify_one();
+    return 0;
+}
+
+int ReplayMdApi::PostInstruments(RequestType type, char *ppInstrumentID[], int count) {
+    if (!ppInstrumentID || count <= 0) {
+        return -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < count; ++i) {
+            Request request;
+            request.type = type;
+            request.requestId = 0;
+            request.isLast = i + 1 == count;
+            request.instrument = ppInstrumentID[i] ? ppInstrumentID[i] : "";
+            m_requests.push_back(request);
+        }
+        m_hasRequests.store(true, std::memory_order_release);
+    }
+    m_cond.notify_one();
+    return 0;
+}
+
+bool ReplayMdApi::ScanSegments() {
+    DIR* dir = opendir(m_options.dir.c_str());
+    if (!dir) {
+        LOG("[错误] 无法打开回放目录 {}", m_options.dir);
+        return false;
+    }
+    // 未指定交易日时取最新的一天
+    std::vector<std::pair<uint32_t, std::string>> segments;
+    std::string latestDay;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string day;
+        uint32_t index;
+        if (!ParseSegmentName(entry->d_name, day, index)) {
+            continue;
+        }
+        if (!m_options.tradingDay.empty() && day != m_options.tradingDay) {
+            continue;
+        }
+        if (day > latestDay) {
+            latestDay = day;
+            segments.clear();
+        }
+        if (day == latestDay) {
+            segments.push_back(std::make_pair(index, m_options.dir + entry->d_name));
+        }
+    }
+    closedir(dir);
+
+    if (segments.empty()) {
+        LOG("[错误] 回放目录 {} 中没有交易日 {} 的行情日志", m_options.dir,
+            m_options.tradingDay.empty() ? std::string("*") : m_options.tradingDay);
+        return false;
+    }
+    std::sort(segments.begin(), segments.end());
+    m_paths.clear();
+    for (size_t i = 0; i < segments.size(); ++i) {
+        m_paths.push_back(segments[i].second);
+    }
+    CopyField(m_tradingDay, latestDay.c_str());
+    return true;
+}
+
+bool ReplayMdApi::OpenSegment(size_t index) {
+    const std::string& path = m_paths[index];
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG("[错误] 无法打开行情日志 {}", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TickJournalHeader)) {
+        LOG("[错误] 行情日志 {} 长度不足, 跳过", path);
+        close(fd);
+        return false;
+    }
+    // 私有映射: 回调拿到的是可写指针, 调用方改写记录时只复制该页, 不影响文件
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        LOG("[错误] 无法映射行情日志 {}", path);
+        return false;
+    }
+
+    const TickJournalHeader* header = static_cast<const TickJournalHeader*>(base);
+    if (memcmp(header->magic, kTickJournalMagic, sizeof(kTickJournalMagic)) != 0 ||
+        header->version != kTickJournalVersion || header->recordSize != sizeof(TickRecord)) {
+        LOG("[错误] 行情日志 {} 格式不符, 跳过", path);
+        munmap(base, bytes);
+        return false;
+    }
+    madvise(base, bytes, MADV_SEQUENTIAL);
+    madvise(base, bytes, MADV_WILLNEED);
+
+    // 写方异常退出时文件未截断, 记录数以文件头为准, 同时不超过文件长度
+    const uint64_t fileRecords = (bytes - sizeof(TickJournalHeader)) / sizeof(TickRecord);
+    const uint64_t count = header->count.load(std::memory_order_acquire);
+    m_segment.base = static_cast<char*>(base);
+    m_segment.mappedBytes = bytes;
+    m_segment.records = reinterpret_cast<TickRecord*>(m_segment.base + sizeof(TickJournalHeader));
+    m_segment.count = std::min(count, fileRecords);
+    m_segment.next = 0;
+    m_segment.monotonicBaseNs = header->monotonicBaseNs;
+    m_segment.realtimeBaseNs = header->realtimeBaseNs;
+    return true;
+}
+
+void ReplayMdApi::CloseSegment() {
+    if (m_segment.base) {
+        munmap(m_segment.base, m_segment.mappedBytes);
+    }
+    memset(&m_segment, 0, sizeof(m_segment));
+}
+
+TickRecord* ReplayMdApi::NextRecord() {
+    while (m_segment.next == m_segment.count) {
+        CloseSegment();
+        if (m_nextPath == m_paths.size()) {
+            return nullptr;
+        }
+        OpenSegment(m_nextPath++);
+    }
+    return &m_segment.records[m_segment.next++];
+}
+
+bool ReplayMdApi::Pace(const TickRecord& record) {
+    if (m_options.speed <= 0.0) {
+        return true;
+    }
+    // 录制时刻换算为墙上时间, 跨进程重启录制的分段之间也可比较
+    const int64_t tickNs = m_segment.realtimeBaseNs + (record.recvNs - m_segment.monotonicBaseNs);
+    if (m_lastTickNs == 0) {
+        m_paceStartNs = MonotonicNs();
+        m_firstTickNs = tickNs;
+        m_lastTickNs = tickNs;
+        return true;
+    }
+    if (m_options.maxGapNs > 0 && tickNs - m_lastTickNs > m_options.maxGapNs) {
+        m_firstTickNs += tickNs - m_lastTickNs - m_options.maxGapNs;
+    }
+    m_lastTickNs = tickNs;
+
+    const int64_t dueNs = m_paceStartNs + static_cast<int64_t>((tickNs - m_firstTickNs) / m_options.speed);
+    while (true) {
+        const int64_t remainingNs = dueNs - MonotonicNs();
+        if (remainingNs <= 0) {
+            return true;
+        }
+        if (m_hasRequests.load(std::memory_order_acquire) || !m_running.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (remainingNs > kPaceSleepNs) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait_for(lock, std::chrono::nanoseconds(remainingNs - kPaceSpinNs), [this] {
+                return m_hasRequests.load(std::memory_order_relaxed) || !m_running.load(std::memory_order_relaxed);
+            });
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ReplayMdApi::ProcessRequests() {
+    std::vector<Request> requests;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        requests.swap(m_requests);
+        m_hasRequests.store(false, std::memory_order_relaxed);
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const Request& request = requests[i];
+        CThostFtdcRspInfoField rspInfo;
+        memset(&rspInfo, 0, sizeof(rspInfo));
+
+        switch (request.type) {
+        case RequestType::Login: {
+            CThostFtdcRspUserLoginField rsp;
+            memset(&rsp, 0, sizeof(rsp));
+            const time_t now = time(nullptr);
+            struct tm local;
+            localtime_r(&now, &local);
+            strftime(rsp.LoginTime, sizeof(rsp.LoginTime), "%H:%M:%S", &local);
+            CopyField(rsp.TradingDay, m_tradingDay);
+            CopyField(rsp.BrokerID, request.brokerId.c_str());
+            CopyField(rsp.UserID, request.userId.c_str());
+            CopyField(rsp.SystemName, "TickReplay");
+            m_loggedIn = true;
+            if (m_spi) {
+                m_spi->OnRspUserLogin(&rsp, &rspInfo, request.requestId, true);
+            }
+            break;
+        }
+        case RequestType::Logout: {
+            CThostFtdcUserLogoutField rsp;
+            memset(&rsp, 0, sizeof(rsp));
+            CopyField(rsp.BrokerID, request.brokerId.c_str());
+            CopyField(rsp.UserID, request.userId.c_str());
+            m_loggedIn = false;
+            if (m_spi) {
+                m_spi->OnRspUserLogout(&rsp, &rspInfo, request.requestId, true);
+            }
+            break;
+        }
+        case RequestType::Subscribe:
+        case RequestType::UnSubscribe: {
+            CThostFtdcSpecificInstrumentField rsp;
+            memset(&rsp, 0, sizeof(rsp));
+            CopyField(rsp.InstrumentID, request.instrument.c_str());
+            const uint32_t id = m_symbols.Intern(request.instrument);
+            if (id == kInvalidSymbol) {
+                rspInfo.ErrorID = kErrInstrumentNotFound;
+                CopyField(rspInfo.ErrorMsg, "CTP:找不到合约");
+            } else {
+                m_subscribed[id] = request.type == RequestType::Subscribe ? 1 : 0;
+            }
+            if (!m_spi) {
+                break;
+            }
+            if (request.type == RequestType::Subscribe) {
+                m_spi->OnRspSubMarketData(&rsp, &rspInfo, request.requestId, request.isLast);
+            } else {
+                m_spi->OnRspUnSubMarketData(&rsp, &rspInfo, request.requestId, request.isLast);
+            }
+            break;
+        }
+        case RequestType::SubscribeForQuote:
+        case RequestType::UnSubscribeForQuote: {
+            // 日志中没有询价, 只应答
+            CThostFtdcSpecificInstrumentField rsp;
+            memset(&rsp, 0, sizeof(rsp));
+            CopyField(rsp.InstrumentID, request.instrument.c_str());
+            if (!m_spi) {
+                break;
+            }
+            if (request.type == RequestType::SubscribeForQuote) {
+                m_spi->OnRspSubForQuoteRsp(&rsp, &rspInfo, request.requestId, request.isLast);
+            } else {
+                m_spi->OnRspUnSubForQuoteRsp(&rsp, &rspInfo, request.requestId, request.isLast);
+            }
+            break;
+        }
+        case RequestType::QryMulticastInstrument:
+            if (m_spi) {
+                m_spi->OnRspQryMulticastInstrument(nullptr, &rspInfo, request.requestId, true);
+            }
+            break;
+        }
+    }
+}
+
+void ReplayMdApi::ReplayLoop() {
+    if (m_spi) {
+        m_spi->OnFrontConnected();
+    }
+
+    TickRecord* pending = nullptr;
+    while (m_running.load(std::memory_order_acquire)) {
+        // 回调中发出的请求(如登录应答中订阅)也要在读下一笔行情之前处理完
+        if (m_hasRequests.load(std::memory_order_acquire)) {
+            ProcessRequests();
+            continue;
+        }
+        if (!m_loggedIn || m_finished) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] {
+                return m_hasRequests.load(std::memory_order_relaxed) || !m_running.load(std::memory_order_relaxed);
+            });
+            continue;
+        }
+
+        if (!pending) {
+            if (m_startNs == 0) {
+                m_startNs = MonotonicNs();
+            }
+            pending = NextRecord();
+            if (!pending) {
+                m_finished = true;
+                const int64_t elapsedNs = MonotonicNs() - m_startNs;
+                LOG("[回放] 回放结束, 交易日 {}, 读取 {} 笔, 投递 {} 笔, 用时 {}ms, {} 笔/秒", m_tradingDay, m_read,
+                    m_delivered, elapsedNs / 1000000,
+                    elapsedNs > 0 ? static_cast<uint64_t>(m_read * 1000000000.0 / elapsedNs) : 0);
+                continue;
+            }
+            ++m_read;
+            const uint32_t id = m_symbols.Intern(pending->data.InstrumentID);
+            if (id == kInvalidSymbol || !m_subscribed[id]) {
+                pending = nullptr;
+                continue;
+            }
+        }
+
+        // 等待中有请求到达时先处理请求, 之后继续等待同一笔行情
+        if (!Pace(*pending)) {
+            continue;
+        }
+        if (m_spi) {
+            m_spi->OnRtnDepthMarketData(&pending->data);
+        }
+        ++m_delivered;
+        pending = nullptr;
+    }
+}
@@ -0,0 +1,174 @@
+///
+/// @file ReplayMdApi.h
+/// @brief 从行情落盘日志回放深度行情的 CThostFtdcMdApi 实现
+///
+
+#ifndef CTP_TEST_REPLAY_MD_API_H
+#define CTP_TEST_REPLAY_MD_API_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThostFtdcMdApi.h"
+#include "SymbolTable.h"
+#include "TickJournal.h"
+
+///
+/// @brief 回放参数, 由前置地址解析
+///
+/// 前置地址格式为 replay://<目录>?day=<交易日>&speed=<倍速>&gap=<毫秒>, 各项均可省略:
+/// 目录默认取 CreateFtdcMdApi 流文件路径所在目录, 交易日默认取目录中最新的一天;
+/// speed 为 1 按录制时的节奏回放, N 为 N 倍速, max 不等待; gap 不为0时把行情之间
+/// 超过 gap 毫秒的空档(午休、夜盘结束)压缩为 gap 毫秒。
+///
+struct ReplayMdOptions {
+    std::string dir;
+    std::string tradingDay;
+    double speed;               ///< 0 表示最快速度
+    int64_t maxGapNs;           ///< 0 表示不压缩空档
+
+    ReplayMdOptions() : speed(1.0), maxGapNs(0) {}
+
+    /// 解析前置地址, 不是 replay:// 开头时只使用默认目录
+    static ReplayMdOptions Parse(const std::string& frontAddress, const std::string& defaultDir);
+};
+
+///
+/// @brief 行情回放API
+///
+/// 由 ctp_md_replay 库中的 CThostFtdcMdApi::CreateFtdcMdApi() 创建, 代替 thostmduserapi_se
+/// 链接进程序, 调用方代码不变。Init() 后在回放线程上依次回调 OnFrontConnected、登录和订阅应答,
+/// 登录成功后按分段顺序读取 TickJournal 写出的 ticks_<交易日>_<分段>.dat, 只投递已订阅合约的行情。
+///
+/// 分段文件以 MAP_PRIVATE 整体映射, OnRtnDepthMarketData 的参数直接指向映射中的记录, 每笔行情
+/// 不拷贝、不分配内存; 订阅过滤用 SymbolTable 查出合约编号后读一个标志位。全速回放时投递速度
+/// 只受调用方回调的限制。
+///
+/// 请求由调用方线程放入队列, 回放线程在两笔行情之间处理, 与真实API一样回调不与调用线程重叠。
+/// 只回放 Init() 时已存在的分段, 回放过程中新写入的分段不会被读取。
+///
+class ReplayMdApi final : public CThostFtdcMdApi {
+public:
+    explicit ReplayMdApi(const char* flowPath);
+
+    virtual void Release() override;
+    virtual void Init() override;
+    virtual int Join() override;
+    virtual const char *GetTradingDay() override;
+    virtual void RegisterFront(char *pszFrontAddress) override;
+    virtual void RegisterNameServer(char *pszNsAddress) override;
+    virtual void RegisterFensUserInfo(CThostFtdcFensUserInfoField *pFensUserInfo) override;
+    virtual void RegisterSpi(CThostFtdcMdSpi *pSpi) override;
+    virtual int SubscribeMarketData(char *ppInstrumentID[], int nCount) override;
+    virtual int UnSubscribeMarketData(char *ppInstrumentID[], int nCount) override;
+    virtual int SubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) override;
+    virtual int UnSubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) override;
+    virtual int ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) override;
+    virtual int ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) override;
+    virtual int ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField *pQryMulticastInstrument,
+                                          int nRequestID) override;
+
+private:
+    ~ReplayMdApi();
+
+    enum class RequestType {
+        Login,
+        Logout,
+        Subscribe,
+        UnSubscribe,
+        SubscribeForQuote,
+        UnSubscribeForQuote,
+        QryMulticastInstrument,
+    };
+
+    /// 调用方线程发来的请求, 由回放线程处理
+    struct Request {
+        RequestType type;
+        int requestId;
+        bool isLast;
+        std::string instrument;
+        std::string brokerId;       ///< 登录、登出请求
+        std::string userId;
+    };
+
+    /// 当前映射的分段
+    struct Segment {
+        char* base;
+        size_t mappedBytes;
+        TickRecord* records;
+        uint64_t count;
+        uint64_t next;              ///< 下一条待读记录
+        int64_t monotonicBaseNs;
+        int64_t realtimeBaseNs;
+    };
+
+    /// 请求入队并唤醒回放线程
+    int Post(const Request& request);
+
+    /// 每个合约一个请求, 最后一个的 isLast 为true
+    int PostInstruments(RequestType type, char *ppInstrumentID[], int count);
+
+    /// 查找交易日的全部分段, 按分段序号排序
+    bool ScanSegments();
+
+    /// 映射第 index 个分段, 失败时跳过该分段
+    bool OpenSegment(size_t index);
+
+    void CloseSegment();
+
+    /// 下一条记录, 当前分段读完时切换到下一分段; 全部读完返回 nullptr
+    TickRecord* NextRecord();
+
+    /// 等到记录的回放时刻, 等待期间有请求或停止时提前返回false
+    bool Pace(const TickRecord& record);
+
+    /// 处理排队的请求
+    void ProcessRequests();
+
+    /// 回放线程主循环
+    void ReplayLoop();
+
+    std::string m_flowPath;
+    std::string m_frontAddress;
+    CThostFtdcMdSpi* m_spi;
+    ReplayMdOptions m_options;
+    char m_tradingDay[16];
+
+    // 以下在 Init() 之后仅由回放线程访问
+    std::vector<std::string> m_paths;
+    size_t m_nextPath;
+    Segment m_segment;
+    bool m_loggedIn;
+    bool m_finished;
+    int64_t m_startNs;              ///< 开始读取的时刻, 用于统计
+    int64_t m_paceStartNs;          ///< 第一笔投递行情的投递时刻
+    int64_t m_firstTickNs;          ///< 第一笔投递行情的录制时刻, 压缩空档时随之后移
+    int64_t m_lastTickNs;           ///< 上一笔投递行情的录制时刻, 0 表示尚未投递
+    uint64_t m_read;
+    uint64_t m_delivered;
+
+    // 订阅过滤, 以合约编号为下标
+    SymbolTable m_symbols;
+    std::vector<uint8_t> m_subscribed;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_hasRequests;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<Request> m_requests;    ///< 由 m_mutex 保护
+
+    // Join() 等待 Release()
+    std::mutex m_joinMutex;
+    std::condition_variable m_joinCond;
+    bool m_released;
+    int m_joiners;
+};
+
+#endif // CTP_TEST_REPLAY_MD_API_H
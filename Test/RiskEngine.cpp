@@ -0,0 +1,384 @@
+///
+/// @file RiskEngine.cpp
+/// @brief 报单前风控实现
+///
+
+#include "RiskEngine.h"
+
+#include <cfloat>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+const size_t kCacheLine = 64;
+
+// CTP用 DBL_MAX 表示无效价格, 统一换成0
+inline double ValidPrice(double price) {
+    return (price > 0.0 && price < DBL_MAX) ? price : 0.0;
+}
+
+} // namespace
+
+const char* RiskResultText(int result) {
+    switch (result) {
+        case kRiskOk:
+            return "通过";
+        case kRiskBadVolume:
+            return "数量超限";
+        case kRiskNoPriceBand:
+            return "无涨跌停价";
+        case kRiskAboveUpperLimit:
+            return "高于涨停价";
+        case kRiskBelowLowerLimit:
+            return "低于跌停价";
+        case kRiskInstrumentPosition:
+            return "合约持仓超限";
+        case kRiskProductPosition:
+            return "品种持仓超限";
+        case kRiskSelfCross:
+            return "自成交";
+        default:
+            return "未知";
+    }
+}
+
+RiskEngine::RiskEngine(const SymbolTable& symbols, size_t orderCapacity, const RiskLimits& limits)
+    : m_symbols(symbols), m_limits(limits), m_lines(nullptr), m_products(symbols.Capacity() + 1),
+      m_ledger(orderCapacity), m_productsBuilt(false), m_passed(0) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kCacheLine, symbols.Capacity() * sizeof(InstrumentLine)) != 0) {
+        throw std::bad_alloc();
+    }
+    m_lines = static_cast<InstrumentLine*>(memory);
+    for (size_t i = 0; i < symbols.Capacity(); ++i) {
+        InstrumentLine* line = new (&m_lines[i]) InstrumentLine();
+        line->upperLimit.store(0.0, std::memory_order_relaxed);
+        line->lowerLimit.store(0.0, std::memory_order_relaxed);
+        line->ownBestBid.store(0.0, std::memory_order_relaxed);
+        line->ownBestAsk.store(0.0, std::memory_order_relaxed);
+        line->net.store(0, std::memory_order_relaxed);
+        line->workingBuy.store(0, std::memory_order_relaxed);
+        line->workingSell.store(0, std::memory_order_relaxed);
+        line->inflightBuy.store(0, std::memory_order_relaxed);
+        line->inflightSell.store(0, std::memory_order_relaxed);
+        line->product = 0;
+        line->liveHead = 0;
+    }
+    for (size_t i = 0; i < m_products.size(); ++i) {
+        m_products[i].net.store(0, std::memory_order_relaxed);
+        m_products[i].pendingBuy.store(0, std::memory_order_relaxed);
+        m_products[i].pendingSell.store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < kRiskRejectKinds; ++i) {
+        m_rejected[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+RiskEngine::~RiskEngine() {
+    free(m_lines);
+}
+
+// ---------------------------------------------------------------------------
+// 报单线程
+// ---------------------------------------------------------------------------
+
+int RiskEngine::Check(uint32_t symbolId, char direction, double price, int volume) {
+    int result = kRiskOk;
+    if (volume <= 0 || volume > m_limits.maxOrderVolume) {
+        result = kRiskBadVolume;
+    } else if (symbolId >= m_symbols.Capacity()) {
+        result = kRiskNoPriceBand;
+    }
+
+    if (result == kRiskOk) {
+        InstrumentLine& line = m_lines[symbolId];
+        const double upper = line.upperLimit.load(std::memory_order_acquire);
+        const double lower = line.lowerLimit.load(std::memory_order_acquire);
+        const bool buy = direction == THOST_FTDC_D_Buy;
+        if (upper <= 0.0) {
+            result = kRiskNoPriceBand;
+        } else if (price > upper) {
+            result = kRiskAboveUpperLimit;
+        } else if (price < lower) {
+            result = kRiskBelowLowerLimit;
+        } else if (buy) {
+            const double ownAsk = line.ownBestAsk.load(std::memory_order_relaxed);
+            result = (ownAsk > 0.0 && price >= ownAsk) ? kRiskSelfCross : kRiskOk;
+        } else {
+            const double ownBid = line.ownBestBid.load(std::memory_order_relaxed);
+            result = (ownBid > 0.0 && price <= ownBid) ? kRiskSelfCross : kRiskOk;
+        }
+
+        if (result == kRiskOk) {
+            // 先预占再比较, 并发报单时后到者看到先到者的预占量
+            std::atomic<int32_t>& inflight = buy ? line.inflightBuy : line.inflightSell;
+            const int32_t working = (buy ? line.workingBuy : line.workingSell).load(std::memory_order_relaxed);
+            const int32_t net = line.net.load(std::memory_order_relaxed);
+            const int32_t before = inflight.fetch_add(volume, std::memory_order_relaxed);
+            if ((buy ? net : -net) + working + before + volume > m_limits.maxInstrumentNet) {
+                inflight.fetch_sub(volume, std::memory_order_relaxed);
+                result = kRiskInstrumentPosition;
+            } else {
+                ProductLine& product = m_products[line.product];
+                std::atomic<int32_t>& pending = buy ? product.pendingBuy : product.pendingSell;
+                const int32_t productNet = product.net.load(std::memory_order_relaxed);
+                const int32_t pendingBefore = pending.fetch_add(volume, std::memory_order_relaxed);
+                if (line.product != 0 &&
+                    (buy ? productNet : -productNet) + pendingBefore + volume > m_limits.maxProductNet) {
+                    pending.fetch_sub(volume, std::memory_order_relaxed);
+                    inflight.fetch_sub(volume, std::memory_order_relaxed);
+                    result = kRiskProductPosition;
+                }
+            }
+        }
+    }
+
+    if (result == kRiskOk) {
+        m_passed.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_rejected[kRiskBadVolume - result].fetch_add(1, std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void RiskEngine::Release(uint32_t symbolId, char direction, int volume) {
+    InstrumentLine& line = m_lines[symbolId];
+    ProductLine& product = m_products[line.product];
+    if (direction == THOST_FTDC_D_Buy) {
+        line.inflightBuy.fetch_sub(volume, std::memory_order_relaxed);
+        product.pendingBuy.fetch_sub(volume, std::memory_order_relaxed);
+    } else {
+        line.inflightSell.fetch_sub(volume, std::memory_order_relaxed);
+        product.pendingSell.fetch_sub(volume, std::memory_order_relaxed);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 行情处理线程
+// ---------------------------------------------------------------------------
+
+void RiskEngine::OnTick(uint32_t symbolId, const CThostFtdcDepthMarketDataField& data) {
+    if (symbolId >= m_symbols.Capacity()) {
+        return;
+    }
+    // 涨跌停价一天只变一次, 只在变化时写入, 避免每笔行情都让报单线程的缓存行失效
+    InstrumentLine& line = m_lines[symbolId];
+    const double upper = ValidPrice(data.UpperLimitPrice);
+    const double lower = ValidPrice(data.LowerLimitPrice);
+    if (line.lowerLimit.load(std::memory_order_relaxed) != lower) {
+        line.lowerLimit.store(lower, std::memory_order_release);
+    }
+    if (line.upperLimit.load(std::memory_order_relaxed) != upper) {
+        line.upperLimit.store(upper, std::memory_order_release);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 交易回调处理线程
+// ---------------------------------------------------------------------------
+
+void RiskEngine::BuildProducts(const InstrumentCache& instruments, const SymbolTable& symbols) {
+    if (m_productsBuilt || !instruments.Ready()) {
+        return;
+    }
+    std::unordered_map<std::string, uint32_t> products;
+    for (size_t i = 0; i < instruments.Size(); ++i) {
+        const CThostFtdcInstrumentField& instrument = instruments.At(i);
+        const uint32_t symbolId = symbols.Find(instrument.InstrumentID);
+        if (symbolId == kInvalidSymbol || instrument.ProductID[0] == '\0') {
+            continue;
+        }
+        const std::string productId(instrument.ProductID);
+        std::unordered_map<std::string, uint32_t>::const_iterator it = products.find(productId);
+        if (it == products.end()) {
+            it = products.insert(std::make_pair(productId, static_cast<uint32_t>(products.size() + 1))).first;
+        }
+        m_lines[symbolId].product = it->second;
+    }
+    // 建立映射前已计入的持仓和挂单都在下标0, 按合约重新汇总;
+    // 此时报单网关尚未就绪, 没有线程在报单
+    RebuildProducts();
+    m_productsBuilt = true;
+    LOG("[风控] 已建立合约品种映射, 品种 {} 个", products.size());
+}
+
+void RiskEngine::ResetInflight() {
+    const uint32_t size = m_symbols.Size();
+    for (uint32_t i = 0; i < size; ++i) {
+        InstrumentLine& line = m_lines[i];
+        ProductLine& product = m_products[line.product];
+        product.pendingBuy.fetch_sub(line.inflightBuy.exchange(0, std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+        product.pendingSell.fetch_sub(line.inflightSell.exchange(0, std::memory_order_relaxed),
+                                      std::memory_order_relaxed);
+    }
+}
+
+void RiskEngine::OnOrderUpdate(uint32_t index, const OrderInfo& info, bool ownSession) {
+    if (index >= m_ledger.size() || info.symbolId >= m_symbols.Capacity()) {
+        return;
+    }
+    InstrumentLine& line = m_lines[info.symbolId];
+    ProductLine& product = m_products[line.product];
+    OrderLedger& order = m_ledger[index];
+    const bool buy = info.direction == THOST_FTDC_D_Buy;
+    std::atomic<int32_t>& working = buy ? line.workingBuy : line.workingSell;
+    std::atomic<int32_t>& pending = buy ? product.pendingBuy : product.pendingSell;
+
+    int32_t pendingDelta = 0;
+    if (!order.seen) {
+        order.seen = true;
+        order.direction = info.direction;
+        order.price = info.limitPrice;
+        // 本会话发出的报单首次出现, 从在途转为挂单
+        if (ownSession) {
+            (buy ? line.inflightBuy : line.inflightSell).fetch_sub(info.volumeTotalOriginal,
+                                                                   std::memory_order_relaxed);
+            pendingDelta -= info.volumeTotalOriginal;
+        }
+    }
+
+    int32_t remaining = 0;
+    if (!IsTerminalState(info.state) && info.volumeTotalOriginal > info.volumeTraded) {
+        remaining = info.volumeTotalOriginal - info.volumeTraded;
+    }
+    if (remaining != order.remaining) {
+        working.fetch_add(remaining - order.remaining, std::memory_order_relaxed);
+        pendingDelta += remaining - order.remaining;
+        order.remaining = remaining;
+    }
+    if (pendingDelta != 0) {
+        pending.fetch_add(pendingDelta, std::memory_order_relaxed);
+    }
+
+    const bool live = remaining > 0;
+    if (live != order.live) {
+        if (live) {
+            Link(line, index);
+        } else {
+            Unlink(line, index);
+        }
+        RefreshOwnBest(line);
+    }
+}
+
+void RiskEngine::LoadPositions(const std::vector<CThostFtdcInvestorPositionField>& positions,
+                               SymbolTable& symbols) {
+    std::vector<int32_t> net;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const CThostFtdcInvestorPositionField& position = positions[i];
+        const uint32_t symbolId = symbols.Intern(position.InstrumentID);
+        if (symbolId == kInvalidSymbol) {
+            continue;
+        }
+        if (symbolId >= net.size()) {
+            net.resize(symbolId + 1, 0);
+        }
+        net[symbolId] += position.PosiDirection == THOST_FTDC_PD_Short ? -position.YdPosition : position.YdPosition;
+    }
+
+    // 只改写净持仓, 挂单和在途量可能正被报单线程修改
+    std::vector<int32_t> productNet(m_products.size(), 0);
+    const uint32_t size = symbols.Size();
+    for (uint32_t i = 0; i < size; ++i) {
+        const int32_t value = i < net.size() ? net[i] : 0;
+        m_lines[i].net.store(value, std::memory_order_relaxed);
+        productNet[m_lines[i].product] += value;
+    }
+    for (size_t i = 0; i < m_products.size(); ++i) {
+        if (m_products[i].net.load(std::memory_order_relaxed) != productNet[i]) {
+            m_products[i].net.store(productNet[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+void RiskEngine::OnTrade(uint32_t symbolId, const CThostFtdcTradeField& trade) {
+    if (symbolId >= m_symbols.Capacity()) {
+        return;
+    }
+    AddNet(m_lines[symbolId], trade.Direction == THOST_FTDC_D_Buy ? trade.Volume : -trade.Volume);
+}
+
+RiskStats RiskEngine::GetStats() const {
+    RiskStats stats;
+    stats.passed = m_passed.load(std::memory_order_relaxed);
+    for (int i = 0; i < kRiskRejectKinds; ++i) {
+        stats.rejected[i] = m_rejected[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void RiskEngine::AddNet(InstrumentLine& line, int delta) {
+    line.net.fetch_add(delta, std::memory_order_relaxed);
+    m_products[line.product].net.fetch_add(delta, std::memory_order_relaxed);
+}
+
+void RiskEngine::RebuildProducts() {
+    for (size_t i = 0; i < m_products.size(); ++i) {
+        m_products[i].net.store(0, std::memory_order_relaxed);
+        m_products[i].pendingBuy.store(0, std::memory_order_relaxed);
+        m_products[i].pendingSell.store(0, std::memory_order_relaxed);
+    }
+    const uint32_t size = m_symbols.Size();
+    for (uint32_t i = 0; i < size; ++i) {
+        const InstrumentLine& line = m_lines[i];
+        ProductLine& product = m_products[line.product];
+        product.net.fetch_add(line.net.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        product.pendingBuy.fetch_add(line.workingBuy.load(std::memory_order_relaxed) +
+                                     line.inflightBuy.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+        product.pendingSell.fetch_add(line.workingSell.load(std::memory_order_relaxed) +
+                                      line.inflightSell.load(std::memory_order_relaxed),
+                                      std::memory_order_relaxed);
+    }
+}
+
+void RiskEngine::RefreshOwnBest(InstrumentLine& line) {
+    double bestBid = 0.0;
+    double bestAsk = 0.0;
+    for (uint32_t node = line.liveHead; node != 0; node = m_ledger[node - 1].next) {
+        const OrderLedger& order = m_ledger[node - 1];
+        if (order.direction == THOST_FTDC_D_Buy) {
+            bestBid = order.price > bestBid ? order.price : bestBid;
+        } else if (bestAsk == 0.0 || order.price < bestAsk) {
+            bestAsk = order.price;
+        }
+    }
+    if (line.ownBestBid.load(std::memory_order_relaxed) != bestBid) {
+        line.ownBestBid.store(bestBid, std::memory_order_relaxed);
+    }
+    if (line.ownBestAsk.load(std::memory_order_relaxed) != bestAsk) {
+        line.ownBestAsk.store(bestAsk, std::memory_order_relaxed);
+    }
+}
+
+void RiskEngine::Link(InstrumentLine& line, uint32_t index) {
+    OrderLedger& order = m_ledger[index];
+    order.prev = 0;
+    order.next = line.liveHead;
+    if (line.liveHead != 0) {
+        m_ledger[line.liveHead - 1].prev = index + 1;
+    }
+    line.liveHead = index + 1;
+    order.live = true;
+}
+
+void RiskEngine::Unlink(InstrumentLine& line, uint32_t index) {
+    OrderLedger& order = m_ledger[index];
+    if (order.prev != 0) {
+        m_ledger[order.prev - 1].next = order.next;
+    } else {
+        line.liveHead = order.next;
+    }
+    if (order.next != 0) {
+        m_ledger[order.next - 1].prev = order.prev;
+    }
+    order.prev = 0;
+    order.next = 0;
+    order.live = false;
+}
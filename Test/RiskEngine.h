@@ -0,0 +1,170 @@
+///
+/// @file RiskEngine.h
+/// @brief 报单前风控: 涨跌停价、单笔数量、合约和品种净持仓、自成交检查
+///
+
+#ifndef CTP_TEST_RISK_ENGINE_H
+#define CTP_TEST_RISK_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "InstrumentCache.h"
+#include "OrderTable.h"
+#include "SymbolTable.h"
+
+/// 风控检查结果, 与CTP返回码和报单网关错误码不重叠
+const int kRiskOk = 0;
+const int kRiskBadVolume = -200;            ///< 数量不大于0或超过单笔上限
+const int kRiskNoPriceBand = -201;          ///< 尚未收到该合约的涨跌停价
+const int kRiskAboveUpperLimit = -202;      ///< 价格高于涨停价
+const int kRiskBelowLowerLimit = -203;      ///< 价格低于跌停价
+const int kRiskInstrumentPosition = -204;   ///< 成交后合约净持仓超限
+const int kRiskProductPosition = -205;      ///< 成交后品种净持仓超限
+const int kRiskSelfCross = -206;            ///< 与自己的挂单价格交叉
+const int kRiskRejectKinds = 7;             ///< 拒绝原因种数
+
+/// 风控错误码 -> 说明
+const char* RiskResultText(int result);
+
+///
+/// @brief 风控参数
+///
+struct RiskLimits {
+    int maxOrderVolume;         ///< 单笔最大数量
+    int maxInstrumentNet;       ///< 单个合约最大净持仓(绝对值)
+    int maxProductNet;          ///< 单个品种最大净持仓(绝对值)
+};
+
+///
+/// @brief 风控检查统计
+///
+struct RiskStats {
+    uint64_t passed;
+    uint64_t rejected[kRiskRejectKinds];     ///< 按错误码分类, 下标为 kRiskBadVolume - 错误码
+};
+
+///
+/// @brief 报单前风控
+///
+/// 每个合约一条64字节缓存行, 保存涨跌停价、净持仓、挂单量、在途量和自己挂单的最优买卖价,
+/// 每个品种一组净持仓和未成交量。Check() 只访问这两处, 先 fetch_add 预占在途量再比较限额,
+/// 超限时退回, 多个线程同时报单也不会一起越过限额; 全程不加锁、不分配内存, 在报单线程上内联执行。
+///
+/// 写入方:
+/// - OnTick() 由行情处理线程调用, 只在涨跌停价变化时写入;
+/// - OnOrderUpdate() 由交易回调处理线程调用, 根据 OrderTable 中报单状态的变化维护挂单量和
+///   自己挂单的最优价; 每个合约的挂单用侵入式链表串起来, 最优价在该合约的挂单变化时重新计算;
+/// - LoadPositions()/OnTrade() 由交易回调处理线程调用, 净持仓与实时持仓同源: 以昨仓为基线,
+///   按成交编号去重后的当日成交逐笔增减, 续传、重传的成交不会重复计入; 登录后成交暂存期间
+///   成交的数量已离开挂单而尚未计入净持仓;
+/// - Check() 通过后把本笔数量计入在途量, 直到该报单第一次出现在 OrderTable 中(回报或拒单),
+///   发送失败时由调用方 Release(); 重新登录时 ResetInflight() 清零, 断线前未确认的报单
+///   随私有流续传再作为挂单计入。
+///
+/// 净持仓检查按最坏情况计算: 买单检查 净持仓 + 买挂单 + 买在途 + 本笔, 卖单对称。
+/// 自成交检查只覆盖已有回报的挂单, 在途报单在回报到达前不参与比较。
+///
+class RiskEngine {
+public:
+    /// @param symbols       合约编号表, 数组按其容量分配
+    /// @param orderCapacity 与 OrderTable 容量一致
+    RiskEngine(const SymbolTable& symbols, size_t orderCapacity, const RiskLimits& limits);
+    ~RiskEngine();
+
+    RiskEngine(const RiskEngine&) = delete;
+    RiskEngine& operator=(const RiskEngine&) = delete;
+
+    /// 按合约缓存建立合约 -> 品种映射, 每个交易日一次, 由交易回调处理线程调用
+    void BuildProducts(const InstrumentCache& instruments, const SymbolTable& symbols);
+
+    /// 检查一笔限价单, 通过时计入在途量并返回 kRiskOk
+    int Check(uint32_t symbolId, char direction, double price, int volume);
+
+    /// 已通过 Check() 但未能发出的报单, 撤销在途量
+    void Release(uint32_t symbolId, char direction, int volume);
+
+    /// 登录成功后清零在途量, 须在报单网关就绪之前调用
+    void ResetInflight();
+
+    /// 行情: 更新涨跌停价
+    void OnTick(uint32_t symbolId, const CThostFtdcDepthMarketDataField& data);
+
+    /// 报单状态变化
+    /// @param index       OrderTable 记录下标
+    /// @param ownSession  是否为本会话发出的报单(发出时计入过在途量)
+    void OnOrderUpdate(uint32_t index, const OrderInfo& info, bool ownSession);
+
+    /// 以持仓查询结果中的昨仓覆盖全部合约和品种的净持仓(结果为空时清零); 之后须重放当日全部成交
+    void LoadPositions(const std::vector<CThostFtdcInvestorPositionField>& positions, SymbolTable& symbols);
+
+    /// 当日成交, 买增卖减净持仓; 调用方保证每笔成交只调用一次
+    void OnTrade(uint32_t symbolId, const CThostFtdcTradeField& trade);
+
+    /// 获取统计
+    RiskStats GetStats() const;
+
+private:
+    /// 每个合约一条缓存行
+    struct InstrumentLine {
+        std::atomic<double> upperLimit;     ///< 0表示未知
+        std::atomic<double> lowerLimit;
+        std::atomic<double> ownBestBid;     ///< 自己买挂单的最高价, 0表示没有
+        std::atomic<double> ownBestAsk;     ///< 自己卖挂单的最低价, 0表示没有
+        std::atomic<int32_t> net;
+        std::atomic<int32_t> workingBuy;
+        std::atomic<int32_t> workingSell;
+        std::atomic<int32_t> inflightBuy;
+        std::atomic<int32_t> inflightSell;
+        uint32_t product;                   ///< 品种下标, 由 BuildProducts() 写入后只读
+        uint32_t liveHead;                  ///< 挂单链表头(OrderTable 下标+1), 仅处理线程访问
+        char pad[4];
+    };
+
+    static_assert(sizeof(InstrumentLine) == 64, "InstrumentLine must be one cache line");
+
+    /// 每个品种的汇总, 未成交量包含挂单和在途
+    struct ProductLine {
+        std::atomic<int32_t> net;
+        std::atomic<int32_t> pendingBuy;
+        std::atomic<int32_t> pendingSell;
+    };
+
+    /// 每笔报单已计入的数量, 仅处理线程访问
+    struct OrderLedger {
+        uint32_t prev;                      ///< 挂单链表, OrderTable 下标+1
+        uint32_t next;
+        int32_t remaining;                  ///< 已计入挂单量的剩余数量
+        double price;
+        char direction;
+        bool seen;
+        bool live;
+    };
+
+    /// 合约净持仓变化, 同时更新品种
+    void AddNet(InstrumentLine& line, int delta);
+
+    /// 按各合约的当前值重新汇总品种
+    void RebuildProducts();
+
+    /// 重新计算合约的自己挂单最优价
+    void RefreshOwnBest(InstrumentLine& line);
+
+    void Link(InstrumentLine& line, uint32_t index);
+    void Unlink(InstrumentLine& line, uint32_t index);
+
+    const SymbolTable& m_symbols;
+    const RiskLimits m_limits;
+    InstrumentLine* m_lines;
+    std::vector<ProductLine> m_products;    ///< 下标0为未知品种, 不检查
+    std::vector<OrderLedger> m_ledger;
+    bool m_productsBuilt;
+
+    std::atomic<uint64_t> m_passed;
+    std::atomic<uint64_t> m_rejected[kRiskRejectKinds];
+};
+
+#endif // CTP_TEST_RISK_ENGINE_H
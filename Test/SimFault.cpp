@@ -0,0 +1,167 @@
+///
+/// @file SimFault.cpp
+/// @brief 故障注入日程解析
+///
+
+#include "SimFault.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+// 未指定时断线到重连的时长, 与CTP API的首次重连间隔相当
+const int64_t kDefaultDownNs = 1000000000LL;
+
+// Throttle 未指定返回值时按每秒请求超限
+const int kDefaultThrottleCode = -3;
+
+// Reject 未指定错误码时按查询未就绪(CTP:查询未就绪，请稍后重试)
+const int kDefaultRejectCode = 90;
+
+/// 按分隔符拆分
+std::vector<std::string> Split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(separator, begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        parts.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return parts;
+}
+
+/// 解析整数, 支持 0x 前缀; 格式错误返回false
+bool ParseInt(const std::string& text, int64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end;
+    value = strtoll(text.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+int64_t MsToNs(int64_t ms) {
+    return ms * 1000000LL;
+}
+
+/// 解析一个故障 <毫秒>:<类型>[:<参数>...]
+bool ParseFault(const std::string& text, SimFault& fault) {
+    const std::vector<std::string> parts = Split(text, ':');
+    int64_t at;
+    if (parts.size() < 3 || !ParseInt(parts[0], at) || at < 0) {
+        return false;
+    }
+    std::vector<int64_t> args;
+    for (size_t i = 2; i < parts.size(); ++i) {
+        int64_t value;
+        if (!ParseInt(parts[i], value)) {
+            return false;
+        }
+        args.push_back(value);
+    }
+    fault.atNs = MsToNs(at);
+
+    const std::string& type = parts[1];
+    if (type == "disconnect") {
+        fault.type = SimFaultType::Disconnect;
+        fault.reason = static_cast<int>(args[0]);
+        fault.durationNs = args.size() > 1 ? MsToNs(args[1]) : kDefaultDownNs;
+        return args.size() <= 2 && fault.durationNs >= 0;
+    }
+    if (type == "stall") {
+        fault.type = SimFaultType::Stall;
+        fault.durationNs = MsToNs(args[0]);
+        fault.reason = args.size() > 1 ? static_cast<int>(args[1]) : 0;
+        fault.downNs = args.size() > 2 ? MsToNs(args[2]) : kDefaultDownNs;
+        return args.size() <= 3 && fault.durationNs > 0 && fault.downNs >= 0;
+    }
+    if (type == "delay") {
+        fault.type = SimFaultType::Delay;
+        fault.delayNs = MsToNs(args[0]);
+        fault.durationNs = args.size() > 1 ? MsToNs(args[1]) : 0;
+        return args.size() == 2 && fault.delayNs > 0 && fault.durationNs > 0;
+    }
+    if (type == "reorder") {
+        fault.type = SimFaultType::Reorder;
+        fault.batch = static_cast<int>(args[0]);
+        fault.durationNs = args.size() > 1 ? MsToNs(args[1]) : 0;
+        return args.size() == 2 && fault.batch > 1 && fault.durationNs > 0;
+    }
+    if (type == "throttle") {
+        fault.type = SimFaultType::Throttle;
+        fault.durationNs = MsToNs(args[0]);
+        fault.reason = args.size() > 1 ? static_cast<int>(args[1]) : kDefaultThrottleCode;
+        return args.size() <= 2 && fault.durationNs > 0 && (fault.reason == -2 || fault.reason == -3);
+    }
+    if (type == "reject") {
+        fault.type = SimFaultType::Reject;
+        fault.durationNs = MsToNs(args[0]);
+        fault.reason = args.size() > 1 ? static_cast<int>(args[1]) : kDefaultRejectCode;
+        return args.size() <= 2 && fault.durationNs > 0 && fault.reason != 0;
+    }
+    return false;
+}
+
+} // namespace
+
+const char* SimFaultTypeName(SimFaultType type) {
+    switch (type) {
+        case SimFaultType::Disconnect: return "断线";
+        case SimFaultType::Stall: return "停顿";
+        case SimFaultType::Delay: return "延迟";
+        case SimFaultType::Reorder: return "乱序";
+        case SimFaultType::Throttle: return "流控";
+        case SimFaultType::Reject: return "查询出错";
+    }
+    return "未知";
+}
+
+SimFaultSchedule SimFaultSchedule::Parse(const std::string& frontAddress) {
+    SimFaultSchedule schedule;
+    const size_t query = frontAddress.find('?');
+    if (query == std::string::npos) {
+        return schedule;
+    }
+    const std::vector<std::string> items = Split(frontAddress.substr(query + 1), '&');
+    for (size_t i = 0; i < items.size(); ++i) {
+        const size_t eq = items[i].find('=');
+        const std::string key = items[i].substr(0, eq);
+        const std::string value = eq == std::string::npos ? "" : items[i].substr(eq + 1);
+        if (key == "faults") {
+            const std::vector<std::string> faults = Split(value, ',');
+            for (size_t j = 0; j < faults.size(); ++j) {
+                SimFault fault;
+                if (faults[j].empty()) {
+                    continue;
+                }
+                if (!ParseFault(faults[j], fault)) {
+                    LOG("[警告] 忽略无效的故障 {}", faults[j]);
+                    continue;
+                }
+                schedule.faults.push_back(fault);
+            }
+        } else if (key == "repeat") {
+            int64_t ms;
+            if (!ParseInt(value, ms) || ms < 0) {
+                LOG("[警告] 故障日程重复周期 {} 无效, 不重复", value);
+            } else {
+                schedule.repeatNs = MsToNs(ms);
+            }
+        } else if (!key.empty()) {
+            LOG("[警告] 忽略未知的前置参数 {}", items[i]);
+        }
+    }
+    std::stable_sort(schedule.faults.begin(), schedule.faults.end(),
+                     [](const SimFault& a, const SimFault& b) { return a.atNs < b.atNs; });
+    if (schedule.repeatNs != 0 && !schedule.faults.empty() && schedule.repeatNs <= schedule.faults.back().atNs) {
+        LOG("[警告] 故障日程重复周期短于最后一个故障的时刻, 不重复");
+        schedule.repeatNs = 0;
+    }
+    return schedule;
+}
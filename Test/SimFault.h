@@ -0,0 +1,71 @@
+///
+/// @file SimFault.h
+/// @brief 模拟前置的故障注入日程
+///
+
+#ifndef CTP_TEST_SIM_FAULT_H
+#define CTP_TEST_SIM_FAULT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///
+/// @brief 故障类型
+///
+enum class SimFaultType : uint8_t {
+    Disconnect,     ///< 断开连接, 回调 OnFrontDisconnected(reason), 经过 durationNs 后自动重连
+    Stall,          ///< durationNs 内不处理请求、不推送回调, 每秒回调一次 OnHeartBeatWarning; reason 不为0时随后断线
+    Delay,          ///< durationNs 内产生的回调各推迟 delayNs 推送, 顺序不变
+    Reorder,        ///< durationNs 内产生的回调每 batch 个倒序推送
+    Throttle,       ///< durationNs 内 Req* 直接返回 reason (-2 未处理请求超限, -3 每秒请求超限)
+    Reject,         ///< durationNs 内查询请求以 OnRspError(reason) 应答, 不返回数据
+};
+
+///
+/// @brief 一个故障
+///
+struct SimFault {
+    int64_t atNs;           ///< 相对连接建立(或本轮日程开始)的时刻
+    SimFaultType type;
+    int reason;             ///< Disconnect/Stall: 断线原因码; Throttle: Req* 的返回值; Reject: 错误码
+    int64_t durationNs;     ///< Disconnect: 断线到重连的时长; 其余: 故障持续时间
+    int64_t downNs;         ///< Stall 后断线时, 断线到重连的时长
+    int64_t delayNs;        ///< Delay: 每个回调推迟的时长
+    int batch;              ///< Reorder: 倒序的回调个数
+
+    SimFault()
+        : atNs(0), type(SimFaultType::Disconnect), reason(0), durationNs(0), downNs(0), delayNs(0), batch(0) {}
+};
+
+///
+/// @brief 故障日程, 由前置地址解析
+///
+/// 前置地址格式为 tcp://...?faults=<故障>,<故障>...&repeat=<毫秒>, 每个故障为 <毫秒>:<类型>[:<参数>...],
+/// 毫秒为相对连接建立的时刻, 原因码可写十六进制:
+///
+/// - <t>:disconnect:<原因码>[:<断线毫秒>]          如 2000:disconnect:0x1001:500
+/// - <t>:stall:<毫秒>[:<原因码>[:<断线毫秒>]]       如 5000:stall:3000:0x2001
+/// - <t>:delay:<推迟毫秒>:<持续毫秒>                如 8000:delay:200:2000
+/// - <t>:reorder:<个数>:<持续毫秒>                  如 9000:reorder:4:2000
+/// - <t>:throttle:<持续毫秒>[:-2|-3]                如 10000:throttle:1000:-3
+/// - <t>:reject:<持续毫秒>[:<错误码>]               如 0:reject:2500:90
+///
+/// repeat 不为0时日程每 repeat 毫秒重复一次。
+///
+struct SimFaultSchedule {
+    std::vector<SimFault> faults;   ///< 按 atNs 排序
+    int64_t repeatNs;               ///< 0 表示不重复
+
+    SimFaultSchedule() : repeatNs(0) {}
+
+    bool Empty() const { return faults.empty(); }
+
+    /// 解析前置地址中的故障日程, 无效的故障记日志后忽略
+    static SimFaultSchedule Parse(const std::string& frontAddress);
+};
+
+/// 故障类型名称, 用于日志
+const char* SimFaultTypeName(SimFaultType type);
+
+#endif // CTP_TEST_SIM_FAULT_H
@@ -0,0 +1,1795 @@
+///
+/// @file SimFront.cpp
+/// @brief 本地模拟交易前置实现
+///
+
+#include "SimFront.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+#include "FieldCopy.h"
+
+namespace {
+
+// 前置线程每次从一个会话连续处理的请求数, 避免单个会话独占前置线程
+const int kRequestBatch = 64;
+
+// 注入停顿期间 OnHeartBeatWarning 的间隔
+const int64_t kHeartBeatWarningNs = 1000000000LL;
+
+// 没有待检查的故障
+const int64_t kNoFaultDue = INT64_MAX;
+
+// 错误码, 与 error.xml 一致
+const int kErrInvalidLogin = 3;
+const int kErrBadField = 15;
+const int kErrInstrumentNotFound = 16;
+const int kErrDuplicateOrderRef = 22;
+const int kErrOrderNotFound = 25;
+const int kErrInsuitableOrderStatus = 26;
+const int kErrUnsupportedFunction = 27;
+const int kErrOverClosePosition = 30;
+const int kErrSettlementNotConfirmed = 42;
+const int kErrOverCloseToday = 50;
+const int kErrOverCloseYesterday = 51;
+const int kErrPriceTypeNotSupported = 80;
+const int kErrQueryNotReady = 90;
+
+const char* ErrorText(int errorId) {
+    switch (errorId) {
+        case 0: return "CTP:正确";
+        case kErrInvalidLogin: return "CTP:不合法的登录";
+        case kErrBadField: return "CTP:报单字段有误";
+        case kErrInstrumentNotFound: return "CTP:找不到合约";
+        case kErrDuplicateOrderRef: return "CTP:报单错误：不允许重复报单";
+        case kErrOrderNotFound: return "CTP:撤单找不到相应报单";
+        case kErrInsuitableOrderStatus: return "CTP:报单已全成交或已撤销，不能再撤";
+        case kErrUnsupportedFunction: return "CTP:不支持的功能";
+        case kErrOverClosePosition: return "CTP:平仓量超过持仓量";
+        case kErrSettlementNotConfirmed: return "CTP:结算结果未确认";
+        case kErrOverCloseToday: return "CTP:平今仓位不足";
+        case kErrOverCloseYesterday: return "CTP:平昨仓位不足";
+        case kErrPriceTypeNotSupported: return "CTP:交易所不支持的价格类型";
+        case kErrQueryNotReady: return "CTP:查询未就绪，请稍后重试";
+        default: return "CTP:模拟前置错误";
+    }
+}
+
+const char* StatusText(char orderStatus, char submitStatus) {
+    if (submitStatus == THOST_FTDC_OSS_InsertSubmitted) {
+        return "报单已提交";
+    }
+    if (submitStatus == THOST_FTDC_OSS_CancelSubmitted) {
+        return "撤单已提交";
+    }
+    switch (orderStatus) {
+        case THOST_FTDC_OST_AllTraded: return "全部成交";
+        case THOST_FTDC_OST_PartTradedQueueing: return "部分成交";
+        case THOST_FTDC_OST_NoTradeQueueing: return "未成交";
+        case THOST_FTDC_OST_Canceled: return "已撤单";
+        default: return "";
+    }
+}
+
+/// 内置合约
+struct InstrumentSpec {
+    const char* instrumentId;
+    const char* exchangeId;
+    const char* name;
+    const char* productId;
+    int volumeMultiple;
+    double priceTick;
+    double marginRatio;
+    double commissionByMoney;
+    double commissionByVolume;
+};
+
+const InstrumentSpec kInstruments[] = {
+    {"rb2701", "SHFE", "螺纹钢2701", "rb", 10, 1.0, 0.10, 0.0001, 0.0},
+    {"cu2612", "SHFE", "铜2612", "cu", 5, 10.0, 0.10, 0.00005, 0.0},
+    {"au2612", "SHFE", "黄金2612", "au", 1000, 0.02, 0.08, 0.0, 10.0},
+    {"sc2612", "INE", "原油2612", "sc", 1000, 0.1, 0.12, 0.0, 20.0},
+    {"IF2611", "CFFEX", "沪深300指数2611", "IF", 300, 0.2, 0.12, 0.000023, 0.0},
+    {"m2701", "DCE", "豆粕2701", "m", 10, 1.0, 0.08, 0.0, 1.5},
+    {"SR701", "CZCE", "白糖701", "SR", 10, 1.0, 0.08, 0.0, 3.0},
+    {"lc2701", "GFEX", "碳酸锂2701", "lc", 1, 20.0, 0.12, 0.0003, 0.0},
+};
+
+const size_t kInstrumentCount = sizeof(kInstruments) / sizeof(kInstruments[0]);
+
+/// 无符号整数转十进制, width 不为0时左侧补空格右对齐; 回报热路径上代替 snprintf
+template <size_t N>
+void FormatNumber(char (&dst)[N], uint32_t value, size_t width) {
+    char digits[10];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    size_t pos = 0;
+    while (pos + count < width && pos < N - 1) {
+        dst[pos++] = ' ';
+    }
+    while (count > 0 && pos < N - 1) {
+        dst[pos++] = digits[--count];
+    }
+    dst[pos] = '\0';
+}
+
+/// SimSession 内的队列索引按缓存行对齐, C++11 的 new 不保证超过16字节的对齐
+SimSession* NewSession(size_t requestCapacity, size_t responseCapacity) {
+    void* storage = nullptr;
+    if (posix_memalign(&storage, alignof(SimSession), sizeof(SimSession)) != 0) {
+        return nullptr;
+    }
+    return new (storage) SimSession(requestCapacity, responseCapacity);
+}
+
+void DeleteSession(SimSession* session) {
+    if (session) {
+        session->~SimSession();
+        free(session);
+    }
+}
+
+/// 上期所和能源中心区分今昨仓, 不支持市价单
+bool IsShfeStyle(const char* exchangeId) {
+    return strcmp(exchangeId, "SHFE") == 0 || strcmp(exchangeId, "INE") == 0;
+}
+
+bool IsQuery(SimRequestType type) {
+    switch (type) {
+        case SimRequestType::QrySettlementInfo:
+        case SimRequestType::QryTradingAccount:
+        case SimRequestType::QryInvestorPosition:
+        case SimRequestType::QryInstrument:
+        case SimRequestType::QryInstrumentMarginRate:
+        case SimRequestType::QryInstrumentCommissionRate:
+        case SimRequestType::QryTrade:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// 请求对应的应答类型
+TraderEventType ResponseTypeOf(SimRequestType type) {
+    switch (type) {
+        case SimRequestType::Authenticate: return TraderEventType::RspAuthenticate;
+        case SimRequestType::UserLogin: return TraderEventType::RspUserLogin;
+        case SimRequestType::UserLogout: return TraderEventType::RspUserLogout;
+        case SimRequestType::QrySettlementInfo: return TraderEventType::RspQrySettlementInfo;
+        case SimRequestType::SettlementInfoConfirm: return TraderEventType::RspSettlementInfoConfirm;
+        case SimRequestType::QryTradingAccount: return TraderEventType::RspQryTradingAccount;
+        case SimRequestType::QryInvestorPosition: return TraderEventType::RspQryInvestorPosition;
+        case SimRequestType::QryInstrument: return TraderEventType::RspQryInstrument;
+        case SimRequestType::QryInstrumentMarginRate: return TraderEventType::RspQryInstrumentMarginRate;
+        case SimRequestType::QryInstrumentCommissionRate: return TraderEventType::RspQryInstrumentCommissionRate;
+        case SimRequestType::QryTrade: return TraderEventType::RspQryTrade;
+        case SimRequestType::OrderInsert: return TraderEventType::RspOrderInsert;
+        case SimRequestType::OrderAction: return TraderEventType::RspOrderAction;
+        case SimRequestType::BatchOrderAction: return TraderEventType::RspBatchOrderAction;
+        default: return TraderEventType::RspError;
+    }
+}
+
+/// 回报和连接通知不带 CThostFtdcRspInfoField
+bool HasRspInfo(TraderEventType type) {
+    switch (type) {
+        case TraderEventType::FrontConnected:
+        case TraderEventType::FrontDisconnected:
+        case TraderEventType::HeartBeatWarning:
+        case TraderEventType::RtnOrder:
+        case TraderEventType::RtnTrade:
+            return false;
+        default:
+            return true;
+    }
+}
+
+} // namespace
+
+SimFront& SimFront::Instance() {
+    static SimFront front;
+    return front;
+}
+
+SimFront::SimFront()
+    : m_symbols(new SymbolTable(256)), m_matcher(kInstrumentCount), m_nextSessionId(0x1000), m_clockSecond(-1),
+      m_sessions(new std::atomic<SimSession*>[kMaxSessions]), m_sessionCount(0),
+      m_running(false), m_requests(0), m_acceptedOrders(0), m_orderRejects(0), m_cancels(0),
+      m_tradeCount(0), m_responses(0), m_responseQueueFullSpins(0), m_faults(0), m_heldResponses(0) {
+    for (int i = 0; i < kMaxSessions; ++i) {
+        m_sessions[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    const time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(m_tradingDay, sizeof(m_tradingDay), "%Y%m%d", &local);
+    m_clock[0] = '\0';
+
+    m_instruments.resize(kInstrumentCount);
+    for (size_t i = 0; i < kInstrumentCount; ++i) {
+        const InstrumentSpec& spec = kInstruments[i];
+        Instrument& instrument = m_instruments[m_symbols->Intern(std::string(spec.instrumentId))];
+        CThostFtdcInstrumentField& field = instrument.field;
+        memset(&field, 0, sizeof(field));
+        CopyField(field.InstrumentID, spec.instrumentId);
+        CopyField(field.ExchangeInstID, spec.instrumentId);
+        CopyField(field.ExchangeID, spec.exchangeId);
+        CopyField(field.InstrumentName, spec.name);
+        CopyField(field.ProductID, spec.productId);
+        field.ProductClass = THOST_FTDC_PC_Futures;
+        instrument.exchange = 0;
+        while (instrument.exchange < static_cast<int>(m_exchanges.size()) &&
+               m_exchanges[instrument.exchange].id != spec.exchangeId) {
+            ++instrument.exchange;
+        }
+        if (instrument.exchange == static_cast<int>(m_exchanges.size())) {
+            m_exchanges.push_back(Exchange());
+            m_exchanges.back().id = spec.exchangeId;
+            m_exchanges.back().rightAligned = IsShfeStyle(spec.exchangeId) || strcmp(spec.exchangeId, "CFFEX") == 0;
+            m_exchanges.back().tradeCount = 0;
+        }
+        // 合约代码末尾为年月, 郑商所只有年份的最后一位
+        const size_t length = strlen(spec.instrumentId);
+        const int yymm = atoi(spec.instrumentId + length - (strcmp(spec.exchangeId, "CZCE") == 0 ? 3 : 4));
+        field.DeliveryYear = 2000 + (yymm >= 1000 ? yymm / 100 : 20 + yymm / 100);
+        field.DeliveryMonth = yymm % 100;
+        field.MaxMarketOrderVolume = 100;
+        field.MinMarketOrderVolume = 1;
+        field.MaxLimitOrderVolume = 500;
+        field.MinLimitOrderVolume = 1;
+        field.VolumeMultiple = spec.volumeMultiple;
+        field.PriceTick = spec.priceTick;
+        CopyField(field.CreateDate, m_tradingDay);
+        CopyField(field.OpenDate, m_tradingDay);
+        snprintf(field.ExpireDate, sizeof(field.ExpireDate), "%04u%02u15", field.DeliveryYear % 10000u,
+                 field.DeliveryMonth % 100u);
+        CopyField(field.StartDelivDate, field.ExpireDate);
+        CopyField(field.EndDelivDate, field.ExpireDate);
+        field.InstLifePhase = THOST_FTDC_IP_Started;
+        field.IsTrading = 1;
+        field.PositionType = THOST_FTDC_PT_Gross;
+        field.PositionDateType = IsShfeStyle(spec.exchangeId) ? THOST_FTDC_PDT_UseHistory : THOST_FTDC_PDT_NoUseHistory;
+        field.LongMarginRatio = spec.marginRatio;
+        field.ShortMarginRatio = spec.marginRatio;
+        field.MaxMarginSideAlgorithm = strcmp(spec.exchangeId, "CFFEX") == 0 ? THOST_FTDC_MMSA_YES : THOST_FTDC_MMSA_NO;
+        instrument.marginRatio = spec.marginRatio;
+        instrument.commissionByMoney = spec.commissionByMoney;
+        instrument.commissionByVolume = spec.commissionByVolume;
+    }
+}
+
+SimFront::~SimFront() {
+    Stop();
+    for (int i = 0; i < kMaxSessions; ++i) {
+        DeleteSession(m_sessions[i].load(std::memory_order_relaxed));
+    }
+}
+
+void SimFront::Configure(const SimFrontOptions& options) {
+    std::lock_guard<std::mutex> lock(m_attachMutex);
+    if (!m_running.load()) {
+        m_options = options;
+    }
+}
+
+SimSession* SimFront::Attach() {
+    std::lock_guard<std::mutex> lock(m_attachMutex);
+    int slot = 0;
+    while (slot < kMaxSessions && m_sessions[slot].load(std::memory_order_acquire) != nullptr) {
+        ++slot;
+    }
+    if (slot == kMaxSessions) {
+        return nullptr;
+    }
+
+    SimSession* session = NewSession(m_options.requestQueueCapacity, m_options.responseQueueCapacity);
+    if (!session) {
+        return nullptr;
+    }
+    m_sessions[slot].store(session, std::memory_order_release);
+    if (slot >= m_sessionCount.load(std::memory_order_relaxed)) {
+        m_sessionCount.store(slot + 1, std::memory_order_release);
+    }
+
+    if (!m_running.load()) {
+        m_orders.reserve(m_options.orderCapacity);
+        m_orderIndex.reserve(m_options.orderCapacity);
+        m_trades.reserve(m_options.orderCapacity);
+        m_matcher.Reserve(m_options.orderCapacity);
+        m_running.store(true);
+        m_thread = std::thread(&SimFront::Run, this);
+    }
+    return session;
+}
+
+void SimFront::Detach(SimSession* session) {
+    session->closing.store(true, std::memory_order_release);
+    session->detached.store(true, std::memory_order_release);
+    m_waiter.Notify();
+}
+
+void SimFront::Stop() {
+    m_waiter.Signal([this] { m_running.store(false); });
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+SimFrontStats SimFront::GetStats() const {
+    SimFrontStats stats;
+    stats.requests = m_requests.load(std::memory_order_relaxed);
+    stats.orders = m_acceptedOrders.load(std::memory_order_relaxed);
+    stats.orderRejects = m_orderRejects.load(std::memory_order_relaxed);
+    stats.cancels = m_cancels.load(std::memory_order_relaxed);
+    stats.trades = m_tradeCount.load(std::memory_order_relaxed);
+    stats.responses = m_responses.load(std::memory_order_relaxed);
+    stats.responseQueueFullSpins = m_responseQueueFullSpins.load(std::memory_order_relaxed);
+    stats.faults = m_faults.load(std::memory_order_relaxed);
+    stats.heldResponses = m_heldResponses.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ---------------------------------------------------------------------------
+// 调用 Req* 的线程
+// ---------------------------------------------------------------------------
+
+int SimFront::Send(SimSession* session, SimRequestType type, int requestId, const void* data, size_t size) {
+    if (type != SimRequestType::Connect && !session->connected.load(std::memory_order_acquire)) {
+        return -1;
+    }
+    const int64_t throttleEnd = session->throttleEndNs.load(std::memory_order_acquire);
+    if (throttleEnd != 0 && type != SimRequestType::Connect && MonotonicNs() < throttleEnd) {
+        return session->throttleCode.load(std::memory_order_relaxed);
+    }
+    if (m_options.maxPendingRequests > 0 &&
+        session->pending.load(std::memory_order_relaxed) >= m_options.maxPendingRequests) {
+        return -2;
+    }
+    if (IsQuery(type) && m_options.queriesPerSecond > 0) {
+        const int64_t now = MonotonicNs();
+        const int64_t interval = static_cast<int64_t>(1e9 / m_options.queriesPerSecond);
+        int64_t last = session->lastQueryNs.load(std::memory_order_relaxed);
+        if ((last != 0 && now - last < interval) ||
+            !session->lastQueryNs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+            return -3;
+        }
+    }
+
+    while (session->sendLock.test_and_set(std::memory_order_acquire)) {
+    }
+    SimRequest* req = session->requests.Claim();
+    if (!req) {
+        session->sendLock.clear(std::memory_order_release);
+        return -2;
+    }
+    req->type = type;
+    req->requestId = requestId;
+    req->enqueueNs = MonotonicNs();
+    if (data) {
+        memcpy(&req->data, data, size);
+    }
+    session->pending.fetch_add(1, std::memory_order_relaxed);
+    session->requests.Publish();
+    session->sendLock.clear(std::memory_order_release);
+
+    m_waiter.Notify();
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 前置线程
+// ---------------------------------------------------------------------------
+
+void SimFront::Run() {
+    while (m_running.load(std::memory_order_acquire)) {
+        bool busy = false;
+        int64_t faultDueNs = kNoFaultDue;
+        const int count = m_sessionCount.load(std::memory_order_acquire);
+        for (int slot = 0; slot < count; ++slot) {
+            SimSession* session = m_sessions[slot].load(std::memory_order_acquire);
+            if (!session) {
+                continue;
+            }
+            if (session->detached.load(std::memory_order_acquire)) {
+                Release(slot);
+                continue;
+            }
+            if (session->fault.active) {
+                faultDueNs = std::min(faultDueNs, RunFaults(slot, *session, MonotonicNs()));
+                // 停顿期间请求留在队列中
+                if (session->fault.stallEndNs != 0) {
+                    continue;
+                }
+            }
+            for (int n = 0; n < kRequestBatch; ++n) {
+                SimRequest* req = session->requests.Front();
+                if (!req) {
+                    break;
+                }
+                Process(slot, *session, *req);
+                session->requests.Pop();
+                session->pending.fetch_sub(1, std::memory_order_relaxed);
+                m_requests.store(m_requests.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                busy = true;
+            }
+        }
+
+        if (busy) {
+            m_waiter.Busy();
+            continue;
+        }
+
+        // 有待执行的故障时在到期时醒来
+        std::chrono::nanoseconds sleep = std::chrono::nanoseconds::max();
+        if (faultDueNs != kNoFaultDue) {
+            sleep = std::chrono::nanoseconds(std::max<int64_t>(faultDueNs - MonotonicNs(), 0));
+        }
+        m_waiter.Idle([this, count] {
+            bool idle = m_running.load(std::memory_order_relaxed);
+            for (int slot = 0; idle && slot < count; ++slot) {
+                SimSession* session = m_sessions[slot].load(std::memory_order_acquire);
+                idle = !session || ((session->requests.Empty() || session->fault.stallEndNs != 0) &&
+                                    !session->detached.load(std::memory_order_relaxed));
+            }
+            return !idle || m_sessionCount.load(std::memory_order_acquire) != count;
+        }, sleep);
+    }
+}
+
+void SimFront::Release(int slot) {
+    SimSession* session = m_sessions[slot].load(std::memory_order_acquire);
+    if (session->loggedIn) {
+        std::vector<int>& sessions = m_accounts[session->account].sessions;
+        sessions.erase(std::remove(sessions.begin(), sessions.end(), slot), sessions.end());
+    }
+    std::lock_guard<std::mutex> lock(m_attachMutex);
+    m_sessions[slot].store(nullptr, std::memory_order_release);
+    DeleteSession(session);
+}
+
+void SimFront::Process(int slot, SimSession& session, SimRequest& req) {
+    // 注入断线前已入队的请求随连接丢失
+    if (!session.connected.load(std::memory_order_relaxed) && req.type != SimRequestType::Connect) {
+        return;
+    }
+    switch (req.type) {
+        case SimRequestType::Connect:
+            OnConnect(session);
+            return;
+        case SimRequestType::Authenticate:
+            OnAuthenticate(session, req);
+            return;
+        case SimRequestType::UserLogin:
+            OnUserLogin(slot, session, req);
+            return;
+        case SimRequestType::Unsupported:
+            Respond(session, TraderEventType::RspError, req.requestId, kErrUnsupportedFunction);
+            return;
+        default:
+            break;
+    }
+
+    // 其余请求须先登录
+    if (!session.loggedIn) {
+        if (req.type == SimRequestType::OrderInsert) {
+            RejectOrder(session, req, kErrInvalidLogin);
+        } else if (req.type == SimRequestType::OrderAction) {
+            RejectAction(session, req, kErrInvalidLogin);
+        } else {
+            Respond(session, ResponseTypeOf(req.type), req.requestId, kErrInvalidLogin);
+        }
+        return;
+    }
+    // 注入的查询出错期间查询只回 OnRspError; 窗口结束后 RunFaults 才清零, 因此还要比较时刻
+    if (IsQuery(req.type) && session.fault.rejectEndNs != 0 && MonotonicNs() < session.fault.rejectEndNs) {
+        Respond(session, TraderEventType::RspError, req.requestId, session.fault.rejectCode);
+        return;
+    }
+
+    switch (req.type) {
+        case SimRequestType::UserLogout:
+            OnUserLogout(slot, session, req);
+            break;
+        case SimRequestType::QrySettlementInfo:
+            OnQrySettlementInfo(session, req);
+            break;
+        case SimRequestType::SettlementInfoConfirm:
+            OnSettlementInfoConfirm(session, req);
+            break;
+        case SimRequestType::QryTradingAccount:
+            OnQryTradingAccount(session, req);
+            break;
+        case SimRequestType::QryInvestorPosition:
+            OnQryInvestorPosition(session, req);
+            break;
+        case SimRequestType::QryInstrument:
+            OnQryInstrument(session, req);
+            break;
+        case SimRequestType::QryInstrumentMarginRate:
+            OnQryMarginRate(session, req);
+            break;
+        case SimRequestType::QryInstrumentCommissionRate:
+            OnQryCommissionRate(session, req);
+            break;
+        case SimRequestType::QryTrade:
+            OnQryTrade(session, req);
+            break;
+        case SimRequestType::OrderInsert:
+            OnOrderInsert(session, req);
+            break;
+        case SimRequestType::OrderAction:
+            OnOrderAction(session, req);
+            break;
+        case SimRequestType::BatchOrderAction:
+            OnBatchOrderAction(session, req);
+            break;
+        default:
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 回调
+// ---------------------------------------------------------------------------
+
+TraderEvent* SimFront::ClaimResponse(SimSession& session) {
+    TraderEvent* ev;
+    while ((ev = session.responses.Claim()) == nullptr) {
+        if (session.closing.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        m_responseQueueFullSpins.store(m_responseQueueFullSpins.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+    return ev;
+}
+
+void SimFront::DeliverResponse(SimSession& session) {
+    session.responses.Publish();
+    m_responses.store(m_responses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    session.callbackWaiter.Notify();
+}
+
+TraderEvent* SimFront::BeginResponse(SimSession& session, TraderEventType type, int requestId, bool isLast,
+                                     int errorId) {
+    TraderEvent* ev = session.fault.holdResponses ? &session.fault.staging : ClaimResponse(session);
+    if (!ev) {
+        return nullptr;
+    }
+    ev->type = type;
+    ev->hasData = false;
+    ev->hasRspInfo = HasRspInfo(type);
+    ev->isLast = isLast;
+    ev->requestId = requestId;
+    ev->enqueueNs = MonotonicNs();
+    if (ev->hasRspInfo) {
+        ev->rspInfo.ErrorID = errorId;
+        CopyField(ev->rspInfo.ErrorMsg, ErrorText(errorId));
+    }
+    return ev;
+}
+
+void SimFront::PublishResponse(SimSession& session) {
+    if (session.fault.holdResponses) {
+        HoldResponse(session);
+        return;
+    }
+    DeliverResponse(session);
+}
+
+void SimFront::Respond(SimSession& session, TraderEventType type, int requestId, int errorId) {
+    if (BeginResponse(session, type, requestId, true, errorId)) {
+        PublishResponse(session);
+    }
+}
+
+void SimFront::RejectOrder(SimSession& session, const SimRequest& req, int errorId) {
+    m_orderRejects.store(m_orderRejects.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspOrderInsert, req.requestId, true, errorId);
+    if (ev) {
+        ev->hasData = true;
+        ev->data.inputOrder = req.data.inputOrder;
+        PublishResponse(session);
+    }
+    ev = BeginResponse(session, TraderEventType::ErrRtnOrderInsert, 0, true, errorId);
+    if (ev) {
+        ev->hasData = true;
+        ev->data.inputOrder = req.data.inputOrder;
+        PublishResponse(session);
+    }
+}
+
+void SimFront::RejectAction(SimSession& session, const SimRequest& req, int errorId) {
+    const CThostFtdcInputOrderActionField& input = req.data.inputOrderAction;
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspOrderAction, req.requestId, true, errorId);
+    if (ev) {
+        ev->hasData = true;
+        ev->data.inputOrderAction = input;
+        PublishResponse(session);
+    }
+    ev = BeginResponse(session, TraderEventType::ErrRtnOrderAction, 0, true, errorId);
+    if (ev) {
+        CThostFtdcOrderActionField& action = ev->data.orderAction;
+        memset(&action, 0, sizeof(action));
+        CopyField(action.BrokerID, input.BrokerID);
+        CopyField(action.InvestorID, input.InvestorID);
+        action.OrderActionRef = input.OrderActionRef;
+        CopyField(action.OrderRef, input.OrderRef);
+        action.RequestID = input.RequestID;
+        action.FrontID = input.FrontID;
+        action.SessionID = input.SessionID;
+        CopyField(action.ExchangeID, input.ExchangeID);
+        CopyField(action.OrderSysID, input.OrderSysID);
+        action.ActionFlag = input.ActionFlag;
+        CopyField(action.ActionDate, m_tradingDay);
+        CopyField(action.ActionTime, Now());
+        action.OrderActionStatus = THOST_FTDC_OAS_Rejected;
+        CopyField(action.UserID, input.UserID);
+        CopyField(action.StatusMsg, ErrorText(errorId));
+        CopyField(action.InstrumentID, input.InstrumentID);
+        ev->hasData = true;
+        PublishResponse(session);
+    }
+}
+
+const char* SimFront::Now() {
+    const time_t now = time(nullptr);
+    if (now != m_clockSecond) {
+        m_clockSecond = now;
+        struct tm local;
+        localtime_r(&now, &local);
+        strftime(m_clock, sizeof(m_clock), "%H:%M:%S", &local);
+    }
+    return m_clock;
+}
+
+// ---------------------------------------------------------------------------
+// 连接、登录和查询
+// ---------------------------------------------------------------------------
+
+void SimFront::OnConnect(SimSession& session) {
+    // 故障日程从首次连接开始计时
+    SimFaultState& fault = session.fault;
+    if (fault.baseNs == 0 && !fault.schedule.Empty()) {
+        fault.baseNs = MonotonicNs();
+        fault.active = true;
+    }
+    session.connected.store(true, std::memory_order_release);
+    Respond(session, TraderEventType::FrontConnected, 0);
+}
+
+void SimFront::OnAuthenticate(SimSession& session, const SimRequest& req) {
+    const CThostFtdcReqAuthenticateField& input = req.data.authenticate;
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspAuthenticate, req.requestId, true);
+    if (!ev) {
+        return;
+    }
+    CThostFtdcRspAuthenticateField& rsp = ev->data.rspAuthenticate;
+    memset(&rsp, 0, sizeof(rsp));
+    CopyField(rsp.BrokerID, input.BrokerID);
+    CopyField(rsp.UserID, input.UserID);
+    CopyField(rsp.UserProductInfo, input.UserProductInfo);
+    CopyField(rsp.AppID, input.AppID);
+    rsp.AppType = THOST_FTDC_APP_TYPE_Investor;
+    ev->hasData = true;
+    PublishResponse(session);
+}
+
+void SimFront::OnUserLogin(int slot, SimSession& session, const SimRequest& req) {
+    const CThostFtdcReqUserLoginField& input = req.data.userLogin;
+    if (session.loggedIn || !input.BrokerID[0] || !input.UserID[0] || !input.Password[0]) {
+        Respond(session, TraderEventType::RspUserLogin, req.requestId, kErrInvalidLogin);
+        return;
+    }
+
+    const std::string key = std::string(input.BrokerID) + "/" + input.UserID;
+    std::unordered_map<std::string, int>::const_iterator it = m_accountIndex.find(key);
+    int index;
+    if (it != m_accountIndex.end()) {
+        index = it->second;
+    } else {
+        index = static_cast<int>(m_accounts.size());
+        m_accounts.push_back(Account());
+        Account& account = m_accounts.back();
+        account.brokerId = input.BrokerID;
+        account.investorId = input.UserID;
+        account.balance = m_options.initialBalance;
+        account.closeProfit = 0;
+        account.commission = 0;
+        account.settlementConfirmed = false;
+        account.maxOrderRef = 0;
+        Position empty;
+        memset(&empty, 0, sizeof(empty));
+        account.positions.assign(m_instruments.size(), empty);
+        BuildTemplates(account);
+        m_accountIndex[key] = index;
+    }
+    Account& account = m_accounts[index];
+    account.sessions.push_back(slot);
+    session.account = index;
+    session.sessionId = ++m_nextSessionId;
+    session.loggedIn = true;
+
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspUserLogin, req.requestId, true);
+    if (ev) {
+        CThostFtdcRspUserLoginField& rsp = ev->data.rspUserLogin;
+        memset(&rsp, 0, sizeof(rsp));
+        CopyField(rsp.TradingDay, m_tradingDay);
+        CopyField(rsp.LoginTime, Now());
+        CopyField(rsp.BrokerID, input.BrokerID);
+        CopyField(rsp.UserID, input.UserID);
+        CopyField(rsp.SystemName, "SimFront");
+        rsp.FrontID = session.frontId;
+        rsp.SessionID = session.sessionId;
+        snprintf(rsp.MaxOrderRef, sizeof(rsp.MaxOrderRef), "%d", account.maxOrderRef);
+        CopyField(rsp.SHFETime, rsp.LoginTime);
+        CopyField(rsp.DCETime, rsp.LoginTime);
+        CopyField(rsp.CZCETime, rsp.LoginTime);
+        CopyField(rsp.FFEXTime, rsp.LoginTime);
+        CopyField(rsp.INETime, rsp.LoginTime);
+        CopyField(rsp.GFEXTime, rsp.LoginTime);
+        CopyField(rsp.SysVersion, "SimFront 6.7.7");
+        ev->hasData = true;
+        PublishResponse(session);
+    }
+
+    // 私有流回报紧随登录应答
+    ReplayFlow(session);
+}
+
+void SimFront::OnUserLogout(int slot, SimSession& session, const SimRequest& req) {
+    std::vector<int>& sessions = m_accounts[session.account].sessions;
+    sessions.erase(std::remove(sessions.begin(), sessions.end(), slot), sessions.end());
+    session.loggedIn = false;
+
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspUserLogout, req.requestId, true);
+    if (ev) {
+        ev->data.userLogout = req.data.userLogout;
+        ev->hasData = true;
+        PublishResponse(session);
+    }
+}
+
+void SimFront::OnQrySettlementInfo(SimSession& session, const SimRequest& req) {
+    const Account& account = m_accounts[session.account];
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspQrySettlementInfo, req.requestId, true);
+    if (!ev) {
+        return;
+    }
+    CThostFtdcSettlementInfoField& rsp = ev->data.settlementInfo;
+    memset(&rsp, 0, sizeof(rsp));
+    CopyField(rsp.TradingDay, m_tradingDay);
+    rsp.SettlementID = 1;
+    CopyField(rsp.BrokerID, account.brokerId.c_str());
+    CopyField(rsp.InvestorID, account.investorId.c_str());
+    rsp.SequenceNo = 1;
+    snprintf(rsp.Content, sizeof(rsp.Content), "模拟前置结算单 交易日: %s 投资者: %s 权益: %.2f", m_tradingDay,
+             account.investorId.c_str(), account.balance);
+    CopyField(rsp.AccountID, account.investorId.c_str());
+    CopyField(rsp.CurrencyID, "CNY");
+    ev->hasData = true;
+    PublishResponse(session);
+}
+
+void SimFront::OnSettlementInfoConfirm(SimSession& session, const SimRequest& req) {
+    Account& account = m_accounts[session.account];
+    account.settlementConfirmed = true;
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspSettlementInfoConfirm, req.requestId, true);
+    if (!ev) {
+        return;
+    }
+    CThostFtdcSettlementInfoConfirmField& rsp = ev->data.settlementInfoConfirm;
+    memset(&rsp, 0, sizeof(rsp));
+    CopyField(rsp.BrokerID, account.brokerId.c_str());
+    CopyField(rsp.InvestorID, account.investorId.c_str());
+    CopyField(rsp.ConfirmDate, m_tradingDay);
+    CopyField(rsp.ConfirmTime, Now());
+    rsp.SettlementID = 1;
+    CopyField(rsp.AccountID, account.investorId.c_str());
+    CopyField(rsp.CurrencyID, "CNY");
+    ev->hasData = true;
+    PublishResponse(session);
+}
+
+void SimFront::OnQryTradingAccount(SimSession& session, const SimRequest& req) {
+    const Account& account = m_accounts[session.account];
+    double margin = 0;
+    for (size_t i = 0; i < account.positions.size(); ++i) {
+        const Position& position = account.positions[i];
+        margin += (position.cost[0] + position.cost[1]) * m_instruments[i].marginRatio;
+    }
+
+    TraderEvent* ev = BeginResponse(session, TraderEventType::RspQryTradingAccount, req.requestId, true);
+    if (!ev) {
+        return;
+    }
+    CThostFtdcTradingAccountField& rsp = ev->data.tradingAccount;
+    memset(&rsp, 0, sizeof(rsp));
+    CopyField(rsp.BrokerID, account.brokerId.c_str());
+    CopyField(rsp.AccountID, account.investorId.c_str());
+    rsp.PreBalance = m_options.initialBalance;
+    rsp.CurrMargin = margin;
+    rsp.Commission = account.commission;
+    rsp.CloseProfit = account.closeProfit;
+    rsp.Balance = account.balance;
+    rsp.Available = account.balance - margin;
+    rsp.WithdrawQuota = rsp.Available;
+    CopyField(rsp.TradingDay, m_tradingDay);
+    rsp.SettlementID = 1;
+    CopyField(rsp.CurrencyID, "CNY");
+    ev->hasData = true;
+    PublishResponse(session);
+}
+
+void SimFront::OnQryInvestorPosition(SimSession& session, const SimRequest& req) {
+    const Account& account = m_accounts[session.account];
+    const char* instrumentId = req.data.qryInvestorPosition.InstrumentID;
+    const uint32_t only = instrumentId[0] ? m_symbols->Find(instrumentId) : kInvalidSymbol;
+
+    // 每个合约多空各一行, 全部为今仓; 最后一行带 isLast, 没有持仓时返回空应答
+    TraderEvent* pending = nullptr;
+    for (uint32_t id = 0; id < account.positions.size(); ++id) {
+        if (instrumentId[0] && id != only) {
+            continue;
+        }
+        const Position& position = account.positions[id];
+        const Instrument& instrument = m_instruments[id];
+        for (int side = 0; side < 2; ++side) {
+            if (position.volume[side] == 0) {
+                continue;
+            }
+            if (pending) {
+                PublishResponse(session);
+            }
+            pending = BeginResponse(session, TraderEventType::RspQryInvestorPosition, req.requestId, false);
+            if (!pending) {
+                return;
+            }
+            CThostFtdcInvestorPositionField& rsp = pending->data.investorPosition;
+            memset(&rsp, 0, sizeof(rsp));
+            CopyField(rsp.BrokerID, account.brokerId.c_str());
+            CopyField(rsp.InvestorID, account.investorId.c_str());
+            rsp.PosiDirection = side == 0 ? THOST_FTDC_PD_Long : THOST_FTDC_PD_Short;
+            rsp.HedgeFlag = THOST_FTDC_HF_Speculation;
+            rsp.PositionDate = THOST_FTDC_PSD_Today;
+            rsp.Position = position.volume[side];
+            rsp.TodayPosition = position.volume[side];
+            // 多头持仓被卖平冻结记在空头冻结, 空头反之
+            if (side == 0) {
+                rsp.ShortFrozen = position.frozen[side];
+            } else {
+                rsp.LongFrozen = position.frozen[side];
+            }
+            rsp.OpenVolume = position.volume[side];
+            rsp.OpenCost = position.cost[side];
+            rsp.PositionCost = position.cost[side];
+            rsp.UseMargin = position.cost[side] * instrument.marginRatio;
+            CopyField(rsp.TradingDay, m_tradingDay);
+            rsp.SettlementID = 1;
+            CopyField(rsp.ExchangeID, instrument.field.ExchangeID);
+            CopyField(rsp.InstrumentID, instrument.field.InstrumentID);
+            pending->hasData = true;
+        }
+    }
+    if (pending) {
+        pending->isLast = true;
+        PublishResponse(session);
+    } else {
+        Respond(session, TraderEventType::RspQryInvestorPosition, req.requestId);
+    }
+}
+
+void SimFront::OnQryInstrument(SimSession& session, const SimRequest& req) {
+    const char* instrumentId = req.data.qryInstrument.InstrumentID;
+    if (instrumentId[0]) {
+        const uint32_t id = m_symbols->Find(req.data.qryInstrument.InstrumentID);
+        TraderEvent* ev = BeginResponse(session, TraderEventType::RspQryInstrument, req.requestId, true);
+        if (ev) {
+            ev->hasData = id != kInvalidSymbol;
+            if (ev->hasData) {
+                ev->data.instrument = m_instruments[id].field;
+            }
+            PublishResponse(session);
+        }
+        return;
+    }
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        TraderEvent* ev =
+            BeginResponse(session, TraderEventType::RspQryInstrument, req.requestId, i + 1 == m_instruments.size());
+        if (ev) {
+            ev->data.instrument = m_instruments[i].field;
+            ev->hasData = true;
+            PublishResponse(session);
+        }
+    }
+}
+
+std::vector<uint32_t> SimFront::RateInstruments(const Account& account, const char* instrumentId) const {
+    // 指定合约时只返回该合约, 否则返回有持仓的合约
+    std::vector<uint32_t> ids;
+    if (instrumentId[0]) {
+        const uint32_t id = m_symbols->Find(instrumentId);
+        if (id != kInvalidSymbol) {
+            ids.push_back(id);
+        }
+        return ids;
+    }
+    for (uint32_t id = 0; id < account.positions.size(); ++id) {
+        if (account.positions[id].volume[0] != 0 || account.positions[id].volume[1] != 0) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+void SimFront::OnQryMarginRate(SimSession& session, const SimRequest& req) {
+    const Account& account = m_accounts[session.account];
+    const std::vector<uint32_t> ids = RateInstruments(account, req.data.qryMarginRate.InstrumentID);
+    if (ids.empty()) {
+        Respond(session, TraderEventType::RspQryInstrumentMarginRate, req.requestId);
+        return;
+    }
+    for (size_t i = 0; i < ids.size(); ++i) {
+        TraderEvent* ev =
+            BeginResponse(session, TraderEventType::RspQryInstrumentMarginRate, req.requestId, i + 1 == ids.size());
+        if (!ev) {
+            return;
+        }
+        const Instrument& instrument = m_instruments[ids[i]];
+        CThostFtdcInstrumentMarginRateField& rsp = ev->data.marginRate;
+        memset(&rsp, 0, sizeof(rsp));
+        rsp.InvestorRange = THOST_FTDC_IR_All;
+        CopyField(rsp.BrokerID, account.brokerId.c_str());
+        CopyField(rsp.InvestorID, account.investorId.c_str());
+        rsp.HedgeFlag = THOST_FTDC_HF_Speculation;
+        rsp.LongMarginRatioByMoney = instrument.marginRatio;
+        rsp.ShortMarginRatioByMoney = instrument.marginRatio;
+        CopyField(rsp.ExchangeID, instrument.field.ExchangeID);
+        CopyField(rsp.InstrumentID, instrument.field.InstrumentID);
+        ev->hasData = true;
+        PublishResponse(session);
+    }
+}
+
+void SimFront::OnQryCommissionRate(SimSession& session, const SimRequest& req) {
+    const Account& account = m_accounts[session.account];
+    const std::vector<uint32_t> ids = RateInstruments(account, req.data.qryCommissionRate.InstrumentID);
+    if (ids.empty()) {
+        Respond(session, TraderEventType::RspQryInstrumentCommissionRate, req.requestId);
+        return;
+    }
+    for (size_t i = 0; i < ids.size(); ++i) {
+        TraderEvent* ev = BeginResponse(session, TraderEventType::RspQryInstrumentCommissionRate, req.requestId,
+                                        i + 1 == ids.size());
+        if (!ev) {
+            return;
+        }
+        const Instrument& instrument = m_instruments[ids[i]];
+        CThostFtdcInstrumentCommissionRateField& rsp = ev->data.commissionRate;
+        memset(&rsp, 0, sizeof(rsp));
+        rsp.InvestorRange = THOST_FTDC_IR_All;
+        CopyField(rsp.BrokerID, account.brokerId.c_str());
+        CopyField(rsp.InvestorID, account.investorId.c_str());
+        rsp.OpenRatioByMoney = instrument.commissionByMoney;
+        rsp.OpenRatioByVolume = instrument.commissionByVolume;
+        rsp.CloseRatioByMoney = instrument.commissionByMoney;
+        rsp.CloseRatioByVolume = instrument.commissionByVolume;
+        rsp.CloseTodayRatioByMoney = instrument.commissionByMoney;
+        rsp.CloseTodayRatioByVolume = instrument.commissionByVolume;
+        CopyField(rsp.ExchangeID, instrument.field.ExchangeID);
+        CopyField(rsp.InstrumentID, instrument.field.InstrumentID);
+        ev->hasData = true;
+        PublishResponse(session);
+    }
+}
+
+void SimFront::OnQryTrade(SimSession& session, const SimRequest& req) {
+    const Account& account = m_accounts[session.account];
+    const char* instrumentId = req.data.qryTrade.InstrumentID;
+    const uint32_t only = instrumentId[0] ? m_symbols->Find(instrumentId) : kInvalidSymbol;
+
+    // 按私有流顺序返回账户当日全部成交; 最后一行带 isLast, 没有成交时返回空应答
+    TraderEvent* pending = nullptr;
+    for (size_t pos = 0; pos < account.flow.size(); ++pos) {
+        const FlowEntry& entry = account.flow[pos];
+        if (entry.trade == kNoTrade || (instrumentId[0] && m_orders[entry.order].instrument != only)) {
+            continue;
+        }
+        if (pending) {
+            PublishResponse(session);
+        }
+        pending = BeginResponse(session, TraderEventType::RspQryTrade, req.requestId, false);
+        if (!pending) {
+            return;
+        }
+        FillTrade(entry.trade, pending->data.trade);
+        pending->hasData = true;
+    }
+    if (pending) {
+        pending->isLast = true;
+        PublishResponse(session);
+    } else {
+        Respond(session, TraderEventType::RspQryTrade, req.requestId);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 报单和撤单
+// ---------------------------------------------------------------------------
+
+bool SimFront::IsWorking(const Order& order) {
+    return order.orderStatus == THOST_FTDC_OST_NoTradeQueueing ||
+           order.orderStatus == THOST_FTDC_OST_PartTradedQueueing || order.orderStatus == THOST_FTDC_OST_Unknown;
+}
+
+int SimFront::CheckClose(const Account& account, const Instrument& instrument, uint32_t id,
+                         const CThostFtdcInputOrderField& input) const {
+    const char offset = input.CombOffsetFlag[0];
+    if (offset == THOST_FTDC_OF_Open) {
+        return 0;
+    }
+    // 上期所和能源中心的平仓和平昨只平昨仓, 模拟前置没有昨仓
+    const bool shfe = IsShfeStyle(instrument.field.ExchangeID);
+    if (shfe && offset != THOST_FTDC_OF_CloseToday) {
+        return kErrOverCloseYesterday;
+    }
+    // 卖平多头, 买平空头
+    const Position& position = account.positions[id];
+    const int side = input.Direction == THOST_FTDC_D_Sell ? 0 : 1;
+    if (input.VolumeTotalOriginal > position.volume[side] - position.frozen[side]) {
+        return shfe ? kErrOverCloseToday : kErrOverClosePosition;
+    }
+    return 0;
+}
+
+void SimFront::OnOrderInsert(SimSession& session, const SimRequest& req) {
+    const CThostFtdcInputOrderField& input = req.data.inputOrder;
+    Account& account = m_accounts[session.account];
+
+    const uint32_t id = m_symbols->Find(input.InstrumentID);
+    if (id == kInvalidSymbol) {
+        RejectOrder(session, req, kErrInstrumentNotFound);
+        return;
+    }
+    const Instrument& instrument = m_instruments[id];
+
+    const char offset = input.CombOffsetFlag[0];
+    bool valid = input.VolumeTotalOriginal > 0 && input.VolumeTotalOriginal <= instrument.field.MaxLimitOrderVolume &&
+                 (input.Direction == THOST_FTDC_D_Buy || input.Direction == THOST_FTDC_D_Sell) &&
+                 (offset == THOST_FTDC_OF_Open || offset == THOST_FTDC_OF_Close ||
+                  offset == THOST_FTDC_OF_CloseToday || offset == THOST_FTDC_OF_CloseYesterday) &&
+                 (input.TimeCondition == THOST_FTDC_TC_GFD || input.TimeCondition == THOST_FTDC_TC_IOC) &&
+                 (input.VolumeCondition == THOST_FTDC_VC_AV || input.VolumeCondition == THOST_FTDC_VC_CV ||
+                  (input.VolumeCondition == THOST_FTDC_VC_MV && input.MinVolume > 0 &&
+                   input.MinVolume <= input.VolumeTotalOriginal));
+    if (input.OrderPriceType == THOST_FTDC_OPT_LimitPrice) {
+        const double ticks = input.LimitPrice / instrument.field.PriceTick;
+        valid = valid && input.LimitPrice > 0 && std::fabs(ticks - std::floor(ticks + 0.5)) < 1e-6;
+    } else if (input.OrderPriceType == THOST_FTDC_OPT_AnyPrice) {
+        if (IsShfeStyle(instrument.field.ExchangeID)) {
+            RejectOrder(session, req, kErrPriceTypeNotSupported);
+            return;
+        }
+    } else {
+        valid = false;
+    }
+    if (!valid) {
+        RejectOrder(session, req, kErrBadField);
+        return;
+    }
+    if (!account.settlementConfirmed) {
+        RejectOrder(session, req, kErrSettlementNotConfirmed);
+        return;
+    }
+    const int closeError = CheckClose(account, instrument, id, input);
+    if (closeError != 0) {
+        RejectOrder(session, req, closeError);
+        return;
+    }
+
+    // 未填 OrderRef 时由柜台分配
+    TThostFtdcOrderRefType orderRef;
+    if (input.OrderRef[0]) {
+        CopyField(orderRef, input.OrderRef);
+    } else {
+        snprintf(orderRef, sizeof(orderRef), "%d", account.maxOrderRef + 1);
+    }
+    const OrderKey key = MakeOrderKey(session.frontId, session.sessionId, orderRef);
+    const uint32_t index = static_cast<uint32_t>(m_orders.size());
+    if (!m_orderIndex.insert(std::make_pair(key, index)).second) {
+        RejectOrder(session, req, kErrDuplicateOrderRef);
+        return;
+    }
+    account.maxOrderRef = std::max(account.maxOrderRef, atoi(orderRef));
+
+    m_orders.push_back(Order());
+    Order& order = m_orders.back();
+    order.key = key;
+    order.instrument = id;
+    order.account = session.account;
+    order.requestId = req.requestId;
+    order.exchangeSeq = 0;
+    order.limitPrice = input.LimitPrice;
+    order.volumeTotalOriginal = input.VolumeTotalOriginal;
+    order.volumeTraded = 0;
+    order.minVolume = input.VolumeCondition == THOST_FTDC_VC_MV ? input.MinVolume : 1;
+    order.direction = input.Direction;
+    order.offset = offset;
+    order.hedge = input.CombHedgeFlag[0] ? input.CombHedgeFlag[0] : THOST_FTDC_HF_Speculation;
+    order.priceType = input.OrderPriceType;
+    // 市价单按 FAK 处理
+    order.timeCondition = input.OrderPriceType == THOST_FTDC_OPT_AnyPrice ? THOST_FTDC_TC_IOC : input.TimeCondition;
+    order.volumeCondition = input.VolumeCondition;
+    order.orderStatus = THOST_FTDC_OST_Unknown;
+    order.submitStatus = THOST_FTDC_OSS_InsertSubmitted;
+    CopyField(order.insertTime, Now());
+    CopyField(order.updateTime, order.insertTime);
+    order.cancelTime[0] = '\0';
+    CopyField(order.userId, input.UserID);
+    m_acceptedOrders.store(m_acceptedOrders.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // 平仓报单冻结持仓
+    if (offset != THOST_FTDC_OF_Open) {
+        account.positions[id].frozen[order.direction == THOST_FTDC_D_Sell ? 0 : 1] += order.volumeTotalOriginal;
+    }
+    PushOrder(index, true);
+    Execute(index);
+}
+
+void SimFront::Execute(uint32_t index) {
+    Order& order = m_orders[index];
+    const Instrument& instrument = m_instruments[order.instrument];
+    Exchange& exchange = m_exchanges[instrument.exchange];
+    const bool buy = order.direction == THOST_FTDC_D_Buy;
+
+    // 交易所接受, 分配 OrderSysID
+    exchange.orders.push_back(index);
+    order.exchangeSeq = static_cast<uint32_t>(exchange.orders.size());
+    order.submitStatus = THOST_FTDC_OSS_Accepted;
+    order.orderStatus = THOST_FTDC_OST_NoTradeQueueing;
+
+    int64_t limitTicks;
+    if (order.priceType == THOST_FTDC_OPT_AnyPrice) {
+        limitTicks = buy ? SimMatcher::kMarketBuy : SimMatcher::kMarketSell;
+    } else {
+        limitTicks = static_cast<int64_t>(std::floor(order.limitPrice / instrument.field.PriceTick + 0.5));
+    }
+
+    // FOK 须全部成交, 最小成交量须达到 MinVolume, 否则不撮合直接撤单
+    int required = order.minVolume;
+    if (order.volumeCondition == THOST_FTDC_VC_CV) {
+        required = order.volumeTotalOriginal;
+    }
+    int remaining = order.volumeTotalOriginal;
+    if (required <= 1 || m_matcher.Available(order.instrument, buy, limitTicks, required) >= required) {
+        m_fills.clear();
+        remaining = m_matcher.Match(order.instrument, buy, limitTicks, remaining, m_fills);
+        for (size_t i = 0; i < m_fills.size(); ++i) {
+            const SimFill& fill = m_fills[i];
+            const double price = static_cast<double>(fill.ticks) * instrument.field.PriceTick;
+            const uint32_t tradeSeq = ++exchange.tradeCount;
+            ApplyFill(fill.maker, fill.volume, price, tradeSeq);
+            ApplyFill(index, fill.volume, price, tradeSeq);
+        }
+    }
+
+    if (remaining == 0) {
+        return;
+    }
+    if (order.timeCondition == THOST_FTDC_TC_GFD) {
+        m_matcher.Add(index, order.instrument, buy, limitTicks, remaining);
+        if (order.volumeTraded == 0) {
+            PushOrder(index, false);
+        }
+        return;
+    }
+    // FAK/FOK 和市价单的剩余量撤销
+    ReleaseFrozen(order, remaining);
+    order.orderStatus = THOST_FTDC_OST_Canceled;
+    CopyField(order.cancelTime, Now());
+    CopyField(order.updateTime, order.cancelTime);
+    m_cancels.store(m_cancels.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    PushOrder(index, false);
+}
+
+void SimFront::ApplyFill(uint32_t index, int volume, double price, uint32_t tradeSeq) {
+    Order& order = m_orders[index];
+    Account& account = m_accounts[order.account];
+    const Instrument& instrument = m_instruments[order.instrument];
+    Position& position = account.positions[order.instrument];
+    const double amount = price * volume * instrument.field.VolumeMultiple;
+
+    // 持仓和资金
+    if (order.offset == THOST_FTDC_OF_Open) {
+        const int side = order.direction == THOST_FTDC_D_Buy ? 0 : 1;
+        position.volume[side] += volume;
+        position.cost[side] += amount;
+    } else {
+        const int side = order.direction == THOST_FTDC_D_Sell ? 0 : 1;
+        const double cost = position.cost[side] * volume / position.volume[side];
+        const double profit = side == 0 ? amount - cost : cost - amount;
+        position.volume[side] -= volume;
+        position.frozen[side] -= volume;
+        position.cost[side] = position.volume[side] == 0 ? 0 : position.cost[side] - cost;
+        account.closeProfit += profit;
+        account.balance += profit;
+    }
+    const double commission = amount * instrument.commissionByMoney + volume * instrument.commissionByVolume;
+    account.commission += commission;
+    account.balance -= commission;
+
+    // 报单状态
+    order.volumeTraded += volume;
+    order.orderStatus = order.volumeTraded == order.volumeTotalOriginal ? THOST_FTDC_OST_AllTraded
+                                                                         : THOST_FTDC_OST_PartTradedQueueing;
+    const char* now = Now();
+    CopyField(order.updateTime, now);
+    PushOrder(index, false);
+
+    Trade trade;
+    trade.order = index;
+    trade.tradeSeq = tradeSeq;
+    trade.volume = volume;
+    trade.price = price;
+    CopyField(trade.tradeTime, now);
+    m_trades.push_back(trade);
+    m_tradeCount.store(m_tradeCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    PushTrade(static_cast<uint32_t>(m_trades.size() - 1));
+}
+
+void SimFront::ReleaseFrozen(const Order& order, int volume) {
+    if (order.offset != THOST_FTDC_OF_Open) {
+        m_accounts[order.account].positions[order.instrument].frozen[order.direction == THOST_FTDC_D_Sell ? 0 : 1] -=
+            volume;
+    }
+}
+
+void SimFront::FormatExchangeId(const Exchange& exchange, uint32_t seq, char (&dst)[21]) const {
+    FormatNumber(dst, seq, exchange.rightAligned ? 12 : 0);
+}
+
+int64_t SimFront::FindOrder(const SimSession& session, const CThostFtdcInputOrderActionField& action) const {
+    if (action.OrderRef[0]) {
+        const int frontId = action.FrontID != 0 ? action.FrontID : session.frontId;
+        const int sessionId = action.SessionID != 0 ? action.SessionID : session.sessionId;
+        std::unordered_map<OrderKey, uint32_t, OrderKeyHash>::const_iterator it =
+            m_orderIndex.find(MakeOrderKey(frontId, sessionId, action.OrderRef));
+        return it != m_orderIndex.end() ? it->second : -1;
+    }
+    for (size_t i = 0; i < m_exchanges.size(); ++i) {
+        const Exchange& exchange = m_exchanges[i];
+        if (exchange.id != action.ExchangeID) {
+            continue;
+        }
+        // 右对齐的编号前导空格由 atoll 跳过
+        const long long seq = atoll(action.OrderSysID);
+        if (seq <= 0 || static_cast<size_t>(seq) > exchange.orders.size()) {
+            return -1;
+        }
+        return exchange.orders[seq - 1];
+    }
+    return -1;
+}
+
+void SimFront::OnOrderAction(SimSession& session, const SimRequest& req) {
+    const CThostFtdcInputOrderActionField& input = req.data.inputOrderAction;
+    if (input.ActionFlag != THOST_FTDC_AF_Delete) {
+        RejectAction(session, req, kErrUnsupportedFunction);
+        return;
+    }
+    const int64_t index = FindOrder(session, input);
+    if (index < 0 || m_orders[index].account != session.account) {
+        RejectAction(session, req, kErrOrderNotFound);
+        return;
+    }
+    if (!IsWorking(m_orders[index])) {
+        RejectAction(session, req, kErrInsuitableOrderStatus);
+        return;
+    }
+    CancelOrder(static_cast<uint32_t>(index));
+}
+
+void SimFront::OnBatchOrderAction(SimSession& session, const SimRequest& req) {
+    const CThostFtdcInputBatchOrderActionField& input = req.data.inputBatchOrderAction;
+    // 只有中金所支持批量撤单
+    if (strcmp(input.ExchangeID, "CFFEX") != 0) {
+        TraderEvent* ev = BeginResponse(session, TraderEventType::RspBatchOrderAction, req.requestId, true,
+                                        kErrUnsupportedFunction);
+        if (ev) {
+            ev->data.inputBatchOrderAction = input;
+            ev->hasData = true;
+            PublishResponse(session);
+        }
+        ev = BeginResponse(session, TraderEventType::ErrRtnBatchOrderAction, 0, true, kErrUnsupportedFunction);
+        if (ev) {
+            CThostFtdcBatchOrderActionField& action = ev->data.batchOrderAction;
+            memset(&action, 0, sizeof(action));
+            CopyField(action.BrokerID, input.BrokerID);
+            CopyField(action.InvestorID, input.InvestorID);
+            action.OrderActionRef = input.OrderActionRef;
+            action.RequestID = input.RequestID;
+            action.FrontID = input.FrontID;
+            action.SessionID = input.SessionID;
+            CopyField(action.ExchangeID, input.ExchangeID);
+            CopyField(action.ActionDate, m_tradingDay);
+            CopyField(action.ActionTime, Now());
+            action.OrderActionStatus = THOST_FTDC_OAS_Rejected;
+            CopyField(action.UserID, input.UserID);
+            CopyField(action.StatusMsg, ErrorText(kErrUnsupportedFunction));
+            ev->hasData = true;
+            PublishResponse(session);
+        }
+        return;
+    }
+
+    // 撤销该账户在指定前置和会话下该交易所的全部挂单
+    const std::vector<FlowEntry>& flow = m_accounts[session.account].flow;
+    for (size_t i = 0; i < flow.size(); ++i) {
+        if (flow[i].trade != kNoTrade) {
+            continue;
+        }
+        const Order& order = m_orders[flow[i].order];
+        if (IsWorking(order) && order.key.frontId == input.FrontID && order.key.sessionId == input.SessionID &&
+            strcmp(m_instruments[order.instrument].field.ExchangeID, input.ExchangeID) == 0) {
+            CancelOrder(flow[i].order);
+        }
+    }
+}
+
+void SimFront::CancelOrder(uint32_t index) {
+    Order& order = m_orders[index];
+    order.submitStatus = THOST_FTDC_OSS_CancelSubmitted;
+    PushOrder(index, false);
+
+    m_matcher.Remove(index);
+    ReleaseFrozen(order, order.volumeTotalOriginal - order.volumeTraded);
+    order.submitStatus = THOST_FTDC_OSS_Accepted;
+    order.orderStatus = THOST_FTDC_OST_Canceled;
+    CopyField(order.cancelTime, Now());
+    CopyField(order.updateTime, order.cancelTime);
+    m_cancels.store(m_cancels.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    PushOrder(index, false);
+}
+
+// ---------------------------------------------------------------------------
+// 私有流
+// ---------------------------------------------------------------------------
+
+void SimFront::BuildTemplates(Account& account) const {
+    account.orderTemplates.resize(m_instruments.size());
+    account.tradeTemplates.resize(m_instruments.size());
+    for (size_t i = 0; i < m_instruments.size(); ++i) {
+        const CThostFtdcInstrumentField& spec = m_instruments[i].field;
+
+        CThostFtdcOrderField& order = account.orderTemplates[i];
+        memset(&order, 0, sizeof(order));
+        CopyField(order.BrokerID, account.brokerId.c_str());
+        CopyField(order.InvestorID, account.investorId.c_str());
+        order.ContingentCondition = THOST_FTDC_CC_Immediately;
+        order.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
+        CopyField(order.ExchangeID, spec.ExchangeID);
+        CopyField(order.ClientID, account.investorId.c_str());
+        order.InstallID = 1;
+        CopyField(order.TradingDay, m_tradingDay);
+        order.SettlementID = 1;
+        order.OrderSource = THOST_FTDC_OSRC_Participant;
+        order.OrderType = THOST_FTDC_ORDT_Normal;
+        CopyField(order.InsertDate, m_tradingDay);
+        CopyField(order.CurrencyID, "CNY");
+        CopyField(order.InstrumentID, spec.InstrumentID);
+        CopyField(order.ExchangeInstID, spec.InstrumentID);
+
+        CThostFtdcTradeField& trade = account.tradeTemplates[i];
+        memset(&trade, 0, sizeof(trade));
+        CopyField(trade.BrokerID, account.brokerId.c_str());
+        CopyField(trade.InvestorID, account.investorId.c_str());
+        CopyField(trade.ExchangeID, spec.ExchangeID);
+        CopyField(trade.ClientID, account.investorId.c_str());
+        CopyField(trade.TradeDate, m_tradingDay);
+        trade.TradeType = THOST_FTDC_TRDT_Common;
+        trade.PriceSource = THOST_FTDC_PSRC_LastPrice;
+        CopyField(trade.TradingDay, m_tradingDay);
+        trade.SettlementID = 1;
+        trade.TradeSource = THOST_FTDC_TSRC_NORMAL;
+        CopyField(trade.InstrumentID, spec.InstrumentID);
+        CopyField(trade.ExchangeInstID, spec.InstrumentID);
+    }
+}
+
+void SimFront::FillOrder(uint32_t index, CThostFtdcOrderField& field) const {
+    const Order& order = m_orders[index];
+    const Account& account = m_accounts[order.account];
+
+    // 从模板拷贝不变字段, 只填写随报单和状态变化的字段
+    field = account.orderTemplates[order.instrument];
+    CopyField(field.OrderRef, order.key.orderRef);
+    CopyField(field.UserID, order.userId);
+    field.OrderPriceType = order.priceType;
+    field.Direction = order.direction;
+    field.CombOffsetFlag[0] = order.offset;
+    field.CombHedgeFlag[0] = order.hedge;
+    field.LimitPrice = order.limitPrice;
+    field.VolumeTotalOriginal = order.volumeTotalOriginal;
+    field.TimeCondition = order.timeCondition;
+    field.VolumeCondition = order.volumeCondition;
+    field.MinVolume = order.minVolume;
+    field.RequestID = order.requestId;
+    FormatNumber(field.OrderLocalID, index + 1, 12);
+    field.OrderSubmitStatus = order.submitStatus;
+    if (order.exchangeSeq != 0) {
+        FormatExchangeId(m_exchanges[m_instruments[order.instrument].exchange], order.exchangeSeq, field.OrderSysID);
+        field.SequenceNo = static_cast<int>(order.exchangeSeq);
+    }
+    field.OrderStatus = order.orderStatus;
+    field.VolumeTraded = order.volumeTraded;
+    field.VolumeTotal = order.orderStatus == THOST_FTDC_OST_Canceled ? 0 : order.volumeTotalOriginal - order.volumeTraded;
+    memcpy(field.InsertTime, order.insertTime, sizeof(order.insertTime));
+    memcpy(field.UpdateTime, order.updateTime, sizeof(order.updateTime));
+    memcpy(field.CancelTime, order.cancelTime, sizeof(order.cancelTime));
+    field.FrontID = order.key.frontId;
+    field.SessionID = order.key.sessionId;
+    CopyField(field.StatusMsg, StatusText(order.orderStatus, order.submitStatus));
+    field.BrokerOrderSeq = static_cast<int>(index + 1);
+}
+
+void SimFront::FillTrade(uint32_t index, CThostFtdcTradeField& field) const {
+    const Trade& trade = m_trades[index];
+    const Order& order = m_orders[trade.order];
+    const Account& account = m_accounts[order.account];
+    const Exchange& exchange = m_exchanges[m_instruments[order.instrument].exchange];
+
+    field = account.tradeTemplates[order.instrument];
+    CopyField(field.OrderRef, order.key.orderRef);
+    CopyField(field.UserID, order.userId);
+    FormatExchangeId(exchange, trade.tradeSeq, field.TradeID);
+    field.Direction = order.direction;
+    FormatExchangeId(exchange, order.exchangeSeq, field.OrderSysID);
+    field.OffsetFlag = order.offset;
+    field.HedgeFlag = order.hedge;
+    field.Price = trade.price;
+    field.Volume = trade.volume;
+    memcpy(field.TradeTime, trade.tradeTime, sizeof(trade.tradeTime));
+    FormatNumber(field.OrderLocalID, trade.order + 1, 12);
+    field.SequenceNo = static_cast<int>(index + 1);
+    field.BrokerOrderSeq = static_cast<int>(trade.order + 1);
+}
+
+void SimFront::PushOrder(uint32_t index, bool isNew) {
+    Account& account = m_accounts[m_orders[index].account];
+    if (isNew) {
+        m_orders[index].flowPos = static_cast<uint32_t>(account.flow.size());
+        FlowEntry entry;
+        entry.order = index;
+        entry.trade = kNoTrade;
+        account.flow.push_back(entry);
+    }
+    for (size_t i = 0; i < account.sessions.size(); ++i) {
+        SimSession* session = m_sessions[account.sessions[i]].load(std::memory_order_relaxed);
+        TraderEvent* ev = BeginResponse(*session, TraderEventType::RtnOrder, 0, true);
+        if (ev) {
+            FillOrder(index, ev->data.order);
+            ev->hasData = true;
+            PublishResponse(*session);
+        }
+        session->privateFlowPos = static_cast<uint32_t>(account.flow.size());
+    }
+}
+
+void SimFront::PushTrade(uint32_t trade) {
+    Account& account = m_accounts[m_orders[m_trades[trade].order].account];
+    FlowEntry entry;
+    entry.order = m_trades[trade].order;
+    entry.trade = trade;
+    account.flow.push_back(entry);
+    for (size_t i = 0; i < account.sessions.size(); ++i) {
+        SimSession* session = m_sessions[account.sessions[i]].load(std::memory_order_relaxed);
+        TraderEvent* ev = BeginResponse(*session, TraderEventType::RtnTrade, 0, true);
+        if (ev) {
+            FillTrade(trade, ev->data.trade);
+            ev->hasData = true;
+            PublishResponse(*session);
+        }
+        session->privateFlowPos = static_cast<uint32_t>(account.flow.size());
+    }
+}
+
+void SimFront::ReplayFlow(SimSession& session) {
+    const std::vector<FlowEntry>& flow = m_accounts[session.account].flow;
+    uint32_t pos = 0;
+    if (session.privateResume == THOST_TERT_QUICK) {
+        pos = static_cast<uint32_t>(flow.size());
+    } else if (session.privateResume == THOST_TERT_RESUME) {
+        pos = std::min(session.privateFlowPos, static_cast<uint32_t>(flow.size()));
+    }
+    // 报单补发当前状态, 成交逐笔补发
+    for (; pos < flow.size(); ++pos) {
+        const bool isTrade = flow[pos].trade != kNoTrade;
+        TraderEvent* ev =
+            BeginResponse(session, isTrade ? TraderEventType::RtnTrade : TraderEventType::RtnOrder, 0, true);
+        if (ev) {
+            if (isTrade) {
+                FillTrade(flow[pos].trade, ev->data.trade);
+            } else {
+                FillOrder(flow[pos].order, ev->data.order);
+            }
+            ev->hasData = true;
+            PublishResponse(session);
+        }
+    }
+    session.privateFlowPos = pos;
+}
+
+// ---------------------------------------------------------------------------
+// 故障注入
+// ---------------------------------------------------------------------------
+
+int64_t SimFront::RunFaults(int slot, SimSession& session, int64_t now) {
+    SimFaultState& fault = session.fault;
+    const SimFaultSchedule& schedule = fault.schedule;
+    int64_t due = kNoFaultDue;
+
+    if (fault.reconnectNs != 0) {
+        if (now >= fault.reconnectNs) {
+            fault.reconnectNs = 0;
+            LOG("[SimFront] 会话 {} 重新连接", session.sessionId);
+            OnConnect(session);
+        } else {
+            due = fault.reconnectNs;
+        }
+    }
+
+    // 断线期间日程照常推进, 到期的故障在重连之后才有意义的由各故障自行判断
+    if (fault.nextFault == schedule.faults.size() && schedule.repeatNs != 0 &&
+        now >= fault.baseNs + schedule.repeatNs) {
+        fault.baseNs += schedule.repeatNs;
+        fault.nextFault = 0;
+    }
+    while (fault.nextFault < schedule.faults.size() &&
+           now >= fault.baseNs + schedule.faults[fault.nextFault].atNs) {
+        StartFault(slot, session, schedule.faults[fault.nextFault++], now);
+    }
+    if (fault.nextFault < schedule.faults.size()) {
+        due = std::min(due, fault.baseNs + schedule.faults[fault.nextFault].atNs);
+    } else if (schedule.repeatNs != 0) {
+        due = std::min(due, fault.baseNs + schedule.repeatNs);
+    }
+
+    if (fault.stallEndNs != 0) {
+        if (now >= fault.stallEndNs) {
+            fault.stallEndNs = 0;
+            if (fault.stallReason != 0) {
+                DropConnection(slot, session, fault.stallReason, fault.stallDownNs, now);
+            }
+        } else {
+            if (now >= fault.nextHeartBeatNs) {
+                // 心跳告警由API自己产生, 不受推迟影响
+                TraderEvent* ev = ClaimResponse(session);
+                if (ev) {
+                    ev->type = TraderEventType::HeartBeatWarning;
+                    ev->hasData = false;
+                    ev->hasRspInfo = false;
+                    ev->isLast = true;
+                    ev->requestId = static_cast<int>((now - fault.stallStartNs) / kHeartBeatWarningNs);
+                    ev->enqueueNs = now;
+                    DeliverResponse(session);
+                }
+                fault.nextHeartBeatNs += kHeartBeatWarningNs;
+            }
+            due = std::min(due, std::min(fault.nextHeartBeatNs, fault.stallEndNs));
+        }
+    }
+    if (fault.delayEndNs != 0) {
+        if (now >= fault.delayEndNs) {
+            fault.delayEndNs = 0;
+        } else {
+            due = std::min(due, fault.delayEndNs);
+        }
+    }
+    if (fault.reorderEndNs != 0) {
+        if (now >= fault.reorderEndNs) {
+            fault.reorderEndNs = 0;
+            FlushReorder(session, now);
+        } else {
+            due = std::min(due, fault.reorderEndNs);
+        }
+    }
+    if (fault.rejectEndNs != 0) {
+        if (now >= fault.rejectEndNs) {
+            fault.rejectEndNs = 0;
+        } else {
+            due = std::min(due, fault.rejectEndNs);
+        }
+    }
+    const int64_t throttleEnd = session.throttleEndNs.load(std::memory_order_relaxed);
+    if (throttleEnd != 0) {
+        if (now >= throttleEnd) {
+            session.throttleEndNs.store(0, std::memory_order_relaxed);
+        } else {
+            due = std::min(due, throttleEnd);
+        }
+    }
+
+    ReleaseHeld(session, now);
+    if (!fault.held.empty()) {
+        due = std::min(due, fault.held.front().releaseNs);
+    }
+    // 本轮刚注入的断线(含停顿后断线)在上面检查重连之后才设置重连时刻
+    if (fault.reconnectNs != 0) {
+        due = std::min(due, fault.reconnectNs);
+    }
+
+    fault.holdResponses =
+        fault.stallEndNs != 0 || fault.delayEndNs != 0 || fault.reorderEndNs != 0 || !fault.held.empty();
+    fault.active = due != kNoFaultDue;
+    return due;
+}
+
+void SimFront::StartFault(int slot, SimSession& session, const SimFault& spec, int64_t now) {
+    SimFaultState& fault = session.fault;
+    // 断线期间的故障没有连接可作用, 跳过
+    if (fault.reconnectNs != 0) {
+        return;
+    }
+    m_faults.store(m_faults.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    LOG("[SimFront] 会话 {} 注入故障: {}, 参数: {}, 持续: {}ms", session.sessionId, SimFaultTypeName(spec.type),
+        (spec.type == SimFaultType::Delay ? static_cast<int>(spec.delayNs / 1000000)
+                                          : spec.type == SimFaultType::Reorder ? spec.batch : spec.reason),
+        spec.durationNs / 1000000);
+    switch (spec.type) {
+        case SimFaultType::Disconnect:
+            DropConnection(slot, session, spec.reason, spec.durationNs, now);
+            break;
+        case SimFaultType::Stall:
+            fault.stallStartNs = now;
+            fault.stallEndNs = now + spec.durationNs;
+            fault.nextHeartBeatNs = now + kHeartBeatWarningNs;
+            fault.stallReason = spec.reason;
+            fault.stallDownNs = spec.downNs;
+            break;
+        case SimFaultType::Delay:
+            fault.delayEndNs = now + spec.durationNs;
+            fault.delayNs = spec.delayNs;
+            break;
+        case SimFaultType::Reorder:
+            FlushReorder(session, now);
+            fault.reorderEndNs = now + spec.durationNs;
+            fault.reorderBatch = spec.batch;
+            break;
+        case SimFaultType::Throttle:
+            session.throttleCode.store(spec.reason, std::memory_order_relaxed);
+            session.throttleEndNs.store(now + spec.durationNs, std::memory_order_release);
+            break;
+        case SimFaultType::Reject:
+            fault.rejectEndNs = now + spec.durationNs;
+            fault.rejectCode = spec.reason;
+            break;
+    }
+    fault.holdResponses =
+        fault.stallEndNs != 0 || fault.delayEndNs != 0 || fault.reorderEndNs != 0 || !fault.held.empty();
+}
+
+void SimFront::DropConnection(int slot, SimSession& session, int reason, int64_t downNs, int64_t now) {
+    SimFaultState& fault = session.fault;
+
+    // 未推送的私有流回报客户端没有收到, 重新登录后从其中最早的位置续传
+    uint32_t resumePos = session.privateFlowPos;
+    for (size_t i = 0; i < fault.held.size(); ++i) {
+        resumePos = std::min(resumePos, fault.held[i].flowPos);
+    }
+    for (size_t i = 0; i < fault.reorderBuffer.size(); ++i) {
+        resumePos = std::min(resumePos, fault.reorderBuffer[i].flowPos);
+    }
+    fault.held.clear();
+    fault.reorderBuffer.clear();
+    fault.stallEndNs = 0;
+    fault.delayEndNs = 0;
+    fault.reorderEndNs = 0;
+    fault.rejectEndNs = 0;
+    fault.holdResponses = false;
+
+    session.connected.store(false, std::memory_order_release);
+    if (session.loggedIn) {
+        std::vector<int>& sessions = m_accounts[session.account].sessions;
+        sessions.erase(std::remove(sessions.begin(), sessions.end(), slot), sessions.end());
+        session.loggedIn = false;
+        session.privateFlowPos = resumePos;
+        // CTP API重连后私有流从已收到的位置续传, 与首次登录的订阅方式无关
+        session.privateResume = THOST_TERT_RESUME;
+    }
+    session.lastQueryNs.store(0, std::memory_order_relaxed);
+
+    // 丢弃未处理的请求
+    while (session.requests.Front()) {
+        session.requests.Pop();
+        session.pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    TraderEvent* ev = ClaimResponse(session);
+    if (ev) {
+        ev->type = TraderEventType::FrontDisconnected;
+        ev->hasData = false;
+        ev->hasRspInfo = false;
+        ev->isLast = true;
+        ev->requestId = reason;
+        ev->enqueueNs = now;
+        DeliverResponse(session);
+    }
+    fault.reconnectNs = now + std::max<int64_t>(downNs, 1);
+}
+
+void SimFront::HoldResponse(SimSession& session) {
+    SimFaultState& fault = session.fault;
+    m_heldResponses.store(m_heldResponses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    SimHeldResponse held;
+    held.event = fault.staging;
+    held.releaseNs = 0;
+    held.flowPos = UINT32_MAX;
+    // 回报的 BrokerOrderSeq 为报单下标+1
+    if (held.event.type == TraderEventType::RtnOrder) {
+        held.flowPos = m_orders[static_cast<uint32_t>(held.event.data.order.BrokerOrderSeq - 1)].flowPos;
+    } else if (held.event.type == TraderEventType::RtnTrade) {
+        held.flowPos = m_orders[static_cast<uint32_t>(held.event.data.trade.BrokerOrderSeq - 1)].flowPos;
+    }
+
+    const int64_t now = MonotonicNs();
+    if (fault.reorderEndNs != 0) {
+        fault.reorderBuffer.push_back(held);
+        if (static_cast<int>(fault.reorderBuffer.size()) >= fault.reorderBatch) {
+            FlushReorder(session, now);
+        }
+        return;
+    }
+    int64_t release = fault.delayEndNs != 0 ? now + fault.delayNs : now;
+    if (fault.stallEndNs != 0) {
+        release = std::max(release, fault.stallEndNs);
+    }
+    if (!fault.held.empty()) {
+        release = std::max(release, fault.held.back().releaseNs);
+    }
+    held.releaseNs = release;
+    fault.held.push_back(held);
+}
+
+void SimFront::FlushReorder(SimSession& session, int64_t now) {
+    SimFaultState& fault = session.fault;
+    int64_t release = fault.stallEndNs != 0 ? std::max(now, fault.stallEndNs) : now;
+    if (!fault.held.empty()) {
+        release = std::max(release, fault.held.back().releaseNs);
+    }
+    for (size_t i = fault.reorderBuffer.size(); i > 0; --i) {
+        fault.held.push_back(fault.reorderBuffer[i - 1]);
+        fault.held.back().releaseNs = release;
+    }
+    fault.reorderBuffer.clear();
+}
+
+void SimFront::ReleaseHeld(SimSession& session, int64_t now) {
+    SimFaultState& fault = session.fault;
+    while (!fault.held.empty() && fault.held.front().releaseNs <= now) {
+        TraderEvent* ev = ClaimResponse(session);
+        if (!ev) {
+            fault.held.clear();
+            return;
+        }
+        *ev = fault.held.front().event;
+        ev->enqueueNs = now;
+        DeliverResponse(session);
+        fault.held.pop_front();
+    }
+}
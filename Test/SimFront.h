@@ -0,0 +1,490 @@
+///
+/// @file SimFront.h
+/// @brief 本地模拟交易前置: 在进程内代替CTP交易前置和柜台, 供 SimTraderApi 连接
+///
+
+#ifndef CTP_TEST_SIM_FRONT_H
+#define CTP_TEST_SIM_FRONT_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "ConsumerWaiter.h"
+#include "OrderTable.h"
+#include "SimFault.h"
+#include "SimMatcher.h"
+#include "SpscQueue.h"
+#include "SymbolTable.h"
+#include "TraderEvent.h"
+
+///
+/// @brief 模拟前置参数
+///
+struct SimFrontOptions {
+    double initialBalance;          ///< 资金账户首次登录时的权益
+    double queriesPerSecond;        ///< 每个会话每秒允许的查询数, 超出时 ReqQry* 返回-3; 0为不限
+    int maxPendingRequests;         ///< 每个会话未处理的请求数上限, 超出时 Req* 返回-2; 0为不限
+    size_t requestQueueCapacity;    ///< 每个会话的请求队列容量
+    size_t responseQueueCapacity;   ///< 每个会话的回调队列容量
+    size_t orderCapacity;           ///< 预分配的报单记录数, 超出后按需扩容
+
+    SimFrontOptions()
+        : initialBalance(10000000.0), queriesPerSecond(1.0), maxPendingRequests(0),
+          requestQueueCapacity(8192), responseQueueCapacity(8192), orderCapacity(1 << 20) {}
+};
+
+///
+/// @brief 模拟前置统计
+///
+struct SimFrontStats {
+    uint64_t requests;              ///< 处理的请求数
+    uint64_t orders;                ///< 接受的报单数
+    uint64_t orderRejects;          ///< 被拒的报单数
+    uint64_t cancels;               ///< 撤销的报单数
+    uint64_t trades;                ///< 成交笔数, 每笔成交双方各算一次
+    uint64_t responses;             ///< 发出的回调数
+    uint64_t responseQueueFullSpins;    ///< 会话回调队列满时前置线程的等待次数
+    uint64_t faults;                ///< 注入的故障数
+    uint64_t heldResponses;         ///< 因注入的故障被推迟或重排的回调数
+};
+
+///
+/// @brief 请求类型
+///
+enum class SimRequestType : uint8_t {
+    Connect,                ///< Init() 后建立连接
+    Authenticate,
+    UserLogin,
+    UserLogout,
+    QrySettlementInfo,
+    SettlementInfoConfirm,
+    QryTradingAccount,
+    QryInvestorPosition,
+    QryInstrument,
+    QryInstrumentMarginRate,
+    QryInstrumentCommissionRate,
+    QryTrade,
+    OrderInsert,
+    OrderAction,
+    BatchOrderAction,
+    Unsupported,            ///< 模拟前置未实现的请求, 以错误应答返回
+};
+
+///
+/// @brief 请求载荷, 同一时刻只有一个成员有效
+///
+union SimRequestData {
+    CThostFtdcReqAuthenticateField authenticate;
+    CThostFtdcReqUserLoginField userLogin;
+    CThostFtdcUserLogoutField userLogout;
+    CThostFtdcQrySettlementInfoField qrySettlementInfo;
+    CThostFtdcSettlementInfoConfirmField settlementInfoConfirm;
+    CThostFtdcQryTradingAccountField qryTradingAccount;
+    CThostFtdcQryInvestorPositionField qryInvestorPosition;
+    CThostFtdcQryInstrumentField qryInstrument;
+    CThostFtdcQryInstrumentMarginRateField qryMarginRate;
+    CThostFtdcQryInstrumentCommissionRateField qryCommissionRate;
+    CThostFtdcQryTradeField qryTrade;
+    CThostFtdcInputOrderField inputOrder;
+    CThostFtdcInputOrderActionField inputOrderAction;
+    CThostFtdcInputBatchOrderActionField inputBatchOrderAction;
+};
+
+///
+/// @brief 会话发往前置的一个请求
+///
+struct SimRequest {
+    SimRequestType type;
+    int requestId;
+    int64_t enqueueNs;      ///< 入队时刻(单调时钟)
+    SimRequestData data;
+};
+
+///
+/// @brief 因故障被推迟或重排的回调
+///
+struct SimHeldResponse {
+    TraderEvent event;
+    int64_t releaseNs;          ///< 推送时刻
+    uint32_t flowPos;           ///< 报单和成交回报所在的私有流位置, 断线丢弃时从此处续传; 其余回调为 UINT32_MAX
+};
+
+///
+/// @brief 会话的故障注入状态, 仅前置线程访问
+///
+/// 各时刻为0表示该故障未生效。推迟队列非空时新的回调也进入队列, 保证故障之外的回调不会越过
+/// 推迟中的回调。
+///
+struct SimFaultState {
+    SimFaultSchedule schedule;
+    bool active;                ///< 有待执行或正在生效的故障, 为false时前置线程不检查
+    bool holdResponses;         ///< 回调写入 staging 并进入推迟队列, 而不是直接写入回调队列
+    size_t nextFault;           ///< 下一个待执行的故障
+    int64_t baseNs;             ///< 本轮日程的起点, 0 表示尚未连接
+    int64_t reconnectNs;        ///< 断线后的重连时刻
+    int64_t stallStartNs;
+    int64_t stallEndNs;
+    int64_t nextHeartBeatNs;    ///< 停顿期间下一次 OnHeartBeatWarning 的时刻
+    int stallReason;            ///< 停顿结束后断线的原因码, 0 表示不断线
+    int64_t stallDownNs;
+    int64_t delayEndNs;
+    int64_t delayNs;
+    int64_t reorderEndNs;
+    int reorderBatch;
+    int64_t rejectEndNs;
+    int rejectCode;             ///< 查询出错期间 OnRspError 的错误码
+    TraderEvent staging;        ///< holdResponses 时 BeginResponse 返回的槽位
+    std::deque<SimHeldResponse> held;           ///< 推迟队列, 按 releaseNs 排序
+    std::vector<SimHeldResponse> reorderBuffer; ///< 凑满 reorderBatch 个后倒序进入推迟队列
+
+    SimFaultState()
+        : active(false), holdResponses(false), nextFault(0), baseNs(0), reconnectNs(0), stallStartNs(0),
+          stallEndNs(0), nextHeartBeatNs(0), stallReason(0), stallDownNs(0), delayEndNs(0), delayNs(0),
+          reorderEndNs(0), reorderBatch(0), rejectEndNs(0), rejectCode(0) {}
+};
+
+///
+/// @brief 一个API实例与前置之间的会话
+///
+/// 请求队列由调用 Req* 的线程写入, 多个线程写入时以自旋锁串行化, 与CTP内部串行发送一致;
+/// 前置线程是唯一的读方。回调队列由前置线程写入, API的回调线程读取。
+/// 会话由前置创建和释放, API调用 SimFront::Detach() 后不再访问它。
+///
+struct SimSession {
+    SimSession(size_t requestCapacity, size_t responseCapacity)
+        : requests(requestCapacity), responses(responseCapacity), pending(0), lastQueryNs(0),
+          connected(false), closing(false), detached(false), throttleEndNs(0), throttleCode(0),
+          frontId(1), sessionId(0), account(-1), loggedIn(false), privateResume(THOST_TERT_RESTART),
+          privateFlowPos(0) {
+        sendLock.clear();
+    }
+
+    SpscQueue<SimRequest> requests;
+    SpscQueue<TraderEvent> responses;
+    std::atomic_flag sendLock;
+    std::atomic<int> pending;           ///< 已入队未处理的请求数
+    std::atomic<int64_t> lastQueryNs;   ///< 上一次查询的发送时刻, 用于查询流控
+    std::atomic<bool> connected;
+    std::atomic<bool> closing;          ///< API正在释放, 前置不再写入回调
+    std::atomic<bool> detached;         ///< API已释放, 前置线程注销会话
+    std::atomic<int64_t> throttleEndNs; ///< 注入的流控在此时刻前生效, 0 表示没有; 由前置线程写入
+    std::atomic<int> throttleCode;      ///< 注入的流控期间 Req* 的返回值
+
+    // 回调线程休眠/唤醒, 前置线程写入回调后调用 Notify()
+    ConsumerWaiter callbackWaiter;
+
+    // 以下仅前置线程访问
+    int frontId;
+    int sessionId;
+    int account;                        ///< 登录后的资金账户下标
+    bool loggedIn;
+    THOST_TE_RESUME_TYPE privateResume; ///< 私有流订阅方式, 登录时决定从何处补发回报
+    uint32_t privateFlowPos;            ///< 已收到的私有流位置, 断线重连后 RESUME 从此处续传
+
+    // 故障注入, 日程在连接请求入队之前写入
+    SimFaultState fault;
+};
+
+///
+/// @brief 本地模拟交易前置
+///
+/// 进程内单例, 由一个前置线程按会话轮询请求队列并生成回调, 所有柜台状态(资金账户、
+/// 报单、私有流)只由前置线程访问, 不加锁。回调按真实CTP的顺序生成:
+///
+/// - 报单: OnRtnOrder(已提交, 未知状态) 后由 SimMatcher 按价格优先、时间优先撮合, 每笔成交
+///   先推送被动方的 OnRtnOrder + OnRtnTrade, 再推送主动方的; 剩余量挂单时 OnRtnOrder(未成交),
+///   FAK(含最小成交量)和市价单的剩余量 OnRtnOrder(已撤单), FOK 不能全部成交时直接撤单。
+///   OrderSysID 和 TradeID 按交易所各自编号, 上期所、能源中心和中金所为12位右对齐。
+///   柜台拒单为 OnRspOrderInsert + OnErrRtnOrderInsert, 错误码取自 error.xml。
+/// - 撤单: OnRtnOrder(撤单已提交) -> OnRtnOrder(已撤单); 找不到报单或报单已结束时
+///   OnRspOrderAction + OnErrRtnOrderAction。
+/// - 报单和成交回报进入资金账户的私有流, 推送给该账户全部已登录会话; 登录时按
+///   RESTART/RESUME/QUICK 补发私有流。
+///
+/// 合约为内置的一组各交易所期货合约, 交易日为本地日期, 所有用户名和密码均可登录。
+/// 持仓全部为今仓, 平仓检查可平量并冻结; 资金按成交计算手续费、平仓盈亏和保证金, 不检查可用资金。
+///
+/// 会话带有故障日程时(见 SimFault.h), 前置线程按日程对该会话注入断线、停顿、回调推迟或乱序和流控。
+/// 断线时丢弃未处理的请求和未推送的回调, 会话注销登录并在到期后重新回调 OnFrontConnected;
+/// 重新登录后私有流从客户端实际收到的位置续传, 与CTP API断线重连的行为一致。
+///
+class SimFront {
+public:
+    static SimFront& Instance();
+
+    /// 设置参数, 须在第一个会话连接前调用
+    void Configure(const SimFrontOptions& options);
+
+    /// API初始化时创建会话, 首次调用时启动前置线程
+    SimSession* Attach();
+
+    /// API释放时调用, 会话在前置线程中注销并释放
+    void Detach(SimSession* session);
+
+    /// 向会话发送请求, 可在任意线程调用; 返回值同CTP Req* 函数: 0, -1 未连接, -2 未处理请求超限, -3 查询超限
+    int Send(SimSession* session, SimRequestType type, int requestId, const void* data, size_t size);
+
+    /// 交易日 (yyyymmdd)
+    const char* TradingDay() const { return m_tradingDay; }
+
+    /// 获取统计, 可在任意线程调用
+    SimFrontStats GetStats() const;
+
+    /// 停止前置线程, 进程退出前调用
+    void Stop();
+
+private:
+    /// 交易所, 各自分配 OrderSysID 和 TradeID
+    struct Exchange {
+        std::string id;
+        bool rightAligned;              ///< 编号是否为12位右对齐
+        std::vector<uint32_t> orders;   ///< OrderSysID 序号-1 -> 报单下标
+        uint32_t tradeCount;
+    };
+
+    /// 内置合约及其费率
+    struct Instrument {
+        CThostFtdcInstrumentField field;
+        int exchange;                   ///< m_exchanges 下标
+        double marginRatio;             ///< 按金额保证金率
+        double commissionByMoney;       ///< 按金额手续费率
+        double commissionByVolume;      ///< 按手数手续费
+    };
+
+    /// 报单记录, 回报按需从记录和合约拼出完整的 CThostFtdcOrderField
+    struct Order {
+        OrderKey key;
+        uint32_t instrument;
+        int account;
+        int requestId;
+        uint32_t exchangeSeq;           ///< 交易所报单序号, 0 表示尚未被交易所接受
+        uint32_t flowPos;               ///< 报单在资金账户私有流中的位置
+        double limitPrice;
+        int volumeTotalOriginal;
+        int volumeTraded;
+        int minVolume;
+        char direction;
+        char offset;
+        char hedge;
+        char priceType;
+        char timeCondition;
+        char volumeCondition;
+        char orderStatus;
+        char submitStatus;
+        char insertTime[9];
+        char updateTime[9];
+        char cancelTime[9];
+        char userId[16];
+    };
+
+    /// 成交记录
+    struct Trade {
+        uint32_t order;
+        uint32_t tradeSeq;              ///< 交易所成交序号, 成交双方相同
+        int volume;
+        double price;
+        char tradeTime[9];
+    };
+
+    /// 账户在一个合约上的持仓, 下标0为多头、1为空头
+    struct Position {
+        int volume[2];
+        int frozen[2];                  ///< 平仓挂单冻结量
+        double cost[2];                 ///< 开仓成本, 价格 * 数量 * 合约乘数
+    };
+
+    /// 私有流的一项: 报单首次出现或一笔成交
+    struct FlowEntry {
+        uint32_t order;
+        uint32_t trade;                 ///< m_trades 下标, 报单项为 kNoTrade
+    };
+
+    static const uint32_t kNoTrade = UINT32_MAX;
+
+    /// 资金账户
+    struct Account {
+        std::string brokerId;
+        std::string investorId;
+        double balance;
+        double closeProfit;
+        double commission;
+        bool settlementConfirmed;
+        int maxOrderRef;                ///< 账户已用过的最大 OrderRef, 登录时作为 MaxOrderRef 返回
+        std::vector<FlowEntry> flow;    ///< 私有流
+        std::vector<int> sessions;      ///< 已登录会话的槽位
+        std::vector<Position> positions;    ///< 以合约下标索引
+        std::vector<CThostFtdcOrderField> orderTemplates;   ///< 报单回报模板, 以合约下标索引
+        std::vector<CThostFtdcTradeField> tradeTemplates;   ///< 成交回报模板, 以合约下标索引
+    };
+
+    static const int kMaxSessions = 1024;
+
+    SimFront();
+    ~SimFront();
+
+    SimFront(const SimFront&) = delete;
+    SimFront& operator=(const SimFront&) = delete;
+
+    /// 前置线程主循环
+    void Run();
+
+    /// 处理一个请求
+    void Process(int slot, SimSession& session, SimRequest& req);
+
+    void OnConnect(SimSession& session);
+    void OnAuthenticate(SimSession& session, const SimRequest& req);
+    void OnUserLogin(int slot, SimSession& session, const SimRequest& req);
+    void OnUserLogout(int slot, SimSession& session, const SimRequest& req);
+    void OnQrySettlementInfo(SimSession& session, const SimRequest& req);
+    void OnSettlementInfoConfirm(SimSession& session, const SimRequest& req);
+    void OnQryTradingAccount(SimSession& session, const SimRequest& req);
+    void OnQryInvestorPosition(SimSession& session, const SimRequest& req);
+    void OnQryInstrument(SimSession& session, const SimRequest& req);
+    void OnQryMarginRate(SimSession& session, const SimRequest& req);
+    void OnQryCommissionRate(SimSession& session, const SimRequest& req);
+    void OnQryTrade(SimSession& session, const SimRequest& req);
+
+    /// 费率查询的合约: 指定合约时为该合约, 否则为有持仓的合约
+    std::vector<uint32_t> RateInstruments(const Account& account, const char* instrumentId) const;
+    void OnOrderInsert(SimSession& session, const SimRequest& req);
+    void OnOrderAction(SimSession& session, const SimRequest& req);
+    void OnBatchOrderAction(SimSession& session, const SimRequest& req);
+
+    /// 注销会话: 从资金账户中移除并释放
+    void Release(int slot);
+
+    /// 申请会话回调槽位并填写事件头, 队列满时让出CPU等待回调线程; 回调被推迟时返回 staging
+    TraderEvent* BeginResponse(SimSession& session, TraderEventType type, int requestId, bool isLast,
+                               int errorId = 0);
+
+    /// 发布回调并在回调线程休眠时唤醒它; 回调被推迟时放入推迟队列
+    void PublishResponse(SimSession& session);
+
+    /// 直接申请回调队列槽位, 不经过故障注入; 队列满时让出CPU等待, 会话关闭时返回 nullptr
+    TraderEvent* ClaimResponse(SimSession& session);
+
+    /// 发布 ClaimResponse 得到的回调并在回调线程休眠时唤醒它
+    void DeliverResponse(SimSession& session);
+
+    /// 执行到期的故障, 推送到期的推迟回调; 返回下一次需要检查的时刻
+    int64_t RunFaults(int slot, SimSession& session, int64_t now);
+
+    /// 开始一个故障
+    void StartFault(int slot, SimSession& session, const SimFault& fault, int64_t now);
+
+    /// 断开连接: 丢弃未处理的请求和未推送的回调, 注销登录, 回调 OnFrontDisconnected, downNs 后重连
+    void DropConnection(int slot, SimSession& session, int reason, int64_t downNs, int64_t now);
+
+    /// 把 staging 中的回调放入推迟队列或乱序缓冲
+    void HoldResponse(SimSession& session);
+
+    /// 乱序缓冲中的回调倒序进入推迟队列
+    void FlushReorder(SimSession& session, int64_t now);
+
+    /// 推送到期的推迟回调
+    void ReleaseHeld(SimSession& session, int64_t now);
+
+    /// 发送不带数据的应答或错误应答
+    void Respond(SimSession& session, TraderEventType type, int requestId, int errorId = 0);
+
+    /// 拒绝报单: OnRspOrderInsert + OnErrRtnOrderInsert
+    void RejectOrder(SimSession& session, const SimRequest& req, int errorId);
+
+    /// 拒绝撤单: OnRspOrderAction + OnErrRtnOrderAction
+    void RejectAction(SimSession& session, const SimRequest& req, int errorId);
+
+    /// 记录报单状态变化: 首次出现时写入私有流, 并向账户全部会话推送 OnRtnOrder
+    void PushOrder(uint32_t index, bool isNew);
+
+    /// 预填账户在每个合约上的回报模板, 回报时只改写变化的字段
+    void BuildTemplates(Account& account) const;
+
+    /// 按报单记录填写 CThostFtdcOrderField
+    void FillOrder(uint32_t index, CThostFtdcOrderField& field) const;
+
+    /// 登录后按订阅方式补发私有流
+    void ReplayFlow(SimSession& session);
+
+    /// 撤销一笔挂单
+    void CancelOrder(uint32_t index);
+
+    /// 检查平仓量, 返回0或错误码
+    int CheckClose(const Account& account, const Instrument& instrument, uint32_t id,
+                   const CThostFtdcInputOrderField& input) const;
+
+    /// 交易所接受报单后撮合, 推送成交和最终状态, 剩余量按报单条件挂单或撤销
+    void Execute(uint32_t index);
+
+    /// 记一笔成交: 更新报单、持仓和资金, 写入私有流并推送 OnRtnOrder + OnRtnTrade
+    void ApplyFill(uint32_t index, int volume, double price, uint32_t tradeSeq);
+
+    /// 平仓报单剩余量不再成交时解冻持仓
+    void ReleaseFrozen(const Order& order, int volume);
+
+    /// 写入私有流并向账户全部会话推送 OnRtnTrade
+    void PushTrade(uint32_t trade);
+
+    /// 按成交记录填写 CThostFtdcTradeField
+    void FillTrade(uint32_t trade, CThostFtdcTradeField& field) const;
+
+    /// 按交易所格式填写 OrderSysID 或 TradeID
+    void FormatExchangeId(const Exchange& exchange, uint32_t seq, char (&dst)[21]) const;
+
+    /// 按 前置+会话+OrderRef 或 交易所+OrderSysID 查找报单, 找不到时返回 -1;
+    /// 未填前置和会话编号时取本会话的
+    int64_t FindOrder(const SimSession& session, const CThostFtdcInputOrderActionField& action) const;
+
+    /// 报单是否仍在交易所队列中
+    static bool IsWorking(const Order& order);
+
+    /// 当前时刻 hh:mm:ss, 每秒格式化一次
+    const char* Now();
+
+    SimFrontOptions m_options;
+    char m_tradingDay[9];
+    std::unique_ptr<SymbolTable> m_symbols;         ///< 合约代码 -> m_instruments 下标
+    std::vector<Instrument> m_instruments;
+    std::vector<Exchange> m_exchanges;
+
+    // 以下仅前置线程访问
+    std::vector<Account> m_accounts;
+    std::unordered_map<std::string, int> m_accountIndex;    ///< 经纪公司+投资者 -> m_accounts 下标
+    std::vector<Order> m_orders;
+    std::unordered_map<OrderKey, uint32_t, OrderKeyHash> m_orderIndex;
+    std::vector<Trade> m_trades;
+    SimMatcher m_matcher;
+    std::vector<SimFill> m_fills;                   ///< 撮合结果, 每笔报单复用
+    int m_nextSessionId;
+    int64_t m_clockSecond;
+    char m_clock[9];
+
+    // 会话槽位, Attach() 写入, 前置线程读取并在注销后清空
+    std::unique_ptr<std::atomic<SimSession*>[]> m_sessions;
+    std::atomic<int> m_sessionCount;                ///< 已使用的槽位数上界
+    std::mutex m_attachMutex;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    ConsumerWaiter m_waiter;
+
+    // 统计, 由前置线程写入
+    std::atomic<uint64_t> m_requests;
+    std::atomic<uint64_t> m_acceptedOrders;
+    std::atomic<uint64_t> m_orderRejects;
+    std::atomic<uint64_t> m_cancels;
+    std::atomic<uint64_t> m_tradeCount;
+    std::atomic<uint64_t> m_responses;
+    std::atomic<uint64_t> m_responseQueueFullSpins;
+    std::atomic<uint64_t> m_faults;
+    std::atomic<uint64_t> m_heldResponses;
+};
+
+#endif // CTP_TEST_SIM_FRONT_H
@@ -0,0 +1,152 @@
+///
+/// @file SimMatcher.cpp
+/// @brief 模拟前置撮合引擎实现
+///
+
+#include "SimMatcher.h"
+
+const int64_t SimMatcher::kMarketBuy;
+const int64_t SimMatcher::kMarketSell;
+const uint32_t SimMatcher::kNil;
+
+SimMatcher::SimMatcher(size_t instrumentCount) : m_books(instrumentCount), m_resting(0) {}
+
+size_t SimMatcher::Find(const Side& side, bool buy, int64_t ticks, bool& found) {
+    // 买方升序、卖方降序, 二分查找第一个不优于 ticks 的位置
+    size_t lo = 0;
+    size_t hi = side.size();
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const bool before = buy ? side[mid].ticks < ticks : side[mid].ticks > ticks;
+        if (before) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    found = lo < side.size() && side[lo].ticks == ticks;
+    return lo;
+}
+
+int SimMatcher::Available(uint32_t instrument, bool buy, int64_t limitTicks, int volume) const {
+    const Side& side = buy ? m_books[instrument].asks : m_books[instrument].bids;
+    int available = 0;
+    for (size_t i = side.size(); i > 0 && available < volume; --i) {
+        const Level& level = side[i - 1];
+        if (!Crosses(buy, limitTicks, level.ticks)) {
+            break;
+        }
+        for (uint32_t n = level.head; n != kNil && available < volume; n = m_nodes[n].next) {
+            available += m_nodes[n].remaining;
+        }
+    }
+    return available < volume ? available : volume;
+}
+
+int SimMatcher::Match(uint32_t instrument, bool buy, int64_t limitTicks, int volume, std::vector<SimFill>& fills) {
+    Side& side = buy ? m_books[instrument].asks : m_books[instrument].bids;
+    while (volume > 0 && !side.empty()) {
+        Level& level = side.back();
+        if (!Crosses(buy, limitTicks, level.ticks)) {
+            break;
+        }
+        while (volume > 0 && level.head != kNil) {
+            const uint32_t maker = level.head;
+            Node& node = m_nodes[maker];
+            SimFill fill;
+            fill.maker = maker;
+            fill.ticks = level.ticks;
+            fill.volume = node.remaining < volume ? node.remaining : volume;
+            node.remaining -= fill.volume;
+            volume -= fill.volume;
+            fill.makerDone = node.remaining == 0;
+            if (fill.makerDone) {
+                level.head = node.next;
+                if (level.head != kNil) {
+                    m_nodes[level.head].prev = kNil;
+                }
+                --m_resting;
+            }
+            fills.push_back(fill);
+        }
+        if (level.head == kNil) {
+            side.pop_back();
+        }
+    }
+    return volume;
+}
+
+void SimMatcher::Add(uint32_t order, uint32_t instrument, bool buy, int64_t ticks, int volume) {
+    if (order >= m_nodes.size()) {
+        m_nodes.resize(order + 1);
+    }
+    Node& node = m_nodes[order];
+    node.prev = kNil;
+    node.next = kNil;
+    node.instrument = instrument;
+    node.remaining = volume;
+    node.ticks = ticks;
+    node.buy = buy;
+
+    Side& side = buy ? m_books[instrument].bids : m_books[instrument].asks;
+    bool found;
+    const size_t pos = Find(side, buy, ticks, found);
+    if (found) {
+        Level& level = side[pos];
+        node.prev = level.tail;
+        m_nodes[level.tail].next = order;
+        level.tail = order;
+    } else {
+        Level level;
+        level.ticks = ticks;
+        level.head = order;
+        level.tail = order;
+        side.insert(side.begin() + pos, level);
+    }
+    ++m_resting;
+}
+
+bool SimMatcher::Remove(uint32_t order) {
+    if (order >= m_nodes.size() || m_nodes[order].remaining == 0) {
+        return false;
+    }
+    Node& node = m_nodes[order];
+    Side& side = node.buy ? m_books[node.instrument].bids : m_books[node.instrument].asks;
+    bool found;
+    const size_t pos = Find(side, node.buy, node.ticks, found);
+    Level& level = side[pos];
+    if (node.prev != kNil) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        level.head = node.next;
+    }
+    if (node.next != kNil) {
+        m_nodes[node.next].prev = node.prev;
+    } else {
+        level.tail = node.prev;
+    }
+    if (level.head == kNil) {
+        side.erase(side.begin() + pos);
+    }
+    node.remaining = 0;
+    --m_resting;
+    return true;
+}
+
+bool SimMatcher::BestBid(uint32_t instrument, int64_t& ticks) const {
+    const Side& side = m_books[instrument].bids;
+    if (side.empty()) {
+        return false;
+    }
+    ticks = side.back().ticks;
+    return true;
+}
+
+bool SimMatcher::BestAsk(uint32_t instrument, int64_t& ticks) const {
+    const Side& side = m_books[instrument].asks;
+    if (side.empty()) {
+        return false;
+    }
+    ticks = side.back().ticks;
+    return true;
+}
@@ -0,0 +1,105 @@
+///
+/// @file SimMatcher.h
+/// @brief 模拟前置的撮合引擎: 每个合约一本价格优先、时间优先的限价订单簿
+///
+
+#ifndef CTP_TEST_SIM_MATCHER_H
+#define CTP_TEST_SIM_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///
+/// @brief 一笔成交, 由撮合产生, 价格为挂单方的价格
+///
+struct SimFill {
+    uint32_t maker;         ///< 被动方报单下标
+    int volume;
+    int64_t ticks;          ///< 成交价, 以最小变动价位为单位
+    bool makerDone;         ///< 被动方已全部成交并移出订单簿
+};
+
+///
+/// @brief 限价订单簿
+///
+/// 价格以最小变动价位的整数倍表示, 比较和排序不涉及浮点数。每个合约买卖各一组价位,
+/// 价位按价格排序存放在数组中, 最优价位在数组末尾: 买方升序、卖方降序。新报单和成交
+/// 绝大多数发生在最优价附近, 插入、删除价位只移动末尾少量元素, 撮合从末尾依次消耗价位。
+/// 同一价位的挂单按到达顺序串成双向链表, 链表节点以报单下标直接索引, 撤单 O(log 价位数)。
+///
+/// 报单下标由调用方(SimFront)分配, 与其报单记录一一对应。撮合只维护挂单剩余量,
+/// 报单状态和回报由调用方根据 SimFill 生成。仅前置线程访问, 不加锁。
+///
+class SimMatcher {
+public:
+    /// 市价单的限价: 买单取最大值, 卖单取最小值
+    static const int64_t kMarketBuy = INT64_MAX;
+    static const int64_t kMarketSell = INT64_MIN;
+
+    explicit SimMatcher(size_t instrumentCount);
+
+    /// 预分配报单节点, 超出后按需扩容
+    void Reserve(size_t orderCapacity) { m_nodes.reserve(orderCapacity); }
+
+    /// 以 limitTicks 为限价可立即成交的数量, 最多数到 volume 为止; 用于 FOK 和最小成交量检查
+    int Available(uint32_t instrument, bool buy, int64_t limitTicks, int volume) const;
+
+    /// 主动撮合一笔报单, 成交追加到 fills, 返回未成交数量。报单本身不进入订单簿
+    int Match(uint32_t instrument, bool buy, int64_t limitTicks, int volume, std::vector<SimFill>& fills);
+
+    /// 把报单的剩余量挂入订单簿, 排在同价位已有挂单之后
+    void Add(uint32_t order, uint32_t instrument, bool buy, int64_t ticks, int volume);
+
+    /// 从订单簿移除挂单, 不在簿中时返回false
+    bool Remove(uint32_t order);
+
+    /// 最优买价和卖价, 没有挂单时返回false
+    bool BestBid(uint32_t instrument, int64_t& ticks) const;
+    bool BestAsk(uint32_t instrument, int64_t& ticks) const;
+
+    /// 全部挂单数
+    size_t Resting() const { return m_resting; }
+
+private:
+    static const uint32_t kNil = UINT32_MAX;
+
+    /// 一个价位
+    struct Level {
+        int64_t ticks;
+        uint32_t head;          ///< 最早到达的挂单
+        uint32_t tail;
+    };
+
+    /// 一方的价位, 最优价在末尾
+    typedef std::vector<Level> Side;
+
+    /// 挂单节点, 以报单下标索引
+    struct Node {
+        uint32_t prev;
+        uint32_t next;
+        uint32_t instrument;
+        int remaining;          ///< 0 表示不在订单簿中
+        int64_t ticks;
+        bool buy;
+    };
+
+    struct Book {
+        Side bids;
+        Side asks;
+    };
+
+    /// 价位在 side 中的位置; 不存在时返回应插入的位置, found 为false
+    static size_t Find(const Side& side, bool buy, int64_t ticks, bool& found);
+
+    /// 限价是否与价位交叉
+    static bool Crosses(bool buy, int64_t limitTicks, int64_t levelTicks) {
+        return buy ? levelTicks <= limitTicks : levelTicks >= limitTicks;
+    }
+
+    std::vector<Book> m_books;
+    std::vector<Node> m_nodes;
+    size_t m_resting;
+};
+
+#endif // CTP_TEST_SIM_MATCHER_H
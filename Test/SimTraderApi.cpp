@@ -0,0 +1,687 @@
+///
+/// @file SimTraderApi.cpp
+/// @brief 模拟交易API实现
+///
+
+#include "SimTraderApi.h"
+
+#include <cstring>
+
+#include "AsyncLogger.h"
+
+CThostFtdcTraderApi* CThostFtdcTraderApi::CreateFtdcTraderApi(const char *pszFlowPath) {
+    return new SimTraderApi(pszFlowPath);
+}
+
+const char* CThostFtdcTraderApi::GetApiVersion() {
+    return "v6.7.7 SimFront";
+}
+
+SimTraderApi::SimTraderApi(const char* flowPath)
+    : m_flowPath(flowPath ? flowPath : ""), m_spi(nullptr), m_privateResume(THOST_TERT_RESTART), m_session(nullptr),
+      m_running(false), m_released(false), m_joiners(0) {}
+
+SimTraderApi::~SimTraderApi() {}
+
+void SimTraderApi::Init() {
+    if (m_session) {
+        return;
+    }
+    m_session = SimFront::Instance().Attach();
+    if (!m_session) {
+        LOG("[SimTraderApi] 模拟前置会话数已满, 无法连接");
+        return;
+    }
+    // 连接请求入队之前写入, 前置线程处理登录时读取
+    m_session->privateResume = m_privateResume;
+    m_session->fault.schedule = SimFaultSchedule::Parse(m_frontAddress);
+
+    m_running.store(true);
+    m_callbackThread = std::thread(&SimTraderApi::CallbackLoop, this);
+    SimFront::Instance().Send(m_session, SimRequestType::Connect, 0, nullptr, 0);
+}
+
+void SimTraderApi::Release() {
+    if (m_session) {
+        // 先让前置停止写入回调, 避免回调队列满时前置线程等待已停止的回调线程
+        m_session->closing.store(true, std::memory_order_release);
+        m_session->callbackWaiter.Signal([this] { m_running.store(false); });
+        if (m_callbackThread.joinable()) {
+            m_callbackThread.join();
+        }
+        SimFront::Instance().Detach(m_session);
+        m_session = nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(m_joinMutex);
+    m_released = true;
+    m_joinCond.notify_all();
+    m_joinCond.wait(lock, [this] { return m_joiners == 0; });
+    lock.unlock();
+    delete this;
+}
+
+int SimTraderApi::Join() {
+    std::unique_lock<std::mutex> lock(m_joinMutex);
+    ++m_joiners;
+    m_joinCond.wait(lock, [this] { return m_released; });
+    --m_joiners;
+    m_joinCond.notify_all();
+    return 0;
+}
+
+const char* SimTraderApi::GetTradingDay() {
+    return SimFront::Instance().TradingDay();
+}
+
+void SimTraderApi::GetFrontInfo(CThostFtdcFrontInfoField *pFrontInfo) {
+    if (!pFrontInfo) {
+        return;
+    }
+    memset(pFrontInfo, 0, sizeof(*pFrontInfo));
+    strncpy(pFrontInfo->FrontAddr, m_frontAddress.c_str(), sizeof(pFrontInfo->FrontAddr) - 1);
+}
+
+void SimTraderApi::RegisterFront(char *pszFrontAddress) {
+    m_frontAddress = pszFrontAddress ? pszFrontAddress : "";
+}
+
+void SimTraderApi::RegisterNameServer(char *pszNsAddress) {
+    m_frontAddress = pszNsAddress ? pszNsAddress : "";
+}
+
+void SimTraderApi::RegisterFensUserInfo(CThostFtdcFensUserInfoField *) {}
+
+void SimTraderApi::RegisterSpi(CThostFtdcTraderSpi *pSpi) {
+    m_spi = pSpi;
+}
+
+void SimTraderApi::SubscribePrivateTopic(THOST_TE_RESUME_TYPE nResumeType) {
+    m_privateResume = nResumeType;
+}
+
+void SimTraderApi::SubscribePublicTopic(THOST_TE_RESUME_TYPE) {
+    // 模拟前置没有公有流
+}
+
+int SimTraderApi::RegisterUserSystemInfo(CThostFtdcUserSystemInfoField *) {
+    return 0;
+}
+
+int SimTraderApi::SubmitUserSystemInfo(CThostFtdcUserSystemInfoField *) {
+    return 0;
+}
+
+template <typename T>
+int SimTraderApi::Request(SimRequestType type, T *field, int requestId) {
+    if (!m_session) {
+        return -1;
+    }
+    return SimFront::Instance().Send(m_session, type, requestId, field, sizeof(T));
+}
+
+int SimTraderApi::Unsupported(int requestId) {
+    if (!m_session) {
+        return -1;
+    }
+    return SimFront::Instance().Send(m_session, SimRequestType::Unsupported, requestId, nullptr, 0);
+}
+
+// ---------------------------------------------------------------------------
+// 回调线程
+// ---------------------------------------------------------------------------
+
+void SimTraderApi::CallbackLoop() {
+    SimSession* session = m_session;
+    while (m_running.load(std::memory_order_acquire)) {
+        TraderEvent* ev = session->responses.Front();
+        if (ev) {
+            Dispatch(*ev);
+            session->responses.Pop();
+            session->callbackWaiter.Busy();
+            continue;
+        }
+        session->callbackWaiter.Idle([this, session] {
+            return !session->responses.Empty() || !m_running.load(std::memory_order_relaxed);
+        });
+    }
+}
+
+void SimTraderApi::Dispatch(TraderEvent& ev) {
+    if (!m_spi) {
+        return;
+    }
+    CThostFtdcRspInfoField* rspInfo = ev.hasRspInfo ? &ev.rspInfo : nullptr;
+    TraderEventData* data = ev.hasData ? &ev.data : nullptr;
+    switch (ev.type) {
+        case TraderEventType::FrontConnected:
+            m_spi->OnFrontConnected();
+            break;
+        case TraderEventType::FrontDisconnected:
+            m_spi->OnFrontDisconnected(ev.requestId);
+            break;
+        case TraderEventType::HeartBeatWarning:
+            m_spi->OnHeartBeatWarning(ev.requestId);
+            break;
+        case TraderEventType::RspAuthenticate:
+            m_spi->OnRspAuthenticate(data ? &data->rspAuthenticate : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspUserLogin:
+            m_spi->OnRspUserLogin(data ? &data->rspUserLogin : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspUserLogout:
+            m_spi->OnRspUserLogout(data ? &data->userLogout : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQrySettlementInfo:
+            m_spi->OnRspQrySettlementInfo(data ? &data->settlementInfo : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspSettlementInfoConfirm:
+            m_spi->OnRspSettlementInfoConfirm(data ? &data->settlementInfoConfirm : nullptr, rspInfo, ev.requestId,
+                                              ev.isLast);
+            break;
+        case TraderEventType::RspQryTradingAccount:
+            m_spi->OnRspQryTradingAccount(data ? &data->tradingAccount : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryInvestorPosition:
+            m_spi->OnRspQryInvestorPosition(data ? &data->investorPosition : nullptr, rspInfo, ev.requestId,
+                                            ev.isLast);
+            break;
+        case TraderEventType::RspQryInstrument:
+            m_spi->OnRspQryInstrument(data ? &data->instrument : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryInstrumentMarginRate:
+            m_spi->OnRspQryInstrumentMarginRate(data ? &data->marginRate : nullptr, rspInfo, ev.requestId,
+                                                ev.isLast);
+            break;
+        case TraderEventType::RspQryInstrumentCommissionRate:
+            m_spi->OnRspQryInstrumentCommissionRate(data ? &data->commissionRate : nullptr, rspInfo, ev.requestId,
+                                                    ev.isLast);
+            break;
+        case TraderEventType::RspQryTrade:
+            m_spi->OnRspQryTrade(data ? &data->trade : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspError:
+            m_spi->OnRspError(rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RtnOrder:
+            m_spi->OnRtnOrder(&ev.data.order);
+            break;
+        case TraderEventType::RtnTrade:
+            m_spi->OnRtnTrade(&ev.data.trade);
+            break;
+        case TraderEventType::RspOrderInsert:
+            m_spi->OnRspOrderInsert(data ? &data->inputOrder : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::ErrRtnOrderInsert:
+            m_spi->OnErrRtnOrderInsert(data ? &data->inputOrder : nullptr, rspInfo);
+            break;
+        case TraderEventType::RspOrderAction:
+            m_spi->OnRspOrderAction(data ? &data->inputOrderAction : nullptr, rspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::ErrRtnOrderAction:
+            m_spi->OnErrRtnOrderAction(data ? &data->orderAction : nullptr, rspInfo);
+            break;
+        case TraderEventType::RspBatchOrderAction:
+            m_spi->OnRspBatchOrderAction(data ? &data->inputBatchOrderAction : nullptr, rspInfo, ev.requestId,
+                                         ev.isLast);
+            break;
+        case TraderEventType::ErrRtnBatchOrderAction:
+            m_spi->OnErrRtnBatchOrderAction(data ? &data->batchOrderAction : nullptr, rspInfo);
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 请求
+// ---------------------------------------------------------------------------
+
+int SimTraderApi::ReqAuthenticate(CThostFtdcReqAuthenticateField *pReqAuthenticateField, int nRequestID) {
+    return Request(SimRequestType::Authenticate, pReqAuthenticateField, nRequestID);
+}
+
+int SimTraderApi::ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) {
+    return Request(SimRequestType::UserLogin, pReqUserLoginField, nRequestID);
+}
+
+int SimTraderApi::ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) {
+    return Request(SimRequestType::UserLogout, pUserLogout, nRequestID);
+}
+
+int SimTraderApi::ReqOrderInsert(CThostFtdcInputOrderField *pInputOrder, int nRequestID) {
+    return Request(SimRequestType::OrderInsert, pInputOrder, nRequestID);
+}
+
+int SimTraderApi::ReqOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction, int nRequestID) {
+    return Request(SimRequestType::OrderAction, pInputOrderAction, nRequestID);
+}
+
+int SimTraderApi::ReqSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                           int nRequestID) {
+    return Request(SimRequestType::SettlementInfoConfirm, pSettlementInfoConfirm, nRequestID);
+}
+
+int SimTraderApi::ReqBatchOrderAction(CThostFtdcInputBatchOrderActionField *pInputBatchOrderAction, int nRequestID) {
+    return Request(SimRequestType::BatchOrderAction, pInputBatchOrderAction, nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorPosition(CThostFtdcQryInvestorPositionField *pQryInvestorPosition, int nRequestID) {
+    return Request(SimRequestType::QryInvestorPosition, pQryInvestorPosition, nRequestID);
+}
+
+int SimTraderApi::ReqQryTradingAccount(CThostFtdcQryTradingAccountField *pQryTradingAccount, int nRequestID) {
+    return Request(SimRequestType::QryTradingAccount, pQryTradingAccount, nRequestID);
+}
+
+int SimTraderApi::ReqQryInstrumentMarginRate(CThostFtdcQryInstrumentMarginRateField *pQryInstrumentMarginRate,
+                                             int nRequestID) {
+    return Request(SimRequestType::QryInstrumentMarginRate, pQryInstrumentMarginRate, nRequestID);
+}
+
+int SimTraderApi::ReqQryInstrumentCommissionRate(CThostFtdcQryInstrumentCommissionRateField *pQryInstrumentCommissionRate,
+                                                 int nRequestID) {
+    return Request(SimRequestType::QryInstrumentCommissionRate, pQryInstrumentCommissionRate, nRequestID);
+}
+
+int SimTraderApi::ReqQryInstrument(CThostFtdcQryInstrumentField *pQryInstrument, int nRequestID) {
+    return Request(SimRequestType::QryInstrument, pQryInstrument, nRequestID);
+}
+
+int SimTraderApi::ReqQrySettlementInfo(CThostFtdcQrySettlementInfoField *pQrySettlementInfo, int nRequestID) {
+    return Request(SimRequestType::QrySettlementInfo, pQrySettlementInfo, nRequestID);
+}
+
+int SimTraderApi::ReqQryTrade(CThostFtdcQryTradeField *pQryTrade, int nRequestID) {
+    return Request(SimRequestType::QryTrade, pQryTrade, nRequestID);
+}
+
+int SimTraderApi::ReqUserPasswordUpdate(CThostFtdcUserPasswordUpdateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqTradingAccountPasswordUpdate(CThostFtdcTradingAccountPasswordUpdateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqUserAuthMethod(CThostFtdcReqUserAuthMethodField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqGenUserCaptcha(CThostFtdcReqGenUserCaptchaField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqGenUserText(CThostFtdcReqGenUserTextField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqUserLoginWithCaptcha(CThostFtdcReqUserLoginWithCaptchaField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqUserLoginWithText(CThostFtdcReqUserLoginWithTextField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqUserLoginWithOTP(CThostFtdcReqUserLoginWithOTPField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqParkedOrderInsert(CThostFtdcParkedOrderField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqParkedOrderAction(CThostFtdcParkedOrderActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryMaxOrderVolume(CThostFtdcQryMaxOrderVolumeField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqRemoveParkedOrder(CThostFtdcRemoveParkedOrderField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqRemoveParkedOrderAction(CThostFtdcRemoveParkedOrderActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqExecOrderInsert(CThostFtdcInputExecOrderField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqExecOrderAction(CThostFtdcInputExecOrderActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqForQuoteInsert(CThostFtdcInputForQuoteField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQuoteInsert(CThostFtdcInputQuoteField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQuoteAction(CThostFtdcInputQuoteActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqOptionSelfCloseInsert(CThostFtdcInputOptionSelfCloseField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqOptionSelfCloseAction(CThostFtdcInputOptionSelfCloseActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqCombActionInsert(CThostFtdcInputCombActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryOrder(CThostFtdcQryOrderField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestor(CThostFtdcQryInvestorField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryTradingCode(CThostFtdcQryTradingCodeField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryExchange(CThostFtdcQryExchangeField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryProduct(CThostFtdcQryProductField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryDepthMarketData(CThostFtdcQryDepthMarketDataField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryTraderOffer(CThostFtdcQryTraderOfferField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryTransferBank(CThostFtdcQryTransferBankField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorPositionDetail(CThostFtdcQryInvestorPositionDetailField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryNotice(CThostFtdcQryNoticeField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySettlementInfoConfirm(CThostFtdcQrySettlementInfoConfirmField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorPositionCombineDetail(CThostFtdcQryInvestorPositionCombineDetailField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryCFMMCTradingAccountKey(CThostFtdcQryCFMMCTradingAccountKeyField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryEWarrantOffset(CThostFtdcQryEWarrantOffsetField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorProductGroupMargin(CThostFtdcQryInvestorProductGroupMarginField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryExchangeMarginRate(CThostFtdcQryExchangeMarginRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryExchangeMarginRateAdjust(CThostFtdcQryExchangeMarginRateAdjustField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryExchangeRate(CThostFtdcQryExchangeRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySecAgentACIDMap(CThostFtdcQrySecAgentACIDMapField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryProductExchRate(CThostFtdcQryProductExchRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryProductGroup(CThostFtdcQryProductGroupField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryMMInstrumentCommissionRate(CThostFtdcQryMMInstrumentCommissionRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryMMOptionInstrCommRate(CThostFtdcQryMMOptionInstrCommRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInstrumentOrderCommRate(CThostFtdcQryInstrumentOrderCommRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySecAgentTradingAccount(CThostFtdcQryTradingAccountField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySecAgentCheckMode(CThostFtdcQrySecAgentCheckModeField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySecAgentTradeInfo(CThostFtdcQrySecAgentTradeInfoField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryOptionInstrTradeCost(CThostFtdcQryOptionInstrTradeCostField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryOptionInstrCommRate(CThostFtdcQryOptionInstrCommRateField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryExecOrder(CThostFtdcQryExecOrderField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryForQuote(CThostFtdcQryForQuoteField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryQuote(CThostFtdcQryQuoteField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryOptionSelfClose(CThostFtdcQryOptionSelfCloseField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestUnit(CThostFtdcQryInvestUnitField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryCombInstrumentGuard(CThostFtdcQryCombInstrumentGuardField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryCombAction(CThostFtdcQryCombActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryTransferSerial(CThostFtdcQryTransferSerialField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryAccountregister(CThostFtdcQryAccountregisterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryContractBank(CThostFtdcQryContractBankField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryParkedOrder(CThostFtdcQryParkedOrderField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryParkedOrderAction(CThostFtdcQryParkedOrderActionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryTradingNotice(CThostFtdcQryTradingNoticeField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryBrokerTradingParams(CThostFtdcQryBrokerTradingParamsField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryBrokerTradingAlgos(CThostFtdcQryBrokerTradingAlgosField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQueryCFMMCTradingAccountToken(CThostFtdcQueryCFMMCTradingAccountTokenField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqFromBankToFutureByFuture(CThostFtdcReqTransferField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqFromFutureToBankByFuture(CThostFtdcReqTransferField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQueryBankAccountMoneyByFuture(CThostFtdcReqQueryAccountField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryClassifiedInstrument(CThostFtdcQryClassifiedInstrumentField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryCombPromotionParam(CThostFtdcQryCombPromotionParamField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRiskSettleInvstPosition(CThostFtdcQryRiskSettleInvstPositionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRiskSettleProductStatus(CThostFtdcQryRiskSettleProductStatusField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMFutureParameter(CThostFtdcQrySPBMFutureParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMOptionParameter(CThostFtdcQrySPBMOptionParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMIntraParameter(CThostFtdcQrySPBMIntraParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMInterParameter(CThostFtdcQrySPBMInterParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMPortfDefinition(CThostFtdcQrySPBMPortfDefinitionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMInvestorPortfDef(CThostFtdcQrySPBMInvestorPortfDefField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorPortfMarginRatio(CThostFtdcQryInvestorPortfMarginRatioField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorProdSPBMDetail(CThostFtdcQryInvestorProdSPBMDetailField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorCommoditySPMMMargin(CThostFtdcQryInvestorCommoditySPMMMarginField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorCommodityGroupSPMMMargin(CThostFtdcQryInvestorCommodityGroupSPMMMarginField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPMMInstParam(CThostFtdcQrySPMMInstParamField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPMMProductParam(CThostFtdcQrySPMMProductParamField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQrySPBMAddOnInterParameter(CThostFtdcQrySPBMAddOnInterParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRCAMSCombProductInfo(CThostFtdcQryRCAMSCombProductInfoField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRCAMSInstrParameter(CThostFtdcQryRCAMSInstrParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRCAMSIntraParameter(CThostFtdcQryRCAMSIntraParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRCAMSInterParameter(CThostFtdcQryRCAMSInterParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRCAMSShortOptAdjustParam(CThostFtdcQryRCAMSShortOptAdjustParamField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRCAMSInvestorCombPosition(CThostFtdcQryRCAMSInvestorCombPositionField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorProdRCAMSMargin(CThostFtdcQryInvestorProdRCAMSMarginField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRULEInstrParameter(CThostFtdcQryRULEInstrParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRULEIntraParameter(CThostFtdcQryRULEIntraParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryRULEInterParameter(CThostFtdcQryRULEInterParameterField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorProdRULEMargin(CThostFtdcQryInvestorProdRULEMarginField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
+
+int SimTraderApi::ReqQryInvestorPortfSetting(CThostFtdcQryInvestorPortfSettingField *, int nRequestID) {
+    return Unsupported(nRequestID);
+}
@@ -0,0 +1,254 @@
+///
+/// @file SimTraderApi.h
+/// @brief 连接本地模拟前置的 CThostFtdcTraderApi 实现
+///
+
+#ifndef CTP_TEST_SIM_TRADER_API_H
+#define CTP_TEST_SIM_TRADER_API_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ThostFtdcTraderApi.h"
+#include "SimFront.h"
+
+///
+/// @brief 模拟交易API
+///
+/// 由 ctp_sim_trader 库中的 CThostFtdcTraderApi::CreateFtdcTraderApi() 创建, 代替 thosttraderapi_se
+/// 链接进程序, 调用方代码不变。Req* 把请求拷贝进会话请求队列后立即返回, 由 SimFront 前置线程处理;
+/// 回调在API自己的回调线程上按前置生成的顺序调用, 与真实API一样不与调用线程重叠。
+///
+/// RegisterFront 的地址只用于 GetFrontInfo 和解析故障日程(见 SimFaultSchedule), 不建立网络连接;
+/// 私有流只保存在进程内存中, 不写流文件。
+///
+class SimTraderApi final : public CThostFtdcTraderApi {
+public:
+    explicit SimTraderApi(const char* flowPath);
+
+    virtual void Release() override;
+    virtual void Init() override;
+    virtual int Join() override;
+    virtual const char *GetTradingDay() override;
+    virtual void GetFrontInfo(CThostFtdcFrontInfoField *pFrontInfo) override;
+    virtual void RegisterFront(char *pszFrontAddress) override;
+    virtual void RegisterNameServer(char *pszNsAddress) override;
+    virtual void RegisterFensUserInfo(CThostFtdcFensUserInfoField *pFensUserInfo) override;
+    virtual void RegisterSpi(CThostFtdcTraderSpi *pSpi) override;
+    virtual void SubscribePrivateTopic(THOST_TE_RESUME_TYPE nResumeType) override;
+    virtual void SubscribePublicTopic(THOST_TE_RESUME_TYPE nResumeType) override;
+    virtual int RegisterUserSystemInfo(CThostFtdcUserSystemInfoField *pUserSystemInfo) override;
+    virtual int SubmitUserSystemInfo(CThostFtdcUserSystemInfoField *pUserSystemInfo) override;
+
+    // 模拟前置支持的请求
+    virtual int ReqAuthenticate(CThostFtdcReqAuthenticateField *pReqAuthenticateField, int nRequestID) override;
+    virtual int ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) override;
+    virtual int ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) override;
+    virtual int ReqOrderInsert(CThostFtdcInputOrderField *pInputOrder, int nRequestID) override;
+    virtual int ReqOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction, int nRequestID) override;
+    virtual int ReqSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                         int nRequestID) override;
+    virtual int ReqBatchOrderAction(CThostFtdcInputBatchOrderActionField *pInputBatchOrderAction,
+                                    int nRequestID) override;
+    virtual int ReqQryInvestorPosition(CThostFtdcQryInvestorPositionField *pQryInvestorPosition,
+                                       int nRequestID) override;
+    virtual int ReqQryTradingAccount(CThostFtdcQryTradingAccountField *pQryTradingAccount, int nRequestID) override;
+    virtual int ReqQryInstrumentMarginRate(CThostFtdcQryInstrumentMarginRateField *pQryInstrumentMarginRate,
+                                           int nRequestID) override;
+    virtual int ReqQryInstrumentCommissionRate(CThostFtdcQryInstrumentCommissionRateField *pQryInstrumentCommissionRate,
+                                               int nRequestID) override;
+    virtual int ReqQryInstrument(CThostFtdcQryInstrumentField *pQryInstrument, int nRequestID) override;
+    virtual int ReqQrySettlementInfo(CThostFtdcQrySettlementInfoField *pQrySettlementInfo, int nRequestID) override;
+    virtual int ReqQryTrade(CThostFtdcQryTradeField *pQryTrade, int nRequestID) override;
+
+    // 以下请求模拟前置不支持, 以 OnRspError(27 不支持的功能) 应答
+    virtual int ReqUserPasswordUpdate(CThostFtdcUserPasswordUpdateField *pUserPasswordUpdate, int nRequestID) override;
+    virtual int ReqTradingAccountPasswordUpdate(CThostFtdcTradingAccountPasswordUpdateField *pTradingAccountPasswordUpdate,
+                                                int nRequestID) override;
+    virtual int ReqUserAuthMethod(CThostFtdcReqUserAuthMethodField *pReqUserAuthMethod, int nRequestID) override;
+    virtual int ReqGenUserCaptcha(CThostFtdcReqGenUserCaptchaField *pReqGenUserCaptcha, int nRequestID) override;
+    virtual int ReqGenUserText(CThostFtdcReqGenUserTextField *pReqGenUserText, int nRequestID) override;
+    virtual int ReqUserLoginWithCaptcha(CThostFtdcReqUserLoginWithCaptchaField *pReqUserLoginWithCaptcha,
+                                        int nRequestID) override;
+    virtual int ReqUserLoginWithText(CThostFtdcReqUserLoginWithTextField *pReqUserLoginWithText,
+                                     int nRequestID) override;
+    virtual int ReqUserLoginWithOTP(CThostFtdcReqUserLoginWithOTPField *pReqUserLoginWithOTP, int nRequestID) override;
+    virtual int ReqParkedOrderInsert(CThostFtdcParkedOrderField *pParkedOrder, int nRequestID) override;
+    virtual int ReqParkedOrderAction(CThostFtdcParkedOrderActionField *pParkedOrderAction, int nRequestID) override;
+    virtual int ReqQryMaxOrderVolume(CThostFtdcQryMaxOrderVolumeField *pQryMaxOrderVolume, int nRequestID) override;
+    virtual int ReqRemoveParkedOrder(CThostFtdcRemoveParkedOrderField *pRemoveParkedOrder, int nRequestID) override;
+    virtual int ReqRemoveParkedOrderAction(CThostFtdcRemoveParkedOrderActionField *pRemoveParkedOrderAction,
+                                           int nRequestID) override;
+    virtual int ReqExecOrderInsert(CThostFtdcInputExecOrderField *pInputExecOrder, int nRequestID) override;
+    virtual int ReqExecOrderAction(CThostFtdcInputExecOrderActionField *pInputExecOrderAction, int nRequestID) override;
+    virtual int ReqForQuoteInsert(CThostFtdcInputForQuoteField *pInputForQuote, int nRequestID) override;
+    virtual int ReqQuoteInsert(CThostFtdcInputQuoteField *pInputQuote, int nRequestID) override;
+    virtual int ReqQuoteAction(CThostFtdcInputQuoteActionField *pInputQuoteAction, int nRequestID) override;
+    virtual int ReqOptionSelfCloseInsert(CThostFtdcInputOptionSelfCloseField *pInputOptionSelfClose,
+                                         int nRequestID) override;
+    virtual int ReqOptionSelfCloseAction(CThostFtdcInputOptionSelfCloseActionField *pInputOptionSelfCloseAction,
+                                         int nRequestID) override;
+    virtual int ReqCombActionInsert(CThostFtdcInputCombActionField *pInputCombAction, int nRequestID) override;
+    virtual int ReqQryOrder(CThostFtdcQryOrderField *pQryOrder, int nRequestID) override;
+    virtual int ReqQryInvestor(CThostFtdcQryInvestorField *pQryInvestor, int nRequestID) override;
+    virtual int ReqQryTradingCode(CThostFtdcQryTradingCodeField *pQryTradingCode, int nRequestID) override;
+    virtual int ReqQryExchange(CThostFtdcQryExchangeField *pQryExchange, int nRequestID) override;
+    virtual int ReqQryProduct(CThostFtdcQryProductField *pQryProduct, int nRequestID) override;
+    virtual int ReqQryDepthMarketData(CThostFtdcQryDepthMarketDataField *pQryDepthMarketData, int nRequestID) override;
+    virtual int ReqQryTraderOffer(CThostFtdcQryTraderOfferField *pQryTraderOffer, int nRequestID) override;
+    virtual int ReqQryTransferBank(CThostFtdcQryTransferBankField *pQryTransferBank, int nRequestID) override;
+    virtual int ReqQryInvestorPositionDetail(CThostFtdcQryInvestorPositionDetailField *pQryInvestorPositionDetail,
+                                             int nRequestID) override;
+    virtual int ReqQryNotice(CThostFtdcQryNoticeField *pQryNotice, int nRequestID) override;
+    virtual int ReqQrySettlementInfoConfirm(CThostFtdcQrySettlementInfoConfirmField *pQrySettlementInfoConfirm,
+                                            int nRequestID) override;
+    virtual int ReqQryInvestorPositionCombineDetail(CThostFtdcQryInvestorPositionCombineDetailField *pQryInvestorPositionCombineDetail,
+                                                    int nRequestID) override;
+    virtual int ReqQryCFMMCTradingAccountKey(CThostFtdcQryCFMMCTradingAccountKeyField *pQryCFMMCTradingAccountKey,
+                                             int nRequestID) override;
+    virtual int ReqQryEWarrantOffset(CThostFtdcQryEWarrantOffsetField *pQryEWarrantOffset, int nRequestID) override;
+    virtual int ReqQryInvestorProductGroupMargin(CThostFtdcQryInvestorProductGroupMarginField *pQryInvestorProductGroupMargin,
+                                                 int nRequestID) override;
+    virtual int ReqQryExchangeMarginRate(CThostFtdcQryExchangeMarginRateField *pQryExchangeMarginRate,
+                                         int nRequestID) override;
+    virtual int ReqQryExchangeMarginRateAdjust(CThostFtdcQryExchangeMarginRateAdjustField *pQryExchangeMarginRateAdjust,
+                                               int nRequestID) override;
+    virtual int ReqQryExchangeRate(CThostFtdcQryExchangeRateField *pQryExchangeRate, int nRequestID) override;
+    virtual int ReqQrySecAgentACIDMap(CThostFtdcQrySecAgentACIDMapField *pQrySecAgentACIDMap, int nRequestID) override;
+    virtual int ReqQryProductExchRate(CThostFtdcQryProductExchRateField *pQryProductExchRate, int nRequestID) override;
+    virtual int ReqQryProductGroup(CThostFtdcQryProductGroupField *pQryProductGroup, int nRequestID) override;
+    virtual int ReqQryMMInstrumentCommissionRate(CThostFtdcQryMMInstrumentCommissionRateField *pQryMMInstrumentCommissionRate,
+                                                 int nRequestID) override;
+    virtual int ReqQryMMOptionInstrCommRate(CThostFtdcQryMMOptionInstrCommRateField *pQryMMOptionInstrCommRate,
+                                            int nRequestID) override;
+    virtual int ReqQryInstrumentOrderCommRate(CThostFtdcQryInstrumentOrderCommRateField *pQryInstrumentOrderCommRate,
+                                              int nRequestID) override;
+    virtual int ReqQrySecAgentTradingAccount(CThostFtdcQryTradingAccountField *pQryTradingAccount,
+                                             int nRequestID) override;
+    virtual int ReqQrySecAgentCheckMode(CThostFtdcQrySecAgentCheckModeField *pQrySecAgentCheckMode,
+                                        int nRequestID) override;
+    virtual int ReqQrySecAgentTradeInfo(CThostFtdcQrySecAgentTradeInfoField *pQrySecAgentTradeInfo,
+                                        int nRequestID) override;
+    virtual int ReqQryOptionInstrTradeCost(CThostFtdcQryOptionInstrTradeCostField *pQryOptionInstrTradeCost,
+                                           int nRequestID) override;
+    virtual int ReqQryOptionInstrCommRate(CThostFtdcQryOptionInstrCommRateField *pQryOptionInstrCommRate,
+                                          int nRequestID) override;
+    virtual int ReqQryExecOrder(CThostFtdcQryExecOrderField *pQryExecOrder, int nRequestID) override;
+    virtual int ReqQryForQuote(CThostFtdcQryForQuoteField *pQryForQuote, int nRequestID) override;
+    virtual int ReqQryQuote(CThostFtdcQryQuoteField *pQryQuote, int nRequestID) override;
+    virtual int ReqQryOptionSelfClose(CThostFtdcQryOptionSelfCloseField *pQryOptionSelfClose, int nRequestID) override;
+    virtual int ReqQryInvestUnit(CThostFtdcQryInvestUnitField *pQryInvestUnit, int nRequestID) override;
+    virtual int ReqQryCombInstrumentGuard(CThostFtdcQryCombInstrumentGuardField *pQryCombInstrumentGuard,
+                                          int nRequestID) override;
+    virtual int ReqQryCombAction(CThostFtdcQryCombActionField *pQryCombAction, int nRequestID) override;
+    virtual int ReqQryTransferSerial(CThostFtdcQryTransferSerialField *pQryTransferSerial, int nRequestID) override;
+    virtual int ReqQryAccountregister(CThostFtdcQryAccountregisterField *pQryAccountregister, int nRequestID) override;
+    virtual int ReqQryContractBank(CThostFtdcQryContractBankField *pQryContractBank, int nRequestID) override;
+    virtual int ReqQryParkedOrder(CThostFtdcQryParkedOrderField *pQryParkedOrder, int nRequestID) override;
+    virtual int ReqQryParkedOrderAction(CThostFtdcQryParkedOrderActionField *pQryParkedOrderAction,
+                                        int nRequestID) override;
+    virtual int ReqQryTradingNotice(CThostFtdcQryTradingNoticeField *pQryTradingNotice, int nRequestID) override;
+    virtual int ReqQryBrokerTradingParams(CThostFtdcQryBrokerTradingParamsField *pQryBrokerTradingParams,
+                                          int nRequestID) override;
+    virtual int ReqQryBrokerTradingAlgos(CThostFtdcQryBrokerTradingAlgosField *pQryBrokerTradingAlgos,
+                                         int nRequestID) override;
+    virtual int ReqQueryCFMMCTradingAccountToken(CThostFtdcQueryCFMMCTradingAccountTokenField *pQueryCFMMCTradingAccountToken,
+                                                 int nRequestID) override;
+    virtual int ReqFromBankToFutureByFuture(CThostFtdcReqTransferField *pReqTransfer, int nRequestID) override;
+    virtual int ReqFromFutureToBankByFuture(CThostFtdcReqTransferField *pReqTransfer, int nRequestID) override;
+    virtual int ReqQueryBankAccountMoneyByFuture(CThostFtdcReqQueryAccountField *pReqQueryAccount,
+                                                 int nRequestID) override;
+    virtual int ReqQryClassifiedInstrument(CThostFtdcQryClassifiedInstrumentField *pQryClassifiedInstrument,
+                                           int nRequestID) override;
+    virtual int ReqQryCombPromotionParam(CThostFtdcQryCombPromotionParamField *pQryCombPromotionParam,
+                                         int nRequestID) override;
+    virtual int ReqQryRiskSettleInvstPosition(CThostFtdcQryRiskSettleInvstPositionField *pQryRiskSettleInvstPosition,
+                                              int nRequestID) override;
+    virtual int ReqQryRiskSettleProductStatus(CThostFtdcQryRiskSettleProductStatusField *pQryRiskSettleProductStatus,
+                                              int nRequestID) override;
+    virtual int ReqQrySPBMFutureParameter(CThostFtdcQrySPBMFutureParameterField *pQrySPBMFutureParameter,
+                                          int nRequestID) override;
+    virtual int ReqQrySPBMOptionParameter(CThostFtdcQrySPBMOptionParameterField *pQrySPBMOptionParameter,
+                                          int nRequestID) override;
+    virtual int ReqQrySPBMIntraParameter(CThostFtdcQrySPBMIntraParameterField *pQrySPBMIntraParameter,
+                                         int nRequestID) override;
+    virtual int ReqQrySPBMInterParameter(CThostFtdcQrySPBMInterParameterField *pQrySPBMInterParameter,
+                                         int nRequestID) override;
+    virtual int ReqQrySPBMPortfDefinition(CThostFtdcQrySPBMPortfDefinitionField *pQrySPBMPortfDefinition,
+                                          int nRequestID) override;
+    virtual int ReqQrySPBMInvestorPortfDef(CThostFtdcQrySPBMInvestorPortfDefField *pQrySPBMInvestorPortfDef,
+                                           int nRequestID) override;
+    virtual int ReqQryInvestorPortfMarginRatio(CThostFtdcQryInvestorPortfMarginRatioField *pQryInvestorPortfMarginRatio,
+                                               int nRequestID) override;
+    virtual int ReqQryInvestorProdSPBMDetail(CThostFtdcQryInvestorProdSPBMDetailField *pQryInvestorProdSPBMDetail,
+                                             int nRequestID) override;
+    virtual int ReqQryInvestorCommoditySPMMMargin(CThostFtdcQryInvestorCommoditySPMMMarginField *pQryInvestorCommoditySPMMMargin,
+                                                  int nRequestID) override;
+    virtual int ReqQryInvestorCommodityGroupSPMMMargin(CThostFtdcQryInvestorCommodityGroupSPMMMarginField *pQryInvestorCommodityGroupSPMMMargin,
+                                                       int nRequestID) override;
+    virtual int ReqQrySPMMInstParam(CThostFtdcQrySPMMInstParamField *pQrySPMMInstParam, int nRequestID) override;
+    virtual int ReqQrySPMMProductParam(CThostFtdcQrySPMMProductParamField *pQrySPMMProductParam,
+                                       int nRequestID) override;
+    virtual int ReqQrySPBMAddOnInterParameter(CThostFtdcQrySPBMAddOnInterParameterField *pQrySPBMAddOnInterParameter,
+                                              int nRequestID) override;
+    virtual int ReqQryRCAMSCombProductInfo(CThostFtdcQryRCAMSCombProductInfoField *pQryRCAMSCombProductInfo,
+                                           int nRequestID) override;
+    virtual int ReqQryRCAMSInstrParameter(CThostFtdcQryRCAMSInstrParameterField *pQryRCAMSInstrParameter,
+                                          int nRequestID) override;
+    virtual int ReqQryRCAMSIntraParameter(CThostFtdcQryRCAMSIntraParameterField *pQryRCAMSIntraParameter,
+                                          int nRequestID) override;
+    virtual int ReqQryRCAMSInterParameter(CThostFtdcQryRCAMSInterParameterField *pQryRCAMSInterParameter,
+                                          int nRequestID) override;
+    virtual int ReqQryRCAMSShortOptAdjustParam(CThostFtdcQryRCAMSShortOptAdjustParamField *pQryRCAMSShortOptAdjustParam,
+                                               int nRequestID) override;
+    virtual int ReqQryRCAMSInvestorCombPosition(CThostFtdcQryRCAMSInvestorCombPositionField *pQryRCAMSInvestorCombPosition,
+                                                int nRequestID) override;
+    virtual int ReqQryInvestorProdRCAMSMargin(CThostFtdcQryInvestorProdRCAMSMarginField *pQryInvestorProdRCAMSMargin,
+                                              int nRequestID) override;
+    virtual int ReqQryRULEInstrParameter(CThostFtdcQryRULEInstrParameterField *pQryRULEInstrParameter,
+                                         int nRequestID) override;
+    virtual int ReqQryRULEIntraParameter(CThostFtdcQryRULEIntraParameterField *pQryRULEIntraParameter,
+                                         int nRequestID) override;
+    virtual int ReqQryRULEInterParameter(CThostFtdcQryRULEInterParameterField *pQryRULEInterParameter,
+                                         int nRequestID) override;
+    virtual int ReqQryInvestorProdRULEMargin(CThostFtdcQryInvestorProdRULEMarginField *pQryInvestorProdRULEMargin,
+                                             int nRequestID) override;
+    virtual int ReqQryInvestorPortfSetting(CThostFtdcQryInvestorPortfSettingField *pQryInvestorPortfSetting,
+                                           int nRequestID) override;
+
+private:
+    ~SimTraderApi();
+
+    /// 把请求发往前置
+    template <typename T>
+    int Request(SimRequestType type, T *field, int requestId);
+
+    /// 发送不支持的请求
+    int Unsupported(int requestId);
+
+    /// 回调线程主循环
+    void CallbackLoop();
+
+    /// 按事件类型调用 SPI
+    void Dispatch(TraderEvent& ev);
+
+    std::string m_flowPath;
+    std::string m_frontAddress;
+    CThostFtdcTraderSpi* m_spi;
+    THOST_TE_RESUME_TYPE m_privateResume;
+    SimSession* m_session;
+
+    std::thread m_callbackThread;
+    std::atomic<bool> m_running;
+
+    // Join() 等待 Release()
+    std::mutex m_joinMutex;
+    std::condition_variable m_joinCond;
+    bool m_released;
+    int m_joiners;
+};
+
+#endif // CTP_TEST_SIM_TRADER_API_H
@@ -0,0 +1,107 @@
+///
+/// @file SpscQueue.h
+/// @brief 单生产者单消费者无锁环形队列
+///
+
+#ifndef CTP_TEST_SPSC_QUEUE_H
+#define CTP_TEST_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+///
+/// @brief 预分配的单生产者单消费者环形队列
+///
+/// 容量向上取整为2的幂。生产者通过 Claim()/Publish() 直接在槽位内构造数据,
+/// 避免一次额外拷贝; 消费者通过 Front()/Pop() 原地读取。
+/// 头尾索引各自独占缓存行, 并各自缓存对端索引以减少跨核读取。
+///
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : m_capacity(RoundUpPow2(capacity)), m_mask(m_capacity - 1),
+          m_slots(new T[m_capacity]()),
+          m_tail(0), m_cachedHead(0), m_head(0), m_cachedTail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /// 生产者: 获取下一个可写槽位, 队列满时返回nullptr
+    T* Claim() {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead >= m_capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead >= m_capacity) {
+                return nullptr;
+            }
+        }
+        return &m_slots[tail & m_mask];
+    }
+
+    /// 生产者: 发布 Claim() 得到的槽位
+    void Publish() {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// 生产者: 拷贝入队, 队列满时返回false
+    bool TryPush(const T& value) {
+        T* slot = Claim();
+        if (!slot) {
+            return false;
+        }
+        *slot = value;
+        Publish();
+        return true;
+    }
+
+    /// 消费者: 获取队首元素, 队列空时返回nullptr
+    T* Front() {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return nullptr;
+            }
+        }
+        return &m_slots[head & m_mask];
+    }
+
+    /// 消费者: 弹出 Front() 返回的元素
+    void Pop() {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// 当前元素个数(近似值, 任意线程可调用)
+    size_t Size() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    static size_t RoundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    // 生产者独占
+    alignas(64) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+
+    // 消费者独占
+    alignas(64) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+};
+
+#endif // CTP_TEST_SPSC_QUEUE_H
@@ -0,0 +1,85 @@
+///
+/// @file StubMdApi.h
+/// @brief 记录调用的行情API桩, 供 ctp_md_session_test 驱动 MdSession
+///
+
+#ifndef CTP_TEST_STUB_MD_API_H
+#define CTP_TEST_STUB_MD_API_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ThostFtdcMdApi.h"
+
+///
+/// @brief 行情API桩
+///
+/// 不建立连接、不启动线程: Init() 和各请求只记录参数并返回0, 由测试在自己的线程上调用
+/// Spi() 的回调, 充当CTP的行情回调线程。记录的内容只由该线程读写。
+/// 由调用方在栈上创建, Release() 不释放对象。
+///
+class StubMdApi : public CThostFtdcMdApi {
+public:
+    StubMdApi() : m_spi(nullptr), m_inits(0), m_logins(0), m_subscribeResult(0) {
+        memset(&m_lastLogin, 0, sizeof(m_lastLogin));
+    }
+
+    CThostFtdcMdSpi* Spi() const { return m_spi; }
+    const std::string& FrontAddress() const { return m_frontAddress; }
+    int Inits() const { return m_inits; }
+    int Logins() const { return m_logins; }
+    const CThostFtdcReqUserLoginField& LastLogin() const { return m_lastLogin; }
+
+    /// 每次 SubscribeMarketData 的合约数
+    const std::vector<int>& SubscribeBatches() const { return m_batches; }
+    /// 按调用顺序记录的全部订阅合约
+    const std::vector<std::string>& Subscribed() const { return m_subscribed; }
+    void ClearSubscribed() {
+        m_batches.clear();
+        m_subscribed.clear();
+    }
+
+    /// 此后 SubscribeMarketData 的返回值
+    void SetSubscribeResult(int result) { m_subscribeResult = result; }
+
+    virtual void Release() override {}
+    virtual void Init() override { ++m_inits; }
+    virtual int Join() override { return 0; }
+    virtual const char* GetTradingDay() override { return "20260101"; }
+    virtual void RegisterFront(char* pszFrontAddress) override {
+        m_frontAddress = pszFrontAddress ? pszFrontAddress : "";
+    }
+    virtual void RegisterNameServer(char*) override {}
+    virtual void RegisterFensUserInfo(CThostFtdcFensUserInfoField*) override {}
+    virtual void RegisterSpi(CThostFtdcMdSpi* pSpi) override { m_spi = pSpi; }
+    virtual int SubscribeMarketData(char* ppInstrumentID[], int nCount) override {
+        m_batches.push_back(nCount);
+        for (int i = 0; i < nCount; ++i) {
+            m_subscribed.push_back(ppInstrumentID[i]);
+        }
+        return m_subscribeResult;
+    }
+    virtual int UnSubscribeMarketData(char*[], int) override { return 0; }
+    virtual int SubscribeForQuoteRsp(char*[], int) override { return 0; }
+    virtual int UnSubscribeForQuoteRsp(char*[], int) override { return 0; }
+    virtual int ReqUserLogin(CThostFtdcReqUserLoginField* pReqUserLoginField, int) override {
+        ++m_logins;
+        m_lastLogin = *pReqUserLoginField;
+        return 0;
+    }
+    virtual int ReqUserLogout(CThostFtdcUserLogoutField*, int) override { return 0; }
+    virtual int ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField*, int) override { return 0; }
+
+private:
+    CThostFtdcMdSpi* m_spi;
+    std::string m_frontAddress;
+    int m_inits;
+    int m_logins;
+    CThostFtdcReqUserLoginField m_lastLogin;
+    std::vector<int> m_batches;
+    std::vector<std::string> m_subscribed;
+    int m_subscribeResult;
+};
+
+#endif // CTP_TEST_STUB_MD_API_H
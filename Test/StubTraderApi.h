@@ -0,0 +1,185 @@
+///
+/// @file StubTraderApi.h
+/// @brief 空操作的交易API, 只计数报单和撤单调用, 供 ctp_bench 测量发送路径本身的耗时
+///
+
+#ifndef CTP_TEST_STUB_TRADER_API_H
+#define CTP_TEST_STUB_TRADER_API_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "ThostFtdcTraderApi.h"
+
+///
+/// @brief 空操作的交易API
+///
+/// 所有请求立即返回0, 不产生回调。报单、撤单和批量撤单各计一次数, 计数为 relaxed 原子量,
+/// 可由多个报单线程同时调用。由调用方在栈上创建, Release() 不释放对象。
+/// ctp_trigger_test 派生它并重写 ReqOrderInsert() 以记录报单内容。
+///
+class StubTraderApi : public CThostFtdcTraderApi {
+public:
+    StubTraderApi() : m_orderInserts(0), m_orderActions(0), m_batchActions(0) {}
+
+    uint64_t OrderInserts() const { return m_orderInserts.load(std::memory_order_relaxed); }
+    uint64_t OrderActions() const { return m_orderActions.load(std::memory_order_relaxed); }
+    uint64_t BatchActions() const { return m_batchActions.load(std::memory_order_relaxed); }
+
+    virtual int ReqOrderInsert(CThostFtdcInputOrderField* /*pInputOrder*/, int /*nRequestID*/) override {
+        m_orderInserts.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    virtual int ReqOrderAction(CThostFtdcInputOrderActionField* /*pInputOrderAction*/, int /*nRequestID*/) override {
+        m_orderActions.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    virtual int ReqBatchOrderAction(CThostFtdcInputBatchOrderActionField* /*pInputBatchOrderAction*/,
+                                    int /*nRequestID*/) override {
+        m_batchActions.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    virtual void Release() override {}
+    virtual const char* GetTradingDay() override { return "20260101"; }
+
+    // 其余请求均为空操作
+    virtual void Init() override {}
+    virtual int Join() override { return 0; }
+    virtual void GetFrontInfo(CThostFtdcFrontInfoField*) override {}
+    virtual void RegisterFront(char*) override {}
+    virtual void RegisterNameServer(char*) override {}
+    virtual void RegisterFensUserInfo(CThostFtdcFensUserInfoField*) override {}
+    virtual void RegisterSpi(CThostFtdcTraderSpi*) override {}
+    virtual void SubscribePrivateTopic(THOST_TE_RESUME_TYPE) override {}
+    virtual void SubscribePublicTopic(THOST_TE_RESUME_TYPE) override {}
+    virtual int ReqAuthenticate(CThostFtdcReqAuthenticateField*, int) override { return 0; }
+    virtual int RegisterUserSystemInfo(CThostFtdcUserSystemInfoField*) override { return 0; }
+    virtual int SubmitUserSystemInfo(CThostFtdcUserSystemInfoField*) override { return 0; }
+    virtual int ReqUserLogin(CThostFtdcReqUserLoginField*, int) override { return 0; }
+    virtual int ReqUserLogout(CThostFtdcUserLogoutField*, int) override { return 0; }
+    virtual int ReqUserPasswordUpdate(CThostFtdcUserPasswordUpdateField*, int) override { return 0; }
+    virtual int ReqTradingAccountPasswordUpdate(CThostFtdcTradingAccountPasswordUpdateField*, int) override
+        { return 0; }
+    virtual int ReqUserAuthMethod(CThostFtdcReqUserAuthMethodField*, int) override { return 0; }
+    virtual int ReqGenUserCaptcha(CThostFtdcReqGenUserCaptchaField*, int) override { return 0; }
+    virtual int ReqGenUserText(CThostFtdcReqGenUserTextField*, int) override { return 0; }
+    virtual int ReqUserLoginWithCaptcha(CThostFtdcReqUserLoginWithCaptchaField*, int) override { return 0; }
+    virtual int ReqUserLoginWithText(CThostFtdcReqUserLoginWithTextField*, int) override { return 0; }
+    virtual int ReqUserLoginWithOTP(CThostFtdcReqUserLoginWithOTPField*, int) override { return 0; }
+    virtual int ReqParkedOrderInsert(CThostFtdcParkedOrderField*, int) override { return 0; }
+    virtual int ReqParkedOrderAction(CThostFtdcParkedOrderActionField*, int) override { return 0; }
+    virtual int ReqQryMaxOrderVolume(CThostFtdcQryMaxOrderVolumeField*, int) override { return 0; }
+    virtual int ReqSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField*, int) override { return 0; }
+    virtual int ReqRemoveParkedOrder(CThostFtdcRemoveParkedOrderField*, int) override { return 0; }
+    virtual int ReqRemoveParkedOrderAction(CThostFtdcRemoveParkedOrderActionField*, int) override { return 0; }
+    virtual int ReqExecOrderInsert(CThostFtdcInputExecOrderField*, int) override { return 0; }
+    virtual int ReqExecOrderAction(CThostFtdcInputExecOrderActionField*, int) override { return 0; }
+    virtual int ReqForQuoteInsert(CThostFtdcInputForQuoteField*, int) override { return 0; }
+    virtual int ReqQuoteInsert(CThostFtdcInputQuoteField*, int) override { return 0; }
+    virtual int ReqQuoteAction(CThostFtdcInputQuoteActionField*, int) override { return 0; }
+    virtual int ReqOptionSelfCloseInsert(CThostFtdcInputOptionSelfCloseField*, int) override { return 0; }
+    virtual int ReqOptionSelfCloseAction(CThostFtdcInputOptionSelfCloseActionField*, int) override { return 0; }
+    virtual int ReqCombActionInsert(CThostFtdcInputCombActionField*, int) override { return 0; }
+    virtual int ReqQryOrder(CThostFtdcQryOrderField*, int) override { return 0; }
+    virtual int ReqQryTrade(CThostFtdcQryTradeField*, int) override { return 0; }
+    virtual int ReqQryInvestorPosition(CThostFtdcQryInvestorPositionField*, int) override { return 0; }
+    virtual int ReqQryTradingAccount(CThostFtdcQryTradingAccountField*, int) override { return 0; }
+    virtual int ReqQryInvestor(CThostFtdcQryInvestorField*, int) override { return 0; }
+    virtual int ReqQryTradingCode(CThostFtdcQryTradingCodeField*, int) override { return 0; }
+    virtual int ReqQryInstrumentMarginRate(CThostFtdcQryInstrumentMarginRateField*, int) override { return 0; }
+    virtual int ReqQryInstrumentCommissionRate(CThostFtdcQryInstrumentCommissionRateField*, int) override
+        { return 0; }
+    virtual int ReqQryExchange(CThostFtdcQryExchangeField*, int) override { return 0; }
+    virtual int ReqQryProduct(CThostFtdcQryProductField*, int) override { return 0; }
+    virtual int ReqQryInstrument(CThostFtdcQryInstrumentField*, int) override { return 0; }
+    virtual int ReqQryDepthMarketData(CThostFtdcQryDepthMarketDataField*, int) override { return 0; }
+    virtual int ReqQryTraderOffer(CThostFtdcQryTraderOfferField*, int) override { return 0; }
+    virtual int ReqQrySettlementInfo(CThostFtdcQrySettlementInfoField*, int) override { return 0; }
+    virtual int ReqQryTransferBank(CThostFtdcQryTransferBankField*, int) override { return 0; }
+    virtual int ReqQryInvestorPositionDetail(CThostFtdcQryInvestorPositionDetailField*, int) override { return 0; }
+    virtual int ReqQryNotice(CThostFtdcQryNoticeField*, int) override { return 0; }
+    virtual int ReqQrySettlementInfoConfirm(CThostFtdcQrySettlementInfoConfirmField*, int) override { return 0; }
+    virtual int ReqQryInvestorPositionCombineDetail(CThostFtdcQryInvestorPositionCombineDetailField*, int) override
+        { return 0; }
+    virtual int ReqQryCFMMCTradingAccountKey(CThostFtdcQryCFMMCTradingAccountKeyField*, int) override { return 0; }
+    virtual int ReqQryEWarrantOffset(CThostFtdcQryEWarrantOffsetField*, int) override { return 0; }
+    virtual int ReqQryInvestorProductGroupMargin(CThostFtdcQryInvestorProductGroupMarginField*, int) override
+        { return 0; }
+    virtual int ReqQryExchangeMarginRate(CThostFtdcQryExchangeMarginRateField*, int) override { return 0; }
+    virtual int ReqQryExchangeMarginRateAdjust(CThostFtdcQryExchangeMarginRateAdjustField*, int) override
+        { return 0; }
+    virtual int ReqQryExchangeRate(CThostFtdcQryExchangeRateField*, int) override { return 0; }
+    virtual int ReqQrySecAgentACIDMap(CThostFtdcQrySecAgentACIDMapField*, int) override { return 0; }
+    virtual int ReqQryProductExchRate(CThostFtdcQryProductExchRateField*, int) override { return 0; }
+    virtual int ReqQryProductGroup(CThostFtdcQryProductGroupField*, int) override { return 0; }
+    virtual int ReqQryMMInstrumentCommissionRate(CThostFtdcQryMMInstrumentCommissionRateField*, int) override
+        { return 0; }
+    virtual int ReqQryMMOptionInstrCommRate(CThostFtdcQryMMOptionInstrCommRateField*, int) override { return 0; }
+    virtual int ReqQryInstrumentOrderCommRate(CThostFtdcQryInstrumentOrderCommRateField*, int) override { return 0; }
+    virtual int ReqQrySecAgentTradingAccount(CThostFtdcQryTradingAccountField*, int) override { return 0; }
+    virtual int ReqQrySecAgentCheckMode(CThostFtdcQrySecAgentCheckModeField*, int) override { return 0; }
+    virtual int ReqQrySecAgentTradeInfo(CThostFtdcQrySecAgentTradeInfoField*, int) override { return 0; }
+    virtual int ReqQryOptionInstrTradeCost(CThostFtdcQryOptionInstrTradeCostField*, int) override { return 0; }
+    virtual int ReqQryOptionInstrCommRate(CThostFtdcQryOptionInstrCommRateField*, int) override { return 0; }
+    virtual int ReqQryExecOrder(CThostFtdcQryExecOrderField*, int) override { return 0; }
+    virtual int ReqQryForQuote(CThostFtdcQryForQuoteField*, int) override { return 0; }
+    virtual int ReqQryQuote(CThostFtdcQryQuoteField*, int) override { return 0; }
+    virtual int ReqQryOptionSelfClose(CThostFtdcQryOptionSelfCloseField*, int) override { return 0; }
+    virtual int ReqQryInvestUnit(CThostFtdcQryInvestUnitField*, int) override { return 0; }
+    virtual int ReqQryCombInstrumentGuard(CThostFtdcQryCombInstrumentGuardField*, int) override { return 0; }
+    virtual int ReqQryCombAction(CThostFtdcQryCombActionField*, int) override { return 0; }
+    virtual int ReqQryTransferSerial(CThostFtdcQryTransferSerialField*, int) override { return 0; }
+    virtual int ReqQryAccountregister(CThostFtdcQryAccountregisterField*, int) override { return 0; }
+    virtual int ReqQryContractBank(CThostFtdcQryContractBankField*, int) override { return 0; }
+    virtual int ReqQryParkedOrder(CThostFtdcQryParkedOrderField*, int) override { return 0; }
+    virtual int ReqQryParkedOrderAction(CThostFtdcQryParkedOrderActionField*, int) override { return 0; }
+    virtual int ReqQryTradingNotice(CThostFtdcQryTradingNoticeField*, int) override { return 0; }
+    virtual int ReqQryBrokerTradingParams(CThostFtdcQryBrokerTradingParamsField*, int) override { return 0; }
+    virtual int ReqQryBrokerTradingAlgos(CThostFtdcQryBrokerTradingAlgosField*, int) override { return 0; }
+    virtual int ReqQueryCFMMCTradingAccountToken(CThostFtdcQueryCFMMCTradingAccountTokenField*, int) override
+        { return 0; }
+    virtual int ReqFromBankToFutureByFuture(CThostFtdcReqTransferField*, int) override { return 0; }
+    virtual int ReqFromFutureToBankByFuture(CThostFtdcReqTransferField*, int) override { return 0; }
+    virtual int ReqQueryBankAccountMoneyByFuture(CThostFtdcReqQueryAccountField*, int) override { return 0; }
+    virtual int ReqQryClassifiedInstrument(CThostFtdcQryClassifiedInstrumentField*, int) override { return 0; }
+    virtual int ReqQryCombPromotionParam(CThostFtdcQryCombPromotionParamField*, int) override { return 0; }
+    virtual int ReqQryRiskSettleInvstPosition(CThostFtdcQryRiskSettleInvstPositionField*, int) override { return 0; }
+    virtual int ReqQryRiskSettleProductStatus(CThostFtdcQryRiskSettleProductStatusField*, int) override { return 0; }
+    virtual int ReqQrySPBMFutureParameter(CThostFtdcQrySPBMFutureParameterField*, int) override { return 0; }
+    virtual int ReqQrySPBMOptionParameter(CThostFtdcQrySPBMOptionParameterField*, int) override { return 0; }
+    virtual int ReqQrySPBMIntraParameter(CThostFtdcQrySPBMIntraParameterField*, int) override { return 0; }
+    virtual int ReqQrySPBMInterParameter(CThostFtdcQrySPBMInterParameterField*, int) override { return 0; }
+    virtual int ReqQrySPBMPortfDefinition(CThostFtdcQrySPBMPortfDefinitionField*, int) override { return 0; }
+    virtual int ReqQrySPBMInvestorPortfDef(CThostFtdcQrySPBMInvestorPortfDefField*, int) override { return 0; }
+    virtual int ReqQryInvestorPortfMarginRatio(CThostFtdcQryInvestorPortfMarginRatioField*, int) override
+        { return 0; }
+    virtual int ReqQryInvestorProdSPBMDetail(CThostFtdcQryInvestorProdSPBMDetailField*, int) override { return 0; }
+    virtual int ReqQryInvestorCommoditySPMMMargin(CThostFtdcQryInvestorCommoditySPMMMarginField*, int) override
+        { return 0; }
+    virtual int ReqQryInvestorCommodityGroupSPMMMargin(CThostFtdcQryInvestorCommodityGroupSPMMMarginField*, int) override
+        { return 0; }
+    virtual int ReqQrySPMMInstParam(CThostFtdcQrySPMMInstParamField*, int) override { return 0; }
+    virtual int ReqQrySPMMProductParam(CThostFtdcQrySPMMProductParamField*, int) override { return 0; }
+    virtual int ReqQrySPBMAddOnInterParameter(CThostFtdcQrySPBMAddOnInterParameterField*, int) override { return 0; }
+    virtual int ReqQryRCAMSCombProductInfo(CThostFtdcQryRCAMSCombProductInfoField*, int) override { return 0; }
+    virtual int ReqQryRCAMSInstrParameter(CThostFtdcQryRCAMSInstrParameterField*, int) override { return 0; }
+    virtual int ReqQryRCAMSIntraParameter(CThostFtdcQryRCAMSIntraParameterField*, int) override { return 0; }
+    virtual int ReqQryRCAMSInterParameter(CThostFtdcQryRCAMSInterParameterField*, int) override { return 0; }
+    virtual int ReqQryRCAMSShortOptAdjustParam(CThostFtdcQryRCAMSShortOptAdjustParamField*, int) override
+        { return 0; }
+    virtual int ReqQryRCAMSInvestorCombPosition(CThostFtdcQryRCAMSInvestorCombPositionField*, int) override
+        { return 0; }
+    virtual int ReqQryInvestorProdRCAMSMargin(CThostFtdcQryInvestorProdRCAMSMarginField*, int) override { return 0; }
+    virtual int ReqQryRULEInstrParameter(CThostFtdcQryRULEInstrParameterField*, int) override { return 0; }
+    virtual int ReqQryRULEIntraParameter(CThostFtdcQryRULEIntraParameterField*, int) override { return 0; }
+    virtual int ReqQryRULEInterParameter(CThostFtdcQryRULEInterParameterField*, int) override { return 0; }
+    virtual int ReqQryInvestorProdRULEMargin(CThostFtdcQryInvestorProdRULEMarginField*, int) override { return 0; }
+    virtual int ReqQryInvestorPortfSetting(CThostFtdcQryInvestorPortfSettingField*, int) override { return 0; }
+
+private:
+    std::atomic<uint64_t> m_orderInserts;
+    std::atomic<uint64_t> m_orderActions;
+    std::atomic<uint64_t> m_batchActions;
+};
+
+#endif // CTP_TEST_STUB_TRADER_API_H
@@ -0,0 +1,47 @@
+///
+/// @file SymbolTable.cpp
+/// @brief 合约代码驻留表实现
+///
+
+#include "SymbolTable.h"
+
+SymbolTable::SymbolTable(size_t capacity)
+    : m_capacity(capacity), m_slotMask(0), m_size(0) {
+    // 槽位数取不小于容量两倍的2的幂, 装载因子不超过0.5
+    size_t slots = 16;
+    while (slots < capacity * 2) {
+        slots <<= 1;
+    }
+    m_slotMask = static_cast<uint32_t>(slots - 1);
+    m_slotIds.reset(new std::atomic<uint32_t>[slots]);
+    for (size_t i = 0; i < slots; ++i) {
+        m_slotIds[i].store(0, std::memory_order_relaxed);
+    }
+    m_names.reset(new Key[capacity]);
+}
+
+uint32_t SymbolTable::InternSlow(const Key& key) {
+    std::lock_guard<std::mutex> lock(m_insertMutex);
+
+    // 持锁后重新探测: 其他线程可能已插入同一合约
+    uint32_t slot = HashKey(key) & m_slotMask;
+    while (true) {
+        const uint32_t tag = m_slotIds[slot].load(std::memory_order_relaxed);
+        if (tag == 0) {
+            break;
+        }
+        if (KeyEquals(m_names[tag - 1], key)) {
+            return tag - 1;
+        }
+        slot = (slot + 1) & m_slotMask;
+    }
+
+    const uint32_t id = m_size.load(std::memory_order_relaxed);
+    if (id >= m_capacity) {
+        return kInvalidSymbol;
+    }
+    m_names[id] = key;
+    m_size.store(id + 1, std::memory_order_release);
+    m_slotIds[slot].store(id + 1, std::memory_order_release);
+    return id;
+}
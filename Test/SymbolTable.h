@@ -0,0 +1,184 @@
+///
+/// @file SymbolTable.h
+/// @brief 合约代码驻留表, 为每个合约分配稠密的 uint32_t 编号
+///
+
+#ifndef CTP_TEST_SYMBOL_TABLE_H
+#define CTP_TEST_SYMBOL_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ThostFtdcUserApiDataType.h"
+
+/// 无效编号
+const uint32_t kInvalidSymbol = 0xFFFFFFFFu;
+
+///
+/// @brief 合约代码驻留表
+///
+/// 合约代码第一次出现时分配编号, 编号从0开始连续递增, 订单簿、持仓、报单等
+/// 内部表可以直接用编号作为数组下标, 不再以81字节的合约代码做键。
+///
+/// 合约代码统一规整为32字节、末尾补零的定长键, 查找时对键做一次哈希, 在开放寻址
+/// 表中线性探测, 每次比较是两条16字节SSE比较。查找不加锁: 槽位先写键再以 release
+/// 语义发布编号, 读方以 acquire 语义读到编号后键必然可见; 插入由互斥锁串行化。
+/// 槽位和名称数组在构造时一次分配, 不会扩容, 超出容量时 Intern() 返回 kInvalidSymbol。
+///
+/// 超过31字节的合约代码(实际不存在)不予驻留。
+///
+class SymbolTable {
+public:
+    /// 最长合约代码长度
+    static const size_t kMaxSymbolLength = 31;
+
+    /// @param capacity 最多可驻留的合约数
+    explicit SymbolTable(size_t capacity = 65536);
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    /// 查找合约编号, 未驻留时返回 kInvalidSymbol; 可在任意线程调用
+    uint32_t Find(const TThostFtdcInstrumentIDType& instrumentId) const {
+        Key key;
+        if (!MakeFieldKey(instrumentId, key)) {
+            return kInvalidSymbol;
+        }
+        return FindKey(key);
+    }
+
+    uint32_t Find(const std::string& instrumentId) const {
+        Key key;
+        if (!MakeKey(instrumentId.c_str(), key)) {
+            return kInvalidSymbol;
+        }
+        return FindKey(key);
+    }
+
+    /// 查找合约编号, 未驻留时分配新编号; 可在任意线程调用
+    uint32_t Intern(const TThostFtdcInstrumentIDType& instrumentId) {
+        Key key;
+        if (!MakeFieldKey(instrumentId, key)) {
+            return kInvalidSymbol;
+        }
+        const uint32_t id = FindKey(key);
+        return id != kInvalidSymbol ? id : InternSlow(key);
+    }
+
+    uint32_t Intern(const std::string& instrumentId) {
+        Key key;
+        if (!MakeKey(instrumentId.c_str(), key)) {
+            return kInvalidSymbol;
+        }
+        const uint32_t id = FindKey(key);
+        return id != kInvalidSymbol ? id : InternSlow(key);
+    }
+
+    /// 编号对应的合约代码, id < Size()
+    const char* Name(uint32_t id) const { return m_names[id].bytes; }
+
+    /// 已驻留的合约数, 编号范围为 [0, Size())
+    uint32_t Size() const { return m_size.load(std::memory_order_acquire); }
+
+    /// 容量
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    /// 32字节定长键, 合约代码之后全部为0
+    struct Key {
+        alignas(16) char bytes[32];
+    };
+
+    /// 把CTP结构体中的合约代码规整为定长键
+    static bool MakeFieldKey(const TThostFtdcInstrumentIDType& id, Key& key) {
+#if defined(__SSE2__)
+        // 数组长度81, 可以直接读取前32字节, 再用掩码清除第一个'\0'及之后的残留数据
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(id));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(id + 16));
+        const uint32_t nulMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, zero))) |
+                                 (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, zero))) << 16);
+        if (nulMask == 0) {
+            return false;   // 超过31字节
+        }
+        const __m128i length = _mm_set1_epi8(static_cast<char>(__builtin_ctz(nulMask)));
+        const __m128i indexLo = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m128i indexHi = _mm_setr_epi8(16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+        _mm_store_si128(reinterpret_cast<__m128i*>(key.bytes),
+                        _mm_and_si128(lo, _mm_cmplt_epi8(indexLo, length)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(key.bytes + 16),
+                        _mm_and_si128(hi, _mm_cmplt_epi8(indexHi, length)));
+        return true;
+#else
+        return MakeKey(id, key);
+#endif
+    }
+
+    /// 把以'\0'结尾的合约代码规整为定长键
+    static bool MakeKey(const char* id, Key& key) {
+        const size_t length = strnlen(id, sizeof(Key));
+        if (length > kMaxSymbolLength) {
+            return false;
+        }
+        memset(key.bytes, 0, sizeof(Key));
+        memcpy(key.bytes, id, length);
+        return true;
+    }
+
+    static bool KeyEquals(const Key& a, const Key& b) {
+#if defined(__SSE2__)
+        const __m128i lo = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(a.bytes)),
+                                          _mm_load_si128(reinterpret_cast<const __m128i*>(b.bytes)));
+        const __m128i hi = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(a.bytes + 16)),
+                                          _mm_load_si128(reinterpret_cast<const __m128i*>(b.bytes + 16)));
+        return _mm_movemask_epi8(_mm_and_si128(lo, hi)) == 0xFFFF;
+#else
+        return memcmp(a.bytes, b.bytes, sizeof(Key)) == 0;
+#endif
+    }
+
+    static uint32_t HashKey(const Key& key) {
+        uint64_t words[4];
+        memcpy(words, key.bytes, sizeof(words));
+        uint64_t h = (words[0] ^ (words[1] * 0x9E3779B97F4A7C15ull)) ^
+                     ((words[2] ^ words[3]) * 0xC2B2AE3D27D4EB4Full);
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 32;
+        return static_cast<uint32_t>(h);
+    }
+
+    uint32_t FindKey(const Key& key) const {
+        uint32_t slot = HashKey(key) & m_slotMask;
+        while (true) {
+            const uint32_t tag = m_slotIds[slot].load(std::memory_order_acquire);
+            if (tag == 0) {
+                return kInvalidSymbol;
+            }
+            if (KeyEquals(m_names[tag - 1], key)) {
+                return tag - 1;
+            }
+            slot = (slot + 1) & m_slotMask;
+        }
+    }
+
+    uint32_t InternSlow(const Key& key);
+
+    const size_t m_capacity;
+    uint32_t m_slotMask;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_slotIds;    ///< 槽位存放编号+1, 0表示空
+    std::unique_ptr<Key[]> m_names;                         ///< 按编号存放的键
+    std::atomic<uint32_t> m_size;
+    std::mutex m_insertMutex;
+};
+
+#endif // CTP_TEST_SYMBOL_TABLE_H
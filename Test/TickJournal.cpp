@@ -0,0 +1,237 @@
+///
+/// @file TickJournal.cpp
+/// @brief 深度行情落盘日志实现
+///
+
+#include "TickJournal.h"
+
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+
+namespace {
+
+const size_t kHeaderBytes = 128;
+const size_t kPageBytes = 4096;
+
+// 维护线程在写入位置之前提前触碰的字节数, 打开分段时同步触碰同样大小
+const size_t kPrefaultAheadBytes = 16u << 20;
+
+// 维护线程的检查周期
+const std::chrono::milliseconds kMaintenanceInterval(1);
+
+static_assert(sizeof(TickJournalHeader) == kHeaderBytes, "TickJournalHeader must be 128 bytes");
+
+int64_t RealtimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+} // namespace
+
+TickJournal::TickJournal(const std::string& dir, size_t segmentBytes)
+    : m_dir(dir), m_segmentBytes(segmentBytes), m_current(nullptr), m_next(nullptr), m_retired(nullptr),
+      m_written(0), m_dropped(0), m_running(false), m_nextIndex(0) {
+    if (!m_dir.empty() && m_dir[m_dir.size() - 1] != '/') {
+        m_dir += '/';
+    }
+}
+
+TickJournal::~TickJournal() {
+    Stop();
+}
+
+void TickJournal::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_thread = std::thread(&TickJournal::MaintenanceLoop, this);
+}
+
+void TickJournal::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cond.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CloseSegment(m_retired.exchange(nullptr));
+    CloseSegment(m_next.exchange(nullptr));
+    CloseSegment(m_current.exchange(nullptr));
+}
+
+bool TickJournal::Open(const std::string& tradingDay) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_current.load(std::memory_order_relaxed) && tradingDay == m_tradingDay) {
+        return true;
+    }
+
+    // 交易日切换: 关闭旧交易日的全部分段
+    CloseSegment(m_retired.exchange(nullptr));
+    CloseSegment(m_next.exchange(nullptr));
+    CloseSegment(m_current.exchange(nullptr));
+
+    m_tradingDay = tradingDay;
+    m_nextIndex = NextSegmentIndex(tradingDay);
+    Segment* segment = CreateSegment(tradingDay, m_nextIndex++);
+    if (!segment) {
+        return false;
+    }
+    m_current.store(segment, std::memory_order_release);
+    LOG("[行情] 行情日志: {}, 每个分段可容纳 {} 条", segment->path, segment->header->capacity);
+    return true;
+}
+
+TickJournal::Segment* TickJournal::SwitchSegment() {
+    Segment* next = m_next.exchange(nullptr, std::memory_order_acq_rel);
+    if (!next) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Segment* old = m_current.load(std::memory_order_relaxed);
+    m_current.store(next, std::memory_order_release);
+    // 维护线程只在 m_retired 为空时才创建下一分段, 因此这里不会覆盖未回收的分段;
+    // 不唤醒维护线程(唤醒是一次系统调用), 由它在下一个周期回收
+    m_retired.store(old, std::memory_order_release);
+    return next;
+}
+
+TickJournal::Segment* TickJournal::CreateSegment(const std::string& tradingDay, uint32_t index) {
+    mkdir(m_dir.c_str(), 0755);
+    char name[64];
+    snprintf(name, sizeof(name), "ticks_%s_%03u.dat", tradingDay.c_str(), index);
+    const std::string path = m_dir + name;
+
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG("[错误] 无法创建行情日志 {}", path);
+        return nullptr;
+    }
+    // 预分配磁盘空间, 写入时不再分配块; 文件系统不支持时退化为稀疏文件
+    if (fallocate(fd, 0, 0, static_cast<off_t>(m_segmentBytes)) != 0 &&
+        ftruncate(fd, static_cast<off_t>(m_segmentBytes)) != 0) {
+        LOG("[错误] 无法为行情日志 {} 分配空间", path);
+        close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+    void* base = mmap(nullptr, m_segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        LOG("[错误] 无法映射行情日志 {}", path);
+        close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+
+    Segment* segment = new Segment;
+    segment->header = static_cast<TickJournalHeader*>(base);
+    segment->records = reinterpret_cast<TickRecord*>(static_cast<char*>(base) + kHeaderBytes);
+    segment->mappedBytes = m_segmentBytes;
+    segment->prefaultedBytes = 0;
+    segment->fd = fd;
+    segment->path = path;
+
+    TickJournalHeader* header = segment->header;
+    memcpy(header->magic, kTickJournalMagic, sizeof(kTickJournalMagic));
+    header->version = kTickJournalVersion;
+    header->recordSize = sizeof(TickRecord);
+    header->capacity = (m_segmentBytes - kHeaderBytes) / sizeof(TickRecord);
+    memset(header->tradingDay, 0, sizeof(header->tradingDay));
+    strncpy(header->tradingDay, tradingDay.c_str(), sizeof(header->tradingDay) - 1);
+    header->segment = index;
+    header->reserved = 0;
+    header->monotonicBaseNs = MonotonicNs();
+    header->realtimeBaseNs = RealtimeNs();
+    header->count.store(0, std::memory_order_release);
+
+    Prefault(segment, kPrefaultAheadBytes);
+    return segment;
+}
+
+void TickJournal::CloseSegment(Segment* segment) {
+    if (!segment) {
+        return;
+    }
+    const uint64_t count = segment->header->count.load(std::memory_order_acquire);
+    munmap(segment->header, segment->mappedBytes);
+    if (count == 0) {
+        unlink(segment->path.c_str());
+    } else if (ftruncate(segment->fd, static_cast<off_t>(kHeaderBytes + count * sizeof(TickRecord))) != 0) {
+        LOG("[警告] 截断行情日志 {} 失败", segment->path);
+    }
+    close(segment->fd);
+    delete segment;
+}
+
+void TickJournal::Prefault(Segment* segment, size_t limit) {
+    if (limit > segment->mappedBytes) {
+        limit = segment->mappedBytes;
+    }
+    char* base = reinterpret_cast<char*>(segment->header);
+    for (size_t offset = segment->prefaultedBytes; offset < limit; offset += kPageBytes) {
+        // 对页首8字节做 0->0 的比较交换: 页面被写方写过时比较失败、不写入,
+        // 否则写回原值; 两种情况都不改变内容, 但都会让页面以可写方式映射
+        uint64_t expected = 0;
+        __atomic_compare_exchange_n(reinterpret_cast<uint64_t*>(base + offset), &expected, 0, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    if (limit > segment->prefaultedBytes) {
+        segment->prefaultedBytes = (limit + kPageBytes - 1) / kPageBytes * kPageBytes;
+    }
+}
+
+uint32_t TickJournal::NextSegmentIndex(const std::string& tradingDay) const {
+    uint32_t next = 0;
+    DIR* dir = opendir(m_dir.c_str());
+    if (!dir) {
+        return next;
+    }
+    const std::string prefix = "ticks_" + tradingDay + "_";
+    while (struct dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            const uint32_t index = static_cast<uint32_t>(strtoul(name.c_str() + prefix.size(), nullptr, 10));
+            if (index + 1 > next) {
+                next = index + 1;
+            }
+        }
+    }
+    closedir(dir);
+    return next;
+}
+
+void TickJournal::MaintenanceLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        CloseSegment(m_retired.exchange(nullptr, std::memory_order_acq_rel));
+
+        Segment* current = m_current.load(std::memory_order_acquire);
+        if (current) {
+            const size_t used = kHeaderBytes +
+                                current->header->count.load(std::memory_order_acquire) * sizeof(TickRecord);
+            Prefault(current, used + kPrefaultAheadBytes);
+
+            // 用过一半后准备下一分段
+            if (used > current->mappedBytes / 2 && !m_next.load(std::memory_order_acquire) &&
+                !m_retired.load(std::memory_order_acquire)) {
+                Segment* next = CreateSegment(m_tradingDay, m_nextIndex++);
+                m_next.store(next, std::memory_order_release);
+            }
+        }
+        m_cond.wait_for(lock, kMaintenanceInterval);
+    }
+}
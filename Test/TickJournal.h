@@ -0,0 +1,157 @@
+///
+/// @file TickJournal.h
+/// @brief 深度行情落盘日志: 预分配、内存映射、只追加, 按交易日分文件
+///
+
+#ifndef CTP_TEST_TICK_JOURNAL_H
+#define CTP_TEST_TICK_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ThostFtdcUserApiStruct.h"
+
+/// 日志文件魔数和格式版本, 读方据此校验文件
+const char kTickJournalMagic[8] = {'C', 'T', 'P', 'T', 'I', 'C', 'K', '1'};
+const uint32_t kTickJournalVersion = 1;
+
+///
+/// @brief 日志中的一条行情记录
+///
+struct TickRecord {
+    int64_t recvNs;             ///< 本地接收时刻(单调时钟), 可用文件头的时钟基准换算为墙上时间
+    CThostFtdcDepthMarketDataField data;
+};
+
+///
+/// @brief 日志文件头, 占文件开头128字节, 记录数单独占一条缓存行
+///
+/// count 为已提交的记录数, 写方每写完一条记录以 release 语义更新, 其他进程
+/// 映射同一文件后以 acquire 语义读取即可安全读取前 count 条记录。
+///
+struct TickJournalHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;        ///< sizeof(TickRecord)
+    uint64_t capacity;          ///< 本文件可容纳的记录数
+    char tradingDay[16];
+    uint32_t segment;           ///< 同一交易日内的分段序号, 从0开始
+    uint32_t reserved;
+    int64_t monotonicBaseNs;    ///< 创建文件时的单调时钟
+    int64_t realtimeBaseNs;     ///< 创建文件时的墙上时钟(UTC纳秒)
+    alignas(64) std::atomic<uint64_t> count;
+};
+
+///
+/// @brief 深度行情落盘日志
+///
+/// 文件名为 <dir>/ticks_<交易日>_<分段>.dat, 每个分段创建时用 fallocate 预分配
+/// segmentBytes 字节并整体映射。Append() 只做一次 memcpy 和一次原子写, 不做系统调用、
+/// 不分配内存, 可以直接在CTP行情回调线程中调用。
+///
+/// 后台维护线程负责: 在写入位置之前提前触碰页面, 避免写方触发缺页; 当前分段用过一半后
+/// 预先创建下一个分段, 写满时写方原子地切换过去; 回收写满的分段并截断到实际长度。
+/// 下一个分段尚未就绪时写方丢弃行情并计数, 绝不等待。
+///
+/// Open()/Append() 只能由同一个线程(行情回调线程)调用。
+///
+class TickJournal {
+public:
+    /// @param dir          日志目录
+    /// @param segmentBytes 每个分段文件的预分配大小
+    explicit TickJournal(const std::string& dir, size_t segmentBytes = 256u << 20);
+    ~TickJournal();
+
+    TickJournal(const TickJournal&) = delete;
+    TickJournal& operator=(const TickJournal&) = delete;
+
+    /// 启动维护线程
+    void Start();
+
+    /// 停止维护线程, 截断并关闭当前分段
+    void Stop();
+
+    /// 按交易日打开新分段; 交易日与当前相同时直接返回true。仅由写线程调用
+    bool Open(const std::string& tradingDay);
+
+    /// 追加一条行情, 未打开或下一分段未就绪时丢弃并返回false。仅由写线程调用
+    bool Append(int64_t recvNs, const CThostFtdcDepthMarketDataField& data) {
+        Segment* segment = m_current.load(std::memory_order_relaxed);
+        if (!segment) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint64_t count = segment->header->count.load(std::memory_order_relaxed);
+        if (count == segment->header->capacity) {
+            segment = SwitchSegment();
+            if (!segment) {
+                return false;
+            }
+            count = 0;
+        }
+        TickRecord* record = segment->records + count;
+        record->recvNs = recvNs;
+        record->data = data;
+        segment->header->count.store(count + 1, std::memory_order_release);
+        m_written.store(m_written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// 已写入的记录数
+    uint64_t Written() const { return m_written.load(std::memory_order_relaxed); }
+
+    /// 丢弃的记录数
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Segment {
+        TickJournalHeader* header;
+        TickRecord* records;
+        size_t mappedBytes;
+        size_t prefaultedBytes;     ///< 维护线程已触碰的字节数
+        int fd;
+        std::string path;
+    };
+
+    /// 写满时切换到预先创建的下一分段, 未就绪时丢弃
+    Segment* SwitchSegment();
+
+    /// 创建并映射分段文件
+    Segment* CreateSegment(const std::string& tradingDay, uint32_t index);
+
+    /// 截断到实际长度并解除映射
+    void CloseSegment(Segment* segment);
+
+    /// 触碰 segment 中 [prefaultedBytes, limit) 范围的页面
+    void Prefault(Segment* segment, size_t limit);
+
+    /// 同一交易日已存在的最大分段序号+1
+    uint32_t NextSegmentIndex(const std::string& tradingDay) const;
+
+    void MaintenanceLoop();
+
+    std::string m_dir;
+    const size_t m_segmentBytes;
+
+    // 写线程与维护线程共享
+    std::atomic<Segment*> m_current;
+    std::atomic<Segment*> m_next;       ///< 维护线程创建, 写线程取走
+    std::atomic<Segment*> m_retired;    ///< 写线程放入, 维护线程回收
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_dropped;
+
+    // 以下由 m_mutex 保护
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    bool m_running;
+    std::string m_tradingDay;
+    uint32_t m_nextIndex;
+};
+
+#endif // CTP_TEST_TICK_JOURNAL_H
@@ -0,0 +1,367 @@
+///
+/// @file TradeSnapshot.cpp
+/// @brief 报单/成交本地快照实现
+///
+
+#include "TradeSnapshot.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+const char kMagic[8] = {'C', 'T', 'P', 'S', 'N', 'A', 'P', '1'};
+const uint32_t kVersion = 1;
+
+const uint32_t kRecordOrder = 1;
+const uint32_t kRecordTrade = 2;
+
+// 记录数超过 状态数 * kCompactRatio + kCompactSlack 时在打开时压缩
+const size_t kCompactRatio = 2;
+const size_t kCompactSlack = 1024;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t orderSize;     ///< sizeof(CThostFtdcOrderField), API版本变化时快照作废
+    uint32_t tradeSize;     ///< sizeof(CThostFtdcTradeField)
+    uint32_t clean;         ///< 1表示上次正常关闭
+    char tradingDay[16];
+};
+
+struct RecordHeader {
+    uint32_t type;
+    uint32_t size;
+};
+
+bool IsTerminal(char status) {
+    return status == THOST_FTDC_OST_AllTraded || status == THOST_FTDC_OST_Canceled ||
+           status == THOST_FTDC_OST_PartTradedNotQueueing || status == THOST_FTDC_OST_NoTradeNotQueueing;
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string TradeKey(const CThostFtdcTradeField& trade) {
+    char key[64];
+    snprintf(key, sizeof(key), "%.*s:%.*s:%c",
+             static_cast<int>(sizeof(trade.ExchangeID)), trade.ExchangeID,
+             static_cast<int>(sizeof(trade.TradeID)), trade.TradeID, trade.Direction);
+    return key;
+}
+
+TradeSnapshot::TradeSnapshot(const std::string& dir)
+    : m_dir(dir), m_fd(-1), m_records(0) {
+    if (!m_dir.empty() && m_dir[m_dir.size() - 1] != '/') {
+        m_dir += '/';
+    }
+}
+
+TradeSnapshot::~TradeSnapshot() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+std::string TradeSnapshot::PathFor(const std::string& tradingDay) const {
+    return m_dir + "snapshot_" + tradingDay + ".dat";
+}
+
+void TradeSnapshot::Reset() {
+    m_orders.clear();
+    m_orderIndex.clear();
+    m_trades.clear();
+    m_tradeKeys.clear();
+    m_records = 0;
+}
+
+bool TradeSnapshot::LoadLatest() {
+    DIR* dir = opendir(m_dir.c_str());
+    if (!dir) {
+        return false;
+    }
+    // 文件名中的交易日为YYYYMMDD, 按字符串比较即为按日期比较
+    std::string latest;
+    while (struct dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() == 21 && name.compare(0, 9, "snapshot_") == 0 &&
+            name.compare(17, 4, ".dat") == 0 && name > latest) {
+            latest = name;
+        }
+    }
+    closedir(dir);
+    if (latest.empty()) {
+        return false;
+    }
+
+    Reset();
+    bool clean = false;
+    if (!Load(m_dir + latest, clean)) {
+        Reset();
+        m_tradingDay.clear();
+        return false;
+    }
+    LOG("[快照] 加载交易日 {} 的快照: 报单 {} 笔, 成交 {} 笔{}", m_tradingDay, m_orders.size(),
+        m_trades.size(), (clean ? "" : ", 上次未正常退出"));
+    return clean;
+}
+
+bool TradeSnapshot::Load(const std::string& path, bool& clean) {
+    const int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+
+    std::vector<char> buffer(static_cast<size_t>(st.st_size));
+    size_t total = 0;
+    while (total < buffer.size()) {
+        const ssize_t n = read(fd, &buffer[total], buffer.size() - total);
+        if (n <= 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+    }
+
+    FileHeader header;
+    memcpy(&header, &buffer[0], sizeof(header));
+    if (total != buffer.size() || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.orderSize != sizeof(CThostFtdcOrderField) ||
+        header.tradeSize != sizeof(CThostFtdcTradeField)) {
+        LOG("[警告] 快照文件 {} 格式不匹配, 忽略", path);
+        close(fd);
+        return false;
+    }
+    header.tradingDay[sizeof(header.tradingDay) - 1] = '\0';
+    m_tradingDay = header.tradingDay;
+    clean = header.clean == 1;
+
+    size_t offset = sizeof(FileHeader);
+    while (offset + sizeof(RecordHeader) <= total) {
+        RecordHeader record;
+        memcpy(&record, &buffer[offset], sizeof(record));
+        const size_t end = offset + sizeof(RecordHeader) + record.size;
+        if (end > total) {
+            break;
+        }
+        const char* payload = &buffer[offset + sizeof(RecordHeader)];
+        if (record.type == kRecordOrder && record.size == sizeof(CThostFtdcOrderField)) {
+            CThostFtdcOrderField order;
+            memcpy(&order, payload, sizeof(order));
+            MergeOrder(order);
+        } else if (record.type == kRecordTrade && record.size == sizeof(CThostFtdcTradeField)) {
+            CThostFtdcTradeField trade;
+            memcpy(&trade, payload, sizeof(trade));
+            MergeTrade(trade);
+        } else {
+            break;
+        }
+        ++m_records;
+        offset = end;
+    }
+
+    if (offset != total) {
+        // 进程在写记录时退出, 丢弃末尾不完整的记录
+        LOG("[警告] 快照文件 {} 末尾有 {} 字节不完整记录, 已截断", path, total - offset);
+        if (ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            clean = false;
+        }
+    }
+    close(fd);
+    return true;
+}
+
+bool TradeSnapshot::Open(const std::string& tradingDay) {
+    if (m_fd >= 0) {
+        if (tradingDay == m_tradingDay) {
+            return true;    // 断线重连后再次登录
+        }
+        close(m_fd);
+        m_fd = -1;
+    }
+
+    if (tradingDay != m_tradingDay) {
+        // 新交易日, 或未加载快照(强制重传): 从空状态开始
+        Reset();
+        m_tradingDay = tradingDay;
+        if (!Rewrite(false)) {
+            return false;
+        }
+    } else if (m_records > (m_orders.size() + m_trades.size()) * kCompactRatio + kCompactSlack) {
+        if (!Rewrite(false)) {
+            return false;
+        }
+    }
+    return OpenForAppend();
+}
+
+void TradeSnapshot::Close() {
+    if (m_fd < 0) {
+        return;
+    }
+    close(m_fd);
+    m_fd = -1;
+    if (Rewrite(true)) {
+        LOG("[快照] 已保存交易日 {} 的快照: 报单 {} 笔, 成交 {} 笔", m_tradingDay, m_orders.size(),
+            m_trades.size());
+    }
+}
+
+bool TradeSnapshot::Rewrite(bool clean) {
+    mkdir(m_dir.c_str(), 0755);
+
+    const std::string path = PathFor(m_tradingDay);
+    const std::string tmpPath = path + ".tmp";
+    const int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG("[错误] 无法创建快照文件 {}", tmpPath);
+        return false;
+    }
+
+    std::vector<char> buffer;
+    buffer.reserve(sizeof(FileHeader) +
+                   m_orders.size() * (sizeof(RecordHeader) + sizeof(CThostFtdcOrderField)) +
+                   m_trades.size() * (sizeof(RecordHeader) + sizeof(CThostFtdcTradeField)));
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.orderSize = sizeof(CThostFtdcOrderField);
+    header.tradeSize = sizeof(CThostFtdcTradeField);
+    header.clean = clean ? 1 : 0;
+    strncpy(header.tradingDay, m_tradingDay.c_str(), sizeof(header.tradingDay) - 1);
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&header),
+                  reinterpret_cast<const char*>(&header) + sizeof(header));
+
+    for (size_t i = 0; i < m_orders.size(); ++i) {
+        const RecordHeader record = {kRecordOrder, sizeof(CThostFtdcOrderField)};
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&record),
+                      reinterpret_cast<const char*>(&record) + sizeof(record));
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&m_orders[i]),
+                      reinterpret_cast<const char*>(&m_orders[i]) + sizeof(CThostFtdcOrderField));
+    }
+    for (size_t i = 0; i < m_trades.size(); ++i) {
+        const RecordHeader record = {kRecordTrade, sizeof(CThostFtdcTradeField)};
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&record),
+                      reinterpret_cast<const char*>(&record) + sizeof(record));
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&m_trades[i]),
+                      reinterpret_cast<const char*>(&m_trades[i]) + sizeof(CThostFtdcTradeField));
+    }
+
+    const bool ok = WriteAll(fd, &buffer[0], buffer.size()) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOG("[错误] 写入快照文件 {} 失败", path);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    m_records = m_orders.size() + m_trades.size();
+    return true;
+}
+
+bool TradeSnapshot::OpenForAppend() {
+    const std::string path = PathFor(m_tradingDay);
+    m_fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        LOG("[错误] 无法打开快照文件 {}", path);
+        return false;
+    }
+    // 运行期间标记为未正常关闭, 异常退出后下次启动改用完整重传
+    const uint32_t clean = 0;
+    if (pwrite(m_fd, &clean, sizeof(clean), offsetof(FileHeader, clean)) != sizeof(clean) ||
+        fdatasync(m_fd) != 0 || lseek(m_fd, 0, SEEK_END) < 0) {
+        LOG("[错误] 无法写入快照文件 {}", path);
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool TradeSnapshot::ApplyOrder(const CThostFtdcOrderField& order) {
+    if (!MergeOrder(order)) {
+        return false;
+    }
+    Append(kRecordOrder, &order, sizeof(order));
+    return true;
+}
+
+bool TradeSnapshot::ApplyTrade(const CThostFtdcTradeField& trade) {
+    if (!MergeTrade(trade)) {
+        return false;
+    }
+    Append(kRecordTrade, &trade, sizeof(trade));
+    return true;
+}
+
+bool TradeSnapshot::MergeOrder(const CThostFtdcOrderField& order) {
+    const OrderKey key = MakeOrderKey(order.FrontID, order.SessionID, order.OrderRef);
+    std::unordered_map<OrderKey, size_t, OrderKeyHash>::iterator it = m_orderIndex.find(key);
+    if (it == m_orderIndex.end()) {
+        m_orderIndex[key] = m_orders.size();
+        m_orders.push_back(order);
+        return true;
+    }
+
+    CThostFtdcOrderField& current = m_orders[it->second];
+    if (memcmp(&current, &order, sizeof(order)) == 0) {
+        return false;
+    }
+    // 续传时重复到达的旧回报: 成交量回退或从终态回到非终态
+    if (order.VolumeTraded < current.VolumeTraded ||
+        (IsTerminal(current.OrderStatus) && !IsTerminal(order.OrderStatus))) {
+        return false;
+    }
+    current = order;
+    return true;
+}
+
+bool TradeSnapshot::MergeTrade(const CThostFtdcTradeField& trade) {
+    if (!m_tradeKeys.insert(TradeKey(trade)).second) {
+        return false;
+    }
+    m_trades.push_back(trade);
+    return true;
+}
+
+void TradeSnapshot::Append(uint32_t type, const void* data, uint32_t size) {
+    if (m_fd < 0) {
+        return;
+    }
+    char buffer[sizeof(RecordHeader) + (sizeof(CThostFtdcOrderField) > sizeof(CThostFtdcTradeField)
+                                            ? sizeof(CThostFtdcOrderField)
+                                            : sizeof(CThostFtdcTradeField))];
+    const RecordHeader record = {type, size};
+    memcpy(buffer, &record, sizeof(record));
+    memcpy(buffer + sizeof(record), data, size);
+    if (!WriteAll(m_fd, buffer, sizeof(record) + size)) {
+        LOG("[错误] 写入快照记录失败, 停止写入快照");
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    ++m_records;
+}
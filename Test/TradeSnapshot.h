@@ -0,0 +1,101 @@
+///
+/// @file TradeSnapshot.h
+/// @brief 报单/成交本地快照, 支持以 RESUME/QUICK 方式快速重启
+///
+
+#ifndef CTP_TEST_TRADE_SNAPSHOT_H
+#define CTP_TEST_TRADE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "OrderTable.h"
+
+/// 成交的去重键: 交易所+成交编号+方向, 自成交的买卖两笔成交编号相同
+std::string TradeKey(const CThostFtdcTradeField& trade);
+
+///
+/// @brief 报单/成交本地快照
+///
+/// 每个交易日对应一个文件 <dir>/snapshot_<交易日>.dat, 由文件头和追加写入的
+/// 报单、成交记录组成。收到回报时只追加一条定长记录; 正常退出时把当前状态
+/// 压缩重写并标记为"干净"。下次启动时若存在干净的快照, 私有流可用
+/// THOST_TERT_RESUME 续传, 公共流用 THOST_TERT_QUICK, 启动耗时只与快照中的
+/// 报单和成交数量有关, 与重启时刻无关。
+///
+/// 续传或重传时可能收到快照中已有的回报: 成交按 交易所+成交编号+方向 去重,
+/// 报单按 前置+会话+报单引用 保留最新状态, 丢弃重复和比已有状态更旧的回报。
+///
+/// LoadLatest() 在 Init() 之前由主线程调用; Open()/Apply*() 由交易回调处理线程调用;
+/// Close() 在处理线程停止后由主线程调用。
+///
+class TradeSnapshot {
+public:
+    /// @param dir 快照目录, 与交易API的流文件目录相同即可
+    explicit TradeSnapshot(const std::string& dir);
+    ~TradeSnapshot();
+
+    TradeSnapshot(const TradeSnapshot&) = delete;
+    TradeSnapshot& operator=(const TradeSnapshot&) = delete;
+
+    /// 加载目录中最新交易日的快照
+    /// @return 快照存在且上次正常关闭时返回true, 此时可以续传私有流
+    bool LoadLatest();
+
+    /// 登录后以当前交易日打开快照; 交易日与已加载的快照不同时清空状态并新建文件
+    bool Open(const std::string& tradingDay);
+
+    /// 压缩重写快照并标记为正常关闭
+    void Close();
+
+    /// 应用报单回报, 状态有变化时写入快照并返回true, 重复或过期的回报返回false
+    bool ApplyOrder(const CThostFtdcOrderField& order);
+
+    /// 应用成交回报, 新成交写入快照并返回true, 重复成交返回false
+    bool ApplyTrade(const CThostFtdcTradeField& trade);
+
+    /// 已加载或打开的快照交易日
+    const std::string& TradingDay() const { return m_tradingDay; }
+
+    const std::vector<CThostFtdcOrderField>& Orders() const { return m_orders; }
+    const std::vector<CThostFtdcTradeField>& Trades() const { return m_trades; }
+
+private:
+    std::string PathFor(const std::string& tradingDay) const;
+
+    /// 清空内存状态
+    void Reset();
+
+    /// 从文件读取状态, 返回文件是否为干净关闭; 截断末尾不完整的记录
+    bool Load(const std::string& path, bool& clean);
+
+    /// 把当前状态写入临时文件后替换快照文件
+    bool Rewrite(bool clean);
+
+    /// 以追加方式打开快照文件并把干净标志清零
+    bool OpenForAppend();
+
+    /// 更新内存状态, 不写文件
+    bool MergeOrder(const CThostFtdcOrderField& order);
+    bool MergeTrade(const CThostFtdcTradeField& trade);
+
+    /// 追加一条记录
+    void Append(uint32_t type, const void* data, uint32_t size);
+
+    std::string m_dir;
+    std::string m_tradingDay;
+    int m_fd;
+    size_t m_records;               ///< 文件中的记录数, 用于判断是否需要压缩
+
+    std::vector<CThostFtdcOrderField> m_orders;
+    std::unordered_map<OrderKey, size_t, OrderKeyHash> m_orderIndex;
+    std::vector<CThostFtdcTradeField> m_trades;
+    std::unordered_set<std::string> m_tradeKeys;
+};
+
+#endif // CTP_TEST_TRADE_SNAPSHOT_H
@@ -0,0 +1,82 @@
+///
+/// @file TraderEvent.h
+/// @brief 交易回调事件定义, 用于CTP回调线程与处理线程之间的数据传递
+///
+
+#ifndef CTP_TEST_TRADER_EVENT_H
+#define CTP_TEST_TRADER_EVENT_H
+
+#include <cstdint>
+
+#include "ThostFtdcUserApiStruct.h"
+
+///
+/// @brief 交易回调事件类型
+///
+enum class TraderEventType : uint8_t {
+    FrontConnected,
+    FrontDisconnected,
+    HeartBeatWarning,
+    RspAuthenticate,
+    RspUserLogin,
+    RspUserLogout,
+    RspQrySettlementInfo,
+    RspSettlementInfoConfirm,
+    RspQryTradingAccount,
+    RspQryInvestorPosition,
+    RspQryInstrument,
+    RspQryInstrumentMarginRate,
+    RspQryInstrumentCommissionRate,
+    RspQryTrade,
+    RspError,
+    RtnOrder,
+    RtnTrade,
+    RspOrderInsert,
+    ErrRtnOrderInsert,
+    RspOrderAction,
+    ErrRtnOrderAction,
+    RspBatchOrderAction,
+    ErrRtnBatchOrderAction,
+};
+
+///
+/// @brief 回调数据载荷, 同一时刻只有一个成员有效
+///
+union TraderEventData {
+    CThostFtdcRspAuthenticateField rspAuthenticate;
+    CThostFtdcRspUserLoginField rspUserLogin;
+    CThostFtdcUserLogoutField userLogout;
+    CThostFtdcSettlementInfoField settlementInfo;
+    CThostFtdcSettlementInfoConfirmField settlementInfoConfirm;
+    CThostFtdcTradingAccountField tradingAccount;
+    CThostFtdcInvestorPositionField investorPosition;
+    CThostFtdcInstrumentField instrument;
+    CThostFtdcInstrumentMarginRateField marginRate;
+    CThostFtdcInstrumentCommissionRateField commissionRate;
+    CThostFtdcOrderField order;
+    CThostFtdcTradeField trade;
+    CThostFtdcInputOrderField inputOrder;
+    CThostFtdcInputOrderActionField inputOrderAction;
+    CThostFtdcOrderActionField orderAction;
+    CThostFtdcInputBatchOrderActionField inputBatchOrderAction;
+    CThostFtdcBatchOrderActionField batchOrderAction;
+};
+
+///
+/// @brief 交易回调事件
+///
+/// CTP回调线程把回调参数拷贝进预分配的事件槽位后立即返回,
+/// 由处理线程按 type 分发。指针参数为空时对应的 has* 标志为false。
+///
+struct TraderEvent {
+    TraderEventType type;
+    bool hasData;
+    bool hasRspInfo;
+    bool isLast;
+    int requestId;          ///< nRequestID, 或 nReason / nTimeLapse
+    int64_t enqueueNs;      ///< 入队时刻(单调时钟)
+    CThostFtdcRspInfoField rspInfo;
+    TraderEventData data;
+};
+
+#endif // CTP_TEST_TRADER_EVENT_H
@@ -0,0 +1,1377 @@
+///
+/// @file TraderSpi.cpp
+/// @brief CTP交易回调类实现
+///
+
+#include "TraderSpi.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+#include "AsyncLogger.h"
+#include "Clock.h"
+
+namespace {
+
+void UpdateMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+TraderSpi::TraderSpi(CThostFtdcTraderApi* api, ControlEvents& control, size_t queueCapacity)
+    : m_api(api), m_control(control), m_loggedIn(false), m_snapshot(nullptr),
+      m_instruments(nullptr), m_symbols(nullptr), m_gateway(nullptr),
+      m_orders(nullptr), m_risk(nullptr), m_positions(nullptr), m_funds(nullptr), m_latency(nullptr),
+      m_recovery(nullptr), m_frontId(0), m_sessionId(0),
+      m_scheduler(std::bind(&TraderSpi::NextRequestId, this)), m_startupQueries(0), m_loginSeq(0),
+      m_reconnecting(false),
+      m_positionRequestId(0), m_instrumentRequestId(0), m_tradeRequestId(0),
+      m_baselineLoaded(false), m_tradesGated(true), m_gateQueries(0), m_tradeQueryOk(false), m_snapshotTrades(0),
+      m_queue(queueCapacity),
+      m_stopping(false), m_queryFailed(false),
+      m_posted(0), m_dropped(0), m_queueFullSpins(0),
+      m_maxResidenceNs(0), m_totalResidenceNs(0), m_maxQueueDelayNs(0) {
+}
+
+TraderSpi::~TraderSpi() {
+    Stop();
+}
+
+void TraderSpi::Start() {
+    if (m_dispatchThread.joinable()) {
+        return;
+    }
+    m_stopping.store(false);
+    m_dispatchThread = std::thread(&TraderSpi::DispatchLoop, this);
+    m_scheduler.Start();
+}
+
+void TraderSpi::Stop() {
+    if (!m_dispatchThread.joinable()) {
+        return;
+    }
+    m_scheduler.Stop();
+    m_waiter.Signal([this] { m_stopping.store(true); });
+    m_dispatchThread.join();
+}
+
+TraderEventStats TraderSpi::GetStats() const {
+    TraderEventStats stats;
+    stats.posted = m_posted.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.queueFullSpins = m_queueFullSpins.load(std::memory_order_relaxed);
+    stats.maxResidenceNs = m_maxResidenceNs.load(std::memory_order_relaxed);
+    stats.totalResidenceNs = m_totalResidenceNs.load(std::memory_order_relaxed);
+    stats.maxQueueDelayNs = m_maxQueueDelayNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ---------------------------------------------------------------------------
+// CTP回调线程: 拷贝数据入队后立即返回
+// ---------------------------------------------------------------------------
+
+TraderEvent* TraderSpi::ClaimEvent() {
+    TraderEvent* ev;
+    while ((ev = m_queue.Claim()) == nullptr) {
+        if (m_stopping.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        m_queueFullSpins.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+    return ev;
+}
+
+void TraderSpi::PublishEvent(int64_t startNs) {
+    m_queue.Publish();
+
+    m_waiter.Notify();
+
+    const int64_t residenceNs = MonotonicNs() - startNs;
+    m_posted.store(m_posted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_totalResidenceNs.store(m_totalResidenceNs.load(std::memory_order_relaxed) + residenceNs,
+                             std::memory_order_relaxed);
+    if (residenceNs > m_maxResidenceNs.load(std::memory_order_relaxed)) {
+        m_maxResidenceNs.store(residenceNs, std::memory_order_relaxed);
+    }
+}
+
+TraderEvent* TraderSpi::BeginEvent(TraderEventType type, const CThostFtdcRspInfoField* pRspInfo,
+                                   int nRequestID, bool bIsLast, int64_t startNs) {
+    TraderEvent* ev = m_stopping.load(std::memory_order_acquire) ? nullptr : ClaimEvent();
+    if (!ev) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    ev->type = type;
+    ev->hasData = false;
+    ev->hasRspInfo = pRspInfo != nullptr;
+    ev->isLast = bIsLast;
+    ev->requestId = nRequestID;
+    ev->enqueueNs = startNs;
+    if (pRspInfo) {
+        ev->rspInfo = *pRspInfo;
+    }
+    return ev;
+}
+
+void TraderSpi::PostSignal(TraderEventType type, int arg) {
+    const int64_t startNs = MonotonicNs();
+    if (BeginEvent(type, nullptr, arg, true, startNs)) {
+        PublishEvent(startNs);
+    }
+}
+
+template <typename T>
+void TraderSpi::Post(TraderEventType type, T TraderEventData::*member, const T* data,
+                     const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast) {
+    const int64_t startNs = MonotonicNs();
+    TraderEvent* ev = BeginEvent(type, pRspInfo, nRequestID, bIsLast, startNs);
+    if (!ev) {
+        return;
+    }
+    if (data) {
+        ev->hasData = true;
+        ev->data.*member = *data;
+    }
+    PublishEvent(startNs);
+}
+
+void TraderSpi::OnFrontConnected() {
+    PostSignal(TraderEventType::FrontConnected, 0);
+}
+
+void TraderSpi::OnFrontDisconnected(int nReason) {
+    PostSignal(TraderEventType::FrontDisconnected, nReason);
+}
+
+void TraderSpi::OnHeartBeatWarning(int nTimeLapse) {
+    PostSignal(TraderEventType::HeartBeatWarning, nTimeLapse);
+}
+
+void TraderSpi::OnRspAuthenticate(CThostFtdcRspAuthenticateField *pRspAuthenticateField,
+                                  CThostFtdcRspInfoField *pRspInfo,
+                                  int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspAuthenticate, &TraderEventData::rspAuthenticate,
+         pRspAuthenticateField, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin,
+                               CThostFtdcRspInfoField *pRspInfo,
+                               int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspUserLogin, &TraderEventData::rspUserLogin,
+         pRspUserLogin, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspUserLogout(CThostFtdcUserLogoutField *pUserLogout,
+                                CThostFtdcRspInfoField *pRspInfo,
+                                int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspUserLogout, &TraderEventData::userLogout,
+         pUserLogout, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQrySettlementInfo(CThostFtdcSettlementInfoField *pSettlementInfo,
+                                       CThostFtdcRspInfoField *pRspInfo,
+                                       int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQrySettlementInfo, &TraderEventData::settlementInfo,
+         pSettlementInfo, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                           CThostFtdcRspInfoField *pRspInfo,
+                                           int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspSettlementInfoConfirm, &TraderEventData::settlementInfoConfirm,
+         pSettlementInfoConfirm, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTradingAccount,
+                                       CThostFtdcRspInfoField *pRspInfo,
+                                       int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQryTradingAccount, &TraderEventData::tradingAccount,
+         pTradingAccount, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *pInvestorPosition,
+                                         CThostFtdcRspInfoField *pRspInfo,
+                                         int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQryInvestorPosition, &TraderEventData::investorPosition,
+         pInvestorPosition, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument,
+                                   CThostFtdcRspInfoField *pRspInfo,
+                                   int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQryInstrument, &TraderEventData::instrument,
+         pInstrument, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQryInstrumentMarginRate(CThostFtdcInstrumentMarginRateField *pInstrumentMarginRate,
+                                             CThostFtdcRspInfoField *pRspInfo,
+                                             int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQryInstrumentMarginRate, &TraderEventData::marginRate,
+         pInstrumentMarginRate, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQryInstrumentCommissionRate(CThostFtdcInstrumentCommissionRateField *pInstrumentCommissionRate,
+                                                 CThostFtdcRspInfoField *pRspInfo,
+                                                 int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQryInstrumentCommissionRate, &TraderEventData::commissionRate,
+         pInstrumentCommissionRate, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspQryTrade(CThostFtdcTradeField *pTrade, CThostFtdcRspInfoField *pRspInfo,
+                              int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspQryTrade, &TraderEventData::trade, pTrade, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnRspError(CThostFtdcRspInfoField *pRspInfo,
+                           int nRequestID, bool bIsLast) {
+    const int64_t startNs = MonotonicNs();
+    if (BeginEvent(TraderEventType::RspError, pRspInfo, nRequestID, bIsLast, startNs)) {
+        PublishEvent(startNs);
+    }
+}
+
+void TraderSpi::OnRtnOrder(CThostFtdcOrderField *pOrder) {
+    Post(TraderEventType::RtnOrder, &TraderEventData::order, pOrder, nullptr, 0, true);
+}
+
+void TraderSpi::OnRtnTrade(CThostFtdcTradeField *pTrade) {
+    Post(TraderEventType::RtnTrade, &TraderEventData::trade, pTrade, nullptr, 0, true);
+}
+
+void TraderSpi::OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder,
+                                 CThostFtdcRspInfoField *pRspInfo,
+                                 int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspOrderInsert, &TraderEventData::inputOrder, pInputOrder, pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder,
+                                    CThostFtdcRspInfoField *pRspInfo) {
+    Post(TraderEventType::ErrRtnOrderInsert, &TraderEventData::inputOrder, pInputOrder, pRspInfo, 0, true);
+}
+
+void TraderSpi::OnRspOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction,
+                                 CThostFtdcRspInfoField *pRspInfo,
+                                 int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspOrderAction, &TraderEventData::inputOrderAction, pInputOrderAction, pRspInfo,
+         nRequestID, bIsLast);
+}
+
+void TraderSpi::OnErrRtnOrderAction(CThostFtdcOrderActionField *pOrderAction,
+                                    CThostFtdcRspInfoField *pRspInfo) {
+    Post(TraderEventType::ErrRtnOrderAction, &TraderEventData::orderAction, pOrderAction, pRspInfo, 0, true);
+}
+
+void TraderSpi::OnRspBatchOrderAction(CThostFtdcInputBatchOrderActionField *pInputBatchOrderAction,
+                                      CThostFtdcRspInfoField *pRspInfo,
+                                      int nRequestID, bool bIsLast) {
+    Post(TraderEventType::RspBatchOrderAction, &TraderEventData::inputBatchOrderAction, pInputBatchOrderAction,
+         pRspInfo, nRequestID, bIsLast);
+}
+
+void TraderSpi::OnErrRtnBatchOrderAction(CThostFtdcBatchOrderActionField *pBatchOrderAction,
+                                         CThostFtdcRspInfoField *pRspInfo) {
+    Post(TraderEventType::ErrRtnBatchOrderAction, &TraderEventData::batchOrderAction, pBatchOrderAction, pRspInfo,
+         0, true);
+}
+
+// ---------------------------------------------------------------------------
+// 处理线程
+// ---------------------------------------------------------------------------
+
+void TraderSpi::DispatchLoop() {
+    while (true) {
+        if (m_queryFailed.load(std::memory_order_acquire)) {
+            HandleQueryFailures();
+        }
+        TraderEvent* ev = m_queue.Front();
+        if (ev) {
+            UpdateMax(m_maxQueueDelayNs, MonotonicNs() - ev->enqueueNs);
+            Dispatch(*ev);
+            m_queue.Pop();
+            m_waiter.Busy();
+            continue;
+        }
+
+        if (m_stopping.load(std::memory_order_acquire)) {
+            // 停止标志置位后回调线程不再入队, 再确认一次队列为空即可退出
+            if (m_queue.Empty()) {
+                break;
+            }
+            continue;
+        }
+
+        m_waiter.Idle([this] {
+            return !m_queue.Empty() || m_stopping.load(std::memory_order_relaxed) ||
+                   m_queryFailed.load(std::memory_order_relaxed);
+        });
+    }
+}
+
+void TraderSpi::Dispatch(const TraderEvent& ev) {
+    const CThostFtdcRspInfoField* pRspInfo = ev.hasRspInfo ? &ev.rspInfo : nullptr;
+
+    switch (ev.type) {
+        case TraderEventType::FrontConnected:
+            HandleFrontConnected();
+            break;
+        case TraderEventType::FrontDisconnected:
+            HandleFrontDisconnected(ev.requestId);
+            break;
+        case TraderEventType::HeartBeatWarning:
+            HandleHeartBeatWarning(ev.requestId);
+            break;
+        case TraderEventType::RspAuthenticate:
+            HandleRspAuthenticate(ev.hasData ? &ev.data.rspAuthenticate : nullptr,
+                                  pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspUserLogin:
+            HandleRspUserLogin(ev.hasData ? &ev.data.rspUserLogin : nullptr,
+                               pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspUserLogout:
+            HandleRspUserLogout(ev.hasData ? &ev.data.userLogout : nullptr,
+                                pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQrySettlementInfo:
+            HandleRspQrySettlementInfo(ev.hasData ? &ev.data.settlementInfo : nullptr,
+                                       pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspSettlementInfoConfirm:
+            HandleRspSettlementInfoConfirm(ev.hasData ? &ev.data.settlementInfoConfirm : nullptr,
+                                           pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryTradingAccount:
+            HandleRspQryTradingAccount(ev.hasData ? &ev.data.tradingAccount : nullptr,
+                                       pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryInvestorPosition:
+            HandleRspQryInvestorPosition(ev.hasData ? &ev.data.investorPosition : nullptr,
+                                         pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryInstrument:
+            HandleRspQryInstrument(ev.hasData ? &ev.data.instrument : nullptr,
+                                   pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryInstrumentMarginRate:
+            HandleRspQryInstrumentMarginRate(ev.hasData ? &ev.data.marginRate : nullptr,
+                                             pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryInstrumentCommissionRate:
+            HandleRspQryInstrumentCommissionRate(ev.hasData ? &ev.data.commissionRate : nullptr,
+                                                 pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspQryTrade:
+            HandleRspQryTrade(ev.hasData ? &ev.data.trade : nullptr, pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RspError:
+            HandleRspError(pRspInfo, ev.requestId, ev.isLast);
+            break;
+        case TraderEventType::RtnOrder:
+            HandleRtnOrder(ev.hasData ? &ev.data.order : nullptr, ev.enqueueNs);
+            break;
+        case TraderEventType::RtnTrade:
+            HandleRtnTrade(ev.hasData ? &ev.data.trade : nullptr, ev.enqueueNs);
+            break;
+        case TraderEventType::RspOrderInsert:
+        case TraderEventType::ErrRtnOrderInsert:
+            HandleOrderInsertError(ev.hasData ? &ev.data.inputOrder : nullptr, pRspInfo);
+            break;
+        case TraderEventType::RspOrderAction:
+            if (ev.hasData) {
+                const CThostFtdcInputOrderActionField& action = ev.data.inputOrderAction;
+                HandleOrderActionError(MakeOrderKey(action.FrontID, action.SessionID, action.OrderRef),
+                                       action.ExchangeID, action.OrderSysID, pRspInfo);
+            }
+            break;
+        case TraderEventType::ErrRtnOrderAction:
+            if (ev.hasData) {
+                const CThostFtdcOrderActionField& action = ev.data.orderAction;
+                HandleOrderActionError(MakeOrderKey(action.FrontID, action.SessionID, action.OrderRef),
+                                       action.ExchangeID, action.OrderSysID, pRspInfo);
+            }
+            break;
+        case TraderEventType::RspBatchOrderAction:
+            HandleBatchActionError(ev.hasData ? ev.data.inputBatchOrderAction.ExchangeID : "", pRspInfo);
+            break;
+        case TraderEventType::ErrRtnBatchOrderAction:
+            HandleBatchActionError(ev.hasData ? ev.data.batchOrderAction.ExchangeID : "", pRspInfo);
+            break;
+    }
+}
+
+void TraderSpi::HandleFrontConnected() {
+    if (m_recovery) {
+        m_recovery->OnConnected(MonotonicNs());
+    }
+    LOG("[连接] 成功连接到交易服务器");
+    LOG("[状态] 开始用户登录...");
+    ReqUserLogin();
+}
+
+void TraderSpi::HandleFrontDisconnected(int nReason) {
+    if (m_recovery) {
+        m_recovery->OnDisconnected(nReason, MonotonicNs());
+    }
+    LOG("[断开] 与交易服务器断开连接, 原因码: {}", nReason);
+    switch (nReason) {
+        case 0x1001:
+            LOG("  原因: 网络读失败");
+            break;
+        case 0x1002:
+            LOG("  原因: 网络写失败");
+            break;
+        case 0x2001:
+            LOG("  原因: 接收心跳超时");
+            break;
+        case 0x2002:
+            LOG("  原因: 发送心跳失败");
+            break;
+        case 0x2003:
+            LOG("  原因: 收到错误报文");
+            break;
+        default:
+            LOG("  原因: 未知");
+            break;
+    }
+    m_loggedIn.store(false);
+    if (m_gateway) {
+        m_gateway->OnDisconnected();
+    }
+    m_startupQueries = 0;
+    m_instrumentRows.clear();
+    m_positionRows.clear();
+    m_tradeRows.clear();
+    m_scheduler.Reset();
+    if (m_funds) {
+        m_funds->ResetRateRequests();
+    }
+    m_reconnecting = true;
+    m_control.Post(kControlDisconnected);
+}
+
+void TraderSpi::HandleHeartBeatWarning(int nTimeLapse) {
+    LOG("[警告] 心跳超时, 距离上次接收时间: {}秒", nTimeLapse);
+}
+
+void TraderSpi::HandleRspAuthenticate(const CThostFtdcRspAuthenticateField* /*pRspAuthenticateField*/,
+                                      const CThostFtdcRspInfoField* pRspInfo,
+                                      int nRequestID, bool /*bIsLast*/) {
+    LOG("[认证] 收到认证响应, RequestID: {}", nRequestID);
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 认证失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else {
+        LOG("[成功] 客户端认证成功");
+    }
+}
+
+void TraderSpi::HandleRspUserLogin(const CThostFtdcRspUserLoginField* pRspUserLogin,
+                                   const CThostFtdcRspInfoField* pRspInfo,
+                                   int nRequestID, bool /*bIsLast*/) {
+    LOG("[登录] 收到登录响应, RequestID: {}", nRequestID);
+
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 登录失败!");
+        LOG("  ErrorID: {}", pRspInfo->ErrorID);
+        LOG("  ErrorMsg: {}", (pRspInfo->ErrorMsg[0] ? pRspInfo->ErrorMsg : "无"));
+        m_control.Post(kControlLoginFailed);
+        return;
+    }
+
+    LOG("[成功] 登录成功!");
+    m_loggedIn.store(true);
+    ++m_loginSeq;
+    if (m_recovery) {
+        m_recovery->OnLogin(MonotonicNs());
+    }
+
+    if (pRspUserLogin) {
+        LOG("====================================");
+        LOG("登录信息:");
+        LOG("  交易日:    {}", pRspUserLogin->TradingDay);
+        LOG("  登录时间:  {}", pRspUserLogin->LoginTime);
+        LOG("  经纪公司:  {}", pRspUserLogin->BrokerID);
+        LOG("  用户ID:    {}", pRspUserLogin->UserID);
+        LOG("  交易系统:  {}", pRspUserLogin->SystemName);
+        LOG("  前端ID:    {}", pRspUserLogin->FrontID);
+        LOG("  会话ID:    {}", pRspUserLogin->SessionID);
+        LOG("  最大订单:  {}", pRspUserLogin->MaxOrderRef);
+        LOG("  SHFE时间:  {}", pRspUserLogin->SHFETime);
+        LOG("  DCHE时间:  {}", pRspUserLogin->DCETime);
+        LOG("  CZCE时间:  {}", pRspUserLogin->CZCETime);
+        LOG("  DCE时间:   {}", pRspUserLogin->DCETime);
+        LOG("  INE时间:   {}", pRspUserLogin->INETime);
+        LOG("====================================");
+        m_frontId = pRspUserLogin->FrontID;
+        m_sessionId = pRspUserLogin->SessionID;
+        m_ids.SeedOrderRef(pRspUserLogin->MaxOrderRef);
+        if (m_risk) {
+            m_risk->ResetInflight();    // 断线前未确认的报单随续传的回报计为挂单
+        }
+        if (m_gateway) {
+            m_gateway->OnLogin(*pRspUserLogin);
+        }
+    }
+    // 续传的成交在持仓和成交查询都结束后再按成交编号去重计入
+    ResetTradingDay(m_api->GetTradingDay());
+    m_tradesGated = true;
+    m_gateQueries = 2;
+    m_tradeQueryOk = false;
+    m_tradeRows.clear();
+
+    // 私有流回报在登录响应之后到达, 先按交易日打开快照
+    m_snapshotTrades = 0;
+    if (m_snapshot && m_snapshot->Open(m_api->GetTradingDay())) {
+        LOG("[快照] 交易日 {}, 已有报单 {} 笔, 成交 {} 笔", m_snapshot->TradingDay(),
+            m_snapshot->Orders().size(), m_snapshot->Trades().size());
+        m_snapshotTrades = m_snapshot->Trades().size();
+    }
+    LoadOrderTable();
+
+    // 登录成功后提交启动查询: 结算信息查询完成后再提交结算确认,
+    // 资金、持仓和成交查询互不依赖, 由调度器在流控额度允许时依次发送
+    m_startupQueries = 5;
+    LOG("[状态] 查询投资者结算信息...");
+    SubmitQuery(kQuerySettlementInfo, "查询结算信息", kQueryPriorityHigh,
+                std::bind(&TraderSpi::ReqQrySettlementInfo, this, std::placeholders::_1));
+    LOG("[状态] 查询资金账户...");
+    SubmitQuery(kQueryAccount, "查询资金账户", kQueryPriorityNormal,
+                std::bind(&TraderSpi::ReqQryTradingAccount, this, std::placeholders::_1));
+    LOG("[状态] 查询投资者持仓...");
+    SubmitQuery(kQueryPosition, "查询持仓", kQueryPriorityNormal,
+                std::bind(&TraderSpi::ReqQryInvestorPosition, this, std::placeholders::_1));
+    LOG("[状态] 查询当日成交...");
+    SubmitQuery(kQueryTrade, "查询成交", kQueryPriorityNormal,
+                std::bind(&TraderSpi::ReqQryTrade, this, std::placeholders::_1));
+
+    // 合约信息每个交易日只查询一次, 已有缓存时不占用查询额度
+    if (m_instruments) {
+        const std::string tradingDay = m_api->GetTradingDay();
+        if (m_instruments->Open(tradingDay)) {
+            LOG("[合约] 已从缓存加载交易日 {} 的合约 {} 个", tradingDay, m_instruments->Size());
+            InternInstruments();
+        } else {
+            ++m_startupQueries;
+            m_instrumentRows.clear();
+            LOG("[状态] 查询合约...");
+            SubmitQuery(kQueryInstrument, "查询合约", kQueryPriorityLow,
+                        std::bind(&TraderSpi::ReqQryInstrument, this, std::placeholders::_1));
+        }
+    }
+
+    // 重新登录后报单网关已可用, 立即通知主线程撤掉断线前已知的挂单, 不等启动查询
+    if (m_reconnecting) {
+        m_control.Post(kControlRelogin);
+    }
+}
+
+void TraderSpi::HandleRspUserLogout(const CThostFtdcUserLogoutField* /*pUserLogout*/,
+                                    const CThostFtdcRspInfoField* pRspInfo,
+                                    int nRequestID, bool /*bIsLast*/) {
+    LOG("[登出] 收到登出响应, RequestID: {}", nRequestID);
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 登出失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else {
+        LOG("[成功] 登出成功");
+    }
+    m_loggedIn.store(false);
+    m_control.Post(kControlLogoutDone);
+}
+
+void TraderSpi::HandleRspQrySettlementInfo(const CThostFtdcSettlementInfoField* /*pSettlementInfo*/,
+                                           const CThostFtdcRspInfoField* pRspInfo,
+                                           int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 查询结算信息失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+        // 即使查询失败也继续确认
+    } else if (bIsLast) {
+        LOG("[成功] 查询结算信息完成");
+    }
+
+    if (bIsLast) {
+        m_scheduler.OnResponse(nRequestID);
+        CompleteQuery(kQuerySettlementInfo, true);
+    }
+}
+
+void TraderSpi::HandleRspSettlementInfoConfirm(const CThostFtdcSettlementInfoConfirmField* pSettlementInfoConfirm,
+                                               const CThostFtdcRspInfoField* pRspInfo,
+                                               int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 结算确认失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else {
+        LOG("[成功] 结算信息确认成功");
+        if (pSettlementInfoConfirm) {
+            LOG("  确认日期: {}", pSettlementInfoConfirm->ConfirmDate);
+            LOG("  确认时间: {}", pSettlementInfoConfirm->ConfirmTime);
+        }
+    }
+
+    if (bIsLast) {
+        m_scheduler.OnResponse(nRequestID);
+        CompleteQuery(kQuerySettlementConfirm, true);
+    }
+}
+
+void TraderSpi::HandleRspQryTradingAccount(const CThostFtdcTradingAccountField* pTradingAccount,
+                                           const CThostFtdcRspInfoField* pRspInfo,
+                                           int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 查询资金账户失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else if (pTradingAccount) {
+        LOG("[成功] 查询资金账户成功");
+        LOG("====================================");
+        LOG("资金账户信息:");
+        LOG("  账户ID:        {}", pTradingAccount->AccountID);
+        LOG("  可用资金:       {}", pTradingAccount->Available);
+        LOG("  保证金占用:     {}", pTradingAccount->CurrMargin);
+        // LOG("  浮动盈亏:       {}", pTradingAccount->UnrealizedProfit);
+        LOG("  持仓盈亏:       {}", pTradingAccount->CloseProfit);
+        LOG("  权益:           {}", pTradingAccount->Balance);
+        LOG("  入金:           {}", pTradingAccount->Deposit);
+        LOG("  出金:           {}", pTradingAccount->Withdraw);
+        LOG("  冻结保证金:     {}", pTradingAccount->FrozenMargin);
+        LOG("  冻结手续费:     {}", pTradingAccount->FrozenCommission);
+        LOG("  手续费:         {}", pTradingAccount->Commission);
+        // LOG("  风险度:         {}", pTradingAccount->RiskRatio);
+        LOG("====================================");
+        if (m_funds) {
+            m_funds->LoadAccount(*pTradingAccount);
+        }
+    }
+
+    if (bIsLast) {
+        m_scheduler.OnResponse(nRequestID);
+        CompleteQuery(kQueryAccount, true);
+    }
+}
+
+void TraderSpi::HandleRspQryInvestorPosition(const CThostFtdcInvestorPositionField* pInvestorPosition,
+                                             const CThostFtdcRspInfoField* pRspInfo,
+                                             int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    const bool failed = pRspInfo && pRspInfo->ErrorID != 0 && pRspInfo->ErrorID != 203; // 203表示没有持仓
+    if (failed) {
+        LOG("[错误] 查询持仓失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else if (pInvestorPosition) {
+        // 重发的查询从头累积
+        if (nRequestID != m_positionRequestId) {
+            m_positionRows.clear();
+            m_positionRequestId = nRequestID;
+        }
+        // 每次查询的第一行打印表头, 断线重连后的查询同样打印
+        if (m_positionRows.empty()) {
+            LOG("[成功] 查询持仓成功");
+            LOG("====================================");
+            LOG("持仓信息:");
+        }
+        LOG("  合约: {} | 方向: {} | 持仓: {} | 今仓: {}", pInvestorPosition->InstrumentID,
+            (pInvestorPosition->PosiDirection == THOST_FTDC_PD_Short ? "空头" : "多头"),
+            pInvestorPosition->Position, pInvestorPosition->TodayPosition);
+        m_positionRows.push_back(*pInvestorPosition);
+    }
+
+    if (bIsLast) {
+        LOG("====================================");
+        m_scheduler.OnResponse(nRequestID);
+        CompleteQuery(kQueryPosition, !failed);
+    }
+}
+
+void TraderSpi::HandleRspQryInstrument(const CThostFtdcInstrumentField* pInstrument,
+                                       const CThostFtdcRspInfoField* pRspInfo,
+                                       int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 查询合约失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+        m_instrumentRows.clear();
+    } else if (pInstrument) {
+        if (nRequestID != m_instrumentRequestId) {
+            m_instrumentRows.clear();
+            m_instrumentRequestId = nRequestID;
+        }
+        m_instrumentRows.push_back(*pInstrument);
+    }
+
+    if (bIsLast) {
+        m_scheduler.OnResponse(nRequestID);
+        CompleteQuery(kQueryInstrument, true);
+    }
+}
+
+void TraderSpi::HandleRspQryInstrumentMarginRate(const CThostFtdcInstrumentMarginRateField* pMarginRate,
+                                                 const CThostFtdcRspInfoField* pRspInfo,
+                                                 int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 查询保证金率失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else if (pMarginRate && pMarginRate->InstrumentID[0] != '\0' && m_funds && m_symbols) {
+        LOG("[资金] 保证金率 {} | 多头: {} {} | 空头: {} {}", pMarginRate->InstrumentID,
+            pMarginRate->LongMarginRatioByMoney, pMarginRate->LongMarginRatioByVolume,
+            pMarginRate->ShortMarginRatioByMoney, pMarginRate->ShortMarginRatioByVolume);
+        m_funds->OnMarginRate(*pMarginRate, *m_symbols);
+    }
+
+    if (bIsLast) {
+        m_scheduler.OnResponse(nRequestID);
+    }
+}
+
+void TraderSpi::HandleRspQryInstrumentCommissionRate(const CThostFtdcInstrumentCommissionRateField* pCommissionRate,
+                                                     const CThostFtdcRspInfoField* pRspInfo,
+                                                     int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    if (pRspInfo && pRspInfo->ErrorID != 0) {
+        LOG("[错误] 查询手续费率失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else if (pCommissionRate && pCommissionRate->InstrumentID[0] != '\0' && m_funds && m_symbols &&
+               m_instruments) {
+        LOG("[资金] 手续费率 {} | 开仓: {} {} | 平仓: {} {} | 平今: {} {}", pCommissionRate->InstrumentID,
+            pCommissionRate->OpenRatioByMoney, pCommissionRate->OpenRatioByVolume,
+            pCommissionRate->CloseRatioByMoney, pCommissionRate->CloseRatioByVolume,
+            pCommissionRate->CloseTodayRatioByMoney, pCommissionRate->CloseTodayRatioByVolume);
+        m_funds->OnCommissionRate(*pCommissionRate, *m_instruments, *m_symbols);
+    }
+
+    if (bIsLast) {
+        m_scheduler.OnResponse(nRequestID);
+    }
+}
+
+void TraderSpi::InternInstruments() {
+    if (!m_symbols) {
+        return;
+    }
+    for (size_t i = 0; i < m_instruments->Size(); ++i) {
+        if (m_symbols->Intern(m_instruments->At(i).InstrumentID) == kInvalidSymbol) {
+            LOG("[错误] 合约编号表已满 (容量 {}), 剩余合约未分配编号", m_symbols->Capacity());
+            break;
+        }
+    }
+    // 先建立品种映射再生成模板: 模板生成后报单网关即就绪
+    if (m_risk) {
+        m_risk->BuildProducts(*m_instruments, *m_symbols);
+    }
+    if (m_funds) {
+        m_funds->BuildInstruments(*m_instruments, *m_symbols);
+    }
+    if (m_gateway) {
+        m_gateway->BuildTemplates(*m_instruments, *m_symbols);
+    }
+}
+
+void TraderSpi::HandleRspQryTrade(const CThostFtdcTradeField* pTrade, const CThostFtdcRspInfoField* pRspInfo,
+                                  int nRequestID, bool bIsLast) {
+    if (!m_scheduler.IsCurrent(nRequestID)) {
+        return;     // 超时重发前的原请求迟到的响应
+    }
+    // 重发的查询从头累积
+    if (nRequestID != m_tradeRequestId) {
+        m_tradeRows.clear();
+        m_tradeRequestId = nRequestID;
+    }
+    const bool failed = pRspInfo && pRspInfo->ErrorID != 0;
+    if (failed) {
+        LOG("[错误] 查询成交失败, ErrorID: {}, ErrorMsg: {}", pRspInfo->ErrorID, pRspInfo->ErrorMsg);
+    } else if (pTrade) {
+        m_tradeRows.push_back(*pTrade);
+    }
+
+    if (bIsLast) {
+        if (!failed) {
+            LOG("[成功] 查询成交完成, 当日成交 {} 笔", m_tradeRows.size());
+        }
+        m_scheduler.OnResponse(nRequestID);
+        CompleteQuery(kQueryTrade, !failed);
+    }
+}
+
+void TraderSpi::FinishStartupQuery() {
+    if (m_startupQueries > 0 && --m_startupQueries == 0) {
+        if (m_recovery) {
+            m_recovery->OnResynced(MonotonicNs());
+        }
+        LOG("[状态] 所有查询完成, 登录测试成功!");
+        LOG("[状态] 按Ctrl+C退出或等待自动登出...");
+        // 重连后启动查询完成时再通知主线程补撤: 私有流在登录响应之后续传, 查询按流控排在其后,
+        // 此时断线前后的挂单回报已基本进入报单状态表
+        if (m_reconnecting) {
+            m_reconnecting = false;
+            m_control.Post(kControlReconnected);
+        }
+    }
+}
+
+void TraderSpi::HandleRspError(const CThostFtdcRspInfoField* pRspInfo,
+                               int nRequestID, bool /*bIsLast*/) {
+    LOG("[错误] 收到错误响应, RequestID: {}", nRequestID);
+    if (pRspInfo) {
+        LOG("  ErrorID: {}", pRspInfo->ErrorID);
+        LOG("  ErrorMsg: {}", (pRspInfo->ErrorMsg[0] ? pRspInfo->ErrorMsg : "无"));
+    }
+    // 经调度器发送的请求由调度器放弃, 其放弃回调按失败完成所属的启动查询
+    m_scheduler.OnError(nRequestID);
+}
+
+void TraderSpi::HandleRtnOrder(const CThostFtdcOrderField* pOrder, int64_t recvNs) {
+    if (!pOrder) {
+        return;
+    }
+    if (m_latency && pOrder->FrontID == m_frontId && pOrder->SessionID == m_sessionId) {
+        m_latency->OnOrderReturn(atoi(pOrder->OrderRef), pOrder->OrderSysID[0] != '\0', recvNs);
+    }
+    if (m_orders && m_orders->OnRtnOrder(*pOrder)) {
+        ApplyOrderUpdate(m_orders->IndexOf(MakeOrderKey(pOrder->FrontID, pOrder->SessionID, pOrder->OrderRef)));
+    }
+    if (m_snapshot && !m_snapshot->ApplyOrder(*pOrder)) {
+        return;     // 续传时重复到达的回报
+    }
+    LOG("[报单] 合约: {} | 方向: {} | 价格: {} | 数量: {} | 已成交: {} | 状态: {} | 报单引用: {} | {}",
+        pOrder->InstrumentID, (pOrder->Direction == THOST_FTDC_D_Buy ? "买" : "卖"), pOrder->LimitPrice,
+        pOrder->VolumeTotalOriginal, pOrder->VolumeTraded, pOrder->OrderStatus, pOrder->OrderRef,
+        pOrder->StatusMsg);
+}
+
+void TraderSpi::HandleRtnTrade(const CThostFtdcTradeField* pTrade, int64_t recvNs) {
+    if (!pTrade) {
+        return;
+    }
+    // 快照中已有的成交也可能尚未计入本进程的持仓(重启后续传), 由成交编号去重决定
+    if (m_tradesGated) {
+        m_pendingTrades.push_back(*pTrade);
+    } else {
+        ApplyNewTrade(*pTrade);
+    }
+    if (m_snapshot && !m_snapshot->ApplyTrade(*pTrade)) {
+        return;
+    }
+    if (m_orders && m_orders->OnRtnTrade(*pTrade)) {
+        const int64_t index = m_orders->IndexOfSysId(pTrade->ExchangeID, pTrade->OrderSysID);
+        ApplyOrderUpdate(index);
+        // 成交回报不带会话信息, 经报单表确认是本会话的报单
+        OrderInfo info;
+        if (m_latency && index >= 0 && m_orders->Read(static_cast<size_t>(index), info) &&
+            info.key.frontId == m_frontId && info.key.sessionId == m_sessionId) {
+            m_latency->OnTrade(atoi(pTrade->OrderRef), recvNs);
+        }
+    }
+    LOG("[成交] 合约: {} | 方向: {} | 价格: {} | 数量: {} | 成交编号: {} | 报单引用: {}",
+        pTrade->InstrumentID, (pTrade->Direction == THOST_FTDC_D_Buy ? "买" : "卖"), pTrade->Price,
+        pTrade->Volume, pTrade->TradeID, pTrade->OrderRef);
+}
+
+void TraderSpi::ApplyTrade(const CThostFtdcTradeField& trade) {
+    if (m_risk && m_symbols) {
+        m_risk->OnTrade(m_symbols->Intern(trade.InstrumentID), trade);
+    }
+    if (m_positions && m_symbols) {
+        m_positions->OnTrade(m_symbols->Intern(trade.InstrumentID), trade);
+    }
+    if (m_funds && m_symbols) {
+        const uint32_t symbolId = m_symbols->Intern(trade.InstrumentID);
+        if (m_funds->NeedRates(symbolId)) {
+            RequestRates(trade.InstrumentID);
+        }
+        m_funds->OnTrade(symbolId, trade);
+    }
+}
+
+bool TraderSpi::ApplyNewTrade(const CThostFtdcTradeField& trade) {
+    if (!m_tradeKeys.insert(TradeKey(trade)).second) {
+        return false;
+    }
+    m_dayTrades.push_back(trade);
+    ApplyTrade(trade);
+    return true;
+}
+
+void TraderSpi::ResetTradingDay(const std::string& tradingDay) {
+    if (tradingDay == m_tradeDay) {
+        return;
+    }
+    const bool changed = !m_tradeDay.empty();
+    if (changed) {
+        LOG("[持仓] 交易日由 {} 切换为 {}, 清空当日成交 {} 笔", m_tradeDay, tradingDay, m_dayTrades.size());
+    }
+    m_tradeDay = tradingDay;
+    m_tradeKeys.clear();
+    m_dayTrades.clear();
+    m_pendingTrades.clear();
+    m_baselineRows.clear();
+    m_baselineLoaded = false;
+    if (changed) {
+        RebuildPositions();
+    }
+}
+
+void TraderSpi::RebuildPositions() {
+    if (!m_symbols) {
+        return;
+    }
+    if (m_risk) {
+        m_risk->LoadPositions(m_baselineRows, *m_symbols);     // 尚未载入时为空, 净持仓清零
+    }
+    if (m_positions) {
+        if (m_baselineLoaded) {
+            m_positions->Load(m_baselineRows, *m_symbols);
+        } else {
+            m_positions->Reset(*m_symbols);
+        }
+    }
+    if (m_funds) {
+        if (m_baselineLoaded) {
+            m_funds->LoadPositions(m_baselineRows, *m_symbols);
+        } else {
+            m_funds->ResetPositions();
+        }
+    }
+    for (size_t i = 0; i < m_dayTrades.size(); ++i) {
+        ApplyTrade(m_dayTrades[i]);
+    }
+}
+
+void TraderSpi::FinishGateQuery() {
+    if (m_gateQueries > 0 && --m_gateQueries == 0) {
+        ReleasePendingTrades();
+    }
+}
+
+void TraderSpi::ReleasePendingTrades() {
+    if (!m_tradesGated) {
+        return;
+    }
+    m_tradesGated = false;
+
+    // 成交查询结果按私有流顺序包含查询时刻之前的全部当日成交; 查询失败时退回到登录时快照中的成交。
+    // 重排后先开后平的顺序与成交发生的顺序一致, 重放时平仓不会因开仓尚未计入而被截断
+    const std::vector<CThostFtdcTradeField>* base = nullptr;
+    size_t baseCount = 0;
+    if (m_tradeQueryOk) {
+        base = &m_tradeRows;
+        baseCount = m_tradeRows.size();
+    } else if (m_snapshot) {
+        base = &m_snapshot->Trades();
+        baseCount = std::min(m_snapshotTrades, base->size());
+    }
+    std::vector<CThostFtdcTradeField> ordered;
+    std::unordered_set<std::string> keys;
+    ordered.reserve(baseCount + m_dayTrades.size() + m_pendingTrades.size());
+    for (size_t i = 0; i < baseCount; ++i) {
+        if (keys.insert(TradeKey((*base)[i])).second) {
+            ordered.push_back((*base)[i]);
+        }
+    }
+    const size_t baseTrades = ordered.size();
+    for (size_t i = 0; i < m_dayTrades.size(); ++i) {
+        if (keys.insert(TradeKey(m_dayTrades[i])).second) {
+            ordered.push_back(m_dayTrades[i]);
+        }
+    }
+    for (size_t i = 0; i < m_pendingTrades.size(); ++i) {
+        if (keys.insert(TradeKey(m_pendingTrades[i])).second) {
+            ordered.push_back(m_pendingTrades[i]);
+        }
+    }
+    const size_t newTrades = ordered.size() - m_dayTrades.size();
+    m_dayTrades.swap(ordered);
+    m_tradeKeys.swap(keys);
+    RebuildPositions();
+
+    LOG("[成交] {} {} 笔, 暂存的成交 {} 笔, 当日成交 {} 笔, 本次新增 {} 笔, 已重算实时持仓和资金",
+        m_tradeQueryOk ? "成交查询结果" : "快照中的成交", baseTrades, m_pendingTrades.size(), m_dayTrades.size(),
+        newTrades);
+    m_pendingTrades.clear();
+    m_tradeRows.clear();
+}
+
+void TraderSpi::HandleOrderInsertError(const CThostFtdcInputOrderField* pInputOrder,
+                                       const CThostFtdcRspInfoField* pRspInfo) {
+    const int errorId = pRspInfo ? pRspInfo->ErrorID : 0;
+    if (!pInputOrder) {
+        LOG("[错误] 报单被拒, ErrorID: {}", errorId);
+        return;
+    }
+    if (m_orders) {
+        if (!m_orders->OnInsertRejected(m_frontId, m_sessionId, *pInputOrder, errorId)) {
+            return;     // CTP和交易所的拒单可能都会到达, 只打印一次
+        }
+        ApplyOrderUpdate(m_orders->IndexOf(MakeOrderKey(m_frontId, m_sessionId, pInputOrder->OrderRef)));
+    }
+    LOG("[报单] 报单被拒 | 合约: {} | 报单引用: {} | ErrorID: {} | ErrorMsg: {}", pInputOrder->InstrumentID,
+        pInputOrder->OrderRef, errorId, (pRspInfo ? pRspInfo->ErrorMsg : ""));
+}
+
+void TraderSpi::HandleBatchActionError(const char* exchangeId, const CThostFtdcRspInfoField* pRspInfo) {
+    const int errorId = pRspInfo ? pRspInfo->ErrorID : 0;
+    if (errorId == 0) {
+        return;
+    }
+    LOG("[撤单] 批量撤单被拒 | 交易所: {} | ErrorID: {} | ErrorMsg: {}", exchangeId, errorId,
+        (pRspInfo ? pRspInfo->ErrorMsg : ""));
+}
+
+void TraderSpi::HandleOrderActionError(const OrderKey& key, const char* exchangeId, const char* orderSysId,
+                                       const CThostFtdcRspInfoField* pRspInfo) {
+    const int errorId = pRspInfo ? pRspInfo->ErrorID : 0;
+    if (m_orders) {
+        m_orders->OnActionRejected(key, exchangeId, orderSysId, errorId);
+    }
+    LOG("[撤单] 撤单被拒 | 报单引用: {} | 报单编号: {} | ErrorID: {} | ErrorMsg: {}", key.orderRef, orderSysId,
+        errorId, (pRspInfo ? pRspInfo->ErrorMsg : ""));
+}
+
+void TraderSpi::LoadOrderTable() {
+    // 只在进程内首次登录时填充, 断线重连后表中已有全部报单
+    if (!m_orders || !m_snapshot || m_orders->Size() != 0) {
+        return;
+    }
+    const std::vector<CThostFtdcOrderField>& orders = m_snapshot->Orders();
+    for (size_t i = 0; i < orders.size(); ++i) {
+        m_orders->OnRtnOrder(orders[i]);
+    }
+    const std::vector<CThostFtdcTradeField>& trades = m_snapshot->Trades();
+    for (size_t i = 0; i < trades.size(); ++i) {
+        m_orders->OnRtnTrade(trades[i]);
+    }
+    // 快照中的成交经当日成交去重计入持仓、资金和净持仓, 这里只计入挂单和冻结
+    if (m_risk || m_positions || m_funds) {
+        OrderInfo info;
+        for (size_t i = 0; i < m_orders->Size(); ++i) {
+            if (!m_orders->Read(i, info)) {
+                continue;
+            }
+            if (m_risk) {
+                m_risk->OnOrderUpdate(static_cast<uint32_t>(i), info, false);
+            }
+            if (m_positions) {
+                m_positions->OnOrderUpdate(static_cast<uint32_t>(i), info);
+            }
+            if (m_funds) {
+                m_funds->OnOrderUpdate(static_cast<uint32_t>(i), info);
+            }
+        }
+    }
+}
+
+void TraderSpi::ApplyOrderUpdate(int64_t index) {
+    OrderInfo info;
+    if ((!m_risk && !m_positions && !m_funds) || index < 0 || !m_orders->Read(static_cast<size_t>(index), info)) {
+        return;
+    }
+    if (m_risk) {
+        const bool ownSession = info.key.frontId == m_frontId && info.key.sessionId == m_sessionId;
+        m_risk->OnOrderUpdate(static_cast<uint32_t>(index), info, ownSession);
+    }
+    if (m_positions) {
+        m_positions->OnOrderUpdate(static_cast<uint32_t>(index), info);
+    }
+    if (m_funds) {
+        if (m_symbols && m_funds->NeedRates(info.symbolId)) {
+            RequestRates(m_symbols->Name(info.symbolId));
+        }
+        m_funds->OnOrderUpdate(static_cast<uint32_t>(index), info);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 请求
+// ---------------------------------------------------------------------------
+
+void TraderSpi::SetLoginInfo(const std::string& frontAddr,
+                             const std::string& brokerId,
+                             const std::string& userId,
+                             const std::string& password,
+                             const std::string& appId,
+                             const std::string& authCode) {
+    m_frontAddr = frontAddr;
+    m_brokerId = brokerId;
+    m_userId = userId;
+    m_password = password;
+    m_appId = appId;
+    m_authCode = authCode;
+}
+
+void TraderSpi::SetInvestorId(const std::string& investorId) {
+    m_investorId = investorId;
+}
+
+void TraderSpi::SetSnapshot(TradeSnapshot* snapshot) {
+    m_snapshot = snapshot;
+}
+
+void TraderSpi::SetInstrumentCache(InstrumentCache* instruments) {
+    m_instruments = instruments;
+}
+
+void TraderSpi::SetSymbolTable(SymbolTable* symbols) {
+    m_symbols = symbols;
+}
+
+void TraderSpi::SetOrderTable(OrderTable* orders) {
+    m_orders = orders;
+}
+
+void TraderSpi::SetOrderGateway(OrderGateway* gateway) {
+    m_gateway = gateway;
+}
+
+void TraderSpi::SetRiskEngine(RiskEngine* risk) {
+    m_risk = risk;
+}
+
+void TraderSpi::SetPositionKeeper(PositionKeeper* positions) {
+    m_positions = positions;
+}
+
+void TraderSpi::SetFundsEstimator(FundsEstimator* funds) {
+    m_funds = funds;
+}
+
+void TraderSpi::SetLatencyTracker(LatencyTracker* latency) {
+    m_latency = latency;
+}
+
+void TraderSpi::SetRecoveryTracker(RecoveryTracker* recovery) {
+    m_recovery = recovery;
+}
+
+void TraderSpi::ReqUserLogin() {
+    CThostFtdcReqUserLoginField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
+    strncpy(req.Password, m_password.c_str(), sizeof(req.Password) - 1);
+
+    // 如果有认证信息，先进行认证
+    if (!m_appId.empty() && !m_authCode.empty()) {
+        ReqAuthenticate();
+    } else {
+        const int requestId = NextRequestId();
+        int result = m_api->ReqUserLogin(&req, requestId);
+        if (result == 0) {
+            LOG("[请求] 发送登录请求, RequestID: {}", requestId);
+        } else {
+            LOG("[错误] 发送登录请求失败, 返回码: {}", result);
+        }
+    }
+}
+
+void TraderSpi::ReqAuthenticate() {
+    CThostFtdcReqAuthenticateField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
+    strncpy(req.AuthCode, m_authCode.c_str(), sizeof(req.AuthCode) - 1);
+    strncpy(req.AppID, m_appId.c_str(), sizeof(req.AppID) - 1);
+
+    const int requestId = NextRequestId();
+    int result = m_api->ReqAuthenticate(&req, requestId);
+    if (result == 0) {
+        LOG("[请求] 发送认证请求, RequestID: {}", requestId);
+    } else {
+        LOG("[错误] 发送认证请求失败, 返回码: {}", result);
+    }
+}
+
+int TraderSpi::ReqQrySettlementInfo(int requestId) {
+    CThostFtdcQrySettlementInfoField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+
+    return m_api->ReqQrySettlementInfo(&req, requestId);
+}
+
+int TraderSpi::ReqSettlementInfoConfirm(int requestId) {
+    CThostFtdcSettlementInfoConfirmField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+
+    return m_api->ReqSettlementInfoConfirm(&req, requestId);
+}
+
+int TraderSpi::ReqQryTradingAccount(int requestId) {
+    CThostFtdcQryTradingAccountField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+
+    return m_api->ReqQryTradingAccount(&req, requestId);
+}
+
+int TraderSpi::ReqQryInvestorPosition(int requestId) {
+    CThostFtdcQryInvestorPositionField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+
+    return m_api->ReqQryInvestorPosition(&req, requestId);
+}
+
+int TraderSpi::ReqQryTrade(int requestId) {
+    CThostFtdcQryTradeField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+
+    return m_api->ReqQryTrade(&req, requestId);
+}
+
+int TraderSpi::ReqQryInstrument(int requestId) {
+    CThostFtdcQryInstrumentField req = {0};
+    return m_api->ReqQryInstrument(&req, requestId);
+}
+
+int TraderSpi::ReqQryInstrumentMarginRate(const std::string& instrumentId, int requestId) {
+    CThostFtdcQryInstrumentMarginRateField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+    strncpy(req.InstrumentID, instrumentId.c_str(), sizeof(req.InstrumentID) - 1);
+    req.HedgeFlag = THOST_FTDC_HF_Speculation;
+
+    return m_api->ReqQryInstrumentMarginRate(&req, requestId);
+}
+
+int TraderSpi::ReqQryInstrumentCommissionRate(const std::string& instrumentId, int requestId) {
+    CThostFtdcQryInstrumentCommissionRateField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
+    strncpy(req.InstrumentID, instrumentId.c_str(), sizeof(req.InstrumentID) - 1);
+
+    return m_api->ReqQryInstrumentCommissionRate(&req, requestId);
+}
+
+void TraderSpi::RequestRates(const std::string& instrumentId) {
+    const std::string target = instrumentId.empty() ? "持仓合约" : instrumentId;
+    m_scheduler.Submit("查询保证金率 " + target, kQueryPriorityLow,
+                       std::bind(&TraderSpi::ReqQryInstrumentMarginRate, this, instrumentId, std::placeholders::_1));
+    m_scheduler.Submit("查询手续费率 " + target, kQueryPriorityLow,
+                       std::bind(&TraderSpi::ReqQryInstrumentCommissionRate, this, instrumentId,
+                                 std::placeholders::_1));
+}
+
+void TraderSpi::SubmitQuery(QueryKind kind, const std::string& name, int priority,
+                            const QueryScheduler::Sender& sender, bool throttled) {
+    const uint64_t login = m_loginSeq;
+    m_scheduler.Submit(name, priority, sender, throttled,
+                       [this, kind, login](int requestId) { PostQueryFailure(kind, login, requestId); });
+}
+
+void TraderSpi::PostQueryFailure(QueryKind kind, uint64_t login, int requestId) {
+    QueryFailure failure;
+    failure.kind = kind;
+    failure.login = login;
+    failure.requestId = requestId;
+    {
+        std::lock_guard<std::mutex> lock(m_failureMutex);
+        m_queryFailures.push_back(failure);
+        m_queryFailed.store(true, std::memory_order_release);
+    }
+    m_waiter.Notify();
+}
+
+void TraderSpi::HandleQueryFailures() {
+    std::vector<QueryFailure> failures;
+    {
+        std::lock_guard<std::mutex> lock(m_failureMutex);
+        failures.swap(m_queryFailures);
+        m_queryFailed.store(false, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < failures.size(); ++i) {
+        if (failures[i].login != m_loginSeq || !m_loggedIn.load()) {
+            continue;   // 断线前提交的请求, 重新登录后的启动查询另行提交
+        }
+        LOG("[错误] 请求被放弃, RequestID: {}, 按失败继续启动流程", failures[i].requestId);
+        CompleteQuery(failures[i].kind, false);
+    }
+}
+
+void TraderSpi::CompleteQuery(QueryKind kind, bool ok) {
+    switch (kind) {
+        case kQuerySettlementInfo:
+            FinishStartupQuery();
+            // 查询完成后进行结算确认, 查询失败也继续确认; 结算确认不占用查询流控额度
+            LOG("[状态] 确认投资者结算信息...");
+            SubmitQuery(kQuerySettlementConfirm, "结算确认", kQueryPriorityHigh,
+                        std::bind(&TraderSpi::ReqSettlementInfoConfirm, this, std::placeholders::_1), false);
+            break;
+        case kQuerySettlementConfirm:
+        case kQueryAccount:
+            FinishStartupQuery();
+            break;
+        case kQueryPosition:
+            if (ok && m_symbols) {
+                // 昨仓当日不变, 只取当日首次成功的查询结果; 放开成交暂存时重算实时持仓
+                if (!m_baselineLoaded) {
+                    m_baselineRows = m_positionRows;
+                    m_baselineLoaded = true;
+                }
+                if (m_funds) {
+                    RequestRates("");   // 持仓合约的费率, 其余合约在首次报单或成交时补查
+                }
+            }
+            m_positionRows.clear();
+            FinishGateQuery();
+            FinishStartupQuery();
+            break;
+        case kQueryTrade:
+            m_tradeQueryOk = ok;
+            FinishGateQuery();
+            FinishStartupQuery();
+            break;
+        case kQueryInstrument:
+            if (ok && m_instruments && !m_instrumentRows.empty()) {
+                const std::string tradingDay = m_api->GetTradingDay();
+                if (m_instruments->Build(tradingDay, m_instrumentRows)) {
+                    LOG("[合约] 查询合约完成, 共 {} 个, 已写入交易日 {} 的缓存", m_instruments->Size(), tradingDay);
+                    InternInstruments();
+                }
+            }
+            m_instrumentRows.clear();
+            m_instrumentRows.shrink_to_fit();
+            FinishStartupQuery();
+            break;
+    }
+}
+
+bool TraderSpi::ReqUserLogout() {
+    CThostFtdcUserLogoutField req = {0};
+
+    strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
+
+    const int requestId = NextRequestId();
+    int result = m_api->ReqUserLogout(&req, requestId);
+    if (result == 0) {
+        LOG("[请求] 发送登出请求, RequestID: {}", requestId);
+    } else {
+        LOG("[错误] 发送登出请求失败, 返回码: {}", result);
+    }
+    return result == 0;
+}
@@ -0,0 +1,448 @@
+///
+/// @file TraderSpi.h
+/// @brief CTP交易回调类
+///
+
+#ifndef CTP_TEST_TRADER_SPI_H
+#define CTP_TEST_TRADER_SPI_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "ThostFtdcTraderApi.h"
+#include "ConsumerWaiter.h"
+#include "ControlEvents.h"
+#include "FundsEstimator.h"
+#include "IdAllocator.h"
+#include "InstrumentCache.h"
+#include "LatencyTracker.h"
+#include "OrderGateway.h"
+#include "OrderTable.h"
+#include "PositionKeeper.h"
+#include "QueryScheduler.h"
+#include "RecoveryTracker.h"
+#include "RiskEngine.h"
+#include "SpscQueue.h"
+#include "SymbolTable.h"
+#include "TradeSnapshot.h"
+#include "TraderEvent.h"
+
+///
+/// @brief 回调事件队列统计
+///
+struct TraderEventStats {
+    uint64_t posted;            ///< 入队事件数
+    uint64_t dropped;           ///< 停止后丢弃的事件数
+    uint64_t queueFullSpins;    ///< 队列满时回调线程的等待次数
+    int64_t maxResidenceNs;     ///< 回调函数最大驻留时间
+    int64_t totalResidenceNs;   ///< 回调函数累计驻留时间
+    int64_t maxQueueDelayNs;    ///< 事件从入队到被处理的最大延迟
+};
+
+///
+/// @brief CTP交易回调类
+///
+/// CTP回调线程只负责把回调参数拷贝进单生产者单消费者环形队列并立即返回,
+/// 打印和后续请求等实际处理工作由独立的处理线程完成, 避免阻塞CTP的I/O线程。
+///
+class TraderSpi : public CThostFtdcTraderSpi {
+public:
+    /// @param control 断开连接、登录失败、登出完成时向主线程投递的控制事件
+    TraderSpi(CThostFtdcTraderApi* api, ControlEvents& control, size_t queueCapacity = 4096);
+    ~TraderSpi();
+
+    /// 启动事件处理线程, 须在 CThostFtdcTraderApi::Init() 之前调用
+    void Start();
+
+    /// 处理完队列中剩余事件后停止处理线程, 之后到达的回调将被丢弃
+    void Stop();
+
+    /// 获取事件队列统计
+    TraderEventStats GetStats() const;
+
+    /// 是否处于已登录状态
+    bool IsLoggedIn() const { return m_loggedIn.load(); }
+
+    /// RequestID/OrderRef 分配器, 登录成功时以 MaxOrderRef 重置 OrderRef 起点
+    IdAllocator& Ids() { return m_ids; }
+
+    /// 当客户端与交易后台建立起通信连接时，服务器主动发送登录请求
+    virtual void OnFrontConnected() override;
+
+    /// 当客户端与交易后台通信连接断开时，该方法被调用
+    virtual void OnFrontDisconnected(int nReason) override;
+
+    /// 心跳超时警告
+    virtual void OnHeartBeatWarning(int nTimeLapse) override;
+
+    /// 客户端认证响应
+    virtual void OnRspAuthenticate(CThostFtdcRspAuthenticateField *pRspAuthenticateField,
+                                   CThostFtdcRspInfoField *pRspInfo,
+                                   int nRequestID, bool bIsLast) override;
+
+    /// 登录请求响应
+    virtual void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin,
+                                CThostFtdcRspInfoField *pRspInfo,
+                                int nRequestID, bool bIsLast) override;
+
+    /// 登出请求响应
+    virtual void OnRspUserLogout(CThostFtdcUserLogoutField *pUserLogout,
+                                 CThostFtdcRspInfoField *pRspInfo,
+                                 int nRequestID, bool bIsLast) override;
+
+    /// 查询结算信息响应
+    virtual void OnRspQrySettlementInfo(CThostFtdcSettlementInfoField *pSettlementInfo,
+                                        CThostFtdcRspInfoField *pRspInfo,
+                                        int nRequestID, bool bIsLast) override;
+
+    /// 投资者结算结果确认响应
+    virtual void OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                            CThostFtdcRspInfoField *pRspInfo,
+                                            int nRequestID, bool bIsLast) override;
+
+    /// 查询资金账户响应
+    virtual void OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTradingAccount,
+                                        CThostFtdcRspInfoField *pRspInfo,
+                                        int nRequestID, bool bIsLast) override;
+
+    /// 查询投资者持仓响应
+    virtual void OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *pInvestorPosition,
+                                          CThostFtdcRspInfoField *pRspInfo,
+                                          int nRequestID, bool bIsLast) override;
+
+    /// 查询合约响应
+    virtual void OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument,
+                                    CThostFtdcRspInfoField *pRspInfo,
+                                    int nRequestID, bool bIsLast) override;
+
+    /// 查询合约保证金率响应
+    virtual void OnRspQryInstrumentMarginRate(CThostFtdcInstrumentMarginRateField *pInstrumentMarginRate,
+                                              CThostFtdcRspInfoField *pRspInfo,
+                                              int nRequestID, bool bIsLast) override;
+
+    /// 查询合约手续费率响应
+    virtual void OnRspQryInstrumentCommissionRate(CThostFtdcInstrumentCommissionRateField *pInstrumentCommissionRate,
+                                                  CThostFtdcRspInfoField *pRspInfo,
+                                                  int nRequestID, bool bIsLast) override;
+
+    /// 查询成交响应
+    virtual void OnRspQryTrade(CThostFtdcTradeField *pTrade, CThostFtdcRspInfoField *pRspInfo,
+                               int nRequestID, bool bIsLast) override;
+
+    /// 错误应答
+    virtual void OnRspError(CThostFtdcRspInfoField *pRspInfo,
+                            int nRequestID, bool bIsLast) override;
+
+    /// 报单通知
+    virtual void OnRtnOrder(CThostFtdcOrderField *pOrder) override;
+
+    /// 成交通知
+    virtual void OnRtnTrade(CThostFtdcTradeField *pTrade) override;
+
+    /// 报单录入请求响应, 仅在CTP拒绝报单时调用
+    virtual void OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder,
+                                  CThostFtdcRspInfoField *pRspInfo,
+                                  int nRequestID, bool bIsLast) override;
+
+    /// 交易所报单录入错误回报
+    virtual void OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder,
+                                     CThostFtdcRspInfoField *pRspInfo) override;
+
+    /// 报单操作请求响应, 仅在CTP拒绝撤单时调用
+    virtual void OnRspOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction,
+                                  CThostFtdcRspInfoField *pRspInfo,
+                                  int nRequestID, bool bIsLast) override;
+
+    /// 交易所报单操作错误回报
+    virtual void OnErrRtnOrderAction(CThostFtdcOrderActionField *pOrderAction,
+                                     CThostFtdcRspInfoField *pRspInfo) override;
+
+    /// 批量报单操作请求响应, 仅在CTP拒绝批量撤单时调用
+    virtual void OnRspBatchOrderAction(CThostFtdcInputBatchOrderActionField *pInputBatchOrderAction,
+                                       CThostFtdcRspInfoField *pRspInfo,
+                                       int nRequestID, bool bIsLast) override;
+
+    /// 交易所批量报单操作错误回报
+    virtual void OnErrRtnBatchOrderAction(CThostFtdcBatchOrderActionField *pBatchOrderAction,
+                                          CThostFtdcRspInfoField *pRspInfo) override;
+
+    /// 设置登录参数
+    void SetLoginInfo(const std::string& frontAddr,
+                      const std::string& brokerId,
+                      const std::string& userId,
+                      const std::string& password,
+                      const std::string& appId = "",
+                      const std::string& authCode = "");
+
+    /// 设置投资者ID
+    void SetInvestorId(const std::string& investorId);
+
+    /// 设置报单/成交快照, 登录后按交易日打开, 回报在处理线程中写入; 须在 Start() 之前调用
+    void SetSnapshot(TradeSnapshot* snapshot);
+
+    /// 设置合约缓存, 登录后按交易日映射, 缓存不存在时查询全部合约并生成; 须在 Start() 之前调用
+    void SetInstrumentCache(InstrumentCache* instruments);
+
+    /// 设置合约编号表, 合约缓存可用后按缓存顺序为全部合约分配编号; 须在 Start() 之前调用
+    void SetSymbolTable(SymbolTable* symbols);
+
+    /// 设置报单状态表, 报单/成交回报和拒单在处理线程中写入; 须在 Start() 之前调用
+    void SetOrderTable(OrderTable* orders);
+
+    /// 设置报单网关, 登录后更新会话信息, 合约编号分配后生成报单模板; 须在 Start() 之前调用
+    void SetOrderGateway(OrderGateway* gateway);
+
+    /// 设置报单前风控, 报单状态变化、持仓查询结果和成交回报在处理线程中写入; 须在 Start() 之前调用
+    void SetRiskEngine(RiskEngine* risk);
+
+    /// 设置实时持仓, 持仓查询结果、成交回报和报单状态变化在处理线程中写入; 须在 Start() 之前调用
+    void SetPositionKeeper(PositionKeeper* positions);
+
+    /// 设置资金估算, 资金和持仓查询结果、费率、成交回报和报单状态变化在处理线程中写入;
+    /// 须在 Start() 之前调用
+    void SetFundsEstimator(FundsEstimator* funds);
+
+    /// 设置延迟统计, 本会话报单的回报和成交在处理线程中记录; 须在 Start() 之前调用
+    void SetLatencyTracker(LatencyTracker* latency);
+
+    /// 设置断线恢复耗时统计, 断线、重连、登录和启动查询完成在处理线程中记录; 须在 Start() 之前调用
+    void SetRecoveryTracker(RecoveryTracker* recovery);
+
+    /// 请求用户登录
+    void ReqUserLogin();
+
+    /// 客户端认证请求
+    void ReqAuthenticate();
+
+    /// 请求登出, 请求发送失败时返回false
+    bool ReqUserLogout();
+
+private:
+    /// 经 QueryScheduler 发送、完成或放弃时须继续启动流程的请求
+    enum QueryKind {
+        kQuerySettlementInfo,
+        kQuerySettlementConfirm,
+        kQueryAccount,
+        kQueryPosition,
+        kQueryTrade,
+        kQueryInstrument,
+    };
+
+    /// 被调度器放弃的请求, 由放弃它的线程登记, 处理线程处理
+    struct QueryFailure {
+        QueryKind kind;
+        uint64_t login;         ///< 提交时的登录序号, 重新登录后旧请求的失败不再处理
+        int requestId;
+    };
+
+    /// 回调线程: 申请队列槽位, 队列满时让出CPU等待处理线程
+    TraderEvent* ClaimEvent();
+
+    /// 回调线程: 申请槽位并填写事件头, 已停止时返回nullptr
+    TraderEvent* BeginEvent(TraderEventType type, const CThostFtdcRspInfoField* pRspInfo,
+                            int nRequestID, bool bIsLast, int64_t startNs);
+
+    /// 回调线程: 发布事件并在处理线程休眠时唤醒它
+    void PublishEvent(int64_t startNs);
+
+    /// 回调线程: 投递不带数据的事件
+    void PostSignal(TraderEventType type, int arg);
+
+    /// 回调线程: 拷贝回调数据并投递事件
+    template <typename T>
+    void Post(TraderEventType type, T TraderEventData::*member, const T* data,
+              const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+
+    /// 分配RequestID, 可在任意线程调用
+    int NextRequestId() { return m_ids.NextRequestId(); }
+
+    // 以下查询请求由 QueryScheduler 调用, 返回CTP Req*函数的返回码
+    /// 查询结算信息
+    int ReqQrySettlementInfo(int requestId);
+
+    /// 投资者结算结果确认
+    int ReqSettlementInfoConfirm(int requestId);
+
+    /// 查询资金账户
+    int ReqQryTradingAccount(int requestId);
+
+    /// 查询投资者持仓
+    int ReqQryInvestorPosition(int requestId);
+
+    /// 查询当日全部成交
+    int ReqQryTrade(int requestId);
+
+    /// 查询全部合约
+    int ReqQryInstrument(int requestId);
+
+    /// 查询保证金率/手续费率, 合约为空时查询全部持仓合约
+    int ReqQryInstrumentMarginRate(const std::string& instrumentId, int requestId);
+    int ReqQryInstrumentCommissionRate(const std::string& instrumentId, int requestId);
+
+    /// 提交一个合约(为空时为全部持仓合约)的保证金率和手续费率查询
+    void RequestRates(const std::string& instrumentId);
+
+    /// 提交启动流程中的请求, 被放弃时经 PostQueryFailure() 交给处理线程按失败完成
+    void SubmitQuery(QueryKind kind, const std::string& name, int priority, const QueryScheduler::Sender& sender,
+                     bool throttled = true);
+
+    /// 任意线程: 登记被放弃的请求并唤醒处理线程
+    void PostQueryFailure(QueryKind kind, uint64_t login, int requestId);
+
+    /// 处理线程: 处理已登记的放弃请求
+    void HandleQueryFailures();
+
+    /// 请求完成(收到最后一条响应或被放弃), 继续启动流程; ok 为false时查询结果不可用
+    void CompleteQuery(QueryKind kind, bool ok);
+
+    /// 为合约缓存中的全部合约分配编号并生成报单模板
+    void InternInstruments();
+
+    /// 启动查询完成一项, 全部完成时输出提示
+    void FinishStartupQuery();
+
+    /// 处理线程主循环
+    void DispatchLoop();
+
+    /// 按事件类型分发
+    void Dispatch(const TraderEvent& ev);
+
+    // 以下 Handle* 函数均运行在处理线程
+    void HandleFrontConnected();
+    void HandleFrontDisconnected(int nReason);
+    void HandleHeartBeatWarning(int nTimeLapse);
+    void HandleRspAuthenticate(const CThostFtdcRspAuthenticateField* pRspAuthenticateField,
+                               const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspUserLogin(const CThostFtdcRspUserLoginField* pRspUserLogin,
+                            const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspUserLogout(const CThostFtdcUserLogoutField* pUserLogout,
+                             const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspQrySettlementInfo(const CThostFtdcSettlementInfoField* pSettlementInfo,
+                                    const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspSettlementInfoConfirm(const CThostFtdcSettlementInfoConfirmField* pSettlementInfoConfirm,
+                                        const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspQryTradingAccount(const CThostFtdcTradingAccountField* pTradingAccount,
+                                    const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspQryInvestorPosition(const CThostFtdcInvestorPositionField* pInvestorPosition,
+                                      const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspQryInstrument(const CThostFtdcInstrumentField* pInstrument,
+                                const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspQryInstrumentMarginRate(const CThostFtdcInstrumentMarginRateField* pMarginRate,
+                                          const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRspQryInstrumentCommissionRate(const CThostFtdcInstrumentCommissionRateField* pCommissionRate,
+                                              const CThostFtdcRspInfoField* pRspInfo, int nRequestID,
+                                              bool bIsLast);
+    void HandleRspQryTrade(const CThostFtdcTradeField* pTrade, const CThostFtdcRspInfoField* pRspInfo,
+                           int nRequestID, bool bIsLast);
+    void HandleRspError(const CThostFtdcRspInfoField* pRspInfo, int nRequestID, bool bIsLast);
+    void HandleRtnOrder(const CThostFtdcOrderField* pOrder, int64_t recvNs);
+    void HandleRtnTrade(const CThostFtdcTradeField* pTrade, int64_t recvNs);
+    void HandleOrderInsertError(const CThostFtdcInputOrderField* pInputOrder,
+                                const CThostFtdcRspInfoField* pRspInfo);
+    void HandleBatchActionError(const char* exchangeId, const CThostFtdcRspInfoField* pRspInfo);
+    void HandleOrderActionError(const OrderKey& key, const char* exchangeId, const char* orderSysId,
+                                const CThostFtdcRspInfoField* pRspInfo);
+
+    /// 登录后用快照中的报单和成交填充报单状态表
+    void LoadOrderTable();
+
+    /// 报单状态表中的记录有变化后同步到风控、实时持仓和资金估算
+    void ApplyOrderUpdate(int64_t index);
+
+    /// 成交计入风控净持仓、实时持仓和资金估算, 缺少费率时补查
+    void ApplyTrade(const CThostFtdcTradeField& trade);
+
+    /// 按成交编号去重, 当日首次出现的成交记入当日成交并计入; 重复的返回false
+    bool ApplyNewTrade(const CThostFtdcTradeField& trade);
+
+    /// 交易日变化时清空当日成交和昨仓基线
+    void ResetTradingDay(const std::string& tradingDay);
+
+    /// 以昨仓基线(尚未载入时为0)重新计算风控净持仓、实时持仓和资金估算, 按顺序重放当日成交
+    void RebuildPositions();
+
+    /// 持仓或成交查询结束(成功、出错或被放弃), 两者都结束后放开成交暂存
+    void FinishGateQuery();
+
+    /// 放开成交暂存: 按成交查询结果(失败时为登录时快照中的成交)、此前已计入的成交、暂存的成交的顺序
+    /// 去重重排当日成交并重算实时持仓和资金估算
+    void ReleasePendingTrades();
+
+    CThostFtdcTraderApi* m_api;
+    ControlEvents& m_control;
+    std::atomic<bool> m_loggedIn;
+    IdAllocator m_ids;
+    std::string m_frontAddr;
+    std::string m_brokerId;
+    std::string m_userId;
+    std::string m_password;
+    std::string m_investorId;
+    std::string m_appId;
+    std::string m_authCode;
+    TradeSnapshot* m_snapshot;
+    InstrumentCache* m_instruments;
+    SymbolTable* m_symbols;
+    OrderGateway* m_gateway;
+    OrderTable* m_orders;
+    RiskEngine* m_risk;
+    PositionKeeper* m_positions;
+    FundsEstimator* m_funds;
+    LatencyTracker* m_latency;
+    RecoveryTracker* m_recovery;
+    int m_frontId;              ///< 本会话的前置编号, 仅处理线程访问
+    int m_sessionId;            ///< 本会话的会话编号, 仅处理线程访问
+    std::vector<CThostFtdcInstrumentField> m_instrumentRows;   ///< 合约查询结果, 仅处理线程访问
+    std::vector<CThostFtdcInvestorPositionField> m_positionRows;   ///< 持仓查询结果, 仅处理线程访问
+    std::vector<CThostFtdcTradeField> m_tradeRows;     ///< 成交查询结果, 仅处理线程访问
+
+    // 查询调度, 登录后的查询均经由它发送
+    QueryScheduler m_scheduler;
+    int m_startupQueries;       ///< 尚未完成的启动查询数, 仅处理线程访问
+    uint64_t m_loginSeq;        ///< 登录成功次数, 仅处理线程访问
+    bool m_reconnecting;        ///< 断线后尚未完成重新登录和启动查询, 仅处理线程访问
+    int m_positionRequestId;    ///< m_positionRows 所属查询的 RequestID, 仅处理线程访问
+    int m_instrumentRequestId;  ///< m_instrumentRows 所属查询的 RequestID, 仅处理线程访问
+    int m_tradeRequestId;       ///< m_tradeRows 所属查询的 RequestID, 仅处理线程访问
+
+    // 实时持仓和资金估算 = 昨仓基线 + 当日全部成交, 每笔成交按 交易所+成交编号+方向 只计入一次。
+    // 续传、重传、成交查询和快照中的成交可能重复, 均经 ApplyNewTrade() 去重; 均仅处理线程访问
+    std::string m_tradeDay;                         ///< 当日成交所属的交易日
+    std::unordered_set<std::string> m_tradeKeys;    ///< 已计入的成交
+    std::vector<CThostFtdcTradeField> m_dayTrades;  ///< 已计入的成交, 按私有流顺序
+    std::vector<CThostFtdcInvestorPositionField> m_baselineRows;    ///< 当日首次成功的持仓查询结果
+    bool m_baselineLoaded;                          ///< 当日已从持仓查询载入昨仓基线
+
+    // 登录后持仓和成交查询都结束前到达的成交先暂存; 断线时不清空, 未放开的成交留到下次登录
+    bool m_tradesGated;                     ///< 持仓或成交查询尚未结束, 成交暂存
+    int m_gateQueries;                      ///< 尚未结束的持仓和成交查询数
+    bool m_tradeQueryOk;                    ///< 本次登录的成交查询成功
+    size_t m_snapshotTrades;                ///< 登录时快照中的成交数, 成交查询失败时计入这部分
+    std::vector<CThostFtdcTradeField> m_pendingTrades;
+
+    // 回调线程 -> 处理线程
+    SpscQueue<TraderEvent> m_queue;
+    std::thread m_dispatchThread;
+    std::atomic<bool> m_stopping;
+    ConsumerWaiter m_waiter;
+
+    // 调度器放弃的请求 -> 处理线程
+    std::mutex m_failureMutex;
+    std::vector<QueryFailure> m_queryFailures;
+    std::atomic<bool> m_queryFailed;
+
+    // 统计, 由回调线程写入
+    std::atomic<uint64_t> m_posted;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_queueFullSpins;
+    std::atomic<int64_t> m_maxResidenceNs;
+    std::atomic<int64_t> m_totalResidenceNs;
+    // 统计, 由处理线程写入
+    std::atomic<int64_t> m_maxQueueDelayNs;
+};
+
+#endif // CTP_TEST_TRADER_SPI_H
@@ -0,0 +1,287 @@
+///
+/// @file TriggerEngine.cpp
+/// @brief 本地条件单实现
+///
+
+#include "TriggerEngine.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "AsyncLogger.h"
+
+namespace {
+
+// 价格比较容差, 远小于任何合约的最小变动价位
+const double kPriceEpsilon = 1e-7;
+
+// CTP用 DBL_MAX 表示无效价格, 统一换成0
+inline double ValidPrice(double price) {
+    return (price > 0.0 && price < DBL_MAX) ? price : 0.0;
+}
+
+// 上穿阶梯: 触发价低的在堆顶
+inline bool RisingAfter(double a, double b) {
+    return a > b;
+}
+
+// 下穿阶梯: 触发价高的在堆顶
+inline bool FallingAfter(double a, double b) {
+    return a < b;
+}
+
+// 单写者计数, 其他线程只读
+inline void Bump(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+const char* KindName(TriggerKind kind) {
+    switch (kind) {
+        case TriggerKind::Stop:
+            return "止损";
+        case TriggerKind::StopLimit:
+            return "止损限价";
+        case TriggerKind::TakeProfit:
+            return "止盈";
+    }
+    return "未知";
+}
+
+} // namespace
+
+TriggerEngine::TriggerEngine(OrderGateway& gateway, size_t symbolCapacity, size_t capacity)
+    : m_gateway(gateway), m_ladders(symbolCapacity * 2), m_triggers(capacity), m_added(0), m_fired(0),
+      m_sendFailed(0), m_cancelled(0), m_ocoCancelled(0) {
+    for (size_t i = 0; i < m_ladders.size(); ++i) {
+        m_ladders[i].stale = 0;
+    }
+    // 空闲栈按下标从小到大弹出
+    m_free.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i) {
+        m_triggers[i - 1].generation = 0;
+        m_triggers[i - 1].ocoNext = static_cast<uint32_t>(i - 1);
+        m_free.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+int64_t TriggerEngine::Add(const TriggerSpec& spec) {
+    const bool buy = spec.direction == THOST_FTDC_D_Buy;
+    if (spec.symbolId >= m_ladders.size() / 2 || (!buy && spec.direction != THOST_FTDC_D_Sell) ||
+        spec.volume <= 0 || ValidPrice(spec.triggerPrice) == 0.0 ||
+        (spec.kind == TriggerKind::StopLimit && ValidPrice(spec.limitPrice) == 0.0)) {
+        return kTriggerBadSpec;
+    }
+    if (m_free.empty()) {
+        return kTriggerFull;
+    }
+    const uint32_t index = m_free.back();
+    m_free.pop_back();
+    Trigger& trigger = m_triggers[index];
+    trigger.spec = spec;
+    trigger.generation += 1;
+    trigger.ocoNext = index;
+
+    const size_t ladder = LadderOf(spec);
+    std::vector<Entry>& heap = m_ladders[ladder].heap;
+    Entry entry = {spec.triggerPrice, index, trigger.generation};
+    heap.push_back(entry);
+    if (ladder % 2 == 0) {
+        std::push_heap(heap.begin(), heap.end(), [](const Entry& a, const Entry& b) {
+            return RisingAfter(a.price, b.price);
+        });
+    } else {
+        std::push_heap(heap.begin(), heap.end(), [](const Entry& a, const Entry& b) {
+            return FallingAfter(a.price, b.price);
+        });
+    }
+    Bump(m_added);
+    return MakeId(index, trigger.generation);
+}
+
+bool TriggerEngine::Cancel(int64_t id) {
+    const Trigger* trigger = Find(id);
+    if (!trigger) {
+        return false;
+    }
+    Release(static_cast<uint32_t>(trigger - &m_triggers[0]), true);
+    Bump(m_cancelled);
+    return true;
+}
+
+bool TriggerEngine::LinkOco(int64_t first, int64_t second) {
+    const Trigger* a = Find(first);
+    const Trigger* b = Find(second);
+    if (!a || !b) {
+        return false;
+    }
+    const uint32_t ia = static_cast<uint32_t>(a - &m_triggers[0]);
+    const uint32_t ib = static_cast<uint32_t>(b - &m_triggers[0]);
+    for (uint32_t i = ia;;) {
+        if (i == ib) {
+            return false;
+        }
+        i = m_triggers[i].ocoNext;
+        if (i == ia) {
+            break;
+        }
+    }
+    // 交换两个环上的后继即把两个环接成一个
+    std::swap(m_triggers[ia].ocoNext, m_triggers[ib].ocoNext);
+    return true;
+}
+
+bool TriggerEngine::IsResting(int64_t id) const {
+    return Find(id) != nullptr;
+}
+
+void TriggerEngine::OnTick(uint32_t symbolId, const CThostFtdcDepthMarketDataField& data, int64_t recvNs) {
+    const double last = ValidPrice(data.LastPrice);
+    if (last == 0.0 || symbolId >= m_ladders.size() / 2) {
+        return;
+    }
+    const size_t rising = static_cast<size_t>(symbolId) * 2;
+    const size_t falling = rising + 1;
+    while (!m_ladders[rising].heap.empty() && m_ladders[rising].heap.front().price <= last + kPriceEpsilon) {
+        const Entry top = m_ladders[rising].heap.front();
+        PopTop(rising);
+        if (m_triggers[top.index].generation == top.generation) {
+            Fire(top.index, data, last, recvNs);
+        } else {
+            m_ladders[rising].stale -= 1;
+        }
+    }
+    while (!m_ladders[falling].heap.empty() && m_ladders[falling].heap.front().price >= last - kPriceEpsilon) {
+        const Entry top = m_ladders[falling].heap.front();
+        PopTop(falling);
+        if (m_triggers[top.index].generation == top.generation) {
+            Fire(top.index, data, last, recvNs);
+        } else {
+            m_ladders[falling].stale -= 1;
+        }
+    }
+}
+
+TriggerStats TriggerEngine::GetStats() const {
+    TriggerStats stats;
+    stats.added = m_added.load(std::memory_order_relaxed);
+    stats.fired = m_fired.load(std::memory_order_relaxed);
+    stats.sendFailed = m_sendFailed.load(std::memory_order_relaxed);
+    stats.cancelled = m_cancelled.load(std::memory_order_relaxed);
+    stats.ocoCancelled = m_ocoCancelled.load(std::memory_order_relaxed);
+    stats.resting = stats.added - stats.fired - stats.cancelled - stats.ocoCancelled;
+    return stats;
+}
+
+int64_t TriggerEngine::MakeId(uint32_t index, uint32_t generation) {
+    return (static_cast<int64_t>(generation) << 32) | index;
+}
+
+const TriggerEngine::Trigger* TriggerEngine::Find(int64_t id) const {
+    if (id <= 0) {
+        return nullptr;
+    }
+    const uint32_t index = static_cast<uint32_t>(id & 0xffffffff);
+    const uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= m_triggers.size() || (generation & 1) == 0 || m_triggers[index].generation != generation) {
+        return nullptr;
+    }
+    return &m_triggers[index];
+}
+
+size_t TriggerEngine::LadderOf(const TriggerSpec& spec) {
+    const bool buy = spec.direction == THOST_FTDC_D_Buy;
+    const bool rising = spec.kind == TriggerKind::TakeProfit ? !buy : buy;
+    return static_cast<size_t>(spec.symbolId) * 2 + (rising ? 0 : 1);
+}
+
+void TriggerEngine::PopTop(size_t ladder) {
+    std::vector<Entry>& heap = m_ladders[ladder].heap;
+    if (ladder % 2 == 0) {
+        std::pop_heap(heap.begin(), heap.end(), [](const Entry& a, const Entry& b) {
+            return RisingAfter(a.price, b.price);
+        });
+    } else {
+        std::pop_heap(heap.begin(), heap.end(), [](const Entry& a, const Entry& b) {
+            return FallingAfter(a.price, b.price);
+        });
+    }
+    heap.pop_back();
+}
+
+void TriggerEngine::Release(uint32_t index, bool inHeap) {
+    Trigger& trigger = m_triggers[index];
+    // 从环上摘下: 找到前驱, 让它指向自己的后继
+    uint32_t prev = index;
+    while (m_triggers[prev].ocoNext != index) {
+        prev = m_triggers[prev].ocoNext;
+    }
+    m_triggers[prev].ocoNext = trigger.ocoNext;
+    trigger.ocoNext = index;
+    trigger.generation += 1;
+    m_free.push_back(index);
+
+    if (!inHeap) {
+        return;
+    }
+    const size_t ladderIndex = LadderOf(trigger.spec);
+    Ladder& ladder = m_ladders[ladderIndex];
+    ladder.stale += 1;
+    if (ladder.stale * 2 <= ladder.heap.size()) {
+        return;
+    }
+    // 失效元素过半, 整理并重新建堆
+    std::vector<Entry>& heap = ladder.heap;
+    const std::vector<Trigger>& triggers = m_triggers;
+    heap.erase(std::remove_if(heap.begin(), heap.end(), [&triggers](const Entry& e) {
+        return triggers[e.index].generation != e.generation;
+    }), heap.end());
+    if (ladderIndex % 2 == 0) {
+        std::make_heap(heap.begin(), heap.end(), [](const Entry& a, const Entry& b) {
+            return RisingAfter(a.price, b.price);
+        });
+    } else {
+        std::make_heap(heap.begin(), heap.end(), [](const Entry& a, const Entry& b) {
+            return FallingAfter(a.price, b.price);
+        });
+    }
+    ladder.stale = 0;
+}
+
+void TriggerEngine::Fire(uint32_t index, const CThostFtdcDepthMarketDataField& data, double lastPrice,
+                         int64_t recvNs) {
+    const TriggerSpec spec = m_triggers[index].spec;
+    const int64_t id = MakeId(index, m_triggers[index].generation);
+
+    // 先撤销同组其余条件单, 它们可能在本笔行情中也已越过触发价
+    while (m_triggers[index].ocoNext != index) {
+        Release(m_triggers[index].ocoNext, true);
+        Bump(m_ocoCancelled);
+    }
+    Release(index, false);
+    Bump(m_fired);
+
+    const bool buy = spec.direction == THOST_FTDC_D_Buy;
+    double price = spec.kind == TriggerKind::Stop ? 0.0 : ValidPrice(spec.limitPrice);
+    if (price == 0.0) {
+        // 以涨跌停价发出等同市价; 没有涨跌停价时用对手价, 再没有时用最新价
+        price = ValidPrice(buy ? data.UpperLimitPrice : data.LowerLimitPrice);
+        if (price == 0.0) {
+            price = ValidPrice(buy ? data.AskPrice1 : data.BidPrice1);
+        }
+        if (price == 0.0) {
+            price = lastPrice;
+        }
+    }
+    int orderRef = 0;
+    const int result = m_gateway.InsertLimit(spec.symbolId, spec.direction, spec.offset, price, spec.volume,
+                                             spec.strategy, &orderRef, recvNs);
+    if (result != 0) {
+        Bump(m_sendFailed);
+        LOG("[触发] 条件单触发后报单失败 | 编号: {} | 合约: {} | 类型: {} | 触发价: {} | 最新价: {} | 返回码: {}", id,
+            data.InstrumentID, KindName(spec.kind), spec.triggerPrice, lastPrice, result);
+        return;
+    }
+    LOG("[触发] 条件单触发 | 编号: {} | 合约: {} | 类型: {} | 方向: {} | 触发价: {} | 最新价: {} | 报单价: {} | "
+        "数量: {} | 报单引用: {}", id, data.InstrumentID, KindName(spec.kind), (buy ? "买" : "卖"),
+        spec.triggerPrice, lastPrice, price, spec.volume, orderRef);
+}
@@ -0,0 +1,153 @@
+///
+/// @file TriggerEngine.h
+/// @brief 本地条件单: 止损、止损限价、止盈和二选一(OCO), 由行情处理线程按最新价触发
+///
+
+#ifndef CTP_TEST_TRIGGER_ENGINE_H
+#define CTP_TEST_TRIGGER_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "OrderGateway.h"
+
+/// 条件单错误码, 与CTP返回码、报单网关和风控错误码不重叠
+const int64_t kTriggerFull = -300;          ///< 条件单数量达到容量
+const int64_t kTriggerBadSpec = -301;       ///< 合约编号、方向、数量或价格无效
+
+///
+/// @brief 条件单类型
+///
+enum class TriggerKind : uint8_t {
+    Stop,           ///< 止损/突破: 买单在最新价涨到触发价时发出, 卖单在跌到触发价时发出; 以涨跌停价发出
+    StopLimit,      ///< 触发条件同 Stop, 以 limitPrice 发出
+    TakeProfit,     ///< 止盈: 买单在最新价跌到触发价时发出, 卖单在涨到触发价时发出; 以 limitPrice 发出,
+                    ///< limitPrice 为0时以涨跌停价发出
+};
+
+///
+/// @brief 条件单参数
+///
+struct TriggerSpec {
+    uint32_t symbolId;          ///< SymbolTable 编号
+    TriggerKind kind;
+    char direction;             ///< THOST_FTDC_D_Buy / THOST_FTDC_D_Sell
+    char offset;                ///< THOST_FTDC_OF_*
+    double triggerPrice;
+    double limitPrice;          ///< 触发后报单的限价, 见 TriggerKind
+    int volume;
+    int strategy;               ///< 策略槽位, 见 OrderGateway::InsertLimit()
+};
+
+///
+/// @brief 条件单统计
+///
+struct TriggerStats {
+    uint64_t added;
+    uint64_t fired;             ///< 已触发并调用报单网关
+    uint64_t sendFailed;        ///< 触发后报单网关返回错误, 条件单不再保留
+    uint64_t cancelled;         ///< 调用方撤销
+    uint64_t ocoCancelled;      ///< 同组另一笔触发而撤销
+    uint64_t resting;           ///< 当前挂起数
+};
+
+///
+/// @brief 本地条件单引擎
+///
+/// 每个合约两条价格阶梯: 上穿阶梯(最新价 >= 触发价时触发, 买止损和卖止盈)是按触发价的小顶堆,
+/// 下穿阶梯(最新价 <= 触发价时触发, 卖止损和买止盈)是大顶堆。每笔行情只比较两个堆顶,
+/// 没有触发时为 O(1), 每触发一笔 O(log n)。触发后在行情处理线程上直接调用
+/// OrderGateway::InsertLimit(), 并带上该笔行情的到达时刻供延迟统计。
+///
+/// 条件单记录放在固定容量的池中, 编号由下标和代数组成, 撤销或触发后代数加一, 旧编号随即失效。
+/// 撤销时不在堆中查找, 只让堆中的元素失效, 等它到达堆顶时丢弃; 失效元素超过一半时整理该堆,
+/// 堆的大小与挂起数同阶。Add() 可能扩展堆的数组, OnTick() 不分配内存。
+///
+/// 二选一: LinkOco() 把两笔条件单(及其已有的同组条件单)并为一组, 组内用环形链表串起来;
+/// 任一笔触发时撤销同组其余条件单, 调用方撤销其中一笔不影响其余。
+///
+/// 已挂起的条件单在当时的最新价已越过触发价时, 于下一笔行情触发。
+/// 全部方法须在行情处理线程中调用, 即策略在 MdSession 的行情处理函数中下达和撤销条件单;
+/// GetStats() 可在任意线程调用。
+///
+class TriggerEngine {
+public:
+    /// @param gateway        触发后经由它发出报单
+    /// @param symbolCapacity 与 SymbolTable 容量一致
+    /// @param capacity       最多同时挂起的条件单数
+    TriggerEngine(OrderGateway& gateway, size_t symbolCapacity, size_t capacity = 65536);
+
+    TriggerEngine(const TriggerEngine&) = delete;
+    TriggerEngine& operator=(const TriggerEngine&) = delete;
+
+    /// 挂起一笔条件单
+    /// @return 大于0的条件单编号, 或 kTrigger* 错误码
+    int64_t Add(const TriggerSpec& spec);
+
+    /// 撤销条件单, 编号无效(已触发、已撤销)时返回false
+    bool Cancel(int64_t id);
+
+    /// 把两笔挂起的条件单并入同一个二选一组, 任一编号无效或已在同组时返回false
+    bool LinkOco(int64_t first, int64_t second);
+
+    /// 条件单是否仍挂起
+    bool IsResting(int64_t id) const;
+
+    /// 行情: 按最新价触发越过的条件单
+    void OnTick(uint32_t symbolId, const CThostFtdcDepthMarketDataField& data, int64_t recvNs);
+
+    /// 获取统计
+    TriggerStats GetStats() const;
+
+private:
+    /// 堆元素, 代数与条件单记录不一致时表示已失效
+    struct Entry {
+        double price;
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    /// 一条价格阶梯
+    struct Ladder {
+        std::vector<Entry> heap;
+        uint32_t stale;             ///< 堆中已失效的元素数
+    };
+
+    /// 条件单记录
+    struct Trigger {
+        TriggerSpec spec;
+        uint32_t generation;        ///< 奇数表示挂起, 偶数表示空闲
+        uint32_t ocoNext;           ///< 二选一组的环形链表, 未分组时指向自己
+    };
+
+    static int64_t MakeId(uint32_t index, uint32_t generation);
+    const Trigger* Find(int64_t id) const;
+
+    /// 条件单所在的阶梯, 上穿阶梯为 symbolId * 2, 下穿阶梯为 symbolId * 2 + 1
+    static size_t LadderOf(const TriggerSpec& spec);
+
+    /// 按阶梯方向弹出堆顶
+    void PopTop(size_t ladder);
+
+    /// 把条件单移出 OCO 组并放回空闲池; inHeap 表示其堆元素尚未弹出, 需计入失效数
+    void Release(uint32_t index, bool inHeap);
+
+    /// 触发一笔条件单, 其堆元素已弹出
+    void Fire(uint32_t index, const CThostFtdcDepthMarketDataField& data, double lastPrice, int64_t recvNs);
+
+    OrderGateway& m_gateway;
+    std::vector<Ladder> m_ladders;
+    std::vector<Trigger> m_triggers;
+    std::vector<uint32_t> m_free;           ///< 空闲记录下标
+
+    std::atomic<uint64_t> m_added;
+    std::atomic<uint64_t> m_fired;
+    std::atomic<uint64_t> m_sendFailed;
+    std::atomic<uint64_t> m_cancelled;
+    std::atomic<uint64_t> m_ocoCancelled;
+};
+
+#endif // CTP_TEST_TRIGGER_ENGINE_H
@@ -0,0 +1,663 @@
+///
+/// @file TriggerModelTest.cpp
+/// @brief TriggerEngine 随机模型检验: 随机挂起、撤销、组二选一和推送行情, 每一步与逐笔遍历的简单模型对照
+///
+/// 用法: ctp_trigger_test [-n 步数] [-s 种子]。模型不用堆, 每笔行情遍历全部挂起的条件单求出应触发的集合,
+/// 引擎经 OrderGateway 发到记录报单的交易API, 逐笔核对触发集合、顺序、报单价、编号有效性和统计。
+/// 条件单容量取小值, 并交替填充和扫空, 使运行中多次出现容量已满和记录复用。任一步不一致时打印该步并返回1。
+///
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "AsyncLogger.h"
+#include "IdAllocator.h"
+#include "InstrumentCache.h"
+#include "OrderGateway.h"
+#include "StubTraderApi.h"
+#include "SymbolTable.h"
+#include "TriggerEngine.h"
+#include "ThostFtdcUserApiStruct.h"
+
+namespace {
+
+const int kDefaultSteps = 200000;
+const uint32_t kDefaultSeed = 20260101;
+
+// 合约数和条件单容量; 容量小到随机挂起能把池填满
+const int kSymbolCount = 4;
+const size_t kCapacity = 256;
+
+// 价格取整数网格, 使同价和恰好等于触发价的情况经常出现
+const int kMidPrice = 100;
+const int kTriggerRange = 20;
+const int kFillRange = 1;
+const int kNarrowRange = 5;
+const int kWideRange = 25;
+const double kUpperLimit = 130.0;
+const double kLowerLimit = 70.0;
+
+// 随机步分为交替的两段: 填充段行情只在中间价附近跳动, 挂起数涨到容量; 其余段有大幅波动把阶梯扫空
+const int kPhaseSteps = 5000;
+
+// 报单数量即条件单序号, 序号为此数倍数的报单由交易API返回失败
+const int kRejectEvery = 13;
+
+/// xorshift 随机数
+uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int RandomBelow(uint32_t& state, int bound) {
+    return static_cast<int>(NextRandom(state) % static_cast<uint32_t>(bound));
+}
+
+/// 交易API发出的一笔报单
+struct SentOrder {
+    std::string instrumentId;
+    char direction;
+    double price;
+    int volume;
+};
+
+///
+/// @brief 记录报单内容的交易API
+///
+class RecordingTraderApi : public StubTraderApi {
+public:
+    virtual int ReqOrderInsert(CThostFtdcInputOrderField* pInputOrder, int nRequestID) override {
+        StubTraderApi::ReqOrderInsert(pInputOrder, nRequestID);
+        SentOrder order;
+        order.instrumentId = pInputOrder->InstrumentID;
+        order.direction = pInputOrder->Direction;
+        order.price = pInputOrder->LimitPrice;
+        order.volume = pInputOrder->VolumeTotalOriginal;
+        m_sent.push_back(order);
+        return order.volume % kRejectEvery == 0 ? -1 : 0;
+    }
+
+    std::vector<SentOrder>& Sent() { return m_sent; }
+
+private:
+    std::vector<SentOrder> m_sent;
+};
+
+/// 模型中的一笔条件单
+struct ModelTrigger {
+    TriggerSpec spec;
+    bool resting;
+    int group;              ///< 二选一组编号, 挂起时有效
+    size_t restingIndex;    ///< 在挂起列表中的位置, 挂起时有效
+};
+
+/// 模型计数, 与 TriggerStats 对应
+struct ModelStats {
+    uint64_t added;
+    uint64_t fired;
+    uint64_t sendFailed;
+    uint64_t cancelled;
+    uint64_t ocoCancelled;
+    uint64_t full;          ///< 容量已满的次数, 只用于输出
+};
+
+///
+/// @brief 逐笔遍历的条件单模型
+///
+/// 挂起列表无序, 二选一组是成员编号的数组, 合并时把小组并入大组。
+///
+class TriggerModel {
+public:
+    TriggerModel() : m_nextGroup(0) { memset(&m_stats, 0, sizeof(m_stats)); }
+
+    bool IsResting(int64_t id) const {
+        const std::unordered_map<int64_t, ModelTrigger>::const_iterator it = m_triggers.find(id);
+        return it != m_triggers.end() && it->second.resting;
+    }
+
+    bool Known(int64_t id) const { return m_triggers.count(id) != 0; }
+
+    const ModelTrigger& At(int64_t id) const { return m_triggers.at(id); }
+
+    size_t RestingCount() const { return m_resting.size(); }
+    int64_t RestingAt(size_t index) const { return m_resting[index]; }
+
+    const std::vector<int64_t>& Issued() const { return m_issued; }
+    const std::vector<int64_t>& GroupOf(int64_t id) const { return m_groups.at(m_triggers.at(id).group); }
+
+    ModelStats& Stats() { return m_stats; }
+
+    void Add(int64_t id, const TriggerSpec& spec) {
+        ModelTrigger& trigger = m_triggers[id];
+        trigger.spec = spec;
+        trigger.resting = true;
+        trigger.group = m_nextGroup++;
+        trigger.restingIndex = m_resting.size();
+        m_resting.push_back(id);
+        m_groups[trigger.group].push_back(id);
+        m_issued.push_back(id);
+        m_stats.added += 1;
+    }
+
+    bool CanLink(int64_t first, int64_t second) const {
+        return IsResting(first) && IsResting(second) && At(first).group != At(second).group;
+    }
+
+    void Link(int64_t first, int64_t second) {
+        int keep = m_triggers[first].group;
+        int merge = m_triggers[second].group;
+        if (m_groups[keep].size() < m_groups[merge].size()) {
+            std::swap(keep, merge);
+        }
+        std::vector<int64_t>& members = m_groups[merge];
+        for (size_t i = 0; i < members.size(); ++i) {
+            m_triggers[members[i]].group = keep;
+            m_groups[keep].push_back(members[i]);
+        }
+        m_groups.erase(merge);
+    }
+
+    /// 移出挂起列表和所在的组
+    void Remove(int64_t id) {
+        ModelTrigger& trigger = m_triggers[id];
+        trigger.resting = false;
+        const int64_t last = m_resting.back();
+        m_resting[trigger.restingIndex] = last;
+        m_triggers[last].restingIndex = trigger.restingIndex;
+        m_resting.pop_back();
+
+        std::vector<int64_t>& members = m_groups[trigger.group];
+        members.erase(std::find(members.begin(), members.end(), id));
+        if (members.empty()) {
+            m_groups.erase(trigger.group);
+        }
+    }
+
+private:
+    std::unordered_map<int64_t, ModelTrigger> m_triggers;
+    std::unordered_map<int, std::vector<int64_t>> m_groups;
+    std::vector<int64_t> m_resting;
+    std::vector<int64_t> m_issued;
+    int m_nextGroup;
+    ModelStats m_stats;
+};
+
+/// 条件单在一笔行情中的处理次序: 先上穿阶梯按触发价从低到高, 再下穿阶梯按触发价从高到低
+struct FireOrder {
+    int ladder;
+    double price;
+
+    bool operator<(const FireOrder& other) const {
+        if (ladder != other.ladder) {
+            return ladder < other.ladder;
+        }
+        return ladder == 0 ? price < other.price : price > other.price;
+    }
+    bool operator==(const FireOrder& other) const { return ladder == other.ladder && price == other.price; }
+};
+
+bool Rising(const TriggerSpec& spec) {
+    const bool buy = spec.direction == THOST_FTDC_D_Buy;
+    return spec.kind == TriggerKind::TakeProfit ? !buy : buy;
+}
+
+FireOrder OrderOf(const TriggerSpec& spec) {
+    FireOrder order = {Rising(spec) ? 0 : 1, spec.triggerPrice};
+    return order;
+}
+
+bool Crossed(const TriggerSpec& spec, double last) {
+    return Rising(spec) ? last >= spec.triggerPrice : last <= spec.triggerPrice;
+}
+
+double ValidPrice(double price) {
+    return (price > 0.0 && price < DBL_MAX) ? price : 0.0;
+}
+
+/// 触发后的报单价, 规则见 TriggerKind
+double ExpectedPrice(const TriggerSpec& spec, const CThostFtdcDepthMarketDataField& tick) {
+    const bool buy = spec.direction == THOST_FTDC_D_Buy;
+    double price = spec.kind == TriggerKind::Stop ? 0.0 : ValidPrice(spec.limitPrice);
+    if (price == 0.0) {
+        price = ValidPrice(buy ? tick.UpperLimitPrice : tick.LowerLimitPrice);
+    }
+    if (price == 0.0) {
+        price = ValidPrice(buy ? tick.AskPrice1 : tick.BidPrice1);
+    }
+    if (price == 0.0) {
+        price = tick.LastPrice;
+    }
+    return price;
+}
+
+double RandomGridPrice(uint32_t& random, int range) {
+    return static_cast<double>(kMidPrice - range + RandomBelow(random, range * 2 + 1));
+}
+
+/// 无效价格: 0 或 CTP 的 DBL_MAX
+double RandomInvalidPrice(uint32_t& random) {
+    return RandomBelow(random, 2) == 0 ? 0.0 : DBL_MAX;
+}
+
+void RemoveDirectory(const std::string& dir) {
+    DIR* handle = opendir(dir.c_str());
+    if (handle) {
+        while (struct dirent* entry = readdir(handle)) {
+            if (entry->d_name[0] != '.') {
+                unlink((dir + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(handle);
+    }
+    rmdir(dir.c_str());
+}
+
+///
+/// @brief 一次随机检验
+///
+class ModelCheck {
+public:
+    ModelCheck(uint32_t seed)
+        : m_random(seed != 0 ? seed : 1), m_dir(MakeTempDir()), m_instruments(m_dir),
+          m_gateway(&m_api, m_ids, UnlimitedRate()), m_engine(m_gateway, kSymbolCount, kCapacity), m_step(0),
+          m_nextVolume(1) {}
+
+    ~ModelCheck() {
+        if (!m_dir.empty()) {
+            RemoveDirectory(m_dir);
+        }
+    }
+
+    /// 生成合约缓存和报单模板并模拟一次登录, 失败时返回false
+    bool Init() {
+        if (m_dir.empty()) {
+            std::cout << "[错误] 无法创建临时目录" << std::endl;
+            return false;
+        }
+        std::vector<CThostFtdcInstrumentField> rows(kSymbolCount);
+        for (int i = 0; i < kSymbolCount; ++i) {
+            CThostFtdcInstrumentField& row = rows[i];
+            memset(&row, 0, sizeof(row));
+            snprintf(row.InstrumentID, sizeof(row.InstrumentID), "rb%04d", 2601 + i);
+            memcpy(row.ExchangeID, "SHFE", 4);
+            memcpy(row.ProductID, "rb", 2);
+            row.ProductClass = THOST_FTDC_PC_Futures;
+            row.VolumeMultiple = 10;
+            row.PriceTick = 1.0;
+        }
+        if (!m_instruments.Build("20260101", rows)) {
+            std::cout << "[错误] 无法生成合约缓存 " << m_dir << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < m_instruments.Size(); ++i) {
+            m_symbols.Intern(m_instruments.At(i).InstrumentID);
+        }
+        m_gateway.SetAccount("9999", "model", "model");
+        m_gateway.BuildTemplates(m_instruments, m_symbols);
+        CThostFtdcRspUserLoginField login;
+        memset(&login, 0, sizeof(login));
+        login.FrontID = 1;
+        login.SessionID = 1;
+        memcpy(login.MaxOrderRef, "0", 1);
+        m_ids.SeedOrderRef(login.MaxOrderRef);
+        m_gateway.OnLogin(login);
+        return true;
+    }
+
+    /// 运行指定步数, 全部一致时返回true
+    bool Run(int steps) {
+        for (m_step = 1; m_step <= steps; ++m_step) {
+            const int op = RandomBelow(m_random, 100);
+            bool ok;
+            if (op < 40) {
+                ok = StepAdd();
+            } else if (op < 55) {
+                ok = StepCancel();
+            } else if (op < 65) {
+                ok = StepLink();
+            } else {
+                ok = StepTick();
+            }
+            if (!ok || !CheckStats() || !CheckSample()) {
+                return false;
+            }
+        }
+        // 结束时核对所有发出过的编号
+        const std::vector<int64_t>& issued = m_model.Issued();
+        for (size_t i = 0; i < issued.size(); ++i) {
+            if (!CheckResting(issued[i])) {
+                return false;
+            }
+        }
+        const ModelStats& stats = m_model.Stats();
+        std::cout << "[通过] 步数: " << steps << " | 挂起: " << stats.added << " | 触发: " << stats.fired
+                  << " | 报单失败: " << stats.sendFailed << " | 撤销: " << stats.cancelled
+                  << " | 二选一撤销: " << stats.ocoCancelled << " | 容量已满: " << stats.full
+                  << " | 最终挂起: " << m_model.RestingCount() << std::endl;
+        return true;
+    }
+
+private:
+    static std::string MakeTempDir() {
+        char dir[] = "/tmp/ctp_trigger_test_XXXXXX";
+        return mkdtemp(dir) ? std::string(dir) + "/" : std::string();
+    }
+
+    static RateLimiterOptions UnlimitedRate() {
+        RateLimiterOptions options;
+        options.sessionPerSecond = 1e12;
+        options.sessionBurst = 1 << 30;
+        options.exchangePerSecond = 1e12;
+        options.exchangeBurst = 1 << 30;
+        return options;
+    }
+
+    bool Fail(const std::string& message) {
+        std::cout << "[失败] 第 " << m_step << " 步: " << message << std::endl;
+        return false;
+    }
+
+    /// 随机条件单, 约2%的参数无效
+    TriggerSpec RandomSpec(bool& valid) {
+        TriggerSpec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.symbolId = static_cast<uint32_t>(RandomBelow(m_random, kSymbolCount));
+        spec.kind = static_cast<TriggerKind>(RandomBelow(m_random, 3));
+        spec.direction = RandomBelow(m_random, 2) == 0 ? THOST_FTDC_D_Buy : THOST_FTDC_D_Sell;
+        spec.offset = THOST_FTDC_OF_Open;
+        spec.triggerPrice = RandomGridPrice(m_random, kTriggerRange);
+        if (spec.kind == TriggerKind::StopLimit || RandomBelow(m_random, 2) == 0) {
+            spec.limitPrice = RandomGridPrice(m_random, kTriggerRange);
+        }
+        spec.volume = m_nextVolume;
+        spec.strategy = 0;
+
+        valid = true;
+        if (RandomBelow(m_random, 50) == 0) {
+            valid = false;
+            switch (RandomBelow(m_random, 5)) {
+                case 0:
+                    spec.symbolId = kSymbolCount;
+                    break;
+                case 1:
+                    spec.direction = '9';
+                    break;
+                case 2:
+                    spec.volume = 0;
+                    break;
+                case 3:
+                    spec.triggerPrice = RandomInvalidPrice(m_random);
+                    break;
+                default:
+                    spec.kind = TriggerKind::StopLimit;
+                    spec.limitPrice = RandomInvalidPrice(m_random);
+                    break;
+            }
+        }
+        return spec;
+    }
+
+    bool StepAdd() {
+        bool valid = false;
+        const TriggerSpec spec = RandomSpec(valid);
+        const int64_t id = m_engine.Add(spec);
+        if (!valid) {
+            return id == kTriggerBadSpec ? true : Fail("无效参数返回 " + std::to_string(id));
+        }
+        if (m_model.RestingCount() == kCapacity) {
+            m_model.Stats().full += 1;
+            return id == kTriggerFull ? true : Fail("容量已满时返回 " + std::to_string(id));
+        }
+        if (id <= 0) {
+            return Fail("挂起失败, 返回 " + std::to_string(id));
+        }
+        if (m_model.Known(id)) {
+            return Fail("编号 " + std::to_string(id) + " 重复发出");
+        }
+        m_model.Add(id, spec);
+        m_volumeToId[m_nextVolume] = id;
+        m_nextVolume += 1;
+        return true;
+    }
+
+    /// 随机取一个编号: 多数是挂起的, 其余是已失效的或从未发出的
+    int64_t RandomId() {
+        const int pick = RandomBelow(m_random, 10);
+        if (pick < 7 && m_model.RestingCount() > 0) {
+            return m_model.RestingAt(RandomBelow(m_random, static_cast<int>(m_model.RestingCount())));
+        }
+        const std::vector<int64_t>& issued = m_model.Issued();
+        if (pick < 9 && !issued.empty()) {
+            return issued[RandomBelow(m_random, static_cast<int>(issued.size()))];
+        }
+        // 从未发出的编号: 非正数, 或下标超出容量, 或代数为偶数
+        switch (RandomBelow(m_random, 3)) {
+            case 0:
+                return -static_cast<int64_t>(RandomBelow(m_random, 3));
+            case 1:
+                return (int64_t(1) << 32) | static_cast<int64_t>(kCapacity + RandomBelow(m_random, 8));
+            default:
+                return (int64_t(2) << 32) | static_cast<int64_t>(RandomBelow(m_random, kCapacity));
+        }
+    }
+
+    bool StepCancel() {
+        const int64_t id = RandomId();
+        const bool expected = m_model.IsResting(id);
+        if (m_engine.Cancel(id) != expected) {
+            return Fail("撤销 " + std::to_string(id) + " 的结果应为 " + std::to_string(expected));
+        }
+        if (expected) {
+            m_model.Remove(id);
+            m_model.Stats().cancelled += 1;
+        }
+        return true;
+    }
+
+    bool StepLink() {
+        const int64_t first = RandomId();
+        const int64_t second = RandomBelow(m_random, 4) == 0 ? first : RandomId();
+        const bool expected = m_model.CanLink(first, second);
+        if (m_engine.LinkOco(first, second) != expected) {
+            return Fail("组合 " + std::to_string(first) + " 和 " + std::to_string(second) + " 的结果应为 " +
+                        std::to_string(expected));
+        }
+        if (expected) {
+            m_model.Link(first, second);
+        }
+        return true;
+    }
+
+    bool StepTick() {
+        const uint32_t symbolId = static_cast<uint32_t>(RandomBelow(m_random, kSymbolCount));
+        CThostFtdcDepthMarketDataField tick;
+        memset(&tick, 0, sizeof(tick));
+        snprintf(tick.InstrumentID, sizeof(tick.InstrumentID), "%s", m_instruments.At(symbolId).InstrumentID);
+        // 多数行情在中间价附近小幅波动, 少数大幅波动扫过一侧的阶梯, 少数最新价无效
+        int range = RandomBelow(m_random, 10) == 0 ? kWideRange : kNarrowRange;
+        if ((m_step / kPhaseSteps) % 2 == 1) {
+            range = kFillRange;
+        }
+        tick.LastPrice = RandomBelow(m_random, 50) == 0 ? RandomInvalidPrice(m_random)
+                                                         : RandomGridPrice(m_random, range);
+        tick.UpperLimitPrice = RandomBelow(m_random, 2) == 0 ? kUpperLimit : RandomInvalidPrice(m_random);
+        tick.LowerLimitPrice = RandomBelow(m_random, 2) == 0 ? kLowerLimit : RandomInvalidPrice(m_random);
+        tick.AskPrice1 = RandomBelow(m_random, 2) == 0 ? tick.LastPrice + 1 : RandomInvalidPrice(m_random);
+        tick.BidPrice1 = RandomBelow(m_random, 2) == 0 ? tick.LastPrice - 1 : RandomInvalidPrice(m_random);
+
+        // 每个有越过触发价的成员的组恰好触发一笔, 且是组内处理次序最先的一笔(同价时任一笔)
+        std::unordered_map<int, FireOrder> firstOfGroup;
+        const double last = ValidPrice(tick.LastPrice);
+        if (last != 0.0) {
+            for (size_t i = 0; i < m_model.RestingCount(); ++i) {
+                const ModelTrigger& trigger = m_model.At(m_model.RestingAt(i));
+                if (trigger.spec.symbolId != symbolId || !Crossed(trigger.spec, last)) {
+                    continue;
+                }
+                const FireOrder order = OrderOf(trigger.spec);
+                const std::unordered_map<int, FireOrder>::iterator it = firstOfGroup.find(trigger.group);
+                if (it == firstOfGroup.end()) {
+                    firstOfGroup[trigger.group] = order;
+                } else if (order < it->second) {
+                    it->second = order;
+                }
+            }
+        }
+
+        std::vector<SentOrder>& sent = m_api.Sent();
+        sent.clear();
+        m_engine.OnTick(symbolId, tick, 0);
+
+        if (sent.size() != firstOfGroup.size()) {
+            return Fail("最新价 " + std::to_string(tick.LastPrice) + " 应触发 " +
+                        std::to_string(firstOfGroup.size()) + " 笔, 实际 " + std::to_string(sent.size()) + " 笔");
+        }
+        for (size_t i = 0; i < sent.size(); ++i) {
+            const SentOrder& order = sent[i];
+            const std::unordered_map<int, int64_t>::const_iterator found = m_volumeToId.find(order.volume);
+            if (found == m_volumeToId.end() || !m_model.IsResting(found->second)) {
+                return Fail("报单数量 " + std::to_string(order.volume) + " 不对应挂起的条件单");
+            }
+            const int64_t id = found->second;
+            const ModelTrigger trigger = m_model.At(id);
+            const std::unordered_map<int, FireOrder>::iterator first = firstOfGroup.find(trigger.group);
+            if (first == firstOfGroup.end() || !(OrderOf(trigger.spec) == first->second)) {
+                return Fail("条件单 " + std::to_string(id) + " 不应触发, 或同组已触发另一笔");
+            }
+            firstOfGroup.erase(first);
+            if (i > 0 && OrderOf(trigger.spec) < OrderOf(m_model.At(m_volumeToId[sent[i - 1].volume]).spec)) {
+                return Fail("条件单 " + std::to_string(id) + " 的触发次序错误");
+            }
+            const double price = ExpectedPrice(trigger.spec, tick);
+            if (order.instrumentId != tick.InstrumentID || order.direction != trigger.spec.direction ||
+                order.price != price) {
+                return Fail("条件单 " + std::to_string(id) + " 的报单应为 " + tick.InstrumentID + " " +
+                            trigger.spec.direction + " " + std::to_string(price) + ", 实际为 " +
+                            order.instrumentId + " " + order.direction + " " + std::to_string(order.price));
+            }
+
+            ModelStats& stats = m_model.Stats();
+            const std::vector<int64_t> members = m_model.GroupOf(id);
+            for (size_t j = 0; j < members.size(); ++j) {
+                if (members[j] != id) {
+                    m_model.Remove(members[j]);
+                    stats.ocoCancelled += 1;
+                }
+            }
+            m_model.Remove(id);
+            stats.fired += 1;
+            if (order.volume % kRejectEvery == 0) {
+                stats.sendFailed += 1;
+            }
+        }
+        return true;
+    }
+
+    bool CheckResting(int64_t id) {
+        const bool expected = m_model.IsResting(id);
+        if (m_engine.IsResting(id) != expected) {
+            return Fail("编号 " + std::to_string(id) + " 的挂起状态应为 " + std::to_string(expected));
+        }
+        return true;
+    }
+
+    /// 每步抽查几个编号
+    bool CheckSample() {
+        for (int i = 0; i < 4; ++i) {
+            if (!CheckResting(RandomId())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool CheckStats() {
+        const TriggerStats actual = m_engine.GetStats();
+        const ModelStats& expected = m_model.Stats();
+        if (actual.added != expected.added || actual.fired != expected.fired ||
+            actual.sendFailed != expected.sendFailed || actual.cancelled != expected.cancelled ||
+            actual.ocoCancelled != expected.ocoCancelled || actual.resting != m_model.RestingCount()) {
+            return Fail("统计不一致, 引擎 挂起/触发/报单失败/撤销/二选一撤销/当前挂起: " +
+                        std::to_string(actual.added) + "/" + std::to_string(actual.fired) + "/" +
+                        std::to_string(actual.sendFailed) + "/" + std::to_string(actual.cancelled) + "/" +
+                        std::to_string(actual.ocoCancelled) + "/" + std::to_string(actual.resting) + ", 模型: " +
+                        std::to_string(expected.added) + "/" + std::to_string(expected.fired) + "/" +
+                        std::to_string(expected.sendFailed) + "/" + std::to_string(expected.cancelled) + "/" +
+                        std::to_string(expected.ocoCancelled) + "/" + std::to_string(m_model.RestingCount()));
+        }
+        return true;
+    }
+
+    uint32_t m_random;
+    const std::string m_dir;
+    RecordingTraderApi m_api;
+    IdAllocator m_ids;
+    InstrumentCache m_instruments;
+    SymbolTable m_symbols;
+    OrderGateway m_gateway;
+    TriggerEngine m_engine;
+    TriggerModel m_model;
+    std::unordered_map<int, int64_t> m_volumeToId;
+    int m_step;
+    int m_nextVolume;
+};
+
+void PrintUsage(const char* programName) {
+    std::cout << "使用方法: " << programName << " [选项]" << std::endl;
+    std::cout << "选项:" << std::endl;
+    std::cout << "  -n <步数>  随机步数 (默认: " << kDefaultSteps << ")" << std::endl;
+    std::cout << "  -s <种子>  随机数种子 (默认: " << kDefaultSeed << ")" << std::endl;
+    std::cout << "  -h          显示帮助信息" << std::endl;
+}
+
+} // namespace
+
+///
+/// @brief 主函数
+///
+int main(int argc, char* argv[]) {
+    int steps = kDefaultSteps;
+    uint32_t seed = kDefaultSeed;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                steps = atoi(optarg);
+                break;
+            case 's':
+                seed = static_cast<uint32_t>(strtoul(optarg, nullptr, 10));
+                break;
+            case 'h':
+            default:
+                PrintUsage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (steps <= 0) {
+        std::cout << "[错误] 无效的步数" << std::endl;
+        return 1;
+    }
+
+    // 每笔触发都写一条日志, 只写文件
+    if (!AsyncLogger::Instance().Start("ctp_trigger_test.log", false)) {
+        std::cout << "[警告] 无法打开日志文件 ctp_trigger_test.log" << std::endl;
+    }
+    bool ok = false;
+    {
+        ModelCheck check(seed);
+        ok = check.Init() && check.Run(steps);
+    }
+    AsyncLogger::Instance().Stop();
+    return ok ? 0 : 1;
+}
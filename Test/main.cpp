@@ -5,399 +5,69 @@
 
 #include <iostream>
 #include <string>
-#include <thread>
-#include <chrono>
 #include <cstring>
 #include <csignal>
 #include <atomic>
 #include <memory>
 #include <unistd.h>
 #include <fstream>
+#include <vector>
 #include <sstream>
 
 // CTP交易API头文件
 #include "ThostFtdcTraderApi.h"
-
-// 全局变量用于控制程序退出
-std::atomic<bool> g_running(true);
+#include "ThostFtdcMdApi.h"
+#include "TraderSpi.h"
+#include "MdSession.h"
+#include "BookStore.h"
+#include "ControlEvents.h"
+#include "AsyncLogger.h"
+#include "FundsEstimator.h"
+#include "TradeSnapshot.h"
+#include "InstrumentCache.h"
+#include "LatencyTracker.h"
+#include "RecoveryTracker.h"
+#include "OrderGateway.h"
+#include "OrderTable.h"
+#include "PositionKeeper.h"
+#include "RiskEngine.h"
+#include "SymbolTable.h"
+#include "TickJournal.h"
+#include "TriggerEngine.h"
+
+// 登出响应的最长等待时间
+const int kLogoutTimeoutMs = 2000;
+
+// 重连后第一次撤单到补撤的间隔, 期间仍在续传的挂单回报进入报单状态表后再撤一次
+const int kReconnectSweepDelayMs = 2000;
+
+// 主线程上一次撤单的耗时上限, 流控排队更久的挂单留到下一次补撤, 主线程仍能及时响应退出信号
+const int64_t kReconnectCancelBudgetNs = 500LL * 1000000LL;
+
+// 行情队列容量
+const size_t kMdQueueCapacity = 16384;
+
+// 报单状态表容量, 单个交易日的报单数上限
+const size_t kOrderTableCapacity = 65536;
+
+// 报单前风控限额: 单笔数量、单个合约和单个品种的净持仓
+const RiskLimits kRiskLimits = {100, 500, 1000};
+
+// 最多同时挂起的本地条件单数
+const size_t kTriggerCapacity = 65536;
+
+// 主线程控制事件, 信号、断线、登录失败和登出完成均通过它唤醒主线程
+ControlEvents g_control;
+
+// 收到的退出信号, 信号处理函数中不能写日志, 由主线程在退出时输出
+std::atomic<int> g_signal(0);
 
 // 信号处理函数
 void SignalHandler(int signal) {
-    std::cout << "\n收到信号 " << signal << ", 准备退出程序..." << std::endl;
-    g_running = false;
+    g_signal = signal;
+    g_control.Post(kControlShutdown);
 }
 
-///
-/// @brief CTP交易回调类
-///
-class TraderSpi : public CThostFtdcTraderSpi {
-public:
-    TraderSpi(CThostFtdcTraderApi* api) : m_api(api), m_requestId(0) {}
-
-    /// 当客户端与交易后台建立起通信连接时，服务器主动发送登录请求
-    virtual void OnFrontConnected() override {
-        std::cout << "[连接] 成功连接到交易服务器" << std::endl;
-        std::cout << "[状态] 开始用户登录..." << std::endl;
-        ReqUserLogin();
-    }
-
-    /// 当客户端与交易后台通信连接断开时，该方法被调用
-    virtual void OnFrontDisconnected(int nReason) override {
-        std::cout << "[断开] 与交易服务器断开连接, 原因码: " << nReason << std::endl;
-        switch (nReason) {
-            case 0x1001:
-                std::cout << "  原因: 网络读失败" << std::endl;
-                break;
-            case 0x1002:
-                std::cout << "  原因: 网络写失败" << std::endl;
-                break;
-            case 0x2001:
-                std::cout << "  原因: 接收心跳超时" << std::endl;
-                break;
-            case 0x2002:
-                std::cout << "  原因: 发送心跳失败" << std::endl;
-                break;
-            case 0x2003:
-                std::cout << "  原因: 收到错误报文" << std::endl;
-                break;
-            default:
-                std::cout << "  原因: 未知" << std::endl;
-                break;
-        }
-        g_running = false;
-    }
-
-    /// 心跳超时警告
-    virtual void OnHeartBeatWarning(int nTimeLapse) override {
-        std::cout << "[警告] 心跳超时, 距离上次接收时间: " << nTimeLapse << "秒" << std::endl;
-    }
-
-    /// 客户端认证响应
-    virtual void OnRspAuthenticate(CThostFtdcRspAuthenticateField *pRspAuthenticateField,
-                                   CThostFtdcRspInfoField *pRspInfo,
-                                   int nRequestID, bool bIsLast) override {
-        std::cout << "[认证] 收到认证响应, RequestID: " << nRequestID << std::endl;
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            std::cout << "[错误] 认证失败, ErrorID: " << pRspInfo->ErrorID
-                      << ", ErrorMsg: " << pRspInfo->ErrorMsg << std::endl;
-        } else {
-            std::cout << "[成功] 客户端认证成功" << std::endl;
-        }
-    }
-
-    /// 登录请求响应
-    virtual void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin,
-                                CThostFtdcRspInfoField *pRspInfo,
-                                int nRequestID, bool bIsLast) override {
-        std::cout << "[登录] 收到登录响应, RequestID: " << nRequestID << std::endl;
-
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            std::cout << "[错误] 登录失败!" << std::endl;
-            std::cout << "  ErrorID: " << pRspInfo->ErrorID << std::endl;
-            std::cout << "  ErrorMsg: " << (pRspInfo->ErrorMsg[0] ? pRspInfo->ErrorMsg : "无") << std::endl;
-            g_running = false;
-            return;
-        }
-
-        std::cout << "[成功] 登录成功!" << std::endl;
-
-        if (pRspUserLogin) {
-            std::cout << "====================================" << std::endl;
-            std::cout << "登录信息:" << std::endl;
-            std::cout << "  交易日:    " << pRspUserLogin->TradingDay << std::endl;
-            std::cout << "  登录时间:  " << pRspUserLogin->LoginTime << std::endl;
-            std::cout << "  经纪公司:  " << pRspUserLogin->BrokerID << std::endl;
-            std::cout << "  用户ID:    " << pRspUserLogin->UserID << std::endl;
-            std::cout << "  交易系统:  " << pRspUserLogin->SystemName << std::endl;
-            std::cout << "  前端ID:    " << pRspUserLogin->FrontID << std::endl;
-            std::cout << "  会话ID:    " << pRspUserLogin->SessionID << std::endl;
-            std::cout << "  最大订单:  " << pRspUserLogin->MaxOrderRef << std::endl;
-            std::cout << "  SHFE时间:  " << pRspUserLogin->SHFETime << std::endl;
-            std::cout << "  DCHE时间:  " << pRspUserLogin->DCETime << std::endl;
-            std::cout << "  CZCE时间:  " << pRspUserLogin->CZCETime << std::endl;
-            std::cout << "  DCE时间:   " << pRspUserLogin->DCETime << std::endl;
-            std::cout << "  INE时间:   " << pRspUserLogin->INETime << std::endl;
-            std::cout << "====================================" << std::endl;
-        }
-
-        // 登录成功后查询结算信息确认
-        std::cout << "[状态] 查询投资者结算信息..." << std::endl;
-        ReqQrySettlementInfo();
-    }
-
-    /// 登出请求响应
-    virtual void OnRspUserLogout(CThostFtdcUserLogoutField *pUserLogout,
-                                 CThostFtdcRspInfoField *pRspInfo,
-                                 int nRequestID, bool bIsLast) override {
-        std::cout << "[登出] 收到登出响应, RequestID: " << nRequestID << std::endl;
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            std::cout << "[错误] 登出失败, ErrorID: " << pRspInfo->ErrorID
-                      << ", ErrorMsg: " << pRspInfo->ErrorMsg << std::endl;
-        } else {
-            std::cout << "[成功] 登出成功" << std::endl;
-        }
-        g_running = false;
-    }
-
-    /// 查询结算信息响应
-    virtual void OnRspQrySettlementInfo(CThostFtdcSettlementInfoField *pSettlementInfo,
-                                        CThostFtdcRspInfoField *pRspInfo,
-                                        int nRequestID, bool bIsLast) override {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            std::cout << "[错误] 查询结算信息失败, ErrorID: " << pRspInfo->ErrorID
-                      << ", ErrorMsg: " << pRspInfo->ErrorMsg << std::endl;
-            // 即使查询失败也继续确认
-        } else if (bIsLast) {
-            std::cout << "[成功] 查询结算信息完成" << std::endl;
-        }
-
-        if (bIsLast) {
-            // 查询完成后进行结算确认
-            std::cout << "[状态] 确认投资者结算信息..." << std::endl;
-            ReqSettlementInfoConfirm();
-        }
-    }
-
-    /// 投资者结算结果确认响应
-    virtual void OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
-                                            CThostFtdcRspInfoField *pRspInfo,
-                                            int nRequestID, bool bIsLast) override {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            std::cout << "[错误] 结算确认失败, ErrorID: " << pRspInfo->ErrorID
-                      << ", ErrorMsg: " << pRspInfo->ErrorMsg << std::endl;
-        } else {
-            std::cout << "[成功] 结算信息确认成功" << std::endl;
-            if (pSettlementInfoConfirm) {
-                std::cout << "  确认日期: " << pSettlementInfoConfirm->ConfirmDate << std::endl;
-                std::cout << "  确认时间: " << pSettlementInfoConfirm->ConfirmTime << std::endl;
-            }
-        }
-
-        // 结算确认后查询资金账户
-        if (bIsLast) {
-            std::cout << "[状态] 查询资金账户..." << std::endl;
-            ReqQryTradingAccount();
-        }
-    }
-
-    /// 查询资金账户响应
-    virtual void OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTradingAccount,
-                                        CThostFtdcRspInfoField *pRspInfo,
-                                        int nRequestID, bool bIsLast) override {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            std::cout << "[错误] 查询资金账户失败, ErrorID: " << pRspInfo->ErrorID
-                      << ", ErrorMsg: " << pRspInfo->ErrorMsg << std::endl;
-        } else if (pTradingAccount) {
-            std::cout << "[成功] 查询资金账户成功" << std::endl;
-            std::cout << "====================================" << std::endl;
-            std::cout << "资金账户信息:" << std::endl;
-            std::cout << "  账户ID:        " << pTradingAccount->AccountID << std::endl;
-            std::cout << "  可用资金:       " << pTradingAccount->Available << std::endl;
-            std::cout << "  保证金占用:     " << pTradingAccount->CurrMargin << std::endl;
-            // std::cout << "  浮动盈亏:       " << pTradingAccount->UnrealizedProfit << std::endl;
-            std::cout << "  持仓盈亏:       " << pTradingAccount->CloseProfit << std::endl;
-            std::cout << "  权益:           " << pTradingAccount->Balance << std::endl;
-            std::cout << "  入金:           " << pTradingAccount->Deposit << std::endl;
-            std::cout << "  出金:           " << pTradingAccount->Withdraw << std::endl;
-            std::cout << "  冻结保证金:     " << pTradingAccount->FrozenMargin << std::endl;
-            std::cout << "  冻结手续费:     " << pTradingAccount->FrozenCommission << std::endl;
-            std::cout << "  手续费:         " << pTradingAccount->Commission << std::endl;
-            // std::cout << "  风险度:         " << pTradingAccount->RiskRatio << std::endl;
-            std::cout << "====================================" << std::endl;
-        }
-
-        if (bIsLast) {
-            // 查询完成后查询持仓
-            std::cout << "[状态] 查询投资者持仓..." << std::endl;
-            ReqQryInvestorPosition();
-        }
-    }
-
-    /// 查询投资者持仓响应
-    virtual void OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *pInvestorPosition,
-                                          CThostFtdcRspInfoField *pRspInfo,
-                                          int nRequestID, bool bIsLast) override {
-        static bool firstQuery = true;
-
-        if (pRspInfo && pRspInfo->ErrorID != 0 && pRspInfo->ErrorID != 203) { // 203表示没有持仓
-            std::cout << "[错误] 查询持仓失败, ErrorID: " << pRspInfo->ErrorID
-                      << ", ErrorMsg: " << pRspInfo->ErrorMsg << std::endl;
-        } else if (pInvestorPosition) {
-            if (firstQuery) {
-                std::cout << "[成功] 查询持仓成功" << std::endl;
-                std::cout << "====================================" << std::endl;
-                std::cout << "持仓信息:" << std::endl;
-                firstQuery = false;
-            }
-            std::cout << "  合约: " << pInvestorPosition->InstrumentID
-                      << " | 方向: " << (pInvestorPosition->PosiDirection == THOST_FTDC_PD_Long ? "多头" : "空头")
-                      << " | 持仓: " << pInvestorPosition->Position << std::endl;
-                      // << " | 可用: " << pInvestorPosition->Available << std::endl;
-        }
-
-        if (bIsLast) {
-            std::cout << "====================================" << std::endl;
-            std::cout << "[状态] 所有查询完成, 登录测试成功!" << std::endl;
-            std::cout << "[状态] 按Ctrl+C退出或等待自动登出..." << std::endl;
-        }
-    }
-
-    /// 错误应答
-    virtual void OnRspError(CThostFtdcRspInfoField *pRspInfo,
-                           int nRequestID, bool bIsLast) override {
-        std::cout << "[错误] 收到错误响应, RequestID: " << nRequestID << std::endl;
-        if (pRspInfo) {
-            std::cout << "  ErrorID: " << pRspInfo->ErrorID << std::endl;
-            std::cout << "  ErrorMsg: " << (pRspInfo->ErrorMsg[0] ? pRspInfo->ErrorMsg : "无") << std::endl;
-        }
-    }
-
-    /// 设置登录参数
-    void SetLoginInfo(const std::string& frontAddr,
-                      const std::string& brokerId,
-                      const std::string& userId,
-                      const std::string& password,
-                      const std::string& appId = "",
-                      const std::string& authCode = "") {
-        m_frontAddr = frontAddr;
-        m_brokerId = brokerId;
-        m_userId = userId;
-        m_password = password;
-        m_appId = appId;
-        m_authCode = authCode;
-    }
-
-    /// 设置投资者ID
-    void SetInvestorId(const std::string& investorId) {
-        m_investorId = investorId;
-    }
-
-    /// 请求用户登录
-    void ReqUserLogin() {
-        CThostFtdcReqUserLoginField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
-        strncpy(req.Password, m_password.c_str(), sizeof(req.Password) - 1);
-
-        // 如果有认证信息，先进行认证
-        if (!m_appId.empty() && !m_authCode.empty()) {
-            ReqAuthenticate();
-        } else {
-            int result = m_api->ReqUserLogin(&req, ++m_requestId);
-            if (result == 0) {
-                std::cout << "[请求] 发送登录请求, RequestID: " << m_requestId << std::endl;
-            } else {
-                std::cout << "[错误] 发送登录请求失败, 返回码: " << result << std::endl;
-            }
-        }
-    }
-
-    /// 客户端认证请求
-    void ReqAuthenticate() {
-        CThostFtdcReqAuthenticateField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
-        strncpy(req.AuthCode, m_authCode.c_str(), sizeof(req.AuthCode) - 1);
-        strncpy(req.AppID, m_appId.c_str(), sizeof(req.AppID) - 1);
-
-        int result = m_api->ReqAuthenticate(&req, ++m_requestId);
-        if (result == 0) {
-            std::cout << "[请求] 发送认证请求, RequestID: " << m_requestId << std::endl;
-        } else {
-            std::cout << "[错误] 发送认证请求失败, 返回码: " << result << std::endl;
-        }
-    }
-
-    /// 查询结算信息
-    void ReqQrySettlementInfo() {
-        CThostFtdcQrySettlementInfoField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
-
-        int result = m_api->ReqQrySettlementInfo(&req, ++m_requestId);
-        if (result == 0) {
-            std::cout << "[请求] 发送查询结算信息请求, RequestID: " << m_requestId << std::endl;
-        } else {
-            std::cout << "[错误] 发送查询结算信息请求失败, 返回码: " << result << std::endl;
-        }
-    }
-
-    /// 投资者结算结果确认
-    void ReqSettlementInfoConfirm() {
-        CThostFtdcSettlementInfoConfirmField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
-
-        int result = m_api->ReqSettlementInfoConfirm(&req, ++m_requestId);
-        if (result == 0) {
-            std::cout << "[请求] 发送结算确认请求, RequestID: " << m_requestId << std::endl;
-        } else {
-            std::cout << "[错误] 发送结算确认请求失败, 返回码: " << result << std::endl;
-        }
-    }
-
-    /// 查询资金账户
-    void ReqQryTradingAccount() {
-        CThostFtdcQryTradingAccountField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
-
-        int result = m_api->ReqQryTradingAccount(&req, ++m_requestId);
-        if (result == 0) {
-            std::cout << "[请求] 发送查询资金账户请求, RequestID: " << m_requestId << std::endl;
-        } else {
-            std::cout << "[错误] 发送查询资金账户请求失败, 返回码: " << result << std::endl;
-        }
-    }
-
-    /// 查询投资者持仓
-    void ReqQryInvestorPosition() {
-        CThostFtdcQryInvestorPositionField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.InvestorID, m_investorId.c_str(), sizeof(req.InvestorID) - 1);
-
-        int result = m_api->ReqQryInvestorPosition(&req, ++m_requestId);
-        if (result == 0) {
-            std::cout << "[请求] 发送查询持仓请求, RequestID: " << m_requestId << std::endl;
-        } else {
-            std::cout << "[错误] 发送查询持仓请求失败, 返回码: " << result << std::endl;
-        }
-    }
-
-    /// 请求登出
-    void ReqUserLogout() {
-        CThostFtdcUserLogoutField req = {0};
-
-        strncpy(req.BrokerID, m_brokerId.c_str(), sizeof(req.BrokerID) - 1);
-        strncpy(req.UserID, m_userId.c_str(), sizeof(req.UserID) - 1);
-
-        int result = m_api->ReqUserLogout(&req, ++m_requestId);
-        if (result == 0) {
-            std::cout << "[请求] 发送登出请求, RequestID: " << m_requestId << std::endl;
-        } else {
-            std::cout << "[错误] 发送登出请求失败, 返回码: " << result << std::endl;
-            g_running = false;
-        }
-    }
-
-private:
-    CThostFtdcTraderApi* m_api;
-    int m_requestId;
-    std::string m_frontAddr;
-    std::string m_brokerId;
-    std::string m_userId;
-    std::string m_password;
-    std::string m_investorId;
-    std::string m_appId;
-    std::string m_authCode;
-};
-
 ///
 /// @brief 从JSON字符串中提取字段值
 ///
@@ -424,7 +94,8 @@ std::string GetJsonField(const std::string& json, const std::string& key) {
 bool LoadConfigFromFile(std::string& frontAddr, std::string& brokerId,
                         std::string& userId, std::string& password,
                         std::string& investorId, std::string& appId,
-                        std::string& authCode) {
+                        std::string& authCode, std::string& mdFrontAddr,
+                        std::string& subscribeList) {
     std::ifstream file("config.json");
     if (!file.is_open()) {
         return false;
@@ -456,21 +127,63 @@ bool LoadConfigFromFile(std::string& frontAddr, std::string& brokerId,
     std::string auth = GetJsonField(json, "authCode");
     if (!auth.empty()) authCode = auth;
 
+    std::string mdHost = GetJsonField(json, "mdHost");
+    if (!mdHost.empty()) mdFrontAddr = mdHost;
+
+    std::string subscribe = GetJsonField(json, "instruments");
+    if (!subscribe.empty()) subscribeList = subscribe;
+
     return true;
 }
 
+/// @brief 打印各阶段延迟, 先打印全部交易所合计, 再按交易所分别打印
+///
+void LogLatency(const LatencyTracker& latency) {
+    for (int stage = 0; stage < kLatencyStages; ++stage) {
+        for (int exchange = -1; exchange < latency.ExchangeCount(); ++exchange) {
+            const LatencySummary s = latency.Summary(stage, exchange);
+            if (s.count == 0) {
+                continue;
+            }
+            LOG("[统计] 延迟 {} | {} | 样本: {}, 平均: {}ns, p50: {}ns, p90: {}ns, p99: {}ns, p99.9: {}ns, 最大: {}ns",
+                LatencyStageName(stage), (exchange < 0 ? "合计" : latency.ExchangeName(exchange)), s.count, s.mean,
+                s.p50, s.p90, s.p99, s.p999, s.max);
+        }
+    }
+}
+
+/// @brief 打印断线恢复耗时, 没有断线过时不打印
+///
+void LogRecovery(const RecoveryTracker& recovery) {
+    if (recovery.Disconnects() == 0) {
+        return;
+    }
+    LOG("[统计] 断线: {} 次, 恢复中再次断线: {} 次", recovery.Disconnects(), recovery.Interrupted());
+    for (int stage = 0; stage < kRecoveryStages; ++stage) {
+        const LatencySummary s = recovery.Summary(stage);
+        if (s.count == 0) {
+            continue;
+        }
+        LOG("[统计] 恢复 {} | 样本: {}, 平均: {}ns, p50: {}ns, p90: {}ns, p99: {}ns, 最大: {}ns",
+            RecoveryStageName(stage), s.count, s.mean, s.p50, s.p90, s.p99, s.max);
+    }
+}
+
 /// @brief 打印使用说明
 ///
 void PrintUsage(const char* programName) {
     std::cout << "使用方法: " << programName << " [选项]" << std::endl;
     std::cout << "选项:" << std::endl;
     std::cout << "  -f <地址>  交易服务器地址 (格式: tcp://ip:port)" << std::endl;
+    std::cout << "  -m <地址>  行情服务器地址 (格式: tcp://ip:port; 回放版为 replay://目录?day=交易日&speed=倍速|max)" << std::endl;
+    std::cout << "  -s <合约>  订阅行情的合约, 逗号分隔 (如: rb2510,au2512)" << std::endl;
     std::cout << "  -b <经纪商> 经纪公司代码" << std::endl;
     std::cout << "  -u <用户名> 用户名" << std::endl;
     std::cout << "  -p <密码>   密码" << std::endl;
     std::cout << "  -i <投资者> 投资者代码 (默认与用户名相同)" << std::endl;
     std::cout << "  -a <AppID>  应用ID (用于认证)" << std::endl;
     std::cout << "  -c <AuthCode> 认证码" << std::endl;
+    std::cout << "  -R          忽略本地快照, 从头重传私有流和公共流" << std::endl;
     std::cout << "  -h          显示帮助信息" << std::endl;
     std::cout << "\n示例:" << std::endl;
     std::cout << "  " << programName << " -f tcp://180.168.146.187:10130 -b 9999 -u test1 -p 123456" << std::endl;
@@ -482,10 +195,15 @@ void PrintUsage(const char* programName) {
 /// @brief 主函数
 ///
 int main(int argc, char* argv[]) {
-    std::cout << "====================================" << std::endl;
-    std::cout << "  CTP交易API登录测试程序" << std::endl;
-    std::cout << "  版本: 1.0.0" << std::endl;
-    std::cout << "====================================" << std::endl;
+    // 启动异步日志, 日志同时输出到控制台
+    if (!AsyncLogger::Instance().Start("ctp_trader_test.log")) {
+        std::cout << "[警告] 无法打开日志文件 ctp_trader_test.log, 日志仅输出到控制台" << std::endl;
+    }
+
+    LOG("====================================");
+    LOG("  CTP交易API登录测试程序");
+    LOG("  版本: 1.0.0");
+    LOG("====================================");
 
     // 注册信号处理
     signal(SIGINT, SignalHandler);
@@ -499,14 +217,23 @@ int main(int argc, char* argv[]) {
     std::string investorId = "";
     std::string appId = "";
     std::string authCode = "";
+    std::string mdFrontAddr = "";
+    std::string subscribeList = "";
+    bool forceRestart = false;
 
     // 解析命令行参数
     int opt;
-    while ((opt = getopt(argc, argv, "f:b:u:p:i:a:c:h")) != -1) {
+    while ((opt = getopt(argc, argv, "f:m:s:b:u:p:i:a:c:Rh")) != -1) {
         switch (opt) {
             case 'f':
                 frontAddr = optarg;
                 break;
+            case 'm':
+                mdFrontAddr = optarg;
+                break;
+            case 's':
+                subscribeList = optarg;
+                break;
             case 'b':
                 brokerId = optarg;
                 break;
@@ -525,10 +252,15 @@ int main(int argc, char* argv[]) {
             case 'c':
                 authCode = optarg;
                 break;
+            case 'R':
+                forceRestart = true;
+                break;
             case 'h':
+                AsyncLogger::Instance().Stop();
                 PrintUsage(argv[0]);
                 return 0;
             default:
+                AsyncLogger::Instance().Stop();
                 PrintUsage(argv[0]);
                 return 1;
         }
@@ -536,20 +268,23 @@ int main(int argc, char* argv[]) {
 
     // 如果没有命令行参数，尝试从config.json读取配置
     if (userId.empty() && password.empty()) {
-        if (LoadConfigFromFile(frontAddr, brokerId, userId, password, investorId, appId, authCode)) {
-            std::cout << "[状态] 已从 config.json 加载配置" << std::endl;
+        if (LoadConfigFromFile(frontAddr, brokerId, userId, password, investorId, appId, authCode,
+                               mdFrontAddr, subscribeList)) {
+            LOG("[状态] 已从 config.json 加载配置");
         }
     }
 
     // 检查必需参数
     if (userId.empty()) {
-        std::cout << "[错误] 请指定用户名 (-u 参数)" << std::endl;
+        LOG("[错误] 请指定用户名 (-u 参数)");
+        AsyncLogger::Instance().Stop();
         PrintUsage(argv[0]);
         return 1;
     }
 
     if (password.empty()) {
-        std::cout << "[错误] 请指定密码 (-p 参数)" << std::endl;
+        LOG("[错误] 请指定密码 (-p 参数)");
+        AsyncLogger::Instance().Stop();
         PrintUsage(argv[0]);
         return 1;
     }
@@ -559,53 +294,233 @@ int main(int argc, char* argv[]) {
         investorId = userId;
     }
 
-    std::cout << "[配置] 连接配置:" << std::endl;
-    std::cout << "  前端地址: " << frontAddr << std::endl;
-    std::cout << "  经纪公司: " << brokerId << std::endl;
-    std::cout << "  用户名:   " << userId << std::endl;
-    std::cout << "  投资者:   " << investorId << std::endl;
-    std::cout << "====================================" << std::endl;
+    LOG("[配置] 连接配置:");
+    LOG("  前端地址: {}", frontAddr);
+    LOG("  经纪公司: {}", brokerId);
+    LOG("  用户名:   {}", userId);
+    LOG("  投资者:   {}", investorId);
+    LOG("  行情地址: {}", (mdFrontAddr.empty() ? "未配置" : mdFrontAddr.c_str()));
+    LOG("  订阅合约: {}", (subscribeList.empty() ? "无" : subscribeList.c_str()));
+    LOG("====================================");
 
     // 创建交易API实例
-    std::cout << "[状态] 创建交易API实例..." << std::endl;
+    LOG("[状态] 创建交易API实例...");
     CThostFtdcTraderApi* traderApi = CThostFtdcTraderApi::CreateFtdcTraderApi("./flow/");
 
+    // 加载报单/成交快照: 上次正常退出时私有流从断点续传, 公共流只接收登录后的内容,
+    // 否则从头重传, 重复的回报由快照去重
+    TradeSnapshot snapshot("./flow/");
+    const bool resume = !forceRestart && snapshot.LoadLatest();
+
+    // 合约信息缓存, 登录后按交易日映射或查询生成
+    InstrumentCache instruments("./flow/");
+
+    // 合约编号表, 各模块以编号作为数组下标访问合约相关数据
+    SymbolTable symbols;
+
     // 创建并注册回调实例
-    TraderSpi traderSpi(traderApi);
+    TraderSpi traderSpi(traderApi, g_control);
     traderSpi.SetLoginInfo(frontAddr, brokerId, userId, password, appId, authCode);
     traderSpi.SetInvestorId(investorId);
+    traderSpi.SetSnapshot(&snapshot);
+    traderSpi.SetInstrumentCache(&instruments);
+    traderSpi.SetSymbolTable(&symbols);
+    OrderTable orders(symbols, kOrderTableCapacity);
+    traderSpi.SetOrderTable(&orders);
+    RiskEngine risk(symbols, kOrderTableCapacity, kRiskLimits);
+    traderSpi.SetRiskEngine(&risk);
+    PositionKeeper positions(symbols.Capacity(), kOrderTableCapacity);
+    traderSpi.SetPositionKeeper(&positions);
+    FundsEstimator funds(symbols.Capacity(), kOrderTableCapacity);
+    traderSpi.SetFundsEstimator(&funds);
+    LatencyTracker latency(kOrderTableCapacity);
+    traderSpi.SetLatencyTracker(&latency);
+    RecoveryTracker recovery;
+    traderSpi.SetRecoveryTracker(&recovery);
+    OrderGateway gateway(traderApi, traderSpi.Ids());
+    gateway.SetAccount(brokerId, investorId, userId);
+    gateway.SetRiskEngine(&risk);
+    gateway.SetLatencyTracker(&latency);
+    traderSpi.SetOrderGateway(&gateway);
+    traderSpi.Start();
     traderApi->RegisterSpi(&traderSpi);
 
     // 订阅私有流和公共流
-    traderApi->SubscribePrivateTopic(THOST_TERT_RESTART);
-    traderApi->SubscribePublicTopic(THOST_TERT_RESTART);
+    LOG("[状态] 私有流订阅方式: {}", (resume ? "RESUME" : "RESTART"));
+    traderApi->SubscribePrivateTopic(resume ? THOST_TERT_RESUME : THOST_TERT_RESTART);
+    traderApi->SubscribePublicTopic(resume ? THOST_TERT_QUICK : THOST_TERT_RESTART);
 
     // 注册前端地址
-    std::cout << "[状态] 注册交易服务器地址..." << std::endl;
+    LOG("[状态] 注册交易服务器地址...");
     traderApi->RegisterFront(const_cast<char*>(frontAddr.c_str()));
 
     // 初始化
-    std::cout << "[状态] 初始化交易API..." << std::endl;
+    LOG("[状态] 初始化交易API...");
     traderApi->Init();
 
-    std::cout << "[状态] 等待连接..." << std::endl;
+    // 行情会话: 配置了行情地址和订阅合约时启动
+    const std::vector<std::string> mdInstruments = MdSession::ParseInstrumentList(subscribeList);
+    const bool mdEnabled = !mdFrontAddr.empty() && !mdInstruments.empty();
+    CThostFtdcMdApi* mdApi = nullptr;
+    if (mdEnabled) {
+        LOG("[状态] 创建行情API实例...");
+        mdApi = CThostFtdcMdApi::CreateFtdcMdApi("./flow/md_");
+    }
+    MdSession mdSession(mdApi, symbols, mdEnabled ? kMdQueueCapacity : 1);
+    BookStore books(mdEnabled ? symbols.Capacity() : 1);
+    // 本地条件单, 策略在行情处理函数中下达, 由同一线程按行情触发
+    TriggerEngine triggers(gateway, mdEnabled ? symbols.Capacity() : 1, mdEnabled ? kTriggerCapacity : 1);
+    std::vector<char> tickSeen(symbols.Capacity(), 0);
+    TickJournal tickJournal("./flow/");
+    // 回放的行情来自行情日志本身, 不再落盘
+    const bool mdReplay = mdFrontAddr.compare(0, 9, "replay://") == 0;
+    if (mdEnabled) {
+        if (!mdReplay) {
+            tickJournal.Start();
+            mdSession.SetTickJournal(&tickJournal);
+        }
+        mdSession.SetLoginInfo(mdFrontAddr, brokerId, userId, password);
+        mdSession.SetInstruments(mdInstruments);
+        mdSession.SetTickHandler([&symbols, &books, &risk, &triggers, &tickSeen](const MdTick& tick) {
+            books.Update(tick.symbolId, tick.data, tick.recvNs);
+            risk.OnTick(tick.symbolId, tick.data);
+            triggers.OnTick(tick.symbolId, tick.data, tick.recvNs);
+
+            // 每个合约只打印第一笔行情
+            BookSnapshot book;
+            if (!tickSeen[tick.symbolId] && books.Read(tick.symbolId, book)) {
+                tickSeen[tick.symbolId] = 1;
+                LOG("[行情] {} 最新价: {} | 买一: {}@{} | 卖一: {}@{} | 时间: {}ms", symbols.Name(tick.symbolId),
+                    book.lastPrice, book.bidPrice[0], book.bidVolume[0], book.askPrice[0], book.askVolume[0],
+                    book.updateTimeMs);
+            }
+        });
+        mdSession.Start();
+    }
+
+    LOG("[状态] 等待连接...");
+
+    // 主循环: 阻塞等待退出信号、登录失败、断线和重连, 事件到达时立即唤醒。
+    // 断线后CTP自动重连, 重新登录后立即撤掉本账户的全部挂单, 断线期间无法管理的挂单不留在市场上;
+    // 启动查询完成时和 kReconnectSweepDelayMs 后各补撤一次, 撤掉第一次撤单之后才续传到的挂单,
+    // 启动查询停滞时也按时补撤。每次撤单最多耗时 kReconnectCancelBudgetNs, 流控下未撤完时继续定时补撤
+    bool sweepPending = false;
+    for (;;) {
+        const uint32_t events = g_control.Wait(
+            kControlShutdown | kControlLoginFailed | kControlDisconnected | kControlRelogin | kControlReconnected,
+            sweepPending ? kReconnectSweepDelayMs : -1);
+        if (events & (kControlShutdown | kControlLoginFailed)) {
+            break;
+        }
+        g_control.Clear(events & (kControlDisconnected | kControlRelogin | kControlReconnected));
+        if (events & kControlDisconnected) {
+            LOG("[警告] 交易连接断开, 等待自动重连");
+            sweepPending = false;
+        }
+        const char* reason = nullptr;
+        if (events & kControlRelogin) {
+            reason = "重新登录后全部撤单";
+        } else if (events & kControlReconnected) {
+            reason = "启动查询完成后补撤";
+        } else if (events == 0 && sweepPending) {
+            reason = "重连后定时补撤";
+        }
+        if (reason) {
+            MassCancelResult cancel = gateway.MassCancel(orders, CancelScope::Account, 0, 0, kReconnectCancelBudgetNs);
+            LOG("[撤单] {} | 挂单: {} | 批量请求: {} | 逐笔请求: {} | 失败: {} | 待补撤: {} | 耗时: {}ns", reason,
+                cancel.orders, cancel.batchRequests, cancel.actionRequests, cancel.failed, cancel.deferred,
+                cancel.elapsedNs);
+            // 重新登录后安排一次定时补撤, 此后只在流控下未撤完时继续
+            sweepPending = (events & kControlRelogin) != 0 || cancel.deferred > 0;
+        }
+    }
 
-    // 主循环
-    while (g_running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (g_signal != 0) {
+        LOG("收到信号 {}, 准备退出程序...", g_signal.load());
     }
 
-    // 登出
-    std::cout << "[状态] 正在登出..." << std::endl;
-    traderSpi.ReqUserLogout();
+    // 登出: 仅在仍处于登录状态时发送, 收到响应或断线后立即继续, 最多等待 kLogoutTimeoutMs
+    if (traderSpi.IsLoggedIn()) {
+        LOG("[状态] 正在登出...");
+        g_control.Clear(kControlLogoutDone | kControlDisconnected);
+        if (traderSpi.ReqUserLogout() &&
+            !g_control.Wait(kControlLogoutDone | kControlDisconnected, kLogoutTimeoutMs)) {
+            LOG("[警告] 等待登出响应超时 ({}ms)", kLogoutTimeoutMs);
+        }
+    }
+
+    if (mdEnabled) {
+        mdSession.Stop();
+        MdSessionStats mdStats = mdSession.GetStats();
+        LOG("[统计] 行情: {}, 丢弃: {}, 队列满等待: {}, 最大排队延迟: {}ns", mdStats.ticks, mdStats.dropped,
+            mdStats.queueFullSpins, mdStats.maxQueueDelayNs);
+        mdApi->Release();
+        tickJournal.Stop();
+        LOG("[统计] 行情落盘: {}, 丢弃: {}", tickJournal.Written(), tickJournal.Dropped());
+    }
 
-    // 等待登出完成
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    // 停止回调处理线程, 之后到达的回调直接丢弃
+    traderSpi.Stop();
+    TraderEventStats stats = traderSpi.GetStats();
+    LOG("[统计] 回调事件: {}, 丢弃: {}, 队列满等待: {}", stats.posted, stats.dropped, stats.queueFullSpins);
+    LOG("[统计] 回调驻留时间 平均: {}ns, 最大: {}ns, 最大排队延迟: {}ns", (stats.posted ? stats.totalResidenceNs / static_cast<int64_t>(stats.posted) : 0), stats.maxResidenceNs, stats.maxQueueDelayNs);
+    OrderGatewayStats gatewayStats = gateway.GetStats();
+    LOG("[统计] 报单 已发送: {}, 失败: {}", gatewayStats.sent, gatewayStats.failed);
+    LOG("[统计] 撤单 已发送: {}, 失败: {}", gatewayStats.cancelsSent, gatewayStats.cancelsFailed);
+    RateLimiterStats rateStats = gateway.GetRateStats();
+    LOG("[统计] 流控 放行: {}, 排队后放行: {}, 会话拒绝: {}, 交易所拒绝: {}", rateStats.allowed, rateStats.delayed,
+        rateStats.sessionLimited, rateStats.exchangeLimited);
+    LOG("[统计] 流控 CTP返回-2: {}, 返回-3: {}, 下调: {}, 回升: {}, 当前会话速率: {}笔/秒", rateStats.tooManyPending,
+        rateStats.tooManyPerSecond, rateStats.decreases, rateStats.increases, rateStats.sessionPerSecond);
+    RiskStats riskStats = risk.GetStats();
+    uint64_t riskRejected = 0;
+    for (int i = 0; i < kRiskRejectKinds; ++i) {
+        riskRejected += riskStats.rejected[i];
+    }
+    LOG("[统计] 风控 通过: {}, 拒绝: {}", riskStats.passed, riskRejected);
+    for (int i = 0; i < kRiskRejectKinds; ++i) {
+        if (riskStats.rejected[i] != 0) {
+            LOG("  {}: {}", RiskResultText(kRiskBadVolume - i), riskStats.rejected[i]);
+        }
+    }
+    LOG("[统计] 报单表: {} 笔, 容量不足: {}, 无对应报单的成交: {}", orders.Size(), orders.Overflow(),
+        orders.OrphanTrades());
+    Position position;
+    for (uint32_t i = 0; i < symbols.Size(); ++i) {
+        if (!positions.Read(i, position) || (position.longToday == 0 && position.longYesterday == 0 &&
+                                             position.shortToday == 0 && position.shortYesterday == 0)) {
+            continue;
+        }
+        LOG("[持仓] {} | 多头 今: {} 昨: {} 冻结: {} | 空头 今: {} 昨: {} 冻结: {}", symbols.Name(i),
+            position.longToday, position.longYesterday, position.longFrozenToday + position.longFrozenYesterday,
+            position.shortToday, position.shortYesterday,
+            position.shortFrozenToday + position.shortFrozenYesterday);
+    }
+    if (positions.Shortfall() != 0) {
+        LOG("[警告] 成交时持仓不足 {} 手, 持仓初始化可能有误", positions.Shortfall());
+    }
+    FundsSnapshot fundsSnapshot;
+    if (funds.Read(fundsSnapshot)) {
+        LOG("[统计] 资金估算 权益: {}, 可用: {}, 保证金: {}, 冻结保证金: {}, 冻结手续费: {}, 手续费: {}, 平仓盈亏: {}",
+            fundsSnapshot.balance, fundsSnapshot.available, fundsSnapshot.currMargin, fundsSnapshot.frozenMargin,
+            fundsSnapshot.frozenCommission, fundsSnapshot.commission, fundsSnapshot.closeProfit);
+        LOG("[统计] 资金估算 缺少费率: {}", funds.Unpriced());
+    }
+    TriggerStats triggerStats = triggers.GetStats();
+    if (triggerStats.added != 0) {
+        LOG("[统计] 条件单 下达: {}, 触发: {}, 触发后报单失败: {}, 撤销: {}, 二选一撤销: {}, 仍挂起: {}",
+            triggerStats.added, triggerStats.fired, triggerStats.sendFailed, triggerStats.cancelled,
+            triggerStats.ocoCancelled, triggerStats.resting);
+    }
+    LogLatency(latency);
+    LogRecovery(recovery);
 
     // 释放资源
-    std::cout << "[状态] 释放资源..." << std::endl;
+    LOG("[状态] 释放资源...");
     traderApi->Release();
+    snapshot.Close();
 
-    std::cout << "[完成] 程序退出" << std::endl;
+    LOG("[完成] 程序退出");
+    AsyncLogger::Instance().Stop();
     return 0;
 }